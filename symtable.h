@@ -9,6 +9,12 @@ struct SymTable;
 /* pointer SymTable_T to object SymTable initialization */
 typedef struct SymTable *SymTable_T;
 
+/* struct SymTableIter initialization */
+struct SymTableIter;
+
+/* pointer SymTableIter_T to object SymTableIter initialization */
+typedef struct SymTableIter *SymTableIter_T;
+
 /* SymTable_new returns a new SymTable and returns a pointer to the 
 new SymTable object if there is sufficient memory and null if there
 is insufficient memory */
@@ -55,7 +61,13 @@ void *SymTable_get(SymTable_T oSymTable, const char *pcKey);
 /* SymTable_remove takes in SymTable object oSymTable and a const 
 char pointer pcKey. The function removes the binding from oSymTable 
 that has the key pcKey and returns the value of the binding. If the 
-binding to be removed is not found, the funciton returns NULL. */
+binding to be removed is not found, the funciton returns NULL. A 
+hash table whose bindings drop below an eighth of what its buckets 
+or slots hold under the max load shrinks them to about twice what 
+the bindings left need, so a table emptied after a burst of puts is 
+not walked at its old size by SymTable_map; the gap between the two 
+limits keeps a table from shrinking and growing back over and over. 
+It never shrinks below a size reserved with SymTable_reserve. */
 void *SymTable_remove(SymTable_T oSymTable, const char *pcKey);
 
 /* SymTable_map takes in a SymTable object oSymTable, a const char 
@@ -68,6 +80,372 @@ void SymTable_map(SymTable_T oSymTable,
                   void *pvValue, void *pvExtra),
                   const void *pvExtra);
 
+/* SymTable_getCounts takes in a SymTable object oSymTable and two 
+size_t pointers puRehashes and puCompares. The function stores in 
+*puRehashes the number of bindings that have been moved to a new set 
+of buckets by expansion of oSymTable, and in *puCompares the number of
+key comparisons oSymTable has done: calls to memcmp on the bytes of 
+two keys. The list and the hash tables only make one once the keys' 
+lengths (and stored hashes, where there are any) match. */
+void SymTable_getCounts(SymTable_T oSymTable, size_t *puRehashes,
+                        size_t *puCompares);
+
+/* SymTable_setMaxLoad takes in a SymTable object oSymTable and a 
+double dMaxLoad. It sets the max load factor (bindings per bucket or 
+slot) that oSymTable may reach before it expands, so lookups stay 
+constant time at any size. The function returns 1 if dMaxLoad is a 
+valid load factor for the implementation and 0 (leaving oSymTable 
+unchanged) otherwise. Load factors must be positive, and below 1 for 
+open addressing. */
+int SymTable_setMaxLoad(SymTable_T oSymTable, double dMaxLoad);
+
+/* SymTable_setIncremental takes in a SymTable object oSymTable and an
+int iIncremental. If iIncremental is nonzero, later expansions of 
+oSymTable keep the old and new set of buckets side by side and each 
+following operation migrates a few buckets, so no single put pays for 
+rehashing the whole table. If iIncremental is 0, expansions rehash 
+every binding at once (the default). The function returns 1 if the 
+implementation supports the requested mode and 0 otherwise. */
+int SymTable_setIncremental(SymTable_T oSymTable, int iIncremental);
+
+/* SymTable_getAllocCount takes in a SymTable object oSymTable and 
+returns how many times oSymTable has called malloc, for itself, its 
+buckets or slots, and the chunks that its bindings and key copies are 
+allocated from. */
+size_t SymTable_getAllocCount(SymTable_T oSymTable);
+
+/* SymTable_getBytes takes in a SymTable object oSymTable and returns 
+how many bytes of memory from malloc oSymTable currently holds: 
+itself, its buckets, slots or nodes, and the chunks that its bindings 
+and key copies are allocated from. */
+size_t SymTable_getBytes(SymTable_T oSymTable);
+
+/* SymTable_intern takes in a const char pointer pcKey and returns the
+atom for pcKey: a canonical copy of pcKey that lives until the program
+ends, so interning equal strings always returns the same pointer. It
+returns NULL if there is insufficient memory. Atoms are shared by every
+SymTable and must not be modified. */
+const char *SymTable_intern(const char *pcKey);
+
+/* SymTable_putAtom takes in a SymTable object oSymTable, an atom 
+pcAtom returned by SymTable_intern and a const void pointer pvValue. 
+It works like SymTable_put, but the hash of pcAtom is not recomputed 
+and keys are compared by pointer where possible. A binding added by 
+SymTable_putAtom is found by SymTable_get with an equal string, and 
+the other way around. */
+int SymTable_putAtom(SymTable_T oSymTable, const char *pcAtom,
+                     const void *pvValue);
+
+/* SymTable_getAtom takes in a SymTable object oSymTable and an atom 
+pcAtom returned by SymTable_intern. It works like SymTable_get without 
+hashing pcAtom again. */
+void *SymTable_getAtom(SymTable_T oSymTable, const char *pcAtom);
+
+/* SymTable_putBorrowed takes in a SymTable object oSymTable, a const 
+char pointer pcKey and a const void pointer pvValue. It works like 
+SymTable_put, but oSymTable may keep pcKey itself instead of a copy, 
+so the client must leave pcKey unchanged and allocated until the 
+binding is removed or oSymTable is freed. oSymTable never frees or 
+modifies pcKey. */
+int SymTable_putBorrowed(SymTable_T oSymTable, const char *pcKey,
+                         const void *pvValue);
+
+/* SymTable_getOrPut takes in a SymTable object oSymTable, a const 
+char pointer pcKey, a const void pointer pvValue and an int pointer 
+piFound. If oSymTable contains pcKey, *piFound is set to 1 and its 
+value is left alone. Otherwise a binding of pcKey and pvValue is added 
+and *piFound is set to 0. Either way pcKey is hashed and looked up 
+once, and a pointer to the value of pcKey's binding is returned, so 
+the client can read or update it in place. The pointer is valid until 
+oSymTable is next changed by a put or remove or is freed. NULL is 
+returned (and oSymTable left unchanged) if there is insufficient 
+memory. piFound may be NULL. */
+void **SymTable_getOrPut(SymTable_T oSymTable, const char *pcKey,
+                         const void *pvValue, int *piFound);
+
+/* SymTable_upsert takes in a SymTable object oSymTable, a const char 
+pointer pcKey, a const void pointer pvValue and a void double pointer 
+ppvOldValue. It makes pvValue the value of pcKey, replacing the old 
+value if oSymTable contains pcKey and adding a binding otherwise, 
+with a single lookup. *ppvOldValue is set to the old value, or NULL 
+if a binding was added. ppvOldValue may be NULL. It returns 1, or 0 
+(and leaves oSymTable unchanged) if there is insufficient memory. */
+int SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+                    const void *pvValue, void **ppvOldValue);
+
+/* The functions below work like SymTable_put, SymTable_replace, 
+SymTable_contains, SymTable_get and SymTable_remove, but take a key of 
+uLength bytes at pvKey instead of a string. The key need not be '\0' 
+terminated and may contain '\0' bytes, so it can be a slice of a 
+larger buffer. A string key is the same key as its strlen bytes. 
+SymTable_map passes each key as a pointer to its bytes, followed by a 
+'\0'. The radix tree implementation holds no whole keys, so it builds 
+each one in a buffer that is only valid during that call. */
+int SymTable_putN(SymTable_T oSymTable, const void *pvKey,
+                  size_t uLength, const void *pvValue);
+
+void *SymTable_replaceN(SymTable_T oSymTable, const void *pvKey,
+                        size_t uLength, const void *pvValue);
+
+int SymTable_containsN(SymTable_T oSymTable, const void *pvKey,
+                       size_t uLength);
+
+void *SymTable_getN(SymTable_T oSymTable, const void *pvKey,
+                    size_t uLength);
+
+void *SymTable_removeN(SymTable_T oSymTable, const void *pvKey,
+                       size_t uLength);
+
+/* SymTable_hashKey takes in a const char pointer pcKey and returns 
+its full hash. The hash does not depend on any SymTable, so a key 
+looked up in several SymTable objects (such as a chain of scopes) only 
+has to be hashed once. */
+size_t SymTable_hashKey(const char *pcKey);
+
+/* The functions below work like SymTable_put, SymTable_get, 
+SymTable_contains and SymTable_remove, but take uHash, which must be 
+SymTable_hashKey(pcKey), instead of hashing pcKey themselves. */
+int SymTable_putHashed(SymTable_T oSymTable, const char *pcKey,
+                       size_t uHash, const void *pvValue);
+
+void *SymTable_getHashed(SymTable_T oSymTable, const char *pcKey,
+                         size_t uHash);
+
+int SymTable_containsHashed(SymTable_T oSymTable, const char *pcKey,
+                            size_t uHash);
+
+void *SymTable_removeHashed(SymTable_T oSymTable, const char *pcKey,
+                            size_t uHash);
+
+/* SymTable_getMany takes in a SymTable object oSymTable, an array 
+apcKeys of uCount keys and an array apvValues with room for uCount 
+values. It sets apvValues[i] to SymTable_get(oSymTable, apcKeys[i]) 
+for every i, but hashes a batch of keys and starts loading all of 
+their buckets before walking any chain, so the cache misses of 
+different keys overlap instead of happening one after another. */
+void SymTable_getMany(SymTable_T oSymTable, const char *const apcKeys[],
+                      size_t uCount, void *apvValues[]);
+
+/* SymTableHash names the hash functions a SymTable can be created 
+with. SYMTABLE_HASH_DEFAULT is the 65599 hash from the assignment, 
+which SymTable_new uses. SYMTABLE_HASH_FAST reads keys a word at a 
+time (wyhash style) and is much faster on long keys. 
+SYMTABLE_HASH_SIPHASH is SipHash-2-4 keyed with a random seed per 
+SymTable, so a client who does not know the seed cannot pick keys that 
+all collide. SYMTABLE_HASH_FAST is seeded per SymTable as well. */
+enum SymTableHash {SYMTABLE_HASH_DEFAULT = 0, SYMTABLE_HASH_FAST = 1,
+                   SYMTABLE_HASH_SIPHASH = 2};
+
+/* SymTable_newWithOptions takes in eHash, one of SymTableHash, and 
+returns a new SymTable that hashes its keys with eHash, or NULL if 
+there is insufficient memory or eHash is not a SymTableHash. The hash 
+of a key put with SymTable_putAtom or passed to a *Hashed function is 
+only reused by a SymTable made with SYMTABLE_HASH_DEFAULT; other 
+SymTable objects hash such keys again. */
+SymTable_T SymTable_newWithOptions(enum SymTableHash eHash);
+
+/* SymTable_mapParallel works like SymTable_map, but splits the 
+buckets (or slots) of oSymTable into ranges and applies *pfApply to 
+their bindings on up to uThreads threads at once, the calling thread 
+among them. A thread that finishes its ranges early steals half of 
+what another thread has left, so a few long chains do not hold up the 
+rest. It returns once *pfApply has been applied to every binding. A 
+uThreads of 0 or 1 makes it the same as SymTable_map, and an 
+implementation whose bindings cannot be split up (the linked list) 
+always maps on the calling thread. 
+
+Bindings are visited in no particular order, and *pfApply runs on 
+several threads at the same time, always with the same pvExtra. A 
+*pfApply is safe if it only reads the key and value it is given or 
+changes the object that pvValue points to (no two calls get the same 
+binding), and touches anything shared by several bindings, such as 
+*pvExtra, only under its own lock or with atomic operations. It must 
+not call any SymTable function on oSymTable, or rely on running on the 
+calling thread. */
+void SymTable_mapParallel(SymTable_T oSymTable,
+                          void (*pfApply)(const char *pcKey,
+                                          void *pvValue, void *pvExtra),
+                          const void *pvExtra, size_t uThreads);
+
+/* SymTable_iterBegin takes in a SymTable object oSymTable and returns 
+a new iterator over its bindings, or NULL if there is insufficient 
+memory. Unlike SymTable_map, an iterator lets the client stop after 
+any binding, or walk part of oSymTable now and the rest later. Every 
+iterator must be ended with SymTable_iterEnd before oSymTable is 
+freed. 
+
+oSymTable may be changed by puts, replaces and removes while the 
+iterator is in use. Every binding that is in oSymTable for the whole 
+iteration is returned exactly once, even if oSymTable expands in the 
+meantime; a binding put or removed during the iteration may or may 
+not be returned. An implementation may put off expanding oSymTable 
+until its last iterator has ended. Bindings come in no particular 
+order. */
+SymTableIter_T SymTable_iterBegin(SymTable_T oSymTable);
+
+/* SymTable_iterNext takes in an iterator oIter, a const char double 
+pointer ppcKey and a void double pointer ppvValue. If some binding of 
+oIter's SymTable has not been returned yet, it sets *ppcKey and 
+*ppvValue to the key and value of the next one and returns 1. 
+Otherwise it returns 0. Either pointer may be NULL. The key is a 
+pointer to the key's bytes followed by a '\0', as in SymTable_map, 
+and stays valid until the binding is removed. The concurrent 
+implementation instead copies a bucket's bindings out at a time, and 
+the radix tree implementation builds each key in a buffer of oIter's, 
+so their keys stay valid until the next call with oIter, and they also 
+return 0 if there is insufficient memory for the copies. */
+int SymTable_iterNext(SymTableIter_T oIter, const char **ppcKey,
+                      void **ppvValue);
+
+/* SymTable_iterEnd takes in an iterator oIter and frees it */
+void SymTable_iterEnd(SymTableIter_T oIter);
+
+/* SymTable_mapRange takes in a SymTable object oSymTable, const char 
+pointers pcLow and pcHigh, a function pfApply and a const void 
+pointer pvExtra. It applies *pfApply to every binding whose key is at 
+least pcLow and less than pcHigh, passing pvExtra as in SymTable_map. 
+Keys are ordered byte by byte as unsigned chars, a key before any 
+longer key it starts, so string keys are ordered as by strcmp. Either 
+bound may be NULL, leaving that end of the range open. The ordered 
+implementations (the B-tree and the radix tree) visit the bindings in 
+ascending order of key, in O(log n + k) time for k bindings in range 
+for the B-tree and O(length of the bounds + k) for the radix tree; 
+the others look at every binding and visit the ones in range in no 
+particular order. */
+void SymTable_mapRange(SymTable_T oSymTable, const char *pcLow,
+                       const char *pcHigh,
+                       void (*pfApply)(const char *pcKey,
+                                       void *pvValue, void *pvExtra),
+                       const void *pvExtra);
+
+/* SymTable_mapPrefix takes in a SymTable object oSymTable, a const 
+char pointer pcPrefix, a function pfApply and a const void pointer 
+pvExtra. It applies *pfApply to every binding whose key starts with 
+pcPrefix (every binding, if pcPrefix is ""), in the same order and 
+time as SymTable_mapRange. */
+void SymTable_mapPrefix(SymTable_T oSymTable, const char *pcPrefix,
+                        void (*pfApply)(const char *pcKey,
+                                        void *pvValue, void *pvExtra),
+                        const void *pvExtra);
+
+/* SymTable_save takes in a SymTable object oSymTable, a const char 
+pointer pcPath and a size_t uValueSize. It writes a snapshot of 
+oSymTable to the file pcPath (replacing it) that SymTable_openMapped 
+can open. Values are saved as the uValueSize bytes they point to, or 
+as NULL, so they must be plain data that holds no pointers. The 
+function returns 1, or 0 (leaving any file at pcPath as it was) if 
+the file cannot be written or there is insufficient memory. */
+int SymTable_save(SymTable_T oSymTable, const char *pcPath,
+                  size_t uValueSize);
+
+/* SymTable_openMapped takes in a const char pointer pcPath to a file 
+written by SymTable_save and returns a read-only SymTable object that 
+answers straight from the file mapped into memory. Opening it reads 
+the file's index once to check that nothing in it points outside the 
+file, but copies and rehashes nothing, so it takes a small part of 
+the time putting the bindings would. Gets return 
+pointers to the saved values inside the mapping, which must not be 
+written to. Keys passed by SymTable_map and the iterators point into 
+the mapping and stay valid until the SymTable is freed. Every 
+implementation visits a mapped table's bindings in ascending order of 
+key, with mapRange and mapPrefix taking O(log n + k) time. Puts fail, 
+and removes and replaces return NULL and change nothing. The function 
+returns NULL if the file cannot be mapped, is not a snapshot, was 
+written with another version of the format or hash function or on a 
+machine with another byte order or word size, is damaged so that it 
+points outside itself, or if there is insufficient memory. */
+SymTable_T SymTable_openMapped(const char *pcPath);
+
+/* SymTable_newWithCapacity takes in a size_t uCapacity and returns a 
+new SymTable, like SymTable_new, that is already big enough to hold 
+uCapacity bindings without expanding (see SymTable_reserve), or NULL 
+if there is insufficient memory. */
+SymTable_T SymTable_newWithCapacity(size_t uCapacity);
+
+/* SymTable_reserve takes in a SymTable object oSymTable and a size_t 
+uCapacity. It grows oSymTable's buckets or slots (and the arena its 
+nodes come from) at once to the size they would reach by holding 
+uCapacity bindings under the current max load, so putting up to that 
+many bindings rehashes nothing. The linked list and the radix tree 
+have no buckets and only get room for their nodes; the B+ tree 
+allocates each node as it is made and ignores the reservation. 
+Growing the buckets rehashes the bindings already in oSymTable once. 
+Reserving never shrinks oSymTable, and removes do not shrink it below 
+the size reserved until SymTable_compact is called. The function 
+returns 1, or 0 if there is insufficient memory, oSymTable is mapped, 
+or (for an implementation that defers expansion while iterating) 
+oSymTable has iterators. On failure oSymTable still holds the same 
+bindings. */
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity);
+
+/* SymTable_compact takes in a SymTable object oSymTable and rebuilds 
+it to fit the bindings it holds now: its buckets or slots shrink to 
+about twice what the bindings need (forgetting any size reserved with 
+SymTable_reserve), a tree's nodes are filled up, and the bindings and 
+key copies are copied together into fresh chunks, so the memory that 
+removes left scattered and half used is given back. Until it is done 
+oSymTable holds both copies. Pointers from SymTable_getOrPut are not 
+valid afterwards. The function returns 1, or 0 if there is 
+insufficient memory, oSymTable is mapped, or (for an implementation 
+whose iterators point into the table) oSymTable has iterators. On 
+failure oSymTable still holds the same bindings. */
+int SymTable_compact(SymTable_T oSymTable);
+
+/* SYMTABLE_STATS_CHAINS is how many chain lengths the histogram of a 
+SymTableStats tells apart */
+enum {SYMTABLE_STATS_CHAINS = 16};
+
+/* SymTableStats is what SymTable_getStats reports about a SymTable. 
+Fields that do not apply to an implementation are 0: the linked list 
+and the trees have no buckets, and only report allocations and bytes. 
+For open addressing a bucket is a slot, and the chain of a binding is 
+how many groups of slots are probed to reach it. */
+struct SymTableStats {
+    /* how many buckets (or slots) there are */
+    size_t bucketCount;
+    /* the load factor: bindings per bucket or slot */
+    double load;
+    /* chainCounts[i] is how many buckets hold i bindings (for open 
+    addressing, how many bindings are i groups along their probe 
+    sequence), and the last entry counts every longer chain too */
+    size_t chainCounts[SYMTABLE_STATS_CHAINS];
+    /* the length of the longest chain */
+    size_t maxChain;
+    /* how many lookups found their key, and how many did not */
+    size_t hits;
+    size_t misses;
+    /* the average number of bindings (for open addressing, groups) 
+    looked at by a lookup that found its key, and by one that did not */
+    double probesPerHit;
+    double probesPerMiss;
+    /* how many times puts expanded the SymTable, and the seconds 
+    those expansions took in all */
+    size_t expansions;
+    double expandSeconds;
+    /* what SymTable_getAllocCount and SymTable_getBytes return */
+    size_t allocCount;
+    size_t bytes;
+};
+
+/* SymTable_newWithStats takes in eHash, one of SymTableHash, and 
+works like SymTable_newWithOptions, but the SymTable it returns also 
+counts its lookups, the probes they take and its expansions, with how 
+long they take, for SymTable_getStats. A lookup is any search for a 
+key by a get, contains, put, replace, getOrPut or upsert; removes are 
+not counted. Other SymTable objects count none of this, so all it 
+costs them is one test of a flag per lookup and expansion. */
+SymTable_T SymTable_newWithStats(enum SymTableHash eHash);
+
+/* SymTable_getStats takes in a SymTable object oSymTable and a 
+pointer psStats to a SymTableStats, and fills *psStats in. The bucket 
+and chain fields are worked out by walking every bucket, which takes 
+time in proportion to the size of oSymTable. It returns 1 if 
+oSymTable was made by SymTable_newWithStats with an implementation 
+that counts lookups and expansions, and 0 (leaving those fields 0) 
+otherwise. */
+int SymTable_getStats(SymTable_T oSymTable,
+                      struct SymTableStats *psStats);
+
 #endif
 
 
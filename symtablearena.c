@@ -0,0 +1,280 @@
+/* symtable arena implementation */
+#include "symtablearena.h"
+#include <stdlib.h>
+#include <assert.h>
+#include <stddef.h>
+
+/* Align holds every type a block may need to be aligned for, so
+sizeof(union Align) is the alignment of every block */
+union Align {
+    void *p;
+    size_t u;
+    double d;
+    long l;
+};
+
+/* the alignment of every block, and the step between size classes */
+#define ARENA_ALIGN (sizeof(union Align))
+
+/* blocks up to smallMax bytes come from chunks, bigger ones get their
+own malloc. Chunks start at chunkMin bytes and double up to chunkMax
+so small SymTables stay small. */
+enum ArenaSizes {smallMax = 256, chunkMin = 1024, chunkMax = 65536};
+
+/* the number of size classes (and free lists) of small blocks */
+#define CLASS_COUNT (smallMax / ARENA_ALIGN + 1)
+
+/* Chunk is the header of a malloc'd chunk. Chunks are linked together
+so the Arena can free all of them. */
+struct Chunk {
+    /* pointer to the next Chunk in list */
+    struct Chunk *next;
+    /* keeps the data that follows the header aligned */
+    union Align align;
+};
+
+/* Large is the header of a block bigger than smallMax. Large blocks
+are doubly linked so a single one can be released. */
+struct Large {
+    /* pointer to the previous Large block in list */
+    struct Large *prev;
+    /* pointer to the next Large block in list */
+    struct Large *next;
+    /* how many bytes were malloc'd for this block */
+    size_t bytes;
+    /* keeps the data that follows the header aligned */
+    union Align align;
+};
+
+/* FreeBlock is what a released small block holds while it sits on a
+free list */
+struct FreeBlock {
+    /* pointer to the next free block of the same size class */
+    struct FreeBlock *next;
+};
+
+/* Arena holds the list of chunks, the unused end of the newest chunk,
+the free lists of small blocks by size class, the list of large
+blocks and counts of what it took from malloc. */
+struct Arena {
+    /* pointer to the newest Chunk */
+    struct Chunk *chunks;
+    /* first unused byte of the newest chunk */
+    char *bump;
+    /* how many unused bytes are left after bump */
+    size_t bumpLeft;
+    /* the size of the next chunk to malloc */
+    size_t nextChunkSize;
+    /* free lists of released small blocks, indexed by size class */
+    struct FreeBlock *freeLists[CLASS_COUNT];
+    /* pointer to the first Large block */
+    struct Large *larges;
+    /* how many times the Arena has called malloc */
+    size_t allocCount;
+    /* how many bytes the Arena currently holds from malloc */
+    size_t bytes;
+};
+
+/* Arena_round takes in a size uSize and returns it rounded up to a
+multiple of ARENA_ALIGN */
+static size_t Arena_round(size_t uSize)
+{
+   return (uSize + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+}
+
+Arena_T Arena_new(void){
+   struct Arena *oArena = malloc(sizeof(struct Arena));
+   size_t i;
+
+   if (oArena == NULL) {
+      return NULL;
+   }
+   oArena->chunks = NULL;
+   oArena->bump = NULL;
+   oArena->bumpLeft = 0;
+   oArena->nextChunkSize = chunkMin;
+   for (i = 0; i < CLASS_COUNT; i++) {
+      oArena->freeLists[i] = NULL;
+   }
+   oArena->larges = NULL;
+   oArena->allocCount = 1;
+   oArena->bytes = sizeof(struct Arena);
+   return oArena;
+}
+
+void Arena_free(Arena_T oArena){
+   struct Chunk *currChunk;
+   struct Chunk *nextChunk;
+   struct Large *currLarge;
+   struct Large *nextLarge;
+
+   assert(oArena != NULL);
+
+   currChunk = oArena->chunks;
+   while (currChunk != NULL) {
+      nextChunk = currChunk->next;
+      free(currChunk);
+      currChunk = nextChunk;
+   }
+   currLarge = oArena->larges;
+   while (currLarge != NULL) {
+      nextLarge = currLarge->next;
+      free(currLarge);
+      currLarge = nextLarge;
+   }
+   free(oArena);
+}
+
+/* Arena_allocLarge takes in an Arena oArena and a size uSize and
+returns a block of uSize bytes with its own malloc, or NULL if there
+is insufficient memory */
+static void *Arena_allocLarge(Arena_T oArena, size_t uSize)
+{
+   struct Large *nLarge;
+   size_t uBytes = offsetof(struct Large, align) + uSize;
+
+   nLarge = malloc(uBytes);
+   if (nLarge == NULL) {
+      return NULL;
+   }
+   nLarge->prev = NULL;
+   nLarge->next = oArena->larges;
+   nLarge->bytes = uBytes;
+   if (oArena->larges != NULL) {
+      oArena->larges->prev = nLarge;
+   }
+   oArena->larges = nLarge;
+   oArena->allocCount++;
+   oArena->bytes += uBytes;
+   return &nLarge->align;
+}
+
+/* Arena_addChunk takes in an Arena oArena and a chunk size
+uChunkSize and mallocs a new chunk of that many bytes, which becomes
+the chunk that blocks are bumped out of. What was left of the chunk
+before is not used again. It returns 0 if there is insufficient
+memory and 1 otherwise. */
+static int Arena_addChunk(Arena_T oArena, size_t uChunkSize)
+{
+   struct Chunk *nChunk;
+
+   nChunk = malloc(uChunkSize);
+   if (nChunk == NULL) {
+      return 0;
+   }
+   nChunk->next = oArena->chunks;
+   oArena->chunks = nChunk;
+   oArena->bump = (char *)&nChunk->align;
+   oArena->bumpLeft = uChunkSize - offsetof(struct Chunk, align);
+   oArena->allocCount++;
+   oArena->bytes += uChunkSize;
+   return 1;
+}
+
+/* Arena_grow takes in an Arena oArena and a size uSize and mallocs a
+new chunk with room for at least uSize bytes, which becomes the chunk
+that blocks are bumped out of. It returns 0 if there is insufficient
+memory and 1 otherwise. */
+static int Arena_grow(Arena_T oArena, size_t uSize)
+{
+   size_t uChunkSize = oArena->nextChunkSize;
+   size_t uHeader = offsetof(struct Chunk, align);
+
+   while (uChunkSize - uHeader < uSize) {
+      uChunkSize *= 2;
+   }
+   if (! Arena_addChunk(oArena, uChunkSize)) {
+      return 0;
+   }
+   if (oArena->nextChunkSize < chunkMax) {
+      oArena->nextChunkSize *= 2;
+   }
+   return 1;
+}
+
+void *Arena_alloc(Arena_T oArena, size_t uSize){
+   size_t uRounded;
+   struct FreeBlock *freeBlock;
+   void *pvBlock;
+
+   assert(oArena != NULL);
+
+   uRounded = Arena_round(uSize == 0 ? 1 : uSize);
+   if (uRounded > smallMax) {
+      return Arena_allocLarge(oArena, uRounded);
+   }
+
+   /* reuse a released block of the same size class first */
+   freeBlock = oArena->freeLists[uRounded / ARENA_ALIGN];
+   if (freeBlock != NULL) {
+      oArena->freeLists[uRounded / ARENA_ALIGN] = freeBlock->next;
+      return freeBlock;
+   }
+
+   if (oArena->bumpLeft < uRounded) {
+      if (! Arena_grow(oArena, uRounded)) {
+         return NULL;
+      }
+   }
+   pvBlock = oArena->bump;
+   oArena->bump += uRounded;
+   oArena->bumpLeft -= uRounded;
+   return pvBlock;
+}
+
+void Arena_release(Arena_T oArena, void *pvBlock, size_t uSize){
+   size_t uRounded;
+   struct FreeBlock *freeBlock;
+   struct Large *currLarge;
+
+   assert(oArena != NULL);
+   assert(pvBlock != NULL);
+
+   uRounded = Arena_round(uSize == 0 ? 1 : uSize);
+   if (uRounded > smallMax) {
+      currLarge = (struct Large *)
+         ((char *)pvBlock - offsetof(struct Large, align));
+      if (currLarge->prev != NULL) {
+         currLarge->prev->next = currLarge->next;
+      } else {
+         oArena->larges = currLarge->next;
+      }
+      if (currLarge->next != NULL) {
+         currLarge->next->prev = currLarge->prev;
+      }
+      oArena->bytes -= currLarge->bytes;
+      free(currLarge);
+      return;
+   }
+
+   freeBlock = pvBlock;
+   freeBlock->next = oArena->freeLists[uRounded / ARENA_ALIGN];
+   oArena->freeLists[uRounded / ARENA_ALIGN] = freeBlock;
+}
+
+int Arena_reserve(Arena_T oArena, size_t uSize){
+   size_t uHeader = offsetof(struct Chunk, align);
+
+   assert(oArena != NULL);
+
+   if (oArena->bumpLeft >= uSize) {
+      return 1;
+   }
+   if (uSize > (size_t)-1 - uHeader) {
+      return 0;
+   }
+   /* the chunk is exactly as big as asked for, since a reservation is
+   usually for a bulk load whose size is known */
+   return Arena_addChunk(oArena, uHeader + (uSize < chunkMin ?
+                                            chunkMin : uSize));
+}
+
+size_t Arena_getAllocCount(Arena_T oArena){
+   assert(oArena != NULL);
+   return oArena->allocCount;
+}
+
+size_t Arena_getBytes(Arena_T oArena){
+   assert(oArena != NULL);
+   return oArena->bytes;
+}
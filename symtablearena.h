@@ -0,0 +1,51 @@
+/* symtable arena header file */
+#include <stddef.h>
+#ifndef SYMTABLEARENA_INCLUDED
+#define SYMTABLEARENA_INCLUDED
+
+/* An Arena hands out small blocks (Bindings, Nodes and key copies) by
+bumping a pointer through large chunks, and keeps the blocks released
+back to it on free lists by size, so a SymTable makes one malloc per
+chunk instead of several per binding. Blocks larger than a small
+limit get their own malloc. Freeing the Arena releases every block it
+ever handed out. */
+struct Arena;
+
+/* pointer Arena_T to object Arena initialization */
+typedef struct Arena *Arena_T;
+
+/* Arena_new returns a new, empty Arena if there is sufficient memory
+and NULL if there is insufficient memory */
+Arena_T Arena_new(void);
+
+/* Arena_free takes an Arena oArena and frees every chunk and large
+block it holds, and oArena itself. This takes time proportional to the
+number of chunks, not the number of blocks. */
+void Arena_free(Arena_T oArena);
+
+/* Arena_alloc takes an Arena oArena and a size uSize and returns a
+block of at least uSize bytes, suitably aligned for any pointer or
+size_t, or NULL if there is insufficient memory. */
+void *Arena_alloc(Arena_T oArena, size_t uSize);
+
+/* Arena_release takes an Arena oArena, a block pvBlock returned by
+Arena_alloc on oArena and the size uSize it was requested with. The
+block is put on a free list for later Arena_alloc calls of the same
+size (or freed, if it is a large block). */
+void Arena_release(Arena_T oArena, void *pvBlock, size_t uSize);
+
+/* Arena_reserve takes an Arena oArena and a size uSize and makes sure
+the next uSize bytes of small blocks can be handed out without calling
+malloc, by getting one chunk big enough for all of them now. It returns
+1, or 0 (leaving oArena as it was) if there is insufficient memory. */
+int Arena_reserve(Arena_T oArena, size_t uSize);
+
+/* Arena_getAllocCount takes an Arena oArena and returns how many
+times oArena has called malloc */
+size_t Arena_getAllocCount(Arena_T oArena);
+
+/* Arena_getBytes takes an Arena oArena and returns how many bytes
+oArena currently holds from malloc (chunks and large blocks) */
+size_t Arena_getBytes(Arena_T oArena);
+
+#endif
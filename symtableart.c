@@ -0,0 +1,2219 @@
+/* symtable adaptive radix tree implementation */
+#include "symtable.h"
+#include "symtablearena.h"
+#include "symtableatom.h"
+#include "symtableparallel.h"
+#include "symtablesnapshot.h"
+#include "symtablestats.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#endif
+
+/* the four kinds of Node, by how many children they have room for. A
+full Node is replaced by one of the next kind, and a Node that drops
+to shrinkAt children by one of the kind before. */
+enum NodeKinds {NODE4 = 0, NODE16 = 1, NODE48 = 2, NODE256 = 3};
+
+/* how many children each kind of Node has room for */
+static const size_t auCapacity[] = {4, 16, 48, 256};
+
+/* how few children a Node of each kind has before it is replaced by
+the kind before. It is well below that kind's capacity, so a Node
+going back and forth around one size is not resized every time. */
+static const size_t auShrinkAt[] = {0, 3, 12, 36};
+
+/* how many subtrees per thread SymTable_mapParallel splits the tree
+into, so that threads that finish early have some to steal */
+enum {MAP_UNITS_PER_THREAD = 256};
+
+struct Leaf;
+
+/* Node is what every kind of inner node starts with. All the keys
+below a Node continue the path to it with the bytes of its prefix,
+which are kept in the prefixSize bytes right after the node (see
+SymTable_prefixOf), so keys that start alike share those bytes
+instead of each holding a copy. */
+struct Node {
+    /* NODE4, NODE16, NODE48 or NODE256 */
+    unsigned char kind;
+    /* how many children the Node has */
+    unsigned short count;
+    /* how many bytes are in the prefix */
+    size_t prefixLength;
+    /* how many bytes there are room for after the node, at least
+    prefixLength */
+    size_t prefixSize;
+    /* the binding whose key ends right after the prefix, or NULL */
+    struct Leaf *leaf;
+};
+
+/* Node4 holds up to 4 children, with the byte that leads to each in
+keys. The bytes are in ascending order, and children[i] is under
+keys[i]. */
+struct Node4 {
+    struct Node header;
+    unsigned char keys[4];
+    void *children[4];
+};
+
+/* Node16 is a Node4 with room for 16 children. Its bytes fill one
+SSE2 register, so a child is found with a single comparison. */
+struct Node16 {
+    struct Node header;
+    unsigned char keys[16];
+    void *children[16];
+};
+
+/* Node48 holds up to 48 children in any order. index[c] is 1 more than
+where the child under byte c is in children, or 0 if there is none. */
+struct Node48 {
+    struct Node header;
+    unsigned char index[256];
+    void *children[48];
+};
+
+/* Node256 has a child pointer for every byte, NULL if there is none */
+struct Node256 {
+    struct Node header;
+    void *children[256];
+};
+
+/* Leaf is a binding. It hangs where its key first parts from every
+other key, so it only holds the rest of the key, its tail. A child
+pointer to a Leaf has its low bit set (see SymTable_tagLeaf) to tell
+it from a Node; a Node's own binding is pointed to directly. */
+struct Leaf {
+    /* the value */
+    const void *value;
+    /* how many bytes are in tail */
+    size_t tailLength;
+    /* how many bytes there are room for in tail, at least
+    tailLength */
+    size_t tailSize;
+    /* the bytes of the key below the Leaf's place in the tree, not
+    '\0' terminated */
+    unsigned char tail[1];
+};
+
+/* SymTable is an adaptive radix tree: Nodes that branch on one byte
+of the key at a time and skip the bytes that every key below them
+shares */
+struct SymTable {
+    /* the root: NULL if the SymTable is empty, and otherwise a tagged
+    Leaf or a Node */
+    void *root;
+    /* how many bindings are in the SymTable */
+    size_t size;
+    /* how many times keys have been compared with memcmp */
+    size_t compareCount;
+    /* how many bytes are in the longest key ever put, which no key in
+    the SymTable is longer than */
+    size_t maxKeyLength;
+    /* maxKeyLength + 1 bytes where the keys are put back together for
+    SymTable_map, SymTable_mapRange and SymTable_mapPrefix */
+    char *keyBuffer;
+    /* how many times the SymTable has called malloc for itself,
+    keyBuffer and the arenas SymTable_compact has replaced */
+    size_t allocCount;
+    /* the Arena that every Node and Leaf is allocated from */
+    Arena_T arena;
+    /* the mapped snapshot that a SymTable from SymTable_openMapped
+    answers from, or NULL */
+    Snapshot_T snapshot;
+};
+
+/* RangeWalk is what the steps of SymTable_mapRange share: the bounds,
+the function to apply and the buffer the keys are built in */
+struct RangeWalk {
+    /* the lowest key to apply pfApply to, or NULL */
+    const unsigned char *low;
+    /* how many bytes are in low */
+    size_t lowLength;
+    /* the key to stop at, or NULL */
+    const unsigned char *high;
+    /* how many bytes are in high */
+    size_t highLength;
+    /* the function applied to every binding in range */
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra);
+    /* passed on to pfApply */
+    const void *pvExtra;
+    /* where the keys are built */
+    char *key;
+};
+
+/* MapUnit is a subtree that SymTable_mapParallel maps as a whole: a
+child and the bytes of the path to it */
+struct MapUnit {
+    /* a tagged Leaf or a Node */
+    void *child;
+    /* where the path to child starts in the MapJob's paths */
+    size_t pathStart;
+    /* how many bytes are in the path */
+    size_t pathLength;
+};
+
+/* MapJob is what the threads of SymTable_mapParallel share: the
+subtrees, the function to apply and buffers to build keys in. Each
+range of units takes a buffer for as long as it runs, and no more
+ranges run at once than there are threads. */
+struct MapJob {
+    /* the subtrees */
+    struct MapUnit *units;
+    /* the paths of all the units, one after another */
+    unsigned char *paths;
+    /* the function applied to every binding */
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra);
+    /* passed on to pfApply */
+    const void *pvExtra;
+    /* held while a buffer is taken from or put back into buffers */
+    pthread_mutex_t lock;
+    /* the buffers not in use, each of maxKeyLength + 1 bytes */
+    char **buffers;
+    /* how many buffers are not in use */
+    size_t bufferCount;
+};
+
+/* SymTableIter is an iterator over the bindings of a SymTable, in
+ascending order of key. The tree holds no whole keys to point to, so
+the iterator keeps its own copy of the key it returned last and looks
+for the next larger one from the root each time. Puts and removes in
+between need no bookkeeping. */
+struct SymTableIter {
+    /* the SymTable being iterated over */
+    SymTable_T oSymTable;
+    /* the key returned last followed by a '\0' */
+    char *key;
+    /* how many bytes are in key, not counting the '\0' */
+    size_t keyLength;
+    /* how many bytes there are room for in key */
+    size_t keySize;
+    /* 1 once a key has been returned, 0 before */
+    int started;
+    /* the number of the snapshot binding returned next, if the
+    SymTable is mapped */
+    size_t snapshotIndex;
+};
+
+/* SymTable_isLeaf takes in a child pointer pvChild and returns 1 if it
+points to a Leaf and 0 if it points to a Node */
+static int SymTable_isLeaf(const void *pvChild)
+{
+   return ((uintptr_t)pvChild & 1) != 0;
+}
+
+/* SymTable_tagLeaf takes in a Leaf pLeaf and returns a child pointer
+to it. Arena blocks are aligned, so the low bit is free for the tag. */
+static void *SymTable_tagLeaf(struct Leaf *pLeaf)
+{
+   return (void *)((uintptr_t)pLeaf | 1);
+}
+
+/* SymTable_asLeaf takes in a child pointer pvChild to a Leaf and
+returns the Leaf */
+static struct Leaf *SymTable_asLeaf(void *pvChild)
+{
+   return (struct Leaf *)((uintptr_t)pvChild & ~(uintptr_t)1);
+}
+
+/* SymTable_nodeSize takes in a kind of Node iKind and returns the size
+of such a node without its prefix */
+static size_t SymTable_nodeSize(int iKind)
+{
+   switch (iKind) {
+   case NODE4:
+      return sizeof(struct Node4);
+   case NODE16:
+      return sizeof(struct Node16);
+   case NODE48:
+      return sizeof(struct Node48);
+   default:
+      return sizeof(struct Node256);
+   }
+}
+
+/* SymTable_prefixOf takes in a Node pNode and returns its prefix */
+static unsigned char *SymTable_prefixOf(struct Node *pNode)
+{
+   return (unsigned char *)pNode + SymTable_nodeSize(pNode->kind);
+}
+
+/* SymTable_newNode takes in SymTable oSymTable, a kind of Node iKind
+and a prefix size uPrefixSize, and returns a new Node of that kind
+with no children, no binding and room for a prefix of uPrefixSize
+bytes, or NULL if there is insufficient memory */
+static struct Node *SymTable_newNode(SymTable_T oSymTable, int iKind,
+                                     size_t uPrefixSize)
+{
+   struct Node *pNode;
+   size_t uSize = SymTable_nodeSize(iKind);
+
+   if (uPrefixSize > (size_t)-1 - uSize) {
+      return NULL;
+   }
+   pNode = Arena_alloc(oSymTable->arena, uSize + uPrefixSize);
+   if (pNode == NULL) {
+      return NULL;
+   }
+   /* zeroes every child pointer and every Node48 index */
+   memset(pNode, 0, uSize);
+   pNode->kind = (unsigned char)iKind;
+   pNode->prefixSize = uPrefixSize;
+   return pNode;
+}
+
+/* SymTable_releaseNode takes in SymTable oSymTable and a Node pNode,
+and gives pNode back to oSymTable's arena */
+static void SymTable_releaseNode(SymTable_T oSymTable,
+                                 struct Node *pNode)
+{
+   Arena_release(oSymTable->arena, pNode,
+                 SymTable_nodeSize(pNode->kind) + pNode->prefixSize);
+}
+
+/* SymTable_newLeaf takes in SymTable oSymTable, uLength bytes pucTail,
+a size uTailSize of at least uLength and a value pvValue, and returns
+a new Leaf with room for a tail of uTailSize bytes that holds pucTail
+and pvValue, or NULL if there is insufficient memory */
+static struct Leaf *SymTable_newLeaf(SymTable_T oSymTable,
+                                     const unsigned char *pucTail,
+                                     size_t uLength, size_t uTailSize,
+                                     const void *pvValue)
+{
+   struct Leaf *pLeaf;
+
+   assert(uLength <= uTailSize);
+
+   if (uTailSize > (size_t)-1 - offsetof(struct Leaf, tail)) {
+      return NULL;
+   }
+   pLeaf = Arena_alloc(oSymTable->arena,
+                       offsetof(struct Leaf, tail) + uTailSize);
+   if (pLeaf == NULL) {
+      return NULL;
+   }
+   pLeaf->value = pvValue;
+   pLeaf->tailLength = uLength;
+   pLeaf->tailSize = uTailSize;
+   if (uLength > 0) {
+      memcpy(pLeaf->tail, pucTail, uLength);
+   }
+   return pLeaf;
+}
+
+/* SymTable_releaseLeaf takes in SymTable oSymTable and a Leaf pLeaf,
+and gives pLeaf back to oSymTable's arena */
+static void SymTable_releaseLeaf(SymTable_T oSymTable,
+                                 struct Leaf *pLeaf)
+{
+   Arena_release(oSymTable->arena, pLeaf,
+                 offsetof(struct Leaf, tail) + pLeaf->tailSize);
+}
+
+/* SymTable_sorted takes in a Node4 or Node16 pNode and sets *ppucKeys
+and *pppvChildren to its bytes and its children */
+static void SymTable_sorted(struct Node *pNode, unsigned char **ppucKeys,
+                            void ***pppvChildren)
+{
+   if (pNode->kind == NODE4) {
+      *ppucKeys = ((struct Node4 *)pNode)->keys;
+      *pppvChildren = ((struct Node4 *)pNode)->children;
+   } else {
+      *ppucKeys = ((struct Node16 *)pNode)->keys;
+      *pppvChildren = ((struct Node16 *)pNode)->children;
+   }
+}
+
+/* SymTable_search16 takes in a Node16 pNode16 and a byte ucByte, and
+returns the index of ucByte in pNode16's keys, or -1 if it is not
+there. With SSE2 all 16 bytes are compared to ucByte at once, and the
+bits of the ones past count are masked off. */
+static int SymTable_search16(const struct Node16 *pNode16,
+                             unsigned char ucByte)
+{
+#if defined(__SSE2__) && defined(__GNUC__)
+   __m128i vKeys = _mm_loadu_si128((const __m128i *)pNode16->keys);
+   __m128i vByte = _mm_set1_epi8((char)ucByte);
+   int iMask = _mm_movemask_epi8(_mm_cmpeq_epi8(vKeys, vByte)) &
+               ((1 << pNode16->header.count) - 1);
+
+   if (iMask == 0) {
+      return -1;
+   }
+   return __builtin_ctz((unsigned)iMask);
+#else
+   int i;
+
+   for (i = 0; i < (int)pNode16->header.count; i++) {
+      if (pNode16->keys[i] == ucByte) {
+         return i;
+      }
+   }
+   return -1;
+#endif
+}
+
+/* SymTable_findChild takes in a Node pNode and a byte ucByte, and
+returns a pointer to the child pointer under ucByte, or NULL if pNode
+has no child there */
+static void **SymTable_findChild(struct Node *pNode, unsigned char ucByte)
+{
+   struct Node4 *pNode4;
+   struct Node16 *pNode16;
+   struct Node48 *pNode48;
+   struct Node256 *pNode256;
+   size_t i;
+   int iIndex;
+
+   switch (pNode->kind) {
+   case NODE4:
+      pNode4 = (struct Node4 *)pNode;
+      for (i = 0; i < pNode->count; i++) {
+         if (pNode4->keys[i] == ucByte) {
+            return &pNode4->children[i];
+         }
+      }
+      return NULL;
+   case NODE16:
+      pNode16 = (struct Node16 *)pNode;
+      iIndex = SymTable_search16(pNode16, ucByte);
+      return iIndex < 0 ? NULL : &pNode16->children[iIndex];
+   case NODE48:
+      pNode48 = (struct Node48 *)pNode;
+      if (pNode48->index[ucByte] == 0) {
+         return NULL;
+      }
+      return &pNode48->children[pNode48->index[ucByte] - 1];
+   default:
+      pNode256 = (struct Node256 *)pNode;
+      if (pNode256->children[ucByte] == NULL) {
+         return NULL;
+      }
+      return &pNode256->children[ucByte];
+   }
+}
+
+/* SymTable_nextChild takes in a Node pNode, an int iAfter that is -1
+or a byte, and a pointer pucByte. It returns the child of pNode under
+the smallest byte greater than iAfter and sets *pucByte to that byte,
+or returns NULL if there is none. */
+static void *SymTable_nextChild(struct Node *pNode, int iAfter,
+                                unsigned char *pucByte)
+{
+   struct Node48 *pNode48;
+   struct Node256 *pNode256;
+   unsigned char *pucKeys;
+   void **ppvChildren;
+   size_t i;
+   int iByte;
+
+   switch (pNode->kind) {
+   case NODE4:
+   case NODE16:
+      SymTable_sorted(pNode, &pucKeys, &ppvChildren);
+      for (i = 0; i < pNode->count; i++) {
+         if ((int)pucKeys[i] > iAfter) {
+            *pucByte = pucKeys[i];
+            return ppvChildren[i];
+         }
+      }
+      return NULL;
+   case NODE48:
+      pNode48 = (struct Node48 *)pNode;
+      for (iByte = iAfter + 1; iByte < 256; iByte++) {
+         if (pNode48->index[iByte] != 0) {
+            *pucByte = (unsigned char)iByte;
+            return pNode48->children[pNode48->index[iByte] - 1];
+         }
+      }
+      return NULL;
+   default:
+      pNode256 = (struct Node256 *)pNode;
+      for (iByte = iAfter + 1; iByte < 256; iByte++) {
+         if (pNode256->children[iByte] != NULL) {
+            *pucByte = (unsigned char)iByte;
+            return pNode256->children[iByte];
+         }
+      }
+      return NULL;
+   }
+}
+
+/* SymTable_addChild takes in a Node pNode that is not full and has no
+child under byte ucByte, and makes pvChild its child under ucByte */
+static void SymTable_addChild(struct Node *pNode, unsigned char ucByte,
+                              void *pvChild)
+{
+   struct Node48 *pNode48;
+   unsigned char *pucKeys;
+   void **ppvChildren;
+   size_t i;
+
+   assert(pNode->count < auCapacity[pNode->kind]);
+
+   switch (pNode->kind) {
+   case NODE4:
+   case NODE16:
+      SymTable_sorted(pNode, &pucKeys, &ppvChildren);
+      for (i = pNode->count; i > 0 && pucKeys[i - 1] > ucByte; i--) {
+         pucKeys[i] = pucKeys[i - 1];
+         ppvChildren[i] = ppvChildren[i - 1];
+      }
+      pucKeys[i] = ucByte;
+      ppvChildren[i] = pvChild;
+      break;
+   case NODE48:
+      pNode48 = (struct Node48 *)pNode;
+      /* there is a free slot, since the node is not full */
+      i = 0;
+      while (pNode48->children[i] != NULL) {
+         i++;
+      }
+      pNode48->children[i] = pvChild;
+      pNode48->index[ucByte] = (unsigned char)(i + 1);
+      break;
+   default:
+      ((struct Node256 *)pNode)->children[ucByte] = pvChild;
+      break;
+   }
+   pNode->count++;
+}
+
+/* SymTable_removeChild takes in a Node pNode and a byte ucByte that it
+has a child under, and takes that child out of pNode */
+static void SymTable_removeChild(struct Node *pNode, unsigned char ucByte)
+{
+   struct Node48 *pNode48;
+   unsigned char *pucKeys;
+   void **ppvChildren;
+   size_t i;
+
+   switch (pNode->kind) {
+   case NODE4:
+   case NODE16:
+      SymTable_sorted(pNode, &pucKeys, &ppvChildren);
+      for (i = 0; pucKeys[i] != ucByte; i++) {
+         assert(i + 1 < pNode->count);
+      }
+      for (; i + 1 < pNode->count; i++) {
+         pucKeys[i] = pucKeys[i + 1];
+         ppvChildren[i] = ppvChildren[i + 1];
+      }
+      break;
+   case NODE48:
+      pNode48 = (struct Node48 *)pNode;
+      assert(pNode48->index[ucByte] != 0);
+      pNode48->children[pNode48->index[ucByte] - 1] = NULL;
+      pNode48->index[ucByte] = 0;
+      break;
+   default:
+      ((struct Node256 *)pNode)->children[ucByte] = NULL;
+      break;
+   }
+   pNode->count--;
+}
+
+/* SymTable_resize takes in SymTable oSymTable, a Node pNode, a kind of
+Node iKind with room for all of pNode's children and a prefix size
+uPrefixSize of at least pNode's prefix length. It returns a new Node
+of kind iKind with room for uPrefixSize bytes of prefix and the same
+prefix, binding and children as pNode, or NULL if there is
+insufficient memory. pNode is left as it was. */
+static struct Node *SymTable_resize(SymTable_T oSymTable,
+                                    struct Node *pNode, int iKind,
+                                    size_t uPrefixSize)
+{
+   struct Node *pNew;
+   void *pvChild;
+   unsigned char ucByte;
+   int iAfter = -1;
+
+   assert(pNode->count <= auCapacity[iKind]);
+   assert(pNode->prefixLength <= uPrefixSize);
+
+   pNew = SymTable_newNode(oSymTable, iKind, uPrefixSize);
+   if (pNew == NULL) {
+      return NULL;
+   }
+   pNew->prefixLength = pNode->prefixLength;
+   memcpy(SymTable_prefixOf(pNew), SymTable_prefixOf(pNode),
+          pNode->prefixLength);
+   pNew->leaf = pNode->leaf;
+   while ((pvChild = SymTable_nextChild(pNode, iAfter, &ucByte)) != NULL) {
+      SymTable_addChild(pNew, ucByte, pvChild);
+      iAfter = ucByte;
+   }
+   return pNew;
+}
+
+/* SymTable_matching takes in two byte arrays pucA and pucB of at least
+uLength bytes, and returns how many of the first uLength bytes they
+have in common before the first that differs */
+static size_t SymTable_matching(const unsigned char *pucA,
+                                const unsigned char *pucB, size_t uLength)
+{
+   size_t i = 0;
+
+   while (i < uLength && pucA[i] == pucB[i]) {
+      i++;
+   }
+   return i;
+}
+
+/* SymTable_prepend takes in uLength bytes pucBytes with room for
+uFrontLength + 1 more, uFrontLength bytes pucFront and a byte ucByte,
+and puts pucFront and then ucByte in front of pucBytes */
+static void SymTable_prepend(unsigned char *pucBytes, size_t uLength,
+                             const unsigned char *pucFront,
+                             size_t uFrontLength, unsigned char ucByte)
+{
+   memmove(pucBytes + uFrontLength + 1, pucBytes, uLength);
+   memcpy(pucBytes, pucFront, uFrontLength);
+   pucBytes[uFrontLength] = ucByte;
+}
+
+/* SymTable_fitKey takes in SymTable oSymTable and a key length
+uLength, and makes keyBuffer big enough for keys of uLength bytes. It
+returns 0 if there is insufficient memory (leaving oSymTable
+unchanged) and 1 otherwise. */
+static int SymTable_fitKey(SymTable_T oSymTable, size_t uLength)
+{
+   char *pcBuffer;
+
+   if (uLength <= oSymTable->maxKeyLength) {
+      return 1;
+   }
+   if (uLength == (size_t)-1) {
+      return 0;
+   }
+   pcBuffer = realloc(oSymTable->keyBuffer, uLength + 1);
+   if (pcBuffer == NULL) {
+      return 0;
+   }
+   oSymTable->allocCount++;
+   oSymTable->keyBuffer = pcBuffer;
+   oSymTable->maxKeyLength = uLength;
+   return 1;
+}
+
+/* SymTable_newChild takes in SymTable oSymTable, a Node pNode whose
+prefix ends uDepth bytes into a key pucKey of uLength bytes, and a
+value pvValue. It makes a Leaf for the binding and hangs it from
+pNode: as pNode's own binding if the key ends at uDepth, and as the
+child under byte uDepth of the key otherwise. pNode must have room for
+it. The Leaf is returned, or NULL (leaving pNode unchanged) if there
+is insufficient memory. */
+static struct Leaf *SymTable_newChild(SymTable_T oSymTable,
+                                      struct Node *pNode,
+                                      const unsigned char *pucKey,
+                                      size_t uLength, size_t uDepth,
+                                      const void *pvValue)
+{
+   struct Leaf *pLeaf;
+
+   if (uDepth == uLength) {
+      assert(pNode->leaf == NULL);
+      pLeaf = SymTable_newLeaf(oSymTable, NULL, 0, 0, pvValue);
+      if (pLeaf == NULL) {
+         return NULL;
+      }
+      pNode->leaf = pLeaf;
+      return pLeaf;
+   }
+   pLeaf = SymTable_newLeaf(oSymTable, pucKey + uDepth + 1,
+                            uLength - uDepth - 1, uLength - uDepth - 1,
+                            pvValue);
+   if (pLeaf == NULL) {
+      return NULL;
+   }
+   SymTable_addChild(pNode, pucKey[uDepth], SymTable_tagLeaf(pLeaf));
+   return pLeaf;
+}
+
+/* SymTable_splitLeaf takes in SymTable oSymTable, a reference ppvRef
+to a Leaf that is uDepth bytes into a key pucKey of uLength bytes and
+whose tail starts with the next uCommon bytes of the key but is not
+the rest of it, and a value pvValue. A Node4 with those uCommon bytes
+as its prefix takes the Leaf's place, with the Leaf and a new Leaf for
+the binding of pucKey below it. The new Leaf is returned, or NULL
+(leaving the tree unchanged) if there is insufficient memory. */
+static struct Leaf *SymTable_splitLeaf(SymTable_T oSymTable,
+                                       void **ppvRef,
+                                       const unsigned char *pucKey,
+                                       size_t uLength, size_t uDepth,
+                                       size_t uCommon,
+                                       const void *pvValue)
+{
+   struct Leaf *pOld = SymTable_asLeaf(*ppvRef);
+   struct Leaf *pLeaf;
+   struct Node *pNode;
+   unsigned char ucByte;
+
+   pNode = SymTable_newNode(oSymTable, NODE4, uCommon);
+   if (pNode == NULL) {
+      return NULL;
+   }
+   pLeaf = SymTable_newChild(oSymTable, pNode, pucKey, uLength,
+                             uDepth + uCommon, pvValue);
+   if (pLeaf == NULL) {
+      SymTable_releaseNode(oSymTable, pNode);
+      return NULL;
+   }
+   memcpy(SymTable_prefixOf(pNode), pOld->tail, uCommon);
+   pNode->prefixLength = uCommon;
+
+   /* what is left of the old tail after the prefix and the byte of
+   the child it goes under is moved to its front */
+   if (pOld->tailLength == uCommon) {
+      pOld->tailLength = 0;
+      pNode->leaf = pOld;
+   } else {
+      ucByte = pOld->tail[uCommon];
+      memmove(pOld->tail, pOld->tail + uCommon + 1,
+              pOld->tailLength - uCommon - 1);
+      pOld->tailLength -= uCommon + 1;
+      SymTable_addChild(pNode, ucByte, SymTable_tagLeaf(pOld));
+   }
+   *ppvRef = pNode;
+   return pLeaf;
+}
+
+/* SymTable_splitPrefix takes in SymTable oSymTable, a reference ppvRef
+to a Node that is uDepth bytes into a key pucKey of uLength bytes and
+whose prefix starts with the next uCommon bytes of the key but not
+with the byte after them, and a value pvValue. A Node4 with those
+uCommon bytes as its prefix takes the Node's place, with the Node and
+a new Leaf for the binding of pucKey below it. The new Leaf is
+returned, or NULL (leaving the tree unchanged) if there is
+insufficient memory. */
+static struct Leaf *SymTable_splitPrefix(SymTable_T oSymTable,
+                                         void **ppvRef,
+                                         const unsigned char *pucKey,
+                                         size_t uLength, size_t uDepth,
+                                         size_t uCommon,
+                                         const void *pvValue)
+{
+   struct Node *pNode = *ppvRef;
+   unsigned char *pucPrefix = SymTable_prefixOf(pNode);
+   struct Node *pParent;
+   struct Leaf *pLeaf;
+   unsigned char ucByte;
+
+   pParent = SymTable_newNode(oSymTable, NODE4, uCommon);
+   if (pParent == NULL) {
+      return NULL;
+   }
+   pLeaf = SymTable_newChild(oSymTable, pParent, pucKey, uLength,
+                             uDepth + uCommon, pvValue);
+   if (pLeaf == NULL) {
+      SymTable_releaseNode(oSymTable, pParent);
+      return NULL;
+   }
+   memcpy(SymTable_prefixOf(pParent), pucPrefix, uCommon);
+   pParent->prefixLength = uCommon;
+
+   ucByte = pucPrefix[uCommon];
+   memmove(pucPrefix, pucPrefix + uCommon + 1,
+           pNode->prefixLength - uCommon - 1);
+   pNode->prefixLength -= uCommon + 1;
+   SymTable_addChild(pParent, ucByte, pNode);
+   *ppvRef = pParent;
+   return pLeaf;
+}
+
+/* SymTable_add takes in SymTable oSymTable, a key pucKey, its length
+uLength, a value pvValue and an int pointer piFound. If oSymTable
+contains pucKey, *piFound is set to 1 and a pointer to the value of
+its binding is returned. Otherwise a binding of pucKey to pvValue is
+added, *piFound is set to 0 and a pointer to the new value is
+returned. NULL is returned (and oSymTable left unchanged) if there is
+insufficient memory or oSymTable is mapped. */
+static const void **SymTable_add(SymTable_T oSymTable,
+                                 const unsigned char *pucKey,
+                                 size_t uLength, const void *pvValue,
+                                 int *piFound)
+{
+   void **ppvRef = &oSymTable->root;
+   void **ppvChild;
+   struct Node *pNode;
+   struct Node *pBigger;
+   struct Leaf *pLeaf;
+   size_t uDepth = 0;
+   size_t uCommon;
+   size_t uShorter;
+
+   *piFound = 0;
+   /* a mapped SymTable is read-only */
+   if (oSymTable->snapshot != NULL) {
+      return NULL;
+   }
+   if (!SymTable_fitKey(oSymTable, uLength)) {
+      return NULL;
+   }
+
+   for (;;) {
+      if (*ppvRef == NULL) {
+         pLeaf = SymTable_newLeaf(oSymTable, pucKey + uDepth,
+                                  uLength - uDepth, uLength - uDepth,
+                                  pvValue);
+         if (pLeaf == NULL) {
+            return NULL;
+         }
+         *ppvRef = SymTable_tagLeaf(pLeaf);
+         break;
+      }
+
+      if (SymTable_isLeaf(*ppvRef)) {
+         pLeaf = SymTable_asLeaf(*ppvRef);
+         uShorter = pLeaf->tailLength < uLength - uDepth ?
+                    pLeaf->tailLength : uLength - uDepth;
+         oSymTable->compareCount++;
+         uCommon = SymTable_matching(pLeaf->tail, pucKey + uDepth,
+                                     uShorter);
+         if (uCommon == pLeaf->tailLength &&
+             uCommon == uLength - uDepth) {
+            *piFound = 1;
+            return &pLeaf->value;
+         }
+         pLeaf = SymTable_splitLeaf(oSymTable, ppvRef, pucKey, uLength,
+                                    uDepth, uCommon, pvValue);
+         if (pLeaf == NULL) {
+            return NULL;
+         }
+         break;
+      }
+
+      pNode = *ppvRef;
+      uShorter = pNode->prefixLength < uLength - uDepth ?
+                 pNode->prefixLength : uLength - uDepth;
+      uCommon = SymTable_matching(SymTable_prefixOf(pNode),
+                                  pucKey + uDepth, uShorter);
+      if (uCommon < pNode->prefixLength) {
+         pLeaf = SymTable_splitPrefix(oSymTable, ppvRef, pucKey, uLength,
+                                      uDepth, uCommon, pvValue);
+         if (pLeaf == NULL) {
+            return NULL;
+         }
+         break;
+      }
+      uDepth += pNode->prefixLength;
+
+      if (uDepth == uLength) {
+         if (pNode->leaf != NULL) {
+            *piFound = 1;
+            return &pNode->leaf->value;
+         }
+      } else {
+         ppvChild = SymTable_findChild(pNode, pucKey[uDepth]);
+         if (ppvChild != NULL) {
+            ppvRef = ppvChild;
+            uDepth++;
+            continue;
+         }
+      }
+
+      /* the binding hangs from pNode, which is replaced by the next
+      kind of Node first if it is full */
+      pBigger = pNode;
+      if (uDepth < uLength && pNode->count == auCapacity[pNode->kind]) {
+         pBigger = SymTable_resize(oSymTable, pNode, pNode->kind + 1,
+                                   pNode->prefixLength);
+         if (pBigger == NULL) {
+            return NULL;
+         }
+      }
+      pLeaf = SymTable_newChild(oSymTable, pBigger, pucKey, uLength,
+                                uDepth, pvValue);
+      if (pLeaf == NULL) {
+         if (pBigger != pNode) {
+            SymTable_releaseNode(oSymTable, pBigger);
+         }
+         return NULL;
+      }
+      if (pBigger != pNode) {
+         SymTable_releaseNode(oSymTable, pNode);
+         *ppvRef = pBigger;
+      }
+      break;
+   }
+   oSymTable->size++;
+   return &pLeaf->value;
+}
+
+/* SymTable_tidy takes in SymTable oSymTable and a reference ppvRef to a
+Node that has just lost a child or its own binding, and puts the tree
+back in shape: an empty Node is removed, a Node left with only its
+own binding becomes a Leaf, a Node left with one child and no binding
+is merged into the child, and a Node with few children is replaced by
+a smaller kind. If there is insufficient memory for a new Leaf or
+Node, pNode is left as it is, which is still a valid tree. */
+static void SymTable_tidy(SymTable_T oSymTable, void **ppvRef)
+{
+   struct Node *pNode = *ppvRef;
+   struct Node *pChild;
+   struct Node *pNew;
+   struct Leaf *pLeaf;
+   void *pvChild;
+   unsigned char ucByte;
+
+   if (pNode->count == 0) {
+      pLeaf = pNode->leaf;
+      if (pLeaf == NULL) {
+         *ppvRef = NULL;
+      } else if (pLeaf->tailSize >= pNode->prefixLength) {
+         memcpy(pLeaf->tail, SymTable_prefixOf(pNode),
+                pNode->prefixLength);
+         pLeaf->tailLength = pNode->prefixLength;
+         *ppvRef = SymTable_tagLeaf(pLeaf);
+      } else {
+         pLeaf = SymTable_newLeaf(oSymTable, SymTable_prefixOf(pNode),
+                                  pNode->prefixLength,
+                                  pNode->prefixLength, pLeaf->value);
+         if (pLeaf == NULL) {
+            return;
+         }
+         SymTable_releaseLeaf(oSymTable, pNode->leaf);
+         *ppvRef = SymTable_tagLeaf(pLeaf);
+      }
+      SymTable_releaseNode(oSymTable, pNode);
+      return;
+   }
+
+   if (pNode->count == 1 && pNode->leaf == NULL) {
+      /* the prefix and the byte of the only child go in front of the
+      child's own prefix or tail, and the child takes pNode's place */
+      pvChild = SymTable_nextChild(pNode, -1, &ucByte);
+      if (SymTable_isLeaf(pvChild)) {
+         pLeaf = SymTable_asLeaf(pvChild);
+         if (pLeaf->tailSize - pLeaf->tailLength <= pNode->prefixLength) {
+            pLeaf = SymTable_newLeaf(oSymTable, pLeaf->tail,
+                                     pLeaf->tailLength,
+                                     pLeaf->tailLength +
+                                     pNode->prefixLength + 1,
+                                     pLeaf->value);
+            if (pLeaf == NULL) {
+               return;
+            }
+            SymTable_releaseLeaf(oSymTable, SymTable_asLeaf(pvChild));
+         }
+         SymTable_prepend(pLeaf->tail, pLeaf->tailLength,
+                          SymTable_prefixOf(pNode), pNode->prefixLength,
+                          ucByte);
+         pLeaf->tailLength += pNode->prefixLength + 1;
+         *ppvRef = SymTable_tagLeaf(pLeaf);
+      } else {
+         pChild = pvChild;
+         if (pChild->prefixSize - pChild->prefixLength <=
+             pNode->prefixLength) {
+            pChild = SymTable_resize(oSymTable, pChild, pChild->kind,
+                                     pChild->prefixLength +
+                                     pNode->prefixLength + 1);
+            if (pChild == NULL) {
+               return;
+            }
+            SymTable_releaseNode(oSymTable, pvChild);
+         }
+         SymTable_prepend(SymTable_prefixOf(pChild), pChild->prefixLength,
+                          SymTable_prefixOf(pNode), pNode->prefixLength,
+                          ucByte);
+         pChild->prefixLength += pNode->prefixLength + 1;
+         *ppvRef = pChild;
+      }
+      SymTable_releaseNode(oSymTable, pNode);
+      return;
+   }
+
+   if (pNode->count <= auShrinkAt[pNode->kind]) {
+      pNew = SymTable_resize(oSymTable, pNode, pNode->kind - 1,
+                             pNode->prefixLength);
+      if (pNew != NULL) {
+         SymTable_releaseNode(oSymTable, pNode);
+         *ppvRef = pNew;
+      }
+   }
+}
+
+/* SymTable_delete takes in SymTable oSymTable, a key pucKey and its
+length uLength. If oSymTable contains pucKey, its binding is removed
+and its value returned, and otherwise NULL is returned. */
+static void *SymTable_delete(SymTable_T oSymTable,
+                             const unsigned char *pucKey, size_t uLength)
+{
+   void **ppvRef = &oSymTable->root;
+   void **ppvParent = NULL;
+   void **ppvChild;
+   struct Node *pNode;
+   struct Leaf *pLeaf;
+   void *pvValue;
+   size_t uDepth = 0;
+
+   for (;;) {
+      if (*ppvRef == NULL) {
+         return NULL;
+      }
+
+      if (SymTable_isLeaf(*ppvRef)) {
+         pLeaf = SymTable_asLeaf(*ppvRef);
+         if (pLeaf->tailLength != uLength - uDepth) {
+            return NULL;
+         }
+         oSymTable->compareCount++;
+         if (memcmp(pLeaf->tail, pucKey + uDepth, pLeaf->tailLength) != 0) {
+            return NULL;
+         }
+         pvValue = (void*)pLeaf->value;
+         if (ppvParent == NULL) {
+            *ppvRef = NULL;
+         } else {
+            SymTable_removeChild(*ppvParent, pucKey[uDepth - 1]);
+         }
+         SymTable_releaseLeaf(oSymTable, pLeaf);
+         oSymTable->size--;
+         if (ppvParent != NULL) {
+            SymTable_tidy(oSymTable, ppvParent);
+         }
+         return pvValue;
+      }
+
+      pNode = *ppvRef;
+      if (pNode->prefixLength > uLength - uDepth ||
+          memcmp(SymTable_prefixOf(pNode), pucKey + uDepth,
+                 pNode->prefixLength) != 0) {
+         return NULL;
+      }
+      uDepth += pNode->prefixLength;
+      if (uDepth == uLength) {
+         pLeaf = pNode->leaf;
+         if (pLeaf == NULL) {
+            return NULL;
+         }
+         pvValue = (void*)pLeaf->value;
+         pNode->leaf = NULL;
+         SymTable_releaseLeaf(oSymTable, pLeaf);
+         oSymTable->size--;
+         SymTable_tidy(oSymTable, ppvRef);
+         return pvValue;
+      }
+      ppvChild = SymTable_findChild(pNode, pucKey[uDepth]);
+      if (ppvChild == NULL) {
+         return NULL;
+      }
+      ppvParent = ppvRef;
+      ppvRef = ppvChild;
+      uDepth++;
+   }
+}
+
+/* SymTable_lookup takes in SymTable oSymTable, a key pucKey and its
+length uLength, and returns a pointer to the value of pucKey's binding,
+or NULL if there is none. Only the bytes that branch are looked at on
+the way down, and the prefixes and the tail are compared in full. */
+static const void **SymTable_lookup(SymTable_T oSymTable,
+                                    const unsigned char *pucKey,
+                                    size_t uLength)
+{
+   void *pvChild = oSymTable->root;
+   void **ppvChild;
+   struct Node *pNode;
+   struct Leaf *pLeaf;
+   size_t uDepth = 0;
+
+   while (pvChild != NULL) {
+      if (SymTable_isLeaf(pvChild)) {
+         pLeaf = SymTable_asLeaf(pvChild);
+         if (pLeaf->tailLength != uLength - uDepth) {
+            return NULL;
+         }
+         oSymTable->compareCount++;
+         if (memcmp(pLeaf->tail, pucKey + uDepth, pLeaf->tailLength) != 0) {
+            return NULL;
+         }
+         return &pLeaf->value;
+      }
+
+      pNode = pvChild;
+      if (pNode->prefixLength > uLength - uDepth ||
+          memcmp(SymTable_prefixOf(pNode), pucKey + uDepth,
+                 pNode->prefixLength) != 0) {
+         return NULL;
+      }
+      uDepth += pNode->prefixLength;
+      if (uDepth == uLength) {
+         return pNode->leaf == NULL ? NULL : &pNode->leaf->value;
+      }
+      ppvChild = SymTable_findChild(pNode, pucKey[uDepth]);
+      if (ppvChild == NULL) {
+         return NULL;
+      }
+      pvChild = *ppvChild;
+      uDepth++;
+   }
+   return NULL;
+}
+
+/* SymTable_first takes in a child pvChild, a buffer pcKey holding the
+uDepth bytes of the path to pvChild with room for the longest key, and
+a size_t pointer puLength. It writes the smallest key under pvChild
+into pcKey, sets *puLength to its length and returns its Leaf. */
+static struct Leaf *SymTable_first(void *pvChild, char *pcKey,
+                                   size_t uDepth, size_t *puLength)
+{
+   struct Node *pNode;
+   struct Leaf *pLeaf;
+   unsigned char ucByte;
+
+   for (;;) {
+      if (SymTable_isLeaf(pvChild)) {
+         pLeaf = SymTable_asLeaf(pvChild);
+         memcpy(pcKey + uDepth, pLeaf->tail, pLeaf->tailLength);
+         *puLength = uDepth + pLeaf->tailLength;
+         return pLeaf;
+      }
+      pNode = pvChild;
+      memcpy(pcKey + uDepth, SymTable_prefixOf(pNode), pNode->prefixLength);
+      uDepth += pNode->prefixLength;
+      /* a Node's own key starts every other key below it */
+      if (pNode->leaf != NULL) {
+         *puLength = uDepth;
+         return pNode->leaf;
+      }
+      pvChild = SymTable_nextChild(pNode, -1, &ucByte);
+      pcKey[uDepth++] = (char)ucByte;
+   }
+}
+
+/* SymTable_after takes in a child pvChild, a key pcKey of uLength
+bytes whose first uDepth bytes are the path to pvChild, with room for
+the longest key, and a size_t pointer puLength. It finds the smallest
+key under pvChild that is greater than pcKey. If there is one, it is
+written over pcKey, *puLength is set to its length and its Leaf is
+returned. Otherwise NULL is returned and pcKey is left as it was. */
+static struct Leaf *SymTable_after(void *pvChild, char *pcKey,
+                                   size_t uLength, size_t uDepth,
+                                   size_t *puLength)
+{
+   const unsigned char *pucKey = (const unsigned char *)pcKey;
+   struct Node *pNode;
+   struct Leaf *pLeaf;
+   void **ppvChild;
+   unsigned char ucByte;
+   size_t uShorter;
+   int iOrder;
+
+   if (SymTable_isLeaf(pvChild)) {
+      pLeaf = SymTable_asLeaf(pvChild);
+      uShorter = pLeaf->tailLength < uLength - uDepth ?
+                 pLeaf->tailLength : uLength - uDepth;
+      iOrder = memcmp(pLeaf->tail, pucKey + uDepth, uShorter);
+      if (iOrder < 0 ||
+          (iOrder == 0 && pLeaf->tailLength <= uLength - uDepth)) {
+         return NULL;
+      }
+      return SymTable_first(pvChild, pcKey, uDepth, puLength);
+   }
+
+   pNode = pvChild;
+   uShorter = pNode->prefixLength < uLength - uDepth ?
+              pNode->prefixLength : uLength - uDepth;
+   iOrder = memcmp(SymTable_prefixOf(pNode), pucKey + uDepth, uShorter);
+   if (iOrder < 0) {
+      return NULL;
+   }
+   /* if pcKey ends inside the prefix, it starts every key below */
+   if (iOrder > 0 || uShorter < pNode->prefixLength) {
+      return SymTable_first(pvChild, pcKey, uDepth, puLength);
+   }
+   uDepth += pNode->prefixLength;
+
+   /* pNode's own key is pcKey or starts it, so it is never greater.
+   If pcKey goes on, the child it goes on into may hold a greater key,
+   and otherwise the first child after it does. */
+   if (uDepth == uLength) {
+      pvChild = SymTable_nextChild(pNode, -1, &ucByte);
+   } else {
+      ppvChild = SymTable_findChild(pNode, pucKey[uDepth]);
+      if (ppvChild != NULL) {
+         pLeaf = SymTable_after(*ppvChild, pcKey, uLength, uDepth + 1,
+                                puLength);
+         if (pLeaf != NULL) {
+            return pLeaf;
+         }
+      }
+      pvChild = SymTable_nextChild(pNode, pucKey[uDepth], &ucByte);
+   }
+   if (pvChild == NULL) {
+      return NULL;
+   }
+   pcKey[uDepth] = (char)ucByte;
+   return SymTable_first(pvChild, pcKey, uDepth + 1, puLength);
+}
+
+/* SymTable_mapChild takes in a child pvChild, a buffer pcKey holding
+the uDepth bytes of the path to pvChild with room for the longest key,
+a function pfApply and pvExtra. It applies *pfApply to every binding
+under pvChild in ascending order of key, passing each key in pcKey
+followed by a '\0'. */
+static void SymTable_mapChild(void *pvChild, char *pcKey, size_t uDepth,
+                              void (*pfApply)(const char *pcKey,
+                                              void *pvValue,
+                                              void *pvExtra),
+                              const void *pvExtra)
+{
+   struct Node *pNode;
+   struct Leaf *pLeaf;
+   unsigned char ucByte;
+   int iAfter = -1;
+
+   if (SymTable_isLeaf(pvChild)) {
+      pLeaf = SymTable_asLeaf(pvChild);
+      memcpy(pcKey + uDepth, pLeaf->tail, pLeaf->tailLength);
+      pcKey[uDepth + pLeaf->tailLength] = '\0';
+      (*pfApply)(pcKey, (void*)pLeaf->value, (void*)pvExtra);
+      return;
+   }
+
+   pNode = pvChild;
+   memcpy(pcKey + uDepth, SymTable_prefixOf(pNode), pNode->prefixLength);
+   uDepth += pNode->prefixLength;
+   if (pNode->leaf != NULL) {
+      pcKey[uDepth] = '\0';
+      (*pfApply)(pcKey, (void*)pNode->leaf->value, (void*)pvExtra);
+   }
+   while ((pvChild = SymTable_nextChild(pNode, iAfter, &ucByte)) != NULL) {
+      pcKey[uDepth] = (char)ucByte;
+      SymTable_mapChild(pvChild, pcKey, uDepth + 1, pfApply, pvExtra);
+      iAfter = ucByte;
+   }
+}
+
+/* SymTable_saveChild takes in a child pvChild, a buffer pcKey holding
+the uDepth bytes of the path to pvChild with room for the longest key,
+and a SnapshotWriter oWriter. It adds every binding under pvChild to
+oWriter as SymTable_mapChild visits them, but with their lengths, so
+keys holding a '\0' are saved whole. It returns 1, or 0 if there is
+insufficient memory. */
+static int SymTable_saveChild(void *pvChild, char *pcKey, size_t uDepth,
+                              SnapshotWriter_T oWriter)
+{
+   struct Node *pNode;
+   struct Leaf *pLeaf;
+   unsigned char ucByte;
+   int iAfter = -1;
+
+   if (SymTable_isLeaf(pvChild)) {
+      pLeaf = SymTable_asLeaf(pvChild);
+      memcpy(pcKey + uDepth, pLeaf->tail, pLeaf->tailLength);
+      return SnapshotWriter_add(oWriter, pcKey,
+                                uDepth + pLeaf->tailLength,
+                                pLeaf->value);
+   }
+
+   pNode = pvChild;
+   memcpy(pcKey + uDepth, SymTable_prefixOf(pNode), pNode->prefixLength);
+   uDepth += pNode->prefixLength;
+   if (pNode->leaf != NULL &&
+       !SnapshotWriter_add(oWriter, pcKey, uDepth, pNode->leaf->value)) {
+      return 0;
+   }
+   while ((pvChild = SymTable_nextChild(pNode, iAfter, &ucByte)) != NULL) {
+      pcKey[uDepth] = (char)ucByte;
+      if (!SymTable_saveChild(pvChild, pcKey, uDepth + 1, oWriter)) {
+         return 0;
+      }
+      iAfter = ucByte;
+   }
+   return 1;
+}
+
+/* SymTable_bound takes in a path pucPath of uLength bytes whose first
+uFrom bytes are known to be the start of a bound pucBound, and the
+bound and its length uBoundLength. It returns -1 if every key that
+starts with pucPath is less than pucBound, 1 if every one is at least
+pucBound, and 0 if pucPath is a proper start of pucBound, so that
+only the key pucPath itself is known to be less. */
+static int SymTable_bound(const unsigned char *pucPath, size_t uFrom,
+                          size_t uLength, const unsigned char *pucBound,
+                          size_t uBoundLength)
+{
+   size_t i;
+
+   for (i = uFrom; i < uLength && i < uBoundLength; i++) {
+      if (pucPath[i] != pucBound[i]) {
+         return pucPath[i] < pucBound[i] ? -1 : 1;
+      }
+   }
+   return uLength >= uBoundLength ? 1 : 0;
+}
+
+/* SymTable_mapRangeChild takes in a RangeWalk pWalk, a child pvChild
+whose path is the first uDepth bytes of pWalk's key, and how many of
+those uChecked have been compared with the bounds. iAboveLow is 1 if
+every key under pvChild is known to be at least the low bound, and
+iBelowHigh is 1 if every one is known to be less than the high bound.
+It applies pWalk's function to the bindings under pvChild that are in
+range, in ascending order of key, and returns 1 once a key at or past
+the high bound is reached and 0 otherwise. */
+static int SymTable_mapRangeChild(struct RangeWalk *pWalk, void *pvChild,
+                                  size_t uDepth, size_t uChecked,
+                                  int iAboveLow, int iBelowHigh)
+{
+   unsigned char *pucKey = (unsigned char *)pWalk->key;
+   struct Node *pNode;
+   struct Leaf *pLeaf;
+   unsigned char ucByte;
+   int iAfter = -1;
+   int iOrder;
+
+   if (SymTable_isLeaf(pvChild)) {
+      pLeaf = SymTable_asLeaf(pvChild);
+      memcpy(pucKey + uDepth, pLeaf->tail, pLeaf->tailLength);
+      uDepth += pLeaf->tailLength;
+      if (!iAboveLow &&
+          SymTable_bound(pucKey, uChecked, uDepth, pWalk->low,
+                         pWalk->lowLength) != 1) {
+         return 0;
+      }
+      if (!iBelowHigh &&
+          SymTable_bound(pucKey, uChecked, uDepth, pWalk->high,
+                         pWalk->highLength) == 1) {
+         return 1;
+      }
+      pucKey[uDepth] = '\0';
+      (*pWalk->pfApply)(pWalk->key, (void*)pLeaf->value,
+                        (void*)pWalk->pvExtra);
+      return 0;
+   }
+
+   pNode = pvChild;
+   memcpy(pucKey + uDepth, SymTable_prefixOf(pNode), pNode->prefixLength);
+   uDepth += pNode->prefixLength;
+   if (!iAboveLow) {
+      iOrder = SymTable_bound(pucKey, uChecked, uDepth, pWalk->low,
+                              pWalk->lowLength);
+      if (iOrder < 0) {
+         return 0;
+      }
+      iAboveLow = iOrder > 0;
+   }
+   if (!iBelowHigh) {
+      iOrder = SymTable_bound(pucKey, uChecked, uDepth, pWalk->high,
+                              pWalk->highLength);
+      if (iOrder > 0) {
+         return 1;
+      }
+      iBelowHigh = iOrder < 0;
+   }
+
+   /* pNode's own key is below the high bound either way, and below
+   the low bound unless every key here is above it */
+   if (pNode->leaf != NULL && iAboveLow) {
+      pucKey[uDepth] = '\0';
+      (*pWalk->pfApply)(pWalk->key, (void*)pNode->leaf->value,
+                        (void*)pWalk->pvExtra);
+   }
+   while ((pvChild = SymTable_nextChild(pNode, iAfter, &ucByte)) != NULL) {
+      pucKey[uDepth] = ucByte;
+      if (SymTable_mapRangeChild(pWalk, pvChild, uDepth + 1, uDepth,
+                                 iAboveLow, iBelowHigh)) {
+         return 1;
+      }
+      iAfter = ucByte;
+   }
+   return 0;
+}
+
+/* SymTable_split takes in SymTable oSymTable, whose root is a Node, a
+MapJob pJob and a unit count uWanted. It splits the tree into at least
+uWanted subtrees, or as many as it can, by replacing every Node with
+its children (and its own binding) a level at a time, and sets pJob's
+units and paths. It returns how many units there are, or 0 if there is
+insufficient memory. */
+static size_t SymTable_split(SymTable_T oSymTable, struct MapJob *pJob,
+                             size_t uWanted)
+{
+   struct MapUnit *psUnits;
+   struct MapUnit *psNext;
+   unsigned char *pucPaths;
+   unsigned char *pucNext;
+   unsigned char *pucPath;
+   struct Node *pNode;
+   void *pvChild;
+   unsigned char ucByte;
+   size_t uCount = 1;
+   size_t uNextCount;
+   size_t uBytes;
+   size_t uPathLength;
+   size_t i;
+   int iAfter;
+   int iNodes;
+
+   psUnits = malloc(sizeof(struct MapUnit));
+   pucPaths = malloc(1);
+   if (psUnits == NULL || pucPaths == NULL) {
+      free(psUnits);
+      free(pucPaths);
+      return 0;
+   }
+   psUnits[0].child = oSymTable->root;
+   psUnits[0].pathStart = 0;
+   psUnits[0].pathLength = 0;
+
+   while (uCount < uWanted) {
+      /* the next level is sized first, so it takes one malloc */
+      uNextCount = 0;
+      uBytes = 1;
+      iNodes = 0;
+      for (i = 0; i < uCount; i++) {
+         if (SymTable_isLeaf(psUnits[i].child)) {
+            uNextCount++;
+            uBytes += psUnits[i].pathLength;
+            continue;
+         }
+         pNode = psUnits[i].child;
+         uPathLength = psUnits[i].pathLength + pNode->prefixLength;
+         uNextCount += pNode->count + (pNode->leaf != NULL);
+         uBytes += pNode->count * (uPathLength + 1) +
+                   (pNode->leaf != NULL ? uPathLength : 0);
+         iNodes = 1;
+      }
+      if (!iNodes) {
+         break;
+      }
+      psNext = malloc(uNextCount * sizeof(struct MapUnit));
+      pucNext = malloc(uBytes);
+      if (psNext == NULL || pucNext == NULL) {
+         free(psNext);
+         free(pucNext);
+         free(psUnits);
+         free(pucPaths);
+         return 0;
+      }
+
+      uNextCount = 0;
+      uBytes = 0;
+      for (i = 0; i < uCount; i++) {
+         pucPath = pucNext + uBytes;
+         memcpy(pucPath, pucPaths + psUnits[i].pathStart,
+                psUnits[i].pathLength);
+         if (SymTable_isLeaf(psUnits[i].child)) {
+            psNext[uNextCount] = psUnits[i];
+            psNext[uNextCount++].pathStart = uBytes;
+            uBytes += psUnits[i].pathLength;
+            continue;
+         }
+         pNode = psUnits[i].child;
+         memcpy(pucPath + psUnits[i].pathLength, SymTable_prefixOf(pNode),
+                pNode->prefixLength);
+         uPathLength = psUnits[i].pathLength + pNode->prefixLength;
+         if (pNode->leaf != NULL) {
+            psNext[uNextCount].child = SymTable_tagLeaf(pNode->leaf);
+            psNext[uNextCount].pathStart = uBytes;
+            psNext[uNextCount++].pathLength = uPathLength;
+            uBytes += uPathLength;
+         }
+         iAfter = -1;
+         while ((pvChild = SymTable_nextChild(pNode, iAfter, &ucByte))
+                != NULL) {
+            /* the first child's path may start where pucPath is */
+            memmove(pucNext + uBytes, pucPath, uPathLength);
+            pucNext[uBytes + uPathLength] = ucByte;
+            psNext[uNextCount].child = pvChild;
+            psNext[uNextCount].pathStart = uBytes;
+            psNext[uNextCount++].pathLength = uPathLength + 1;
+            uBytes += uPathLength + 1;
+            iAfter = ucByte;
+         }
+      }
+      free(psUnits);
+      free(pucPaths);
+      psUnits = psNext;
+      pucPaths = pucNext;
+      uCount = uNextCount;
+   }
+   pJob->units = psUnits;
+   pJob->paths = pucPaths;
+   return uCount;
+}
+
+/* SymTable_mapUnits takes in a range of unit numbers [uBegin, uEnd)
+and a void pointer pvJob to a MapJob, and maps the bindings of those
+units, building their keys in a buffer taken from the job */
+static void SymTable_mapUnits(size_t uBegin, size_t uEnd, void *pvJob)
+{
+   struct MapJob *pJob = pvJob;
+   struct MapUnit *psUnit;
+   char *pcKey;
+   size_t i;
+
+   pthread_mutex_lock(&pJob->lock);
+   assert(pJob->bufferCount > 0);
+   pcKey = pJob->buffers[--pJob->bufferCount];
+   pthread_mutex_unlock(&pJob->lock);
+
+   for (i = uBegin; i < uEnd; i++) {
+      psUnit = &pJob->units[i];
+      memcpy(pcKey, pJob->paths + psUnit->pathStart, psUnit->pathLength);
+      SymTable_mapChild(psUnit->child, pcKey, psUnit->pathLength,
+                        pJob->pfApply, pJob->pvExtra);
+   }
+
+   pthread_mutex_lock(&pJob->lock);
+   pJob->buffers[pJob->bufferCount++] = pcKey;
+   pthread_mutex_unlock(&pJob->lock);
+}
+
+SymTable_T SymTable_new(void){
+   struct SymTable *oSymTable = malloc(sizeof(struct SymTable));
+
+   if(oSymTable == NULL){
+      return NULL;
+   }
+   oSymTable->root = NULL;
+   oSymTable->size = 0;
+   oSymTable->compareCount = 0;
+   oSymTable->maxKeyLength = 0;
+   oSymTable->snapshot = NULL;
+   oSymTable->keyBuffer = malloc(1);
+   if(oSymTable->keyBuffer == NULL){
+      free(oSymTable);
+      return NULL;
+   }
+   oSymTable->allocCount = 2;
+   oSymTable->arena = Arena_new();
+   if(oSymTable->arena == NULL){
+      free(oSymTable->keyBuffer);
+      free(oSymTable);
+      return NULL;
+   }
+   return oSymTable;
+}
+
+SymTable_T SymTable_newWithOptions(enum SymTableHash eHash){
+   if (eHash != SYMTABLE_HASH_DEFAULT && eHash != SYMTABLE_HASH_FAST &&
+       eHash != SYMTABLE_HASH_SIPHASH) {
+      return NULL;
+   }
+   /* a radix tree branches on the bytes of the key instead of hashing
+   it, so every kind of hash gives the same SymTable */
+   return SymTable_new();
+}
+
+void SymTable_free(SymTable_T oSymTable){
+   assert(oSymTable != NULL);
+
+   /* every Node and Leaf lives in the arena */
+   Arena_free(oSymTable->arena);
+   free(oSymTable->keyBuffer);
+   Snapshot_close(oSymTable->snapshot);
+   free(oSymTable);
+}
+
+size_t SymTable_getLength(SymTable_T oSymTable){
+   assert(oSymTable != NULL);
+   if (oSymTable->snapshot != NULL) {
+      return Snapshot_getLength(oSymTable->snapshot);
+   }
+   return oSymTable->size;
+}
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey,
+                 const void *pvValue) {
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   return SymTable_putN(oSymTable, pcKey, strlen(pcKey), pvValue);
+}
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey,
+                       const void *pvValue){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   return SymTable_replaceN(oSymTable, pcKey, strlen(pcKey), pvValue);
+}
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   return SymTable_containsN(oSymTable, pcKey, strlen(pcKey));
+}
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   return SymTable_getN(oSymTable, pcKey, strlen(pcKey));
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   return SymTable_removeN(oSymTable, pcKey, strlen(pcKey));
+}
+
+int SymTable_putN(SymTable_T oSymTable, const void *pvKey,
+                  size_t uLength, const void *pvValue){
+   int iFound;
+
+   assert(oSymTable != NULL);
+   assert(pvKey != NULL);
+
+   return SymTable_add(oSymTable, pvKey, uLength, pvValue, &iFound)
+          != NULL && !iFound;
+}
+
+void *SymTable_replaceN(SymTable_T oSymTable, const void *pvKey,
+                        size_t uLength, const void *pvValue){
+   const void **ppvValue;
+   void *oldValue;
+
+   assert(oSymTable != NULL);
+   assert(pvKey != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      return NULL;
+   }
+   ppvValue = SymTable_lookup(oSymTable, pvKey, uLength);
+   if (ppvValue == NULL) {
+      return NULL;
+   }
+   oldValue = (void*)*ppvValue;
+   *ppvValue = pvValue;
+   return oldValue;
+}
+
+int SymTable_containsN(SymTable_T oSymTable, const void *pvKey,
+                       size_t uLength){
+   assert(oSymTable != NULL);
+   assert(pvKey != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      return Snapshot_find(oSymTable->snapshot, pvKey, uLength, NULL);
+   }
+   return SymTable_lookup(oSymTable, pvKey, uLength) != NULL;
+}
+
+void *SymTable_getN(SymTable_T oSymTable, const void *pvKey,
+                    size_t uLength){
+   const void **ppvValue;
+   void *pvValue;
+
+   assert(oSymTable != NULL);
+   assert(pvKey != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      if (!Snapshot_find(oSymTable->snapshot, pvKey, uLength, &pvValue)) {
+         return NULL;
+      }
+      return pvValue;
+   }
+   ppvValue = SymTable_lookup(oSymTable, pvKey, uLength);
+   if (ppvValue == NULL) {
+      return NULL;
+   }
+   return (void*)*ppvValue;
+}
+
+void *SymTable_removeN(SymTable_T oSymTable, const void *pvKey,
+                       size_t uLength){
+   assert(oSymTable != NULL);
+   assert(pvKey != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      return NULL;
+   }
+   return SymTable_delete(oSymTable, pvKey, uLength);
+}
+
+void SymTable_map(SymTable_T oSymTable,
+                  void (*pfApply)(const char *pcKey,
+                                  void *pvValue, void *pvExtra),
+                  const void *pvExtra){
+   assert(oSymTable != NULL);
+   assert(pfApply != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      Snapshot_map(oSymTable->snapshot, pfApply, pvExtra);
+      return;
+   }
+   /* the keys are built in keyBuffer, so each one is only valid
+   during its call of pfApply */
+   if (oSymTable->root != NULL) {
+      SymTable_mapChild(oSymTable->root, oSymTable->keyBuffer, 0,
+                        pfApply, pvExtra);
+   }
+}
+
+void SymTable_getCounts(SymTable_T oSymTable, size_t *puRehashes,
+                        size_t *puCompares){
+   assert(oSymTable != NULL);
+   assert(puRehashes != NULL);
+   assert(puCompares != NULL);
+
+   /* a radix tree is never rehashed: a full node is replaced by a
+   bigger one, and nothing else moves */
+   *puRehashes = 0;
+   *puCompares = oSymTable->compareCount;
+}
+
+int SymTable_setMaxLoad(SymTable_T oSymTable, double dMaxLoad){
+   assert(oSymTable != NULL);
+
+   /* a radix tree has no buckets, so any positive load factor is
+   accepted and has no effect */
+   return dMaxLoad > 0.0;
+}
+
+int SymTable_setIncremental(SymTable_T oSymTable, int iIncremental){
+   assert(oSymTable != NULL);
+
+   /* a radix tree grows a node at a time, so it is always incremental
+   and there is no mode to switch */
+   return iIncremental == 0;
+}
+
+size_t SymTable_getAllocCount(SymTable_T oSymTable){
+   assert(oSymTable != NULL);
+   return oSymTable->allocCount + Arena_getAllocCount(oSymTable->arena);
+}
+
+size_t SymTable_getBytes(SymTable_T oSymTable){
+   assert(oSymTable != NULL);
+   return sizeof(struct SymTable) + oSymTable->maxKeyLength + 1 +
+          Arena_getBytes(oSymTable->arena) +
+          (oSymTable->snapshot != NULL ?
+           Snapshot_getBytes(oSymTable->snapshot) : 0);
+}
+
+int SymTable_putAtom(SymTable_T oSymTable, const char *pcAtom,
+                     const void *pvValue){
+   assert(oSymTable != NULL);
+   assert(pcAtom != NULL);
+
+   /* the atom's length saves the strlen, but the tree keeps the key's
+   bytes along its path, not the atom */
+   return SymTable_putN(oSymTable, pcAtom, Atom_getLength(pcAtom),
+                        pvValue);
+}
+
+void *SymTable_getAtom(SymTable_T oSymTable, const char *pcAtom){
+   assert(oSymTable != NULL);
+   assert(pcAtom != NULL);
+
+   return SymTable_getN(oSymTable, pcAtom, Atom_getLength(pcAtom));
+}
+
+int SymTable_putBorrowed(SymTable_T oSymTable, const char *pcKey,
+                         const void *pvValue){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   /* a Leaf holds only the end of its key, which costs no more than
+   a pointer to the client's copy would */
+   return SymTable_put(oSymTable, pcKey, pvValue);
+}
+
+void **SymTable_getOrPut(SymTable_T oSymTable, const char *pcKey,
+                         const void *pvValue, int *piFound){
+   const void **ppvValue;
+   int iFound;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   ppvValue = SymTable_add(oSymTable, (const unsigned char *)pcKey,
+                           strlen(pcKey), pvValue, &iFound);
+   if (ppvValue == NULL) {
+      return NULL;
+   }
+   if (piFound != NULL) {
+      *piFound = iFound;
+   }
+   return (void **)ppvValue;
+}
+
+int SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+                    const void *pvValue, void **ppvOldValue){
+   void **ppvValue;
+   int iFound;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   ppvValue = SymTable_getOrPut(oSymTable, pcKey, pvValue, &iFound);
+   if (ppvValue == NULL) {
+      return 0;
+   }
+   if (ppvOldValue != NULL) {
+      *ppvOldValue = iFound ? *ppvValue : NULL;
+   }
+   *ppvValue = (void*)pvValue;
+   return 1;
+}
+
+int SymTable_putHashed(SymTable_T oSymTable, const char *pcKey,
+                       size_t uHash, const void *pvValue){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   /* a radix tree has no use for the hash */
+   (void)uHash;
+   return SymTable_put(oSymTable, pcKey, pvValue);
+}
+
+void *SymTable_getHashed(SymTable_T oSymTable, const char *pcKey,
+                         size_t uHash){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   (void)uHash;
+   return SymTable_get(oSymTable, pcKey);
+}
+
+int SymTable_containsHashed(SymTable_T oSymTable, const char *pcKey,
+                            size_t uHash){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   (void)uHash;
+   return SymTable_contains(oSymTable, pcKey);
+}
+
+void *SymTable_removeHashed(SymTable_T oSymTable, const char *pcKey,
+                            size_t uHash){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   (void)uHash;
+   return SymTable_remove(oSymTable, pcKey);
+}
+
+void SymTable_getMany(SymTable_T oSymTable, const char *const apcKeys[],
+                      size_t uCount, void *apvValues[]){
+   size_t i;
+
+   assert(oSymTable != NULL);
+   assert(uCount == 0 || (apcKeys != NULL && apvValues != NULL));
+
+   /* each node on the way down depends on the byte before, so there
+   is nothing to start loading early and each key is looked up in
+   turn */
+   for (i = 0; i < uCount; i++) {
+      apvValues[i] = SymTable_get(oSymTable, apcKeys[i]);
+   }
+}
+
+void SymTable_mapParallel(SymTable_T oSymTable,
+                          void (*pfApply)(const char *pcKey,
+                                          void *pvValue, void *pvExtra),
+                          const void *pvExtra, size_t uThreads){
+   struct MapJob sJob;
+   size_t uWanted;
+   size_t uCount;
+   size_t i;
+
+   assert(oSymTable != NULL);
+   assert(pfApply != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      Snapshot_mapParallel(oSymTable->snapshot, pfApply, pvExtra,
+                           uThreads);
+      return;
+   }
+   if (uThreads <= 1 || oSymTable->root == NULL ||
+       SymTable_isLeaf(oSymTable->root)) {
+      SymTable_map(oSymTable, pfApply, pvExtra);
+      return;
+   }
+   uWanted = uThreads > (size_t)-1 / MAP_UNITS_PER_THREAD ?
+             (size_t)-1 : uThreads * MAP_UNITS_PER_THREAD;
+   uCount = SymTable_split(oSymTable, &sJob, uWanted);
+   if (uCount == 0) {
+      SymTable_map(oSymTable, pfApply, pvExtra);
+      return;
+   }
+   /* no more ranges than units run at once, so no more buffers than
+   that are needed */
+   if (uThreads > uCount) {
+      uThreads = uCount;
+   }
+   sJob.pfApply = pfApply;
+   sJob.pvExtra = pvExtra;
+   sJob.bufferCount = 0;
+   sJob.buffers = malloc(uThreads * sizeof(char *));
+   if (sJob.buffers != NULL) {
+      while (sJob.bufferCount < uThreads) {
+         sJob.buffers[sJob.bufferCount] =
+            malloc(oSymTable->maxKeyLength + 1);
+         if (sJob.buffers[sJob.bufferCount] == NULL) {
+            break;
+         }
+         sJob.bufferCount++;
+      }
+   }
+   if (sJob.bufferCount == uThreads &&
+       pthread_mutex_init(&sJob.lock, NULL) == 0) {
+      Parallel_forRange(uCount, uThreads, SymTable_mapUnits, &sJob);
+      pthread_mutex_destroy(&sJob.lock);
+   } else {
+      SymTable_map(oSymTable, pfApply, pvExtra);
+   }
+
+   for (i = 0; i < sJob.bufferCount; i++) {
+      free(sJob.buffers[i]);
+   }
+   free(sJob.buffers);
+   free(sJob.units);
+   free(sJob.paths);
+}
+
+SymTableIter_T SymTable_iterBegin(SymTable_T oSymTable){
+   struct SymTableIter *pIter;
+
+   assert(oSymTable != NULL);
+
+   pIter = malloc(sizeof(struct SymTableIter));
+   if (pIter == NULL) {
+      return NULL;
+   }
+   pIter->oSymTable = oSymTable;
+   pIter->key = NULL;
+   pIter->keyLength = 0;
+   pIter->keySize = 0;
+   pIter->started = 0;
+   pIter->snapshotIndex = 0;
+   return pIter;
+}
+
+int SymTable_iterNext(SymTableIter_T oIter, const char **ppcKey,
+                      void **ppvValue){
+   SymTable_T oSymTable;
+   struct Leaf *pLeaf;
+   char *pcKey;
+
+   assert(oIter != NULL);
+
+   oSymTable = oIter->oSymTable;
+   if (oSymTable->snapshot != NULL) {
+      if (oIter->snapshotIndex == Snapshot_getLength(oSymTable->snapshot)) {
+         return 0;
+      }
+      Snapshot_getBinding(oSymTable->snapshot, oIter->snapshotIndex++,
+                          ppcKey, NULL, ppvValue);
+      return 1;
+   }
+   if (oSymTable->root == NULL) {
+      return 0;
+   }
+   /* the next key is no longer than the longest key ever put */
+   if (oIter->keySize < oSymTable->maxKeyLength + 1) {
+      pcKey = realloc(oIter->key, oSymTable->maxKeyLength + 1);
+      if (pcKey == NULL) {
+         return 0;
+      }
+      oIter->key = pcKey;
+      oIter->keySize = oSymTable->maxKeyLength + 1;
+   }
+
+   if (!oIter->started) {
+      pLeaf = SymTable_first(oSymTable->root, oIter->key, 0,
+                             &oIter->keyLength);
+   } else {
+      pLeaf = SymTable_after(oSymTable->root, oIter->key,
+                             oIter->keyLength, 0, &oIter->keyLength);
+   }
+   if (pLeaf == NULL) {
+      return 0;
+   }
+   oIter->started = 1;
+   oIter->key[oIter->keyLength] = '\0';
+
+   if (ppcKey != NULL) {
+      *ppcKey = oIter->key;
+   }
+   if (ppvValue != NULL) {
+      *ppvValue = (void*)pLeaf->value;
+   }
+   return 1;
+}
+
+void SymTable_iterEnd(SymTableIter_T oIter){
+   assert(oIter != NULL);
+
+   free(oIter->key);
+   free(oIter);
+}
+
+void SymTable_mapRange(SymTable_T oSymTable, const char *pcLow,
+                       const char *pcHigh,
+                       void (*pfApply)(const char *pcKey,
+                                       void *pvValue, void *pvExtra),
+                       const void *pvExtra){
+   struct RangeWalk sWalk;
+
+   assert(oSymTable != NULL);
+   assert(pfApply != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      Snapshot_mapRange(oSymTable->snapshot, pcLow, pcHigh, pfApply,
+                        pvExtra);
+      return;
+   }
+   if (oSymTable->root == NULL) {
+      return;
+   }
+   sWalk.low = (const unsigned char *)pcLow;
+   sWalk.lowLength = pcLow == NULL ? 0 : strlen(pcLow);
+   sWalk.high = (const unsigned char *)pcHigh;
+   sWalk.highLength = pcHigh == NULL ? 0 : strlen(pcHigh);
+   sWalk.pfApply = pfApply;
+   sWalk.pvExtra = pvExtra;
+   sWalk.key = oSymTable->keyBuffer;
+   /* only the subtrees that straddle a bound are looked into, and the
+   rest are either skipped or mapped whole */
+   SymTable_mapRangeChild(&sWalk, oSymTable->root, 0, 0, pcLow == NULL,
+                          pcHigh == NULL);
+}
+
+void SymTable_mapPrefix(SymTable_T oSymTable, const char *pcPrefix,
+                        void (*pfApply)(const char *pcKey,
+                                        void *pvValue, void *pvExtra),
+                        const void *pvExtra){
+   const unsigned char *pucPrefix = (const unsigned char *)pcPrefix;
+   char *pcKey;
+   void *pvChild;
+   void **ppvChild;
+   struct Node *pNode;
+   struct Leaf *pLeaf;
+   size_t uLength;
+   size_t uDepth = 0;
+   size_t uShorter;
+
+   assert(oSymTable != NULL);
+   assert(pcPrefix != NULL);
+   assert(pfApply != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      Snapshot_mapPrefix(oSymTable->snapshot, pcPrefix, pfApply,
+                         pvExtra);
+      return;
+   }
+   /* the keys that start with pcPrefix are the ones under the first
+   child whose path is at least as long as pcPrefix */
+   uLength = strlen(pcPrefix);
+   pcKey = oSymTable->keyBuffer;
+   pvChild = oSymTable->root;
+   while (pvChild != NULL) {
+      if (SymTable_isLeaf(pvChild)) {
+         pLeaf = SymTable_asLeaf(pvChild);
+         if (pLeaf->tailLength >= uLength - uDepth &&
+             memcmp(pLeaf->tail, pucPrefix + uDepth,
+                    uLength - uDepth) == 0) {
+            SymTable_mapChild(pvChild, pcKey, uDepth, pfApply, pvExtra);
+         }
+         return;
+      }
+      pNode = pvChild;
+      uShorter = pNode->prefixLength < uLength - uDepth ?
+                 pNode->prefixLength : uLength - uDepth;
+      if (memcmp(SymTable_prefixOf(pNode), pucPrefix + uDepth,
+                 uShorter) != 0) {
+         return;
+      }
+      if (uShorter == uLength - uDepth) {
+         SymTable_mapChild(pvChild, pcKey, uDepth, pfApply, pvExtra);
+         return;
+      }
+      memcpy(pcKey + uDepth, SymTable_prefixOf(pNode),
+             pNode->prefixLength);
+      uDepth += pNode->prefixLength;
+      ppvChild = SymTable_findChild(pNode, pucPrefix[uDepth]);
+      if (ppvChild == NULL) {
+         return;
+      }
+      pcKey[uDepth] = pcPrefix[uDepth];
+      uDepth++;
+      pvChild = *ppvChild;
+   }
+}
+
+int SymTable_save(SymTable_T oSymTable, const char *pcPath,
+                  size_t uValueSize){
+   SnapshotWriter_T oWriter;
+
+   assert(oSymTable != NULL);
+   assert(pcPath != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      return Snapshot_save(oSymTable->snapshot, pcPath, uValueSize);
+   }
+   oWriter = SnapshotWriter_new(uValueSize);
+   if (oWriter == NULL) {
+      return 0;
+   }
+   if (oSymTable->root != NULL &&
+       !SymTable_saveChild(oSymTable->root, oSymTable->keyBuffer, 0,
+                           oWriter)) {
+      SnapshotWriter_free(oWriter);
+      return 0;
+   }
+   return SnapshotWriter_finish(oWriter, pcPath);
+}
+
+SymTable_T SymTable_openMapped(const char *pcPath){
+   SymTable_T oSymTable;
+
+   assert(pcPath != NULL);
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL) {
+      return NULL;
+   }
+   oSymTable->snapshot = Snapshot_open(pcPath);
+   if (oSymTable->snapshot == NULL) {
+      SymTable_free(oSymTable);
+      return NULL;
+   }
+   oSymTable->allocCount++;
+   return oSymTable;
+}
+
+SymTable_T SymTable_newWithCapacity(size_t uCapacity){
+   SymTable_T oSymTable;
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL) {
+      return NULL;
+   }
+   if (! SymTable_reserve(oSymTable, uCapacity)) {
+      SymTable_free(oSymTable);
+      return NULL;
+   }
+   return oSymTable;
+}
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity){
+   size_t uNewLeaves;
+
+   assert(oSymTable != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      return 0;
+   }
+   /* a radix tree has no buckets. Every binding has a Leaf, so the
+   arena gets room for that many with short tails; the Nodes above
+   them depend on how the keys branch and are made as they come. */
+   if (uCapacity <= oSymTable->size) {
+      return 1;
+   }
+   uNewLeaves = uCapacity - oSymTable->size;
+   if (uNewLeaves > (size_t)-1 / sizeof(struct Leaf)) {
+      return 0;
+   }
+   return Arena_reserve(oSymTable->arena,
+                        uNewLeaves * sizeof(struct Leaf));
+}
+
+/* SymTable_copyChild takes in a SymTable oNew being built by
+SymTable_compact and a child pvChild, and returns a copy of pvChild
+and everything under it from oNew's arena, or NULL if there is
+insufficient memory. Each Node in the copy is of the smallest kind
+with room for its children, and each prefix and tail has room for
+just the bytes it holds. */
+static void *SymTable_copyChild(SymTable_T oNew, void *pvChild)
+{
+   struct Node *pNode;
+   struct Node *pNew;
+   struct Leaf *pLeaf;
+   void *pvCopy;
+   unsigned char ucByte;
+   int iKind = NODE4;
+   int iAfter = -1;
+
+   if (SymTable_isLeaf(pvChild)) {
+      pLeaf = SymTable_asLeaf(pvChild);
+      pLeaf = SymTable_newLeaf(oNew, pLeaf->tail, pLeaf->tailLength,
+                               pLeaf->tailLength, pLeaf->value);
+      return pLeaf == NULL ? NULL : SymTable_tagLeaf(pLeaf);
+   }
+
+   pNode = pvChild;
+   while (auCapacity[iKind] < pNode->count) {
+      iKind++;
+   }
+   pNew = SymTable_resize(oNew, pNode, iKind, pNode->prefixLength);
+   if (pNew == NULL) {
+      return NULL;
+   }
+   if (pNode->leaf != NULL) {
+      pNew->leaf = SymTable_newLeaf(oNew, pNode->leaf->tail,
+                                    pNode->leaf->tailLength,
+                                    pNode->leaf->tailLength,
+                                    pNode->leaf->value);
+      if (pNew->leaf == NULL) {
+         return NULL;
+      }
+   }
+   /* pNew's children are still pNode's until they are copied too */
+   while ((pvChild = SymTable_nextChild(pNew, iAfter, &ucByte)) != NULL) {
+      pvCopy = SymTable_copyChild(oNew, pvChild);
+      if (pvCopy == NULL) {
+         return NULL;
+      }
+      *SymTable_findChild(pNew, ucByte) = pvCopy;
+      iAfter = ucByte;
+   }
+   return pNew;
+}
+
+int SymTable_compact(SymTable_T oSymTable){
+   struct SymTable sNew;
+
+   assert(oSymTable != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      return 0;
+   }
+   /* the iterators keep their own copies of their keys, so they find
+   their place in the copy as they would after any other change */
+   sNew = *oSymTable;
+   sNew.arena = Arena_new();
+   if (sNew.arena == NULL) {
+      return 0;
+   }
+   if (oSymTable->root != NULL) {
+      sNew.root = SymTable_copyChild(&sNew, oSymTable->root);
+      if (sNew.root == NULL) {
+         Arena_free(sNew.arena);
+         return 0;
+      }
+   }
+   sNew.allocCount += Arena_getAllocCount(oSymTable->arena);
+   Arena_free(oSymTable->arena);
+   *oSymTable = sNew;
+   return 1;
+}
+
+SymTable_T SymTable_newWithStats(enum SymTableHash eHash){
+   /* a tree has no buckets to probe and never expands, so there is
+   nothing more to count */
+   return SymTable_newWithOptions(eHash);
+}
+
+int SymTable_getStats(SymTable_T oSymTable,
+                      struct SymTableStats *psStats){
+   assert(oSymTable != NULL);
+   assert(psStats != NULL);
+
+   Stats_clear(psStats);
+   psStats->allocCount = SymTable_getAllocCount(oSymTable);
+   psStats->bytes = SymTable_getBytes(oSymTable);
+   return 0;
+}
@@ -0,0 +1,170 @@
+/* symtable atom pool implementation */
+#include "symtable.h"
+#include "symtableatom.h"
+#include "symtablearena.h"
+#include <stdlib.h>
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+
+/* denotes the min value for the number of slots in the pool. The
+slot count is always a power of two. */
+enum SlotEnds {slotMin = 1024};
+
+/* Atom is how an atom is laid out in the pool's arena: the hash and
+length of the string, followed by the string itself. SymTable_intern
+hands out a pointer to string. */
+struct Atom {
+    /* Atom_hashString of the string */
+    size_t hash;
+    /* strlen of the string */
+    size_t length;
+    /* the characters of the string, including the '\0' */
+    char string[1];
+};
+
+/* AtomPool is the one global set of atoms: an open addressing table
+of Atom pointers and the arena the Atoms are allocated from */
+struct AtomPool {
+    /* array of slotCount Atom pointers, NULL for an empty slot */
+    struct Atom **slots;
+    /* holds how many slots are in the pool */
+    size_t slotCount;
+    /* keeps track of how many Atoms are in the pool */
+    size_t atomCount;
+    /* the Arena that every Atom is allocated from */
+    Arena_T arena;
+};
+
+/* the global pool. It is created by the first SymTable_intern. */
+static struct AtomPool atomPool = {NULL, 0, 0, NULL};
+
+size_t Atom_hashString(const char *pcKey)
+{
+   const size_t HASH_MULTIPLIER = 65599;
+   size_t u;
+   size_t uHash = 0;
+
+   assert(pcKey != NULL);
+
+   /* hash function */
+   for (u = 0; pcKey[u] != '\0'; u++)
+      uHash = uHash * HASH_MULTIPLIER + (size_t)pcKey[u];
+
+   return uHash;
+}
+
+size_t Atom_hashBytes(const void *pvKey, size_t uLength)
+{
+   const size_t HASH_MULTIPLIER = 65599;
+   const char *pcKey = pvKey;
+   size_t u;
+   size_t uHash = 0;
+
+   assert(pvKey != NULL);
+
+   /* the same hash function as Atom_hashString, so a string and its
+   bytes hash alike */
+   for (u = 0; u < uLength; u++)
+      uHash = uHash * HASH_MULTIPLIER + (size_t)pcKey[u];
+
+   return uHash;
+}
+
+size_t SymTable_hashKey(const char *pcKey)
+{
+   assert(pcKey != NULL);
+
+   return Atom_hashString(pcKey);
+}
+
+size_t Atom_getLength(const char *pcAtom)
+{
+   assert(pcAtom != NULL);
+
+   return ((const struct Atom *)
+           (pcAtom - offsetof(struct Atom, string)))->length;
+}
+
+size_t Atom_getHash(const char *pcAtom)
+{
+   assert(pcAtom != NULL);
+
+   return ((const struct Atom *)
+           (pcAtom - offsetof(struct Atom, string)))->hash;
+}
+
+/* Atom_grow doubles the number of slots in the pool (or creates the
+pool) and reinserts every Atom. It returns 0 if there is insufficient
+memory and leaves the pool unchanged, and 1 otherwise. */
+static int Atom_grow(void)
+{
+   struct Atom **newSlots;
+   size_t uNewCount;
+   size_t i;
+   size_t uSlot;
+
+   if (atomPool.arena == NULL) {
+      atomPool.arena = Arena_new();
+      if (atomPool.arena == NULL) {
+         return 0;
+      }
+   }
+
+   uNewCount = (atomPool.slotCount == 0) ? slotMin
+                                         : 2 * atomPool.slotCount;
+   newSlots = calloc(uNewCount, sizeof(struct Atom *));
+   if (newSlots == NULL) {
+      return 0;
+   }
+   for (i = 0; i < atomPool.slotCount; i++) {
+      if (atomPool.slots[i] == NULL)
+         continue;
+      uSlot = atomPool.slots[i]->hash & (uNewCount - 1);
+      while (newSlots[uSlot] != NULL)
+         uSlot = (uSlot + 1) & (uNewCount - 1);
+      newSlots[uSlot] = atomPool.slots[i];
+   }
+   free(atomPool.slots);
+   atomPool.slots = newSlots;
+   atomPool.slotCount = uNewCount;
+   return 1;
+}
+
+const char *SymTable_intern(const char *pcKey){
+   size_t uHash;
+   size_t uSlot;
+   size_t uKeySize;
+   struct Atom *currAtom;
+
+   assert(pcKey != NULL);
+
+   /* keep the pool at most half full so probes stay short */
+   if (2 * (atomPool.atomCount + 1) > atomPool.slotCount) {
+      if (! Atom_grow()) {
+         return NULL;
+      }
+   }
+
+   uKeySize = strlen(pcKey) + 1;
+   uHash = Atom_hashBytes(pcKey, uKeySize - 1);
+   uSlot = uHash & (atomPool.slotCount - 1);
+   while ((currAtom = atomPool.slots[uSlot]) != NULL) {
+      if (currAtom->hash == uHash && currAtom->length == uKeySize - 1 &&
+          memcmp(currAtom->string, pcKey, uKeySize) == 0)
+         return currAtom->string;
+      uSlot = (uSlot + 1) & (atomPool.slotCount - 1);
+   }
+
+   currAtom = Arena_alloc(atomPool.arena,
+                          offsetof(struct Atom, string) + uKeySize);
+   if (currAtom == NULL) {
+      return NULL;
+   }
+   currAtom->hash = uHash;
+   currAtom->length = uKeySize - 1;
+   memcpy(currAtom->string, pcKey, uKeySize);
+   atomPool.slots[uSlot] = currAtom;
+   atomPool.atomCount++;
+   return currAtom->string;
+}
@@ -0,0 +1,30 @@
+/* symtable atom header file */
+#include <stddef.h>
+#ifndef SYMTABLEATOM_INCLUDED
+#define SYMTABLEATOM_INCLUDED
+
+/* An atom is the canonical copy of a string returned by
+SymTable_intern (see symtable.h). Atoms live in one global pool for
+the life of the program, and each one carries the hash of its string
+so SymTable implementations never have to hash it again. */
+
+/* Atom_hashString takes in a const char pointer pcKey and returns the
+hash of pcKey from the assignment specification (multiplier 65599),
+before it is reduced to a bucket. This is the hash every atom
+carries. */
+size_t Atom_hashString(const char *pcKey);
+
+/* Atom_hashBytes takes in a const void pointer pvKey to uLength bytes
+and returns the same hash as Atom_hashString would for a string of
+those bytes, so length delimited keys and strings hash alike */
+size_t Atom_hashBytes(const void *pvKey, size_t uLength);
+
+/* Atom_getHash takes in an atom pcAtom returned by SymTable_intern
+and returns Atom_hashString(pcAtom) without reading the string */
+size_t Atom_getHash(const char *pcAtom);
+
+/* Atom_getLength takes in an atom pcAtom returned by SymTable_intern
+and returns strlen(pcAtom) without reading the string */
+size_t Atom_getLength(const char *pcAtom);
+
+#endif
@@ -0,0 +1,1817 @@
+/* symtable B+ tree implementation */
+#include "symtable.h"
+#include "symtablearena.h"
+#include "symtableatom.h"
+#include "symtableparallel.h"
+#include "symtablesnapshot.h"
+#include "symtablestats.h"
+#include <stdlib.h>
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/* the most bindings a Leaf holds and the most children an Inner node
+has. A node that gets one more is split in two, and a node other than
+the root that drops below half of that is refilled from a neighbour
+or merged with it. */
+enum {LEAF_SIZE = 32, INNER_SIZE = 32};
+
+/* the fewest bindings (children) a Leaf (Inner node) other than the
+root is left with, and how many a split node keeps */
+enum {LEAF_MIN = LEAF_SIZE / 2, INNER_MIN = INNER_SIZE / 2,
+      LEAF_SPLIT = (LEAF_SIZE + 1) / 2,
+      INNER_SPLIT = (INNER_SIZE + 1) / 2};
+
+/* how many leading bytes of a key are packed into its prefix */
+enum {PREFIX_SIZE = 8};
+
+/* the most levels of Inner nodes a tree can have. Every Inner node
+but the root has at least INNER_MIN children, so no tree that fits in
+memory comes close. */
+enum {MAX_HEIGHT = 32};
+
+/* how a binding holds its key: a copy owned by the SymTable, an atom
+from SymTable_intern, or a key borrowed from the client by
+SymTable_putBorrowed. Only copies are released by the SymTable. */
+enum KeyKinds {KEY_COPY = 0, KEY_ATOM = 1, KEY_BORROWED = 2};
+
+/* Leaf holds up to LEAF_SIZE bindings in ascending order of key, in
+parallel arrays so a search reads only the prefixes and the keys it
+needs. Each array has a spare slot, so a binding can go into a full
+Leaf before it is split. The Leaves are linked in order, so a scan
+never goes back up the tree. */
+struct Leaf {
+    /* how many bindings the Leaf holds */
+    size_t count;
+    /* the Leaf with the next larger keys, or NULL for the last one */
+    struct Leaf *next;
+    /* the prefix of each key (see SymTable_prefix), which settles
+    most comparisons without following the key pointer */
+    uint64_t prefixes[LEAF_SIZE + 1];
+    /* the keys: a copy in the arena followed by a '\0', an atom or a
+    borrowed key */
+    const char *keys[LEAF_SIZE + 1];
+    /* how many bytes are in each key, not counting the '\0' */
+    size_t lengths[LEAF_SIZE + 1];
+    /* the values */
+    const void *values[LEAF_SIZE + 1];
+    /* KEY_COPY, KEY_ATOM or KEY_BORROWED for each key */
+    unsigned char kinds[LEAF_SIZE + 1];
+};
+
+/* Inner holds up to INNER_SIZE children and the separators between
+them. Separator i is greater than every key under child i and not
+greater than any key under child i + 1. It is a copy owned by the
+node, cut down to the shortest start of a key that does that. */
+struct Inner {
+    /* how many children the node has */
+    size_t count;
+    /* the prefix of each separator */
+    uint64_t prefixes[INNER_SIZE];
+    /* the separators, not '\0' terminated */
+    const char *keys[INNER_SIZE];
+    /* how many bytes are in each separator */
+    size_t lengths[INNER_SIZE];
+    /* the children: Leaves if the node is on the lowest level of
+    Inner nodes, otherwise Inner nodes */
+    void *children[INNER_SIZE + 1];
+};
+
+/* SymTable is a B+ tree: Inner nodes over a level of Leaves that hold
+every binding */
+struct SymTable {
+    /* the root: a Leaf if height is 0, and an Inner node otherwise */
+    void *root;
+    /* how many levels of Inner nodes are above the Leaves */
+    size_t height;
+    /* how many bindings are in the SymTable */
+    size_t size;
+    /* how many times keys have been compared with memcmp */
+    size_t compareCount;
+    /* how many times the SymTable has called malloc for itself and
+    the arenas SymTable_compact has replaced */
+    size_t allocCount;
+    /* the Arena that every node, key copy and separator is allocated
+    from */
+    Arena_T arena;
+    /* the iterators that have not been ended, linked by their
+    nextIter fields */
+    struct SymTableIter *iters;
+    /* the mapped snapshot that a SymTable from SymTable_openMapped
+    answers from, or NULL */
+    Snapshot_T snapshot;
+};
+
+/* Probe is a key being searched for, with its prefix worked out once
+for the whole search */
+struct Probe {
+    /* the bytes of the key */
+    const char *key;
+    /* how many bytes are in key */
+    size_t length;
+    /* SymTable_prefix of key */
+    uint64_t prefix;
+};
+
+/* Path is the way from the root down to a Leaf: the Inner node on
+each level, the root first, and which of its children was taken */
+struct Path {
+    /* the Inner node on each level */
+    struct Inner *nodes[MAX_HEIGHT];
+    /* the index of the child taken from each node */
+    size_t indices[MAX_HEIGHT];
+};
+
+/* MapJob is what the threads of SymTable_mapParallel share: the
+Leaves in order and the function to apply */
+struct MapJob {
+    /* every Leaf of the SymTable, in order */
+    struct Leaf **leaves;
+    /* the function applied to every binding */
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra);
+    /* passed on to pfApply */
+    const void *pvExtra;
+};
+
+/* BuildNode is a node of the level of a tree that SymTable_compact is
+building, with the separator between it and the node before it */
+struct BuildNode {
+    /* a Leaf or an Inner node */
+    void *node;
+    /* the separator between the node before and this one, or NULL
+    for the first node of the level */
+    const char *separator;
+    /* how many bytes are in separator */
+    size_t length;
+};
+
+/* SymTableIter is an iterator over the bindings of a SymTable, in
+ascending order of key. A put or remove may move bindings to other
+Leaves, so after one the iterator finds its place again by searching
+for the key it returned last. Only a remove can take that key away,
+and it then moves the iterator back to the key before. */
+struct SymTableIter {
+    /* the SymTable being iterated over */
+    SymTable_T oSymTable;
+    /* the Leaf of the binding returned next, or NULL if the iterator
+    has to find its place again */
+    struct Leaf *leaf;
+    /* the index of the binding returned next in leaf */
+    size_t index;
+    /* the key returned last, or NULL to start from the smallest key */
+    const char *lastKey;
+    /* how many bytes are in lastKey */
+    size_t lastLength;
+    /* the number of the snapshot binding returned next, if the
+    SymTable is mapped */
+    size_t snapshotIndex;
+    /* the next iterator of the same SymTable */
+    struct SymTableIter *nextIter;
+};
+
+/* SymTable_prefix takes in a key pcKey of uLength bytes and returns
+its first PREFIX_SIZE bytes as a big endian number, padded with 0
+bytes. Keys with different prefixes are ordered as their prefixes
+are; keys with the same prefix may still differ. */
+static uint64_t SymTable_prefix(const char *pcKey, size_t uLength)
+{
+   uint64_t uPrefix = 0;
+   size_t i;
+
+   for (i = 0; i < PREFIX_SIZE; i++) {
+      uPrefix <<= 8;
+      if (i < uLength) {
+         uPrefix |= (unsigned char)pcKey[i];
+      }
+   }
+   return uPrefix;
+}
+
+/* SymTable_setProbe takes in a Probe psProbe and a key pcKey of
+uLength bytes and makes psProbe search for pcKey */
+static void SymTable_setProbe(struct Probe *psProbe, const char *pcKey,
+                              size_t uLength)
+{
+   psProbe->key = pcKey;
+   psProbe->length = uLength;
+   psProbe->prefix = SymTable_prefix(pcKey, uLength);
+}
+
+/* SymTable_compare takes in SymTable oSymTable, a Probe psProbe and a
+key pcKey of uLength bytes whose prefix is uPrefix. It returns a
+negative number, 0 or a positive number as psProbe's key comes
+before, is or comes after pcKey. Only keys with the same prefix are
+compared with memcmp, which is counted in oSymTable. */
+static int SymTable_compare(SymTable_T oSymTable,
+                            const struct Probe *psProbe,
+                            uint64_t uPrefix, const char *pcKey,
+                            size_t uLength)
+{
+   size_t uShorter;
+   int iResult;
+
+   if (psProbe->prefix != uPrefix) {
+      return (psProbe->prefix < uPrefix) ? -1 : 1;
+   }
+   /* an atom or a key returned by an iterator is often the very key
+   it is looked up with */
+   if (psProbe->key == pcKey && psProbe->length == uLength) {
+      return 0;
+   }
+   uShorter = (psProbe->length < uLength) ? psProbe->length : uLength;
+   if (uShorter > PREFIX_SIZE) {
+      oSymTable->compareCount++;
+      iResult = memcmp(psProbe->key + PREFIX_SIZE, pcKey + PREFIX_SIZE,
+                       uShorter - PREFIX_SIZE);
+      if (iResult != 0) {
+         return iResult;
+      }
+   }
+   return (psProbe->length > uLength) - (psProbe->length < uLength);
+}
+
+/* SymTable_searchLeaf takes in SymTable oSymTable, a Leaf pLeaf, a
+Probe psProbe and an int pointer piFound. It returns the index of the
+first binding of pLeaf whose key is not less than psProbe's, or
+pLeaf->count if there is none, and sets *piFound to 1 if that key is
+psProbe's and to 0 otherwise. */
+static size_t SymTable_searchLeaf(SymTable_T oSymTable,
+                                  const struct Leaf *pLeaf,
+                                  const struct Probe *psProbe,
+                                  int *piFound)
+{
+   size_t uLow = 0;
+   size_t uHigh = pLeaf->count;
+   size_t uMiddle;
+   int iResult;
+
+   *piFound = 0;
+   while (uLow < uHigh) {
+      uMiddle = uLow + (uHigh - uLow) / 2;
+      iResult = SymTable_compare(oSymTable, psProbe,
+                                 pLeaf->prefixes[uMiddle],
+                                 pLeaf->keys[uMiddle],
+                                 pLeaf->lengths[uMiddle]);
+      if (iResult > 0) {
+         uLow = uMiddle + 1;
+      } else {
+         /* keys are unique, so the search ends on this one */
+         if (iResult == 0) {
+            *piFound = 1;
+         }
+         uHigh = uMiddle;
+      }
+   }
+   return uLow;
+}
+
+/* SymTable_searchInner takes in SymTable oSymTable, an Inner node
+pInner and a Probe psProbe, and returns the index of the child of
+pInner that psProbe's key belongs under: the number of separators that
+are not greater than it. */
+static size_t SymTable_searchInner(SymTable_T oSymTable,
+                                   const struct Inner *pInner,
+                                   const struct Probe *psProbe)
+{
+   size_t uLow = 0;
+   size_t uHigh = pInner->count - 1;
+   size_t uMiddle;
+
+   while (uLow < uHigh) {
+      uMiddle = uLow + (uHigh - uLow) / 2;
+      if (SymTable_compare(oSymTable, psProbe, pInner->prefixes[uMiddle],
+                           pInner->keys[uMiddle],
+                           pInner->lengths[uMiddle]) >= 0) {
+         uLow = uMiddle + 1;
+      } else {
+         uHigh = uMiddle;
+      }
+   }
+   return uLow;
+}
+
+/* SymTable_descend takes in SymTable oSymTable, a Probe psProbe and a
+Path psPath, which may be NULL. It returns the Leaf that psProbe's key
+belongs in, and records the way down to it in psPath. */
+static struct Leaf *SymTable_descend(SymTable_T oSymTable,
+                                     const struct Probe *psProbe,
+                                     struct Path *psPath)
+{
+   void *pvNode = oSymTable->root;
+   size_t uLevel;
+   size_t uIndex;
+
+   for (uLevel = 0; uLevel < oSymTable->height; uLevel++) {
+      uIndex = SymTable_searchInner(oSymTable, pvNode, psProbe);
+      if (psPath != NULL) {
+         psPath->nodes[uLevel] = pvNode;
+         psPath->indices[uLevel] = uIndex;
+      }
+      pvNode = ((struct Inner *)pvNode)->children[uIndex];
+   }
+   return pvNode;
+}
+
+/* SymTable_firstLeaf takes in SymTable oSymTable and returns the Leaf
+with its smallest keys */
+static struct Leaf *SymTable_firstLeaf(SymTable_T oSymTable)
+{
+   void *pvNode = oSymTable->root;
+   size_t uLevel;
+
+   for (uLevel = 0; uLevel < oSymTable->height; uLevel++) {
+      pvNode = ((struct Inner *)pvNode)->children[0];
+   }
+   return pvNode;
+}
+
+/* SymTable_find takes in SymTable oSymTable, a Probe psProbe and a
+size_t pointer puIndex. It returns the Leaf holding psProbe's key and
+sets *puIndex to its index there, or returns NULL if there is no such
+key. */
+static struct Leaf *SymTable_find(SymTable_T oSymTable,
+                                  const struct Probe *psProbe,
+                                  size_t *puIndex)
+{
+   struct Leaf *pLeaf;
+   int iFound;
+
+   pLeaf = SymTable_descend(oSymTable, psProbe, NULL);
+   *puIndex = SymTable_searchLeaf(oSymTable, pLeaf, psProbe, &iFound);
+   return iFound ? pLeaf : NULL;
+}
+
+/* SymTable_moveBindings takes in Leaves pTo and pFrom, which may be
+the same Leaf, indices uTo and uFrom and a count uCount, and moves the
+uCount bindings at uFrom in pFrom to uTo in pTo. The counts of the
+Leaves are left to the caller. */
+static void SymTable_moveBindings(struct Leaf *pTo, size_t uTo,
+                                  struct Leaf *pFrom, size_t uFrom,
+                                  size_t uCount)
+{
+   memmove(&pTo->prefixes[uTo], &pFrom->prefixes[uFrom],
+           uCount * sizeof(uint64_t));
+   memmove(&pTo->keys[uTo], &pFrom->keys[uFrom],
+           uCount * sizeof(const char *));
+   memmove(&pTo->lengths[uTo], &pFrom->lengths[uFrom],
+           uCount * sizeof(size_t));
+   memmove(&pTo->values[uTo], &pFrom->values[uFrom],
+           uCount * sizeof(const void *));
+   memmove(&pTo->kinds[uTo], &pFrom->kinds[uFrom], uCount);
+}
+
+/* SymTable_moveSeparators takes in Inner nodes pTo and pFrom, which
+may be the same node, indices uTo and uFrom and a count uCount, and
+moves the uCount separators at uFrom in pFrom to uTo in pTo */
+static void SymTable_moveSeparators(struct Inner *pTo, size_t uTo,
+                                    struct Inner *pFrom, size_t uFrom,
+                                    size_t uCount)
+{
+   memmove(&pTo->prefixes[uTo], &pFrom->prefixes[uFrom],
+           uCount * sizeof(uint64_t));
+   memmove(&pTo->keys[uTo], &pFrom->keys[uFrom],
+           uCount * sizeof(const char *));
+   memmove(&pTo->lengths[uTo], &pFrom->lengths[uFrom],
+           uCount * sizeof(size_t));
+}
+
+/* SymTable_moveChildren takes in Inner nodes pTo and pFrom, which may
+be the same node, indices uTo and uFrom and a count uCount, and moves
+the uCount children at uFrom in pFrom to uTo in pTo */
+static void SymTable_moveChildren(struct Inner *pTo, size_t uTo,
+                                  struct Inner *pFrom, size_t uFrom,
+                                  size_t uCount)
+{
+   memmove(&pTo->children[uTo], &pFrom->children[uFrom],
+           uCount * sizeof(void *));
+}
+
+/* SymTable_setSeparator takes in an Inner node pInner, an index
+uIndex and a separator pcSeparator of uLength bytes, and makes
+pcSeparator separator uIndex of pInner */
+static void SymTable_setSeparator(struct Inner *pInner, size_t uIndex,
+                                  const char *pcSeparator,
+                                  size_t uLength)
+{
+   pInner->prefixes[uIndex] = SymTable_prefix(pcSeparator, uLength);
+   pInner->keys[uIndex] = pcSeparator;
+   pInner->lengths[uIndex] = uLength;
+}
+
+/* SymTable_newSeparator takes in SymTable oSymTable, keys pcLeft and
+pcRight of uLeftLength and uRightLength bytes with pcLeft before
+pcRight, a const char double pointer ppcSeparator and a size_t pointer
+puLength. It sets *ppcSeparator to a new copy of the shortest start of
+pcRight that comes after pcLeft, and *puLength to its length, so it
+can separate a node ending with pcLeft from one starting with pcRight.
+It returns 1, or 0 if there is insufficient memory. */
+static int SymTable_newSeparator(SymTable_T oSymTable,
+                                 const char *pcLeft, size_t uLeftLength,
+                                 const char *pcRight,
+                                 size_t uRightLength,
+                                 const char **ppcSeparator,
+                                 size_t *puLength)
+{
+   size_t uLength = 0;
+   char *pcCopy;
+
+   /* pcRight comes after pcLeft, so it differs from pcLeft (or goes
+   on past its end) before it ends */
+   while (uLength < uLeftLength && pcLeft[uLength] == pcRight[uLength]) {
+      uLength++;
+   }
+   uLength++;
+   assert(uLength <= uRightLength);
+
+   pcCopy = Arena_alloc(oSymTable->arena, uLength);
+   if (pcCopy == NULL) {
+      return 0;
+   }
+   memcpy(pcCopy, pcRight, uLength);
+   *ppcSeparator = pcCopy;
+   *puLength = uLength;
+   return 1;
+}
+
+/* SymTable_storeKey takes in SymTable oSymTable, a key pcKey of
+uLength bytes and iKind, one of KeyKinds. It returns pcKey itself if
+it is an atom or borrowed, and otherwise a '\0' terminated copy of it
+from the arena, or NULL if there is insufficient memory. */
+static const char *SymTable_storeKey(SymTable_T oSymTable,
+                                     const char *pcKey, size_t uLength,
+                                     int iKind)
+{
+   char *defCopy;
+
+   if (iKind != KEY_COPY) {
+      return pcKey;
+   }
+   defCopy = Arena_alloc(oSymTable->arena, uLength + 1);
+   if (defCopy == NULL) {
+      return NULL;
+   }
+   memcpy(defCopy, pcKey, uLength);
+   defCopy[uLength] = '\0';
+   return defCopy;
+}
+
+/* SymTable_releaseKey takes in SymTable oSymTable, a key pcKey of
+uLength bytes and its kind iKind, and releases pcKey back to the
+arena if it is a copy */
+static void SymTable_releaseKey(SymTable_T oSymTable, const char *pcKey,
+                                size_t uLength, int iKind)
+{
+   if (iKind == KEY_COPY) {
+      Arena_release(oSymTable->arena, (char *)pcKey, uLength + 1);
+   }
+}
+
+/* SymTable_loseIters takes in SymTable oSymTable, whose Leaves are
+about to change, and makes each of its iterators find its place again
+before it next returns a binding */
+static void SymTable_loseIters(SymTable_T oSymTable)
+{
+   struct SymTableIter *pIter;
+
+   for (pIter = oSymTable->iters; pIter != NULL;
+        pIter = pIter->nextIter) {
+      pIter->leaf = NULL;
+   }
+}
+
+/* SymTable_mergedKey takes in a full Leaf pLeaf, the index uIndex
+that a Probe psProbe's key is about to be put at, an index uAt and
+pointers ppcKey and puLength. It sets *ppcKey and *puLength to the key
+that will be at uAt once psProbe's key is in. */
+static void SymTable_mergedKey(const struct Leaf *pLeaf, size_t uIndex,
+                               const struct Probe *psProbe, size_t uAt,
+                               const char **ppcKey, size_t *puLength)
+{
+   if (uAt == uIndex) {
+      *ppcKey = psProbe->key;
+      *puLength = psProbe->length;
+      return;
+   }
+   if (uAt > uIndex) {
+      uAt--;
+   }
+   *ppcKey = pLeaf->keys[uAt];
+   *puLength = pLeaf->lengths[uAt];
+}
+
+/* SymTable_insertChild takes in SymTable oSymTable, the Path psPath
+to a node on level uLevel (the Leaves are on level oSymTable->height)
+that has just been split, the separator pcSeparator of uLength bytes
+between its halves, the new right half pvRight and the array apvSpare
+of Inner nodes SymTable_add allocated for this. It puts pvRight into
+the parent, splitting the parent in turn if it overflows, and grows a
+new root if the old root is split. */
+static void SymTable_insertChild(SymTable_T oSymTable,
+                                 const struct Path *psPath,
+                                 size_t uLevel, const char *pcSeparator,
+                                 size_t uLength, void *pvRight,
+                                 void *apvSpare[])
+{
+   struct Inner *pParent;
+   struct Inner *pRight;
+   size_t uIndex;
+
+   while (uLevel > 0) {
+      uLevel--;
+      pParent = psPath->nodes[uLevel];
+      uIndex = psPath->indices[uLevel];
+      SymTable_moveSeparators(pParent, uIndex + 1, pParent, uIndex,
+                              pParent->count - 1 - uIndex);
+      SymTable_moveChildren(pParent, uIndex + 2, pParent, uIndex + 1,
+                            pParent->count - 1 - uIndex);
+      SymTable_setSeparator(pParent, uIndex, pcSeparator, uLength);
+      pParent->children[uIndex + 1] = pvRight;
+      pParent->count++;
+      if (pParent->count <= INNER_SIZE) {
+         return;
+      }
+
+      /* the first INNER_SPLIT children stay, and the separator
+      between them and the rest moves up to the next level */
+      pRight = *apvSpare++;
+      pRight->count = pParent->count - INNER_SPLIT;
+      SymTable_moveChildren(pRight, 0, pParent, INNER_SPLIT,
+                            pRight->count);
+      SymTable_moveSeparators(pRight, 0, pParent, INNER_SPLIT,
+                              pRight->count - 1);
+      pcSeparator = pParent->keys[INNER_SPLIT - 1];
+      uLength = pParent->lengths[INNER_SPLIT - 1];
+      pParent->count = INNER_SPLIT;
+      pvRight = pRight;
+   }
+
+   assert(oSymTable->height < MAX_HEIGHT);
+   pRight = *apvSpare;
+   pRight->count = 2;
+   pRight->children[0] = oSymTable->root;
+   pRight->children[1] = pvRight;
+   SymTable_setSeparator(pRight, 0, pcSeparator, uLength);
+   oSymTable->root = pRight;
+   oSymTable->height++;
+}
+
+/* SymTable_add takes in SymTable oSymTable, a Probe psProbe whose key
+is not in oSymTable, the Path psPath down to the Leaf pLeaf that the
+key belongs in, the index uIndex it goes at there, a const void
+pointer pvValue and iKind, one of KeyKinds. It adds the binding,
+splitting every full node on the way up, and returns a pointer to its
+value. Everything the splits need is allocated first, so if there is
+insufficient memory it returns NULL with oSymTable unchanged. */
+static const void **SymTable_add(SymTable_T oSymTable,
+                                 const struct Probe *psProbe,
+                                 const struct Path *psPath,
+                                 struct Leaf *pLeaf, size_t uIndex,
+                                 const void *pvValue, int iKind)
+{
+   void *apvNodes[MAX_HEIGHT + 2];
+   size_t uNodeCount = 0;
+   size_t uNeeded = 0;
+   size_t uLevel = oSymTable->height;
+   const char *pcKey;
+   const char *pcLeft;
+   const char *pcRight;
+   const char *pcSeparator = NULL;
+   size_t uLeftLength;
+   size_t uRightLength;
+   size_t uSeparatorLength = 0;
+   struct Leaf *pRight;
+   const void **ppvValue;
+
+   /* a full Leaf splits, and so does each full Inner node above it;
+   if the root splits too, there is a new root */
+   if (pLeaf->count == LEAF_SIZE) {
+      uNeeded = 1;
+      while (uLevel > 0 &&
+             psPath->nodes[uLevel - 1]->count == INNER_SIZE) {
+         uNeeded++;
+         uLevel--;
+      }
+      if (uLevel == 0) {
+         uNeeded++;
+      }
+   }
+
+   pcKey = SymTable_storeKey(oSymTable, psProbe->key, psProbe->length,
+                             iKind);
+   if (pcKey == NULL) {
+      return NULL;
+   }
+   if (uNeeded > 0) {
+      SymTable_mergedKey(pLeaf, uIndex, psProbe, LEAF_SPLIT - 1,
+                         &pcLeft, &uLeftLength);
+      SymTable_mergedKey(pLeaf, uIndex, psProbe, LEAF_SPLIT,
+                         &pcRight, &uRightLength);
+      if (! SymTable_newSeparator(oSymTable, pcLeft, uLeftLength,
+                                  pcRight, uRightLength, &pcSeparator,
+                                  &uSeparatorLength)) {
+         SymTable_releaseKey(oSymTable, pcKey, psProbe->length, iKind);
+         return NULL;
+      }
+   }
+   while (uNodeCount < uNeeded) {
+      apvNodes[uNodeCount] = Arena_alloc(oSymTable->arena,
+         (uNodeCount == 0) ? sizeof(struct Leaf) : sizeof(struct Inner));
+      if (apvNodes[uNodeCount] == NULL) {
+         break;
+      }
+      uNodeCount++;
+   }
+   if (uNodeCount < uNeeded) {
+      while (uNodeCount > 0) {
+         uNodeCount--;
+         Arena_release(oSymTable->arena, apvNodes[uNodeCount],
+            (uNodeCount == 0) ? sizeof(struct Leaf) : sizeof(struct Inner));
+      }
+      Arena_release(oSymTable->arena, (char *)pcSeparator,
+                    uSeparatorLength);
+      SymTable_releaseKey(oSymTable, pcKey, psProbe->length, iKind);
+      return NULL;
+   }
+
+   SymTable_loseIters(oSymTable);
+   SymTable_moveBindings(pLeaf, uIndex + 1, pLeaf, uIndex,
+                         pLeaf->count - uIndex);
+   pLeaf->prefixes[uIndex] = psProbe->prefix;
+   pLeaf->keys[uIndex] = pcKey;
+   pLeaf->lengths[uIndex] = psProbe->length;
+   pLeaf->values[uIndex] = pvValue;
+   pLeaf->kinds[uIndex] = (unsigned char)iKind;
+   pLeaf->count++;
+   oSymTable->size++;
+   ppvValue = &pLeaf->values[uIndex];
+   if (uNeeded == 0) {
+      return ppvValue;
+   }
+
+   /* the first LEAF_SPLIT bindings stay and the rest move to a new
+   Leaf on their right */
+   pRight = apvNodes[0];
+   pRight->count = pLeaf->count - LEAF_SPLIT;
+   SymTable_moveBindings(pRight, 0, pLeaf, LEAF_SPLIT, pRight->count);
+   pLeaf->count = LEAF_SPLIT;
+   pRight->next = pLeaf->next;
+   pLeaf->next = pRight;
+   if (uIndex >= LEAF_SPLIT) {
+      ppvValue = &pRight->values[uIndex - LEAF_SPLIT];
+   }
+   SymTable_insertChild(oSymTable, psPath, oSymTable->height,
+                        pcSeparator, uSeparatorLength, pRight,
+                        apvNodes + 1);
+   return ppvValue;
+}
+
+/* SymTable_removeChild takes in an Inner node pInner and an index
+uIndex, and takes separator uIndex and child uIndex + 1 out of
+pInner. Releasing them is left to the caller. */
+static void SymTable_removeChild(struct Inner *pInner, size_t uIndex)
+{
+   SymTable_moveSeparators(pInner, uIndex, pInner, uIndex + 1,
+                           pInner->count - 2 - uIndex);
+   SymTable_moveChildren(pInner, uIndex + 1, pInner, uIndex + 2,
+                         pInner->count - 2 - uIndex);
+   pInner->count--;
+}
+
+/* SymTable_mendLeaves takes in SymTable oSymTable, an Inner node
+pParent on the lowest level of Inner nodes and an index uIndex, where
+one of children uIndex and uIndex + 1 of pParent has too few
+bindings. If the two fit in one Leaf, the right one is merged into the
+left one and 1 is returned. Otherwise their bindings are shared out
+evenly and 0 is returned; if there is no memory for the separator that
+takes, they are left as they are, which only costs some balance. */
+static int SymTable_mendLeaves(SymTable_T oSymTable,
+                               struct Inner *pParent, size_t uIndex)
+{
+   struct Leaf *pLeft = pParent->children[uIndex];
+   struct Leaf *pRight = pParent->children[uIndex + 1];
+   struct Leaf *pFrom;
+   size_t uLeftCount;
+   size_t uAt;
+   size_t uMove;
+   const char *pcSeparator;
+   size_t uLength;
+
+   if (pLeft->count + pRight->count <= LEAF_SIZE) {
+      SymTable_moveBindings(pLeft, pLeft->count, pRight, 0,
+                            pRight->count);
+      pLeft->count += pRight->count;
+      pLeft->next = pRight->next;
+      Arena_release(oSymTable->arena, pRight, sizeof(struct Leaf));
+      Arena_release(oSymTable->arena, (char *)pParent->keys[uIndex],
+                    pParent->lengths[uIndex]);
+      SymTable_removeChild(pParent, uIndex);
+      return 1;
+   }
+
+   /* the new boundary falls between binding uAt - 1 and uAt of pFrom */
+   uLeftCount = (pLeft->count + pRight->count) / 2;
+   if (uLeftCount < pLeft->count) {
+      pFrom = pLeft;
+      uAt = uLeftCount;
+   } else {
+      pFrom = pRight;
+      uAt = uLeftCount - pLeft->count;
+   }
+   if (uAt == 0 ||
+       ! SymTable_newSeparator(oSymTable, pFrom->keys[uAt - 1],
+                               pFrom->lengths[uAt - 1], pFrom->keys[uAt],
+                               pFrom->lengths[uAt], &pcSeparator,
+                               &uLength)) {
+      return 0;
+   }
+   Arena_release(oSymTable->arena, (char *)pParent->keys[uIndex],
+                 pParent->lengths[uIndex]);
+   SymTable_setSeparator(pParent, uIndex, pcSeparator, uLength);
+
+   if (pFrom == pLeft) {
+      uMove = pLeft->count - uLeftCount;
+      SymTable_moveBindings(pRight, uMove, pRight, 0, pRight->count);
+      SymTable_moveBindings(pRight, 0, pLeft, uLeftCount, uMove);
+      pLeft->count -= uMove;
+      pRight->count += uMove;
+   } else {
+      uMove = uAt;
+      SymTable_moveBindings(pLeft, pLeft->count, pRight, 0, uMove);
+      SymTable_moveBindings(pRight, 0, pRight, uMove,
+                            pRight->count - uMove);
+      pLeft->count += uMove;
+      pRight->count -= uMove;
+   }
+   return 0;
+}
+
+/* SymTable_mendInners takes in SymTable oSymTable, an Inner node
+pParent and an index uIndex, where one of children uIndex and
+uIndex + 1 of pParent (Inner nodes too) has too few children. If the
+two fit in one node, the right one is merged into the left one, with
+the separator between them brought down from pParent, and 1 is
+returned. Otherwise the fuller one passes a child to the other through
+pParent and 0 is returned. */
+static int SymTable_mendInners(SymTable_T oSymTable,
+                               struct Inner *pParent, size_t uIndex)
+{
+   struct Inner *pLeft = pParent->children[uIndex];
+   struct Inner *pRight = pParent->children[uIndex + 1];
+
+   if (pLeft->count + pRight->count <= INNER_SIZE) {
+      SymTable_moveSeparators(pLeft, pLeft->count - 1, pParent, uIndex,
+                              1);
+      SymTable_moveSeparators(pLeft, pLeft->count, pRight, 0,
+                              pRight->count - 1);
+      SymTable_moveChildren(pLeft, pLeft->count, pRight, 0,
+                            pRight->count);
+      pLeft->count += pRight->count;
+      Arena_release(oSymTable->arena, pRight, sizeof(struct Inner));
+      SymTable_removeChild(pParent, uIndex);
+      return 1;
+   }
+
+   if (pLeft->count < pRight->count) {
+      SymTable_moveSeparators(pLeft, pLeft->count - 1, pParent, uIndex,
+                              1);
+      pLeft->children[pLeft->count] = pRight->children[0];
+      pLeft->count++;
+      SymTable_moveSeparators(pParent, uIndex, pRight, 0, 1);
+      SymTable_moveSeparators(pRight, 0, pRight, 1, pRight->count - 2);
+      SymTable_moveChildren(pRight, 0, pRight, 1, pRight->count - 1);
+      pRight->count--;
+   } else {
+      SymTable_moveSeparators(pRight, 1, pRight, 0, pRight->count - 1);
+      SymTable_moveChildren(pRight, 1, pRight, 0, pRight->count);
+      SymTable_moveSeparators(pRight, 0, pParent, uIndex, 1);
+      pRight->children[0] = pLeft->children[pLeft->count - 1];
+      pRight->count++;
+      SymTable_moveSeparators(pParent, uIndex, pLeft, pLeft->count - 2,
+                              1);
+      pLeft->count--;
+   }
+   return 0;
+}
+
+/* SymTable_rebalance takes in SymTable oSymTable and the Path psPath
+down to a Leaf pLeaf that has just lost a binding. If pLeaf has too
+few bindings left, it is mended with a neighbour, and so on up for
+each Inner node left with too few children. A root left with a single
+child is replaced by that child. */
+static void SymTable_rebalance(SymTable_T oSymTable,
+                               const struct Path *psPath,
+                               struct Leaf *pLeaf)
+{
+   struct Inner *pRoot;
+   size_t uLevel = oSymTable->height;
+   size_t uIndex;
+
+   if (uLevel == 0 || pLeaf->count >= LEAF_MIN) {
+      return;
+   }
+   /* a node is paired with its left neighbour, if it has one */
+   uIndex = psPath->indices[uLevel - 1];
+   if (uIndex > 0) {
+      uIndex--;
+   }
+   if (! SymTable_mendLeaves(oSymTable, psPath->nodes[uLevel - 1],
+                             uIndex)) {
+      return;
+   }
+
+   for (uLevel = oSymTable->height - 1; uLevel > 0; uLevel--) {
+      if (psPath->nodes[uLevel]->count >= INNER_MIN) {
+         return;
+      }
+      uIndex = psPath->indices[uLevel - 1];
+      if (uIndex > 0) {
+         uIndex--;
+      }
+      if (! SymTable_mendInners(oSymTable, psPath->nodes[uLevel - 1],
+                                uIndex)) {
+         return;
+      }
+   }
+
+   pRoot = oSymTable->root;
+   if (pRoot->count == 1) {
+      oSymTable->root = pRoot->children[0];
+      oSymTable->height--;
+      Arena_release(oSymTable->arena, pRoot, sizeof(struct Inner));
+   }
+}
+
+/* SymTable_before takes in SymTable oSymTable, the Path psPath down
+to a Leaf pLeaf and an index uIndex in pLeaf, and sets *ppcKey and
+*puLength to the key just before the one at uIndex, or *ppcKey to
+NULL if that is the smallest key */
+static void SymTable_before(SymTable_T oSymTable,
+                            const struct Path *psPath,
+                            const struct Leaf *pLeaf, size_t uIndex,
+                            const char **ppcKey, size_t *puLength)
+{
+   void *pvNode;
+   size_t uLevel = oSymTable->height;
+
+   if (uIndex == 0) {
+      /* the last key of the Leaf to the left, found under the lowest
+      node on the path that has a child to the left of it */
+      while (uLevel > 0 && psPath->indices[uLevel - 1] == 0) {
+         uLevel--;
+      }
+      if (uLevel == 0) {
+         *ppcKey = NULL;
+         *puLength = 0;
+         return;
+      }
+      pvNode = psPath->nodes[uLevel - 1]->children[
+         psPath->indices[uLevel - 1] - 1];
+      for (; uLevel < oSymTable->height; uLevel++) {
+         pvNode = ((struct Inner *)pvNode)->children[
+            ((struct Inner *)pvNode)->count - 1];
+      }
+      pLeaf = pvNode;
+      uIndex = pLeaf->count;
+      assert(uIndex > 0);
+   }
+   *ppcKey = pLeaf->keys[uIndex - 1];
+   *puLength = pLeaf->lengths[uIndex - 1];
+}
+
+/* SymTable_delete takes in SymTable oSymTable and a Probe psProbe. It
+removes the binding of psProbe's key and returns its value, or returns
+NULL if there is none. */
+static void *SymTable_delete(SymTable_T oSymTable,
+                             const struct Probe *psProbe)
+{
+   struct Path sPath;
+   struct Leaf *pLeaf;
+   struct SymTableIter *pIter;
+   const char *pcBefore = NULL;
+   size_t uBeforeLength = 0;
+   int iBeforeFound = 0;
+   size_t uIndex;
+   int iFound;
+   void *pvValue;
+
+   pLeaf = SymTable_descend(oSymTable, psProbe, &sPath);
+   uIndex = SymTable_searchLeaf(oSymTable, pLeaf, psProbe, &iFound);
+   if (! iFound) {
+      return NULL;
+   }
+
+   /* an iterator that returned this key last goes back to the key
+   before it, whose successor is the same once this one is gone */
+   for (pIter = oSymTable->iters; pIter != NULL;
+        pIter = pIter->nextIter) {
+      pIter->leaf = NULL;
+      if (pIter->lastKey == pLeaf->keys[uIndex]) {
+         if (! iBeforeFound) {
+            SymTable_before(oSymTable, &sPath, pLeaf, uIndex, &pcBefore,
+                            &uBeforeLength);
+            iBeforeFound = 1;
+         }
+         pIter->lastKey = pcBefore;
+         pIter->lastLength = uBeforeLength;
+      }
+   }
+
+   pvValue = (void*)pLeaf->values[uIndex];
+   SymTable_releaseKey(oSymTable, pLeaf->keys[uIndex],
+                       pLeaf->lengths[uIndex], pLeaf->kinds[uIndex]);
+   SymTable_moveBindings(pLeaf, uIndex, pLeaf, uIndex + 1,
+                         pLeaf->count - uIndex - 1);
+   pLeaf->count--;
+   oSymTable->size--;
+   SymTable_rebalance(oSymTable, &sPath, pLeaf);
+   return pvValue;
+}
+
+/* SymTable_insert takes in SymTable oSymTable, a const char pointer
+pcKey, its length uLength, a const void pointer pvValue and iKind, one
+of KeyKinds. If oSymTable doesn't contain pcKey, a new binding is
+added and 1 is returned. If it does, or there is insufficient memory,
+oSymTable is left unchanged and 0 is returned. */
+static int SymTable_insert(SymTable_T oSymTable, const char *pcKey,
+                           size_t uLength, const void *pvValue,
+                           int iKind)
+{
+   struct Probe sProbe;
+   struct Path sPath;
+   struct Leaf *pLeaf;
+   size_t uIndex;
+   int iFound;
+
+   /* a mapped SymTable is read-only */
+   if (oSymTable->snapshot != NULL) {
+      return 0;
+   }
+   SymTable_setProbe(&sProbe, pcKey, uLength);
+   pLeaf = SymTable_descend(oSymTable, &sProbe, &sPath);
+   uIndex = SymTable_searchLeaf(oSymTable, pLeaf, &sProbe, &iFound);
+   if (iFound) {
+      return 0;
+   }
+   return SymTable_add(oSymTable, &sProbe, &sPath, pLeaf, uIndex,
+                       pvValue, iKind) != NULL;
+}
+
+/* SymTable_lookup takes in SymTable oSymTable, a key pcKey and its
+length uLength, and returns a pointer to the value of pcKey's binding,
+or NULL if there is none */
+static const void **SymTable_lookup(SymTable_T oSymTable,
+                                    const char *pcKey, size_t uLength)
+{
+   struct Probe sProbe;
+   struct Leaf *pLeaf;
+   size_t uIndex;
+
+   SymTable_setProbe(&sProbe, pcKey, uLength);
+   pLeaf = SymTable_find(oSymTable, &sProbe, &uIndex);
+   if (pLeaf == NULL) {
+      return NULL;
+   }
+   return &pLeaf->values[uIndex];
+}
+
+SymTable_T SymTable_new(void){
+   struct SymTable *oSymTable = malloc(sizeof(struct SymTable));
+   struct Leaf *pRoot;
+
+   if(oSymTable == NULL){
+      return NULL;
+   }
+   oSymTable->height = 0;
+   oSymTable->size = 0;
+   oSymTable->compareCount = 0;
+   oSymTable->allocCount = 1;
+   oSymTable->iters = NULL;
+   oSymTable->snapshot = NULL;
+   oSymTable->arena = Arena_new();
+   if(oSymTable->arena == NULL){
+      free(oSymTable);
+      return NULL;
+   }
+   pRoot = Arena_alloc(oSymTable->arena, sizeof(struct Leaf));
+   if(pRoot == NULL){
+      Arena_free(oSymTable->arena);
+      free(oSymTable);
+      return NULL;
+   }
+   pRoot->count = 0;
+   pRoot->next = NULL;
+   oSymTable->root = pRoot;
+   return oSymTable;
+}
+
+SymTable_T SymTable_newWithOptions(enum SymTableHash eHash){
+   if (eHash != SYMTABLE_HASH_DEFAULT && eHash != SYMTABLE_HASH_FAST &&
+       eHash != SYMTABLE_HASH_SIPHASH) {
+      return NULL;
+   }
+   /* a tree orders its keys instead of hashing them, so every kind of
+   hash gives the same SymTable */
+   return SymTable_new();
+}
+
+void SymTable_free(SymTable_T oSymTable){
+   assert(oSymTable != NULL);
+   assert(oSymTable->iters == NULL);
+
+   /* every node, key copy and separator lives in the arena */
+   Arena_free(oSymTable->arena);
+   Snapshot_close(oSymTable->snapshot);
+   free(oSymTable);
+}
+
+size_t SymTable_getLength(SymTable_T oSymTable){
+   assert(oSymTable != NULL);
+   if (oSymTable->snapshot != NULL) {
+      return Snapshot_getLength(oSymTable->snapshot);
+   }
+   return oSymTable->size;
+}
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey,
+                 const void *pvValue) {
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   return SymTable_putN(oSymTable, pcKey, strlen(pcKey), pvValue);
+}
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey,
+                       const void *pvValue){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   return SymTable_replaceN(oSymTable, pcKey, strlen(pcKey), pvValue);
+}
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   return SymTable_containsN(oSymTable, pcKey, strlen(pcKey));
+}
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   return SymTable_getN(oSymTable, pcKey, strlen(pcKey));
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   return SymTable_removeN(oSymTable, pcKey, strlen(pcKey));
+}
+
+int SymTable_putN(SymTable_T oSymTable, const void *pvKey,
+                  size_t uLength, const void *pvValue){
+   assert(oSymTable != NULL);
+   assert(pvKey != NULL);
+
+   return SymTable_insert(oSymTable, pvKey, uLength, pvValue, KEY_COPY);
+}
+
+void *SymTable_replaceN(SymTable_T oSymTable, const void *pvKey,
+                        size_t uLength, const void *pvValue){
+   const void **ppvValue;
+   void *oldValue;
+
+   assert(oSymTable != NULL);
+   assert(pvKey != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      return NULL;
+   }
+   ppvValue = SymTable_lookup(oSymTable, pvKey, uLength);
+   if (ppvValue == NULL) {
+      return NULL;
+   }
+   oldValue = (void*)*ppvValue;
+   *ppvValue = pvValue;
+   return oldValue;
+}
+
+int SymTable_containsN(SymTable_T oSymTable, const void *pvKey,
+                       size_t uLength){
+   assert(oSymTable != NULL);
+   assert(pvKey != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      return Snapshot_find(oSymTable->snapshot, pvKey, uLength, NULL);
+   }
+   return SymTable_lookup(oSymTable, pvKey, uLength) != NULL;
+}
+
+void *SymTable_getN(SymTable_T oSymTable, const void *pvKey,
+                    size_t uLength){
+   const void **ppvValue;
+   void *pvValue;
+
+   assert(oSymTable != NULL);
+   assert(pvKey != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      if (!Snapshot_find(oSymTable->snapshot, pvKey, uLength, &pvValue)) {
+         return NULL;
+      }
+      return pvValue;
+   }
+   ppvValue = SymTable_lookup(oSymTable, pvKey, uLength);
+   if (ppvValue == NULL) {
+      return NULL;
+   }
+   return (void*)*ppvValue;
+}
+
+void *SymTable_removeN(SymTable_T oSymTable, const void *pvKey,
+                       size_t uLength){
+   struct Probe sProbe;
+
+   assert(oSymTable != NULL);
+   assert(pvKey != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      return NULL;
+   }
+   SymTable_setProbe(&sProbe, pvKey, uLength);
+   return SymTable_delete(oSymTable, &sProbe);
+}
+
+void SymTable_map(SymTable_T oSymTable,
+                  void (*pfApply)(const char *pcKey,
+                                  void *pvValue, void *pvExtra),
+                  const void *pvExtra){
+   struct Leaf *pLeaf;
+   size_t i;
+
+   assert(oSymTable != NULL);
+   assert(pfApply != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      Snapshot_map(oSymTable->snapshot, pfApply, pvExtra);
+      return;
+   }
+   for (pLeaf = SymTable_firstLeaf(oSymTable); pLeaf != NULL;
+        pLeaf = pLeaf->next) {
+      for (i = 0; i < pLeaf->count; i++) {
+         (*pfApply)(pLeaf->keys[i], (void*)pLeaf->values[i],
+                    (void*)pvExtra);
+      }
+   }
+}
+
+void SymTable_getCounts(SymTable_T oSymTable, size_t *puRehashes,
+                        size_t *puCompares){
+   assert(oSymTable != NULL);
+   assert(puRehashes != NULL);
+   assert(puCompares != NULL);
+
+   /* a tree is never rehashed: a split moves half a node, not the
+   whole SymTable */
+   *puRehashes = 0;
+   *puCompares = oSymTable->compareCount;
+}
+
+int SymTable_setMaxLoad(SymTable_T oSymTable, double dMaxLoad){
+   assert(oSymTable != NULL);
+
+   /* a tree has no buckets, so any positive load factor is accepted
+   and has no effect */
+   return dMaxLoad > 0.0;
+}
+
+int SymTable_setIncremental(SymTable_T oSymTable, int iIncremental){
+   assert(oSymTable != NULL);
+
+   /* a tree grows a node at a time, so it is always incremental and
+   there is no mode to switch */
+   return iIncremental == 0;
+}
+
+size_t SymTable_getAllocCount(SymTable_T oSymTable){
+   assert(oSymTable != NULL);
+
+   /* the SymTable itself plus everything in its arena */
+   return oSymTable->allocCount + Arena_getAllocCount(oSymTable->arena) +
+          (oSymTable->snapshot != NULL);
+}
+
+size_t SymTable_getBytes(SymTable_T oSymTable){
+   assert(oSymTable != NULL);
+   return sizeof(struct SymTable) + Arena_getBytes(oSymTable->arena) +
+          (oSymTable->snapshot != NULL ?
+           Snapshot_getBytes(oSymTable->snapshot) : 0);
+}
+
+int SymTable_putAtom(SymTable_T oSymTable, const char *pcAtom,
+                     const void *pvValue){
+   assert(oSymTable != NULL);
+   assert(pcAtom != NULL);
+
+   return SymTable_insert(oSymTable, pcAtom, Atom_getLength(pcAtom),
+                          pvValue, KEY_ATOM);
+}
+
+void *SymTable_getAtom(SymTable_T oSymTable, const char *pcAtom){
+   const void **ppvValue;
+
+   assert(oSymTable != NULL);
+   assert(pcAtom != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      return SymTable_getN(oSymTable, pcAtom, Atom_getLength(pcAtom));
+   }
+   /* the binding's key is often pcAtom itself, which SymTable_compare
+   tells without memcmp */
+   ppvValue = SymTable_lookup(oSymTable, pcAtom, Atom_getLength(pcAtom));
+   if (ppvValue == NULL) {
+      return NULL;
+   }
+   return (void*)*ppvValue;
+}
+
+int SymTable_putBorrowed(SymTable_T oSymTable, const char *pcKey,
+                         const void *pvValue){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   return SymTable_insert(oSymTable, pcKey, strlen(pcKey), pvValue,
+                          KEY_BORROWED);
+}
+
+void **SymTable_getOrPut(SymTable_T oSymTable, const char *pcKey,
+                         const void *pvValue, int *piFound){
+   struct Probe sProbe;
+   struct Path sPath;
+   struct Leaf *pLeaf;
+   size_t uIndex;
+   int iFound;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      return NULL;
+   }
+   SymTable_setProbe(&sProbe, pcKey, strlen(pcKey));
+   pLeaf = SymTable_descend(oSymTable, &sProbe, &sPath);
+   uIndex = SymTable_searchLeaf(oSymTable, pLeaf, &sProbe, &iFound);
+   if (piFound != NULL) {
+      *piFound = iFound;
+   }
+   if (iFound) {
+      return (void **)&pLeaf->values[uIndex];
+   }
+   return (void **)SymTable_add(oSymTable, &sProbe, &sPath, pLeaf,
+                                uIndex, pvValue, KEY_COPY);
+}
+
+int SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+                    const void *pvValue, void **ppvOldValue){
+   void **ppvValue;
+   int iFound;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   ppvValue = SymTable_getOrPut(oSymTable, pcKey, pvValue, &iFound);
+   if (ppvValue == NULL) {
+      return 0;
+   }
+   if (ppvOldValue != NULL) {
+      *ppvOldValue = iFound ? *ppvValue : NULL;
+   }
+   *ppvValue = (void*)pvValue;
+   return 1;
+}
+
+int SymTable_putHashed(SymTable_T oSymTable, const char *pcKey,
+                       size_t uHash, const void *pvValue){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   /* a tree has no use for the hash */
+   (void)uHash;
+   return SymTable_put(oSymTable, pcKey, pvValue);
+}
+
+void *SymTable_getHashed(SymTable_T oSymTable, const char *pcKey,
+                         size_t uHash){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   (void)uHash;
+   return SymTable_get(oSymTable, pcKey);
+}
+
+int SymTable_containsHashed(SymTable_T oSymTable, const char *pcKey,
+                            size_t uHash){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   (void)uHash;
+   return SymTable_contains(oSymTable, pcKey);
+}
+
+void *SymTable_removeHashed(SymTable_T oSymTable, const char *pcKey,
+                            size_t uHash){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   (void)uHash;
+   return SymTable_remove(oSymTable, pcKey);
+}
+
+void SymTable_getMany(SymTable_T oSymTable, const char *const apcKeys[],
+                      size_t uCount, void *apvValues[]){
+   size_t i;
+
+   assert(oSymTable != NULL);
+   assert(uCount == 0 || (apcKeys != NULL && apvValues != NULL));
+
+   /* each level of the descent depends on the one above, so there is
+   nothing to start loading early and each key is looked up in turn */
+   for (i = 0; i < uCount; i++) {
+      apvValues[i] = SymTable_get(oSymTable, apcKeys[i]);
+   }
+}
+
+/* SymTable_mapUnits takes in a range of Leaf numbers [uBegin, uEnd)
+and a void pointer pvJob to a MapJob, and maps the bindings of those
+Leaves */
+static void SymTable_mapUnits(size_t uBegin, size_t uEnd, void *pvJob)
+{
+   struct MapJob *pJob = pvJob;
+   struct Leaf *pLeaf;
+   size_t i;
+   size_t j;
+
+   for (i = uBegin; i < uEnd; i++) {
+      pLeaf = pJob->leaves[i];
+      for (j = 0; j < pLeaf->count; j++) {
+         (*pJob->pfApply)(pLeaf->keys[j], (void*)pLeaf->values[j],
+                          (void*)pJob->pvExtra);
+      }
+   }
+}
+
+void SymTable_mapParallel(SymTable_T oSymTable,
+                          void (*pfApply)(const char *pcKey,
+                                          void *pvValue, void *pvExtra),
+                          const void *pvExtra, size_t uThreads){
+   struct MapJob sJob;
+   struct Leaf *pLeaf;
+   size_t uLeafCount = 0;
+
+   assert(oSymTable != NULL);
+   assert(pfApply != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      Snapshot_mapParallel(oSymTable->snapshot, pfApply, pvExtra,
+                           uThreads);
+      return;
+   }
+   if (uThreads <= 1 || oSymTable->height == 0) {
+      SymTable_map(oSymTable, pfApply, pvExtra);
+      return;
+   }
+   /* the Leaves are only linked to each other, so they are numbered
+   by walking them once; that touches a node per LEAF_MIN or more
+   bindings, which is little next to mapping them */
+   for (pLeaf = SymTable_firstLeaf(oSymTable); pLeaf != NULL;
+        pLeaf = pLeaf->next) {
+      uLeafCount++;
+   }
+   sJob.leaves = malloc(uLeafCount * sizeof(struct Leaf *));
+   if (sJob.leaves == NULL) {
+      SymTable_map(oSymTable, pfApply, pvExtra);
+      return;
+   }
+   uLeafCount = 0;
+   for (pLeaf = SymTable_firstLeaf(oSymTable); pLeaf != NULL;
+        pLeaf = pLeaf->next) {
+      sJob.leaves[uLeafCount++] = pLeaf;
+   }
+   sJob.pfApply = pfApply;
+   sJob.pvExtra = pvExtra;
+   Parallel_forRange(uLeafCount, uThreads, SymTable_mapUnits, &sJob);
+   free(sJob.leaves);
+}
+
+SymTableIter_T SymTable_iterBegin(SymTable_T oSymTable){
+   struct SymTableIter *pIter;
+
+   assert(oSymTable != NULL);
+
+   pIter = malloc(sizeof(struct SymTableIter));
+   if (pIter == NULL) {
+      return NULL;
+   }
+   pIter->oSymTable = oSymTable;
+   pIter->leaf = NULL;
+   pIter->index = 0;
+   pIter->lastKey = NULL;
+   pIter->lastLength = 0;
+   pIter->snapshotIndex = 0;
+   pIter->nextIter = oSymTable->iters;
+   oSymTable->iters = pIter;
+   return pIter;
+}
+
+int SymTable_iterNext(SymTableIter_T oIter, const char **ppcKey,
+                      void **ppvValue){
+   struct Probe sProbe;
+   struct Leaf *pLeaf;
+   int iFound;
+
+   assert(oIter != NULL);
+
+   if (oIter->oSymTable->snapshot != NULL) {
+      if (oIter->snapshotIndex ==
+          Snapshot_getLength(oIter->oSymTable->snapshot)) {
+         return 0;
+      }
+      Snapshot_getBinding(oIter->oSymTable->snapshot,
+                          oIter->snapshotIndex++, ppcKey, NULL,
+                          ppvValue);
+      return 1;
+   }
+   if (oIter->leaf == NULL) {
+      if (oIter->lastKey == NULL) {
+         oIter->leaf = SymTable_firstLeaf(oIter->oSymTable);
+         oIter->index = 0;
+      } else {
+         SymTable_setProbe(&sProbe, oIter->lastKey, oIter->lastLength);
+         oIter->leaf = SymTable_descend(oIter->oSymTable, &sProbe, NULL);
+         oIter->index = SymTable_searchLeaf(oIter->oSymTable, oIter->leaf,
+                                            &sProbe, &iFound) + 1;
+         assert(iFound);
+      }
+   }
+   pLeaf = oIter->leaf;
+   while (oIter->index == pLeaf->count) {
+      if (pLeaf->next == NULL) {
+         return 0;
+      }
+      pLeaf = pLeaf->next;
+      oIter->leaf = pLeaf;
+      oIter->index = 0;
+   }
+
+   if (ppcKey != NULL) {
+      *ppcKey = pLeaf->keys[oIter->index];
+   }
+   if (ppvValue != NULL) {
+      *ppvValue = (void*)pLeaf->values[oIter->index];
+   }
+   oIter->lastKey = pLeaf->keys[oIter->index];
+   oIter->lastLength = pLeaf->lengths[oIter->index];
+   oIter->index++;
+   return 1;
+}
+
+void SymTable_iterEnd(SymTableIter_T oIter){
+   struct SymTableIter **ppIter;
+
+   assert(oIter != NULL);
+
+   for (ppIter = &oIter->oSymTable->iters; *ppIter != oIter;
+        ppIter = &(*ppIter)->nextIter) {
+      assert(*ppIter != NULL);
+   }
+   *ppIter = oIter->nextIter;
+   free(oIter);
+}
+
+void SymTable_mapRange(SymTable_T oSymTable, const char *pcLow,
+                       const char *pcHigh,
+                       void (*pfApply)(const char *pcKey,
+                                       void *pvValue, void *pvExtra),
+                       const void *pvExtra){
+   struct Probe sLow;
+   struct Probe sHigh;
+   struct Leaf *pLeaf;
+   size_t i = 0;
+   int iFound;
+
+   assert(oSymTable != NULL);
+   assert(pfApply != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      Snapshot_mapRange(oSymTable->snapshot, pcLow, pcHigh, pfApply,
+                        pvExtra);
+      return;
+   }
+   if (pcLow != NULL) {
+      SymTable_setProbe(&sLow, pcLow, strlen(pcLow));
+      pLeaf = SymTable_descend(oSymTable, &sLow, NULL);
+      i = SymTable_searchLeaf(oSymTable, pLeaf, &sLow, &iFound);
+   } else {
+      pLeaf = SymTable_firstLeaf(oSymTable);
+   }
+   if (pcHigh != NULL) {
+      SymTable_setProbe(&sHigh, pcHigh, strlen(pcHigh));
+   }
+
+   for (; pLeaf != NULL; pLeaf = pLeaf->next, i = 0) {
+      for (; i < pLeaf->count; i++) {
+         if (pcHigh != NULL &&
+             SymTable_compare(oSymTable, &sHigh, pLeaf->prefixes[i],
+                              pLeaf->keys[i], pLeaf->lengths[i]) <= 0) {
+            return;
+         }
+         (*pfApply)(pLeaf->keys[i], (void*)pLeaf->values[i],
+                    (void*)pvExtra);
+      }
+   }
+}
+
+void SymTable_mapPrefix(SymTable_T oSymTable, const char *pcPrefix,
+                        void (*pfApply)(const char *pcKey,
+                                        void *pvValue, void *pvExtra),
+                        const void *pvExtra){
+   struct Probe sPrefix;
+   struct Leaf *pLeaf;
+   size_t i;
+   int iFound;
+
+   assert(oSymTable != NULL);
+   assert(pcPrefix != NULL);
+   assert(pfApply != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      Snapshot_mapPrefix(oSymTable->snapshot, pcPrefix, pfApply,
+                         pvExtra);
+      return;
+   }
+   /* the keys starting with pcPrefix are the ones from pcPrefix on,
+   up to the first one that does not */
+   SymTable_setProbe(&sPrefix, pcPrefix, strlen(pcPrefix));
+   pLeaf = SymTable_descend(oSymTable, &sPrefix, NULL);
+   i = SymTable_searchLeaf(oSymTable, pLeaf, &sPrefix, &iFound);
+
+   for (; pLeaf != NULL; pLeaf = pLeaf->next, i = 0) {
+      for (; i < pLeaf->count; i++) {
+         if (pLeaf->lengths[i] < sPrefix.length ||
+             memcmp(pLeaf->keys[i], pcPrefix, sPrefix.length) != 0) {
+            return;
+         }
+         (*pfApply)(pLeaf->keys[i], (void*)pLeaf->values[i],
+                    (void*)pvExtra);
+      }
+   }
+}
+
+int SymTable_save(SymTable_T oSymTable, const char *pcPath,
+                  size_t uValueSize){
+   SnapshotWriter_T oWriter;
+   struct Leaf *pLeaf;
+   size_t i;
+
+   assert(oSymTable != NULL);
+   assert(pcPath != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      return Snapshot_save(oSymTable->snapshot, pcPath, uValueSize);
+   }
+   oWriter = SnapshotWriter_new(uValueSize);
+   if (oWriter == NULL) {
+      return 0;
+   }
+   for (pLeaf = SymTable_firstLeaf(oSymTable); pLeaf != NULL;
+        pLeaf = pLeaf->next) {
+      for (i = 0; i < pLeaf->count; i++) {
+         if (!SnapshotWriter_add(oWriter, pLeaf->keys[i],
+                                 pLeaf->lengths[i], pLeaf->values[i])) {
+            SnapshotWriter_free(oWriter);
+            return 0;
+         }
+      }
+   }
+   return SnapshotWriter_finish(oWriter, pcPath);
+}
+
+SymTable_T SymTable_openMapped(const char *pcPath){
+   SymTable_T oSymTable;
+
+   assert(pcPath != NULL);
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL) {
+      return NULL;
+   }
+   oSymTable->snapshot = Snapshot_open(pcPath);
+   if (oSymTable->snapshot == NULL) {
+      SymTable_free(oSymTable);
+      return NULL;
+   }
+   return oSymTable;
+}
+
+SymTable_T SymTable_newWithCapacity(size_t uCapacity){
+   SymTable_T oSymTable;
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL) {
+      return NULL;
+   }
+   if (! SymTable_reserve(oSymTable, uCapacity)) {
+      SymTable_free(oSymTable);
+      return NULL;
+   }
+   return oSymTable;
+}
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity){
+   assert(oSymTable != NULL);
+
+   /* a tree has no buckets to size, and its nodes are bigger than the
+   blocks an arena bumps out of its chunks, so each has its own malloc
+   whenever it is made. The key copies' sizes are only known at each
+   put. There is nothing to get ready. */
+   (void)uCapacity;
+   return oSymTable->snapshot == NULL;
+}
+
+/* SymTable_buildLeaves takes in a SymTable oNew being built by
+SymTable_compact, the first Leaf pFrom of the tree being compacted,
+an array psNodes and a Leaf count uLeafCount. It copies the bindings
+of the tree, and their key copies, into uLeafCount new Leaves from
+oNew's arena, spread evenly so that each is at least half full, and
+puts the Leaves and the separators between them in psNodes. It
+returns 1, or 0 if there is insufficient memory. */
+static int SymTable_buildLeaves(SymTable_T oNew, struct Leaf *pFrom,
+                                struct BuildNode *psNodes,
+                                size_t uLeafCount)
+{
+   struct Leaf *pLeaf;
+   struct Leaf *pPrev = NULL;
+   size_t uBase = oNew->size / uLeafCount;
+   size_t uExtra = oNew->size % uLeafCount;
+   size_t uFrom = 0;
+   size_t i;
+   size_t j;
+   const char *pcKey;
+
+   for (i = 0; i < uLeafCount; i++) {
+      pLeaf = Arena_alloc(oNew->arena, sizeof(struct Leaf));
+      if (pLeaf == NULL) {
+         return 0;
+      }
+      pLeaf->count = uBase + (i < uExtra);
+      pLeaf->next = NULL;
+      for (j = 0; j < pLeaf->count; j++) {
+         while (uFrom == pFrom->count) {
+            pFrom = pFrom->next;
+            uFrom = 0;
+         }
+         pcKey = SymTable_storeKey(oNew, pFrom->keys[uFrom],
+                                   pFrom->lengths[uFrom],
+                                   pFrom->kinds[uFrom]);
+         if (pcKey == NULL) {
+            return 0;
+         }
+         pLeaf->prefixes[j] = pFrom->prefixes[uFrom];
+         pLeaf->keys[j] = pcKey;
+         pLeaf->lengths[j] = pFrom->lengths[uFrom];
+         pLeaf->values[j] = pFrom->values[uFrom];
+         pLeaf->kinds[j] = pFrom->kinds[uFrom];
+         uFrom++;
+      }
+      psNodes[i].node = pLeaf;
+      psNodes[i].separator = NULL;
+      psNodes[i].length = 0;
+      if (pPrev != NULL) {
+         pPrev->next = pLeaf;
+         if (! SymTable_newSeparator(oNew, pPrev->keys[pPrev->count - 1],
+                                     pPrev->lengths[pPrev->count - 1],
+                                     pLeaf->keys[0], pLeaf->lengths[0],
+                                     &psNodes[i].separator,
+                                     &psNodes[i].length)) {
+            return 0;
+         }
+      }
+      pPrev = pLeaf;
+   }
+   return 1;
+}
+
+/* SymTable_buildInners takes in a SymTable oNew being built by
+SymTable_compact and an array psNodes of the uCount (at least 2) nodes
+of one level and the separators between them. It makes the level
+above: the fewest Inner nodes from oNew's arena that have room for
+the uCount nodes, spread evenly so that each is at least half full,
+and puts them and the separators between them in psNodes in place of
+the level below. It returns how many there are, or 0 if there is
+insufficient memory. */
+static size_t SymTable_buildInners(SymTable_T oNew,
+                                   struct BuildNode *psNodes,
+                                   size_t uCount)
+{
+   struct Inner *pInner;
+   size_t uParents = (uCount + INNER_SIZE - 1) / INNER_SIZE;
+   size_t uBase = uCount / uParents;
+   size_t uExtra = uCount % uParents;
+   size_t uFirst = 0;
+   size_t i;
+   size_t j;
+
+   for (i = 0; i < uParents; i++) {
+      pInner = Arena_alloc(oNew->arena, sizeof(struct Inner));
+      if (pInner == NULL) {
+         return 0;
+      }
+      pInner->count = uBase + (i < uExtra);
+      for (j = 0; j < pInner->count; j++) {
+         pInner->children[j] = psNodes[uFirst + j].node;
+         if (j > 0) {
+            SymTable_setSeparator(pInner, j - 1,
+                                  psNodes[uFirst + j].separator,
+                                  psNodes[uFirst + j].length);
+         }
+      }
+      /* uFirst is never behind i, so nothing not yet read is
+      overwritten */
+      psNodes[i].node = pInner;
+      psNodes[i].separator = psNodes[uFirst].separator;
+      psNodes[i].length = psNodes[uFirst].length;
+      uFirst += pInner->count;
+   }
+   return uParents;
+}
+
+int SymTable_compact(SymTable_T oSymTable){
+   struct SymTable sNew;
+   struct BuildNode *psNodes;
+   size_t uCount;
+   int iSuccessful;
+
+   assert(oSymTable != NULL);
+
+   /* the iterators hold keys that are about to move */
+   if (oSymTable->snapshot != NULL || oSymTable->iters != NULL) {
+      return 0;
+   }
+   uCount = (oSymTable->size + LEAF_SIZE - 1) / LEAF_SIZE;
+   if (uCount == 0) {
+      uCount = 1;
+   }
+   psNodes = malloc(uCount * sizeof(struct BuildNode));
+   if (psNodes == NULL) {
+      return 0;
+   }
+
+   /* the tree is built again bottom up into a new arena, its Leaves
+   as full as they can be kept while every one stays at least half
+   full, and then so is each level of Inner nodes */
+   sNew = *oSymTable;
+   sNew.height = 0;
+   sNew.arena = Arena_new();
+   iSuccessful = sNew.arena != NULL &&
+                 SymTable_buildLeaves(&sNew, SymTable_firstLeaf(oSymTable),
+                                      psNodes, uCount);
+   while (iSuccessful && uCount > 1) {
+      uCount = SymTable_buildInners(&sNew, psNodes, uCount);
+      iSuccessful = (uCount != 0);
+      sNew.height++;
+   }
+   if (iSuccessful) {
+      sNew.root = psNodes[0].node;
+   }
+   free(psNodes);
+   if (! iSuccessful) {
+      if (sNew.arena != NULL) {
+         Arena_free(sNew.arena);
+      }
+      return 0;
+   }
+
+   sNew.allocCount += Arena_getAllocCount(oSymTable->arena);
+   Arena_free(oSymTable->arena);
+   *oSymTable = sNew;
+   return 1;
+}
+
+SymTable_T SymTable_newWithStats(enum SymTableHash eHash){
+   /* a tree has no buckets to probe and never expands, so there is
+   nothing more to count */
+   return SymTable_newWithOptions(eHash);
+}
+
+int SymTable_getStats(SymTable_T oSymTable,
+                      struct SymTableStats *psStats){
+   assert(oSymTable != NULL);
+   assert(psStats != NULL);
+
+   Stats_clear(psStats);
+   psStats->allocCount = SymTable_getAllocCount(oSymTable);
+   psStats->bytes = SymTable_getBytes(oSymTable);
+   return 0;
+}
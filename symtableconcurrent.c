@@ -0,0 +1,2302 @@
+/* symtable concurrent (sharded) implementation */
+#include "symtable.h"
+#include "symtablearena.h"
+#include "symtableatom.h"
+#include "symtablekeyhash.h"
+#include "symtableparallel.h"
+#include "symtablesnapshot.h"
+#include "symtablestats.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <limits.h>
+#include <stddef.h>
+#include <string.h>
+
+/* Every function of this SymTable may be called from several threads
+at once. Keys are routed by the high bits of their hash to one of
+SHARD_COUNT shards, and each shard is a small hash table of its own,
+with its own mutex, bucket array, counters and arena. Threads working
+on keys in different shards never wait for each other or write to the
+same cache line, and a shard that goes over its load limit expands by
+itself (see SymTable_expand) while the other shards carry on. Only
+what needs the whole SymTable at once, like SymTable_map, takes every
+shard lock, always in the same order. SymTable_intern's atom pool is
+shared by all SymTable objects and is not synchronized, so atoms should
+be interned before threads share them.
+
+Lookups (get, contains and their variants) take no lock at all. Writers
+fill in a Binding before publishing it with a release store, and
+readers follow the chains with acquire loads, so a reader sees either
+the old chain or the new one, never half a Binding. A removed Binding,
+or a bucket array replaced by SymTable_expand, may still be in use by
+a reader, so it is only released after a grace period: every reader
+announces itself in a ReaderSlot counter of the current epoch, and
+SymTable_synchronize moves the epoch on and waits until the counters
+of the old one drain. Removed Bindings wait on their shard's retired
+list and are released RETIRE_BATCH at a time, so one grace period
+covers many removals. */
+
+/* how many shards a SymTable is split into, 2 to the SHARD_BITS */
+enum {SHARD_BITS = 6, SHARD_COUNT = 1 << SHARD_BITS};
+
+/* SymTable_mapParallel splits every shard's buckets into this many
+units of work. Shards differ in size, so a unit is a share of one
+shard rather than a fixed number of buckets. */
+enum {MAP_SPLIT = 64};
+
+/* how many ReaderSlots readers are spread over. Threads beyond this
+share slots, which is correct but makes them write the same cache
+line. */
+enum {READER_SLOTS = 64};
+
+/* how many removed Bindings a shard collects before it waits for a
+grace period and releases them */
+enum {RETIRE_BATCH = 128};
+
+/* denotes the min value for the number of buckets of a shard. A
+shard's bucket count is always a power of two. */
+enum BucketEnds {bucketMin = 8};
+
+/* a shard shrinks once it holds fewer Bindings than its expandAt
+divided by SHRINK_RATIO, to the fewest buckets that hold twice its
+Bindings under the max load, so its load sits well between the two
+limits and puts and removes around either one do not resize it back
+and forth */
+enum {SHRINK_RATIO = 8};
+
+/* SymTable_reserve sizes each shard for its share of the bindings
+plus RESERVE_SPREAD times the square root of that share (about how far
+the share of one shard strays from the average) plus RESERVE_SLACK, so
+that no shard of a bulk load has to expand */
+enum {RESERVE_SPREAD = 5, RESERVE_SLACK = 8};
+
+/* keys shorter than INLINE_KEY_SIZE bytes (counting the '\0') are
+stored inside their Binding, longer keys are copied into the arena */
+enum {INLINE_KEY_SIZE = 24};
+
+/* the size of a cache line, which Shards are padded to so that two
+shards never share one */
+enum {CACHE_LINE = 64};
+
+/* how a Binding holds its key: a copy owned by the SymTable, an atom from
+SymTable_intern, or a key borrowed from the client by
+SymTable_putBorrowed. Only copies are released by the SymTable. */
+enum KeyKinds {KEY_COPY = 0, KEY_ATOM = 1, KEY_BORROWED = 2};
+
+/* The lock free readers need the GCC __atomic builtins (which clang
+also has), since C99 has no atomics of its own. */
+#if !defined(__GNUC__)
+#error "symtableconcurrent.c needs the GCC __atomic builtins"
+#endif
+
+/* SYMTABLE_LOAD_RELAXED reads the size_t or pointer that p points to
+and SYMTABLE_STORE_RELAXED writes v to it, each as one indivisible
+access that may be done while another thread accesses the same
+object. They let SymTable_getLength read the shard counts without
+locking. */
+#define SYMTABLE_LOAD_RELAXED(p) __atomic_load_n(p, __ATOMIC_RELAXED)
+#define SYMTABLE_STORE_RELAXED(p, v) \
+   __atomic_store_n(p, v, __ATOMIC_RELAXED)
+
+/* SYMTABLE_STORE_RELEASE publishes v in the object that p points to
+after every write before it, and SYMTABLE_LOAD_ACQUIRE reads such an
+object so that every read after it sees those writes */
+#define SYMTABLE_LOAD_ACQUIRE(p) __atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define SYMTABLE_STORE_RELEASE(p, v) \
+   __atomic_store_n(p, v, __ATOMIC_RELEASE)
+
+/* SYMTABLE_READ_ENTER adds a reader to the counter that p points to,
+ordered before every load of the read, and SYMTABLE_READ_EXIT takes
+it away after all of them */
+#define SYMTABLE_READ_ENTER(p) \
+   ((void)__atomic_fetch_add(p, 1, __ATOMIC_SEQ_CST))
+#define SYMTABLE_READ_EXIT(p) \
+   ((void)__atomic_fetch_sub(p, 1, __ATOMIC_RELEASE))
+
+/* SYMTABLE_THREAD_LOCAL gives each thread its own copy of a static
+variable */
+#define SYMTABLE_THREAD_LOCAL __thread
+
+/* the default max load factor: a SymTable expands once it holds more
+Bindings than buckets */
+#define DEFAULT_MAX_LOAD 1.0
+
+/* Bindings can be formed to make a list of Bindings and hold
+certain variables: key, value, next. */
+struct Binding {
+    /* char pointer to the key: inlineKey for short keys, otherwise
+    a copy in the arena. A copy is always followed by a '\0'. */
+    const char *key;
+    /* void pointer to the value */
+    const void* value;
+    /* full hash of the key, see SymTable_hash */
+    size_t hash;
+    /* how many bytes are in the key, not counting the '\0' */
+    size_t keyLength;
+    /* pointer to the next Binding in list. Readers may follow it at
+    any time, so it is only changed by release stores. */
+    struct Binding *next;
+    /* once the Binding is removed, the next Binding on its shard's
+    retired list */
+    struct Binding *retired;
+    /* holds the key when it fits, so comparing it stays within the
+    Binding */
+    char inlineKey[INLINE_KEY_SIZE];
+    /* KEY_COPY, KEY_ATOM or KEY_BORROWED, see KeyKinds */
+    int keyKind;
+};
+
+/* Buckets is a bucket array together with its size, so a reader that
+loads one pointer gets a size and chains that belong together */
+struct Buckets {
+    /* holds how many buckets there are, a power of two */
+    size_t size;
+    /* the chains of Bindings, one per bucket */
+    struct Binding *chains[];
+};
+
+/* Shard is one of the independent hash tables that a SymTable is
+split into */
+struct Shard {
+    /* held while the shard is changed. Readers do not take it. */
+    pthread_mutex_t lock;
+    /* the bucket array. It only changes while lock is held, so
+    writers read it directly and readers with SYMTABLE_LOAD_ACQUIRE. */
+    struct Buckets *buckets;
+    /* keeps track of how many Bindings are in the shard */
+    size_t bindingsSize;
+    /* the shard expands once bindingsSize exceeds this, which is its
+    bucket count * maxLoad */
+    size_t expandAt;
+    /* the shard shrinks once bindingsSize drops below this, which is
+    expandAt / SHRINK_RATIO, or 0 if it is as small as it may get */
+    size_t shrinkAt;
+    /* the fewest buckets the shard shrinks to: bucketMin, or what
+    SymTable_reserve grew it to */
+    size_t minCount;
+    /* how many Bindings have been moved to a new bucket array by
+    SymTable_expand */
+    size_t rehashCount;
+    /* how many times the shard has called malloc for bucket arrays,
+    and the arenas SymTable_compact has replaced */
+    size_t allocCount;
+    /* how many times a key in the shard has been compared with
+    memcmp */
+    size_t compareCount;
+    /* the Arena that the shard's Bindings and key copies are
+    allocated from */
+    Arena_T arena;
+    /* the removed Bindings that readers may still be looking at,
+    linked by their retired fields */
+    struct Binding *retired;
+    /* how many Bindings are on the retired list */
+    size_t retiredCount;
+    /* how many times SymTable_compact has replaced arena, freeing the
+    retired Bindings with the old one */
+    size_t compactions;
+    /* the lookups made under lock and the expansions of the shard, if
+    the SymTable counts them */
+    struct Stats stats;
+    /* keeps the next Shard off this one's cache line */
+    char padding[CACHE_LINE];
+};
+
+/* ReaderSlot is where the readers of some threads announce themselves.
+A reader adds itself to readers[epoch % 2] for as long as it looks at
+the SymTable. */
+struct ReaderSlot {
+    /* how many readers that started in an even and an odd epoch are
+    still reading */
+    size_t readers[2];
+    /* how many times a reader using the slot has compared a key with
+    memcmp */
+    size_t compareCount;
+    /* the lookups of the readers using the slot, if the SymTable
+    counts them. Like compareCount, they may lose each other's counts
+    when threads share the slot. */
+    struct Stats stats;
+    /* keeps the next ReaderSlot off this one's cache line */
+    char padding[CACHE_LINE];
+};
+
+/* SymTable holds the shards and what they share: the settings, the
+hash function and the grace period bookkeeping */
+struct SymTable {
+    /* counts grace periods; readers use its low bit to pick their
+    counter */
+    size_t epoch;
+    /* the max load factor (Bindings per bucket) before a shard
+    expands */
+    double maxLoad;
+    /* which hash function keys are hashed with, a SymTableHash */
+    enum SymTableHash hashKind;
+    /* the per table seed of the SYMTABLE_HASH_FAST and
+    SYMTABLE_HASH_SIPHASH hash functions */
+    struct KeyHashSeed seed;
+    /* held by SymTable_synchronize, so grace periods do not overlap */
+    pthread_mutex_t graceLock;
+    /* the shards, each on its own cache lines */
+    struct Shard shards[SHARD_COUNT];
+    /* the reader slots, each on its own cache lines */
+    struct ReaderSlot readerSlots[READER_SLOTS];
+    /* the mapped snapshot that a SymTable from SymTable_openMapped
+    answers from instead of its (empty) shards, or NULL. It is set
+    before the SymTable is shared and never changes, so threads read
+    it without any lock. */
+    Snapshot_T snapshot;
+    /* 1 if the SymTable was made by SymTable_newWithStats and counts
+    its lookups and expansions in its shards and reader slots, and 0
+    otherwise. It is set before the SymTable is shared. */
+    int collectStats;
+};
+
+/* MapJob is what the threads of SymTable_mapParallel share: the
+SymTable being mapped and the function to apply */
+struct MapJob {
+    /* the SymTable whose bindings are mapped */
+    SymTable_T oSymTable;
+    /* the function applied to every binding */
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra);
+    /* passed on to pfApply */
+    const void *pvExtra;
+};
+
+/* KeyBounds holds which keys SymTable_mapRange or SymTable_mapPrefix
+maps: the ones in [low, high), or the ones beginning with prefix */
+struct KeyBounds {
+    /* the smallest key mapped, or NULL for no lower bound */
+    const char *low;
+    /* how many bytes are in low */
+    size_t lowLength;
+    /* mapped keys are less than high, unless it is NULL */
+    const char *high;
+    /* how many bytes are in high */
+    size_t highLength;
+    /* what mapped keys begin with, or NULL for a range */
+    const char *prefix;
+    /* how many bytes are in prefix */
+    size_t prefixLength;
+};
+
+/* IterEntry is a binding that an iterator has copied out of a shard */
+struct IterEntry {
+    /* where the copy of the key starts in the iterator's keys */
+    size_t keyOffset;
+    /* void pointer to the value */
+    const void *value;
+};
+
+/* SymTableIter is an iterator over the Bindings of a SymTable. It
+walks one shard at a time, numbering the shard's buckets by the bucket
+count baseCount the shard had when the iterator got to it: bucket i of
+baseCount holds the Bindings whose hash modulo baseCount is i. If the
+shard grows in between, that is every bucket i + k * baseCount of the
+current count, and if it shrinks, the Bindings of bucket i modulo the
+current count that belong there, so the Bindings still to walk stay
+the same. Each call
+that runs out of copies takes the shard lock and copies the Bindings
+of the next non empty bucket, so the client gets keys that no other
+thread can free. */
+struct SymTableIter {
+    /* the SymTable being iterated over */
+    SymTable_T oSymTable;
+    /* the shard being walked, or SHARD_COUNT once all have been */
+    size_t shard;
+    /* the bucket count of the shard when the iterator got to it */
+    size_t baseCount;
+    /* the next bucket of the shard, counting baseCount buckets */
+    size_t bucket;
+    /* array of entryCap IterEntries, the copies of the last bucket */
+    struct IterEntry *entries;
+    /* how many IterEntries entries has room for */
+    size_t entryCap;
+    /* how many IterEntries the last bucket filled */
+    size_t entryCount;
+    /* the IterEntry SymTable_iterNext returns next */
+    size_t nextEntry;
+    /* the '\0' terminated copies of the keys of entries */
+    char *keys;
+    /* how many bytes keys has room for */
+    size_t keyCap;
+    /* the number of the snapshot binding returned next, if the
+    SymTable is mapped */
+    size_t snapshotIndex;
+};
+
+/* SymTable_mix takes in a hash uHash from Atom_hashString and returns
+it mixed so that the low bits, which pick the bucket, depend on every
+character */
+static size_t SymTable_mix(size_t uHash)
+{
+   uHash ^= uHash >> 16;
+   uHash *= (size_t)0x45d9f3bUL;
+   uHash ^= uHash >> 16;
+   uHash *= (size_t)0x45d9f3bUL;
+   uHash ^= uHash >> 16;
+   return uHash;
+}
+
+/* this function takes in SymTable oSymTable, a const char pointer
+pcKey and its length uLength and returns the full hash of pcKey as a
+type size_t. By default that is the byte at a time hash from the
+assignment followed by a mixing step; the seeded hashes are already
+well spread and are used as they are. */
+static size_t SymTable_hash(SymTable_T oSymTable, const char *pcKey,
+                            size_t uLength)
+{
+   switch (oSymTable->hashKind) {
+   case SYMTABLE_HASH_FAST:
+      return KeyHash_fast(pcKey, uLength, &oSymTable->seed);
+   case SYMTABLE_HASH_SIPHASH:
+      return KeyHash_sip(pcKey, uLength, &oSymTable->seed);
+   default:
+      return SymTable_mix(Atom_hashBytes(pcKey, uLength));
+   }
+}
+
+/* SymTable_rehash takes in SymTable oSymTable, a const char pointer
+pcKey, its length uLength and uHash, the default hash of pcKey (from
+an atom or SymTable_hashKey). It returns SymTable_hash of pcKey,
+mixing uHash instead of hashing pcKey if oSymTable uses the default
+hash. */
+static size_t SymTable_rehash(SymTable_T oSymTable, const char *pcKey,
+                              size_t uLength, size_t uHash)
+{
+   if (oSymTable->hashKind == SYMTABLE_HASH_DEFAULT) {
+      return SymTable_mix(uHash);
+   }
+   return SymTable_hash(oSymTable, pcKey, uLength);
+}
+
+/* SymTable_shardOf takes in SymTable oSymTable and a full hash uHash
+and returns the Shard that uHash belongs to. uHash is multiplied by
+2^64 divided by the golden ratio (Fibonacci hashing) and the shard is
+picked by the high bits of the product, which depend on every bit of
+uHash, so keys spread over the shards even when the high bits of uHash
+are all zero, as they are for short keys under the default hash. */
+static struct Shard *SymTable_shardOf(SymTable_T oSymTable, size_t uHash)
+{
+   return &oSymTable->shards[(uHash * (size_t)0x9e3779b97f4a7c15ULL) >>
+                             (sizeof(size_t) * CHAR_BIT - SHARD_BITS)];
+}
+
+/* SymTable_readBuckets takes in SymTable oSymTable and a full hash
+uHash and returns the bucket array of the shard uHash belongs to, for
+a reader, which holds no lock */
+static struct Buckets *SymTable_readBuckets(SymTable_T oSymTable,
+                                            size_t uHash)
+{
+   struct Shard *pShard = SymTable_shardOf(oSymTable, uHash);
+
+   return SYMTABLE_LOAD_ACQUIRE(&pShard->buckets);
+}
+
+/* SymTable_lockShard takes in SymTable oSymTable and a full hash
+uHash, locks the shard that uHash belongs to and returns it */
+static struct Shard *SymTable_lockShard(SymTable_T oSymTable,
+                                        size_t uHash)
+{
+   struct Shard *pShard = SymTable_shardOf(oSymTable, uHash);
+
+   pthread_mutex_lock(&pShard->lock);
+   return pShard;
+}
+
+/* SymTable_lockAll takes in SymTable oSymTable and locks every
+shard, always in the same order so two threads doing it cannot
+deadlock */
+static void SymTable_lockAll(SymTable_T oSymTable)
+{
+   size_t i;
+
+   for (i = 0; i < SHARD_COUNT; i++) {
+      pthread_mutex_lock(&oSymTable->shards[i].lock);
+   }
+}
+
+/* SymTable_unlockAll takes in SymTable oSymTable and unlocks every
+shard */
+static void SymTable_unlockAll(SymTable_T oSymTable)
+{
+   size_t i;
+
+   for (i = SHARD_COUNT; i > 0; i--) {
+      pthread_mutex_unlock(&oSymTable->shards[i - 1].lock);
+   }
+}
+
+/* SymTable_readerSlot returns the index of the ReaderSlot the calling
+thread uses. Threads are handed slots in turn the first time they
+read. */
+static size_t SymTable_readerSlot(void)
+{
+   static size_t uThreadCount = 0;
+   static SYMTABLE_THREAD_LOCAL size_t uSlot = 0;
+
+   if (uSlot == 0) {
+      /* 0 means the thread has no slot yet, so slots count from 1 */
+      uSlot = __atomic_add_fetch(&uThreadCount, 1, __ATOMIC_RELAXED);
+   }
+   return (uSlot - 1) % READER_SLOTS;
+}
+
+/* SymTable_beginRead takes in SymTable oSymTable, announces the
+calling thread as a reader of it and sets *ppSlot to the thread's
+ReaderSlot. Until the thread passes the returned counter to
+SymTable_endRead, no Binding or bucket array it finds is released. */
+static size_t *SymTable_beginRead(SymTable_T oSymTable,
+                                  struct ReaderSlot **ppSlot)
+{
+   struct ReaderSlot *pSlot;
+   size_t *puReaders;
+
+   pSlot = &oSymTable->readerSlots[SymTable_readerSlot()];
+   puReaders =
+      &pSlot->readers[SYMTABLE_LOAD_RELAXED(&oSymTable->epoch) & 1];
+   SYMTABLE_READ_ENTER(puReaders);
+   *ppSlot = pSlot;
+   return puReaders;
+}
+
+/* SymTable_endRead takes in the counter puReaders that
+SymTable_beginRead returned and ends the read */
+static void SymTable_endRead(size_t *puReaders)
+{
+   SYMTABLE_READ_EXIT(puReaders);
+}
+
+/* SymTable_synchronize takes in SymTable oSymTable and waits for a
+grace period: it returns once every reader that was reading when it
+was called has ended its read. Anything unpublished before the call is
+then out of every reader's reach. The epoch is moved on twice, waiting
+each time for the readers of the epoch that was left, since a reader
+that loaded the epoch just before it moved counts itself in the old
+one. */
+static void SymTable_synchronize(SymTable_T oSymTable)
+{
+   size_t uIndex;
+   size_t uPass;
+   size_t i;
+
+   /* order the caller's unpublishing stores before the counter loads
+   below */
+   __atomic_thread_fence(__ATOMIC_SEQ_CST);
+   pthread_mutex_lock(&oSymTable->graceLock);
+   for (uPass = 0; uPass < 2; uPass++) {
+      uIndex = oSymTable->epoch & 1;
+      __atomic_store_n(&oSymTable->epoch, oSymTable->epoch + 1,
+                       __ATOMIC_SEQ_CST);
+      for (i = 0; i < READER_SLOTS; i++) {
+         while (__atomic_load_n(&oSymTable->readerSlots[i].readers[uIndex],
+                                __ATOMIC_SEQ_CST) != 0) {
+            sched_yield();
+         }
+      }
+   }
+   pthread_mutex_unlock(&oSymTable->graceLock);
+}
+
+/* SymTable_addCount takes in a counter puCount, such as a comparison
+count, and adds uAmount to it. Threads sharing a ReaderSlot may lose
+each other's additions, which only makes the count approximate. */
+static void SymTable_addCount(size_t *puCount, size_t uAmount)
+{
+   if (uAmount != 0) {
+      SYMTABLE_STORE_RELAXED(puCount,
+                             SYMTABLE_LOAD_RELAXED(puCount) + uAmount);
+   }
+}
+
+/* SymTable_statsOf takes in SymTable oSymTable and the Stats psStats
+of one of its shards or reader slots, and returns psStats if
+oSymTable counts its lookups and NULL otherwise */
+static struct Stats *SymTable_statsOf(SymTable_T oSymTable,
+                                      struct Stats *psStats)
+{
+   return oSymTable->collectStats ? psStats : NULL;
+}
+
+/* SymTable_countLookup takes in a bucket array pBuckets, a full hash
+uHash, the Binding pFound that a lookup of a key with hash uHash found
+in pBuckets (or NULL) and the Stats psStats to count in. It walks the
+chain of uHash again to see how many Bindings the lookup looked at,
+and counts the lookup. As with SymTable_addCount, threads sharing
+psStats may lose each other's counts. */
+static void SymTable_countLookup(struct Buckets *pBuckets, size_t uHash,
+                                 const struct Binding *pFound,
+                                 struct Stats *psStats)
+{
+   struct Binding *currNode;
+   size_t uProbes = 0;
+
+   currNode = SYMTABLE_LOAD_ACQUIRE(
+      &pBuckets->chains[uHash & (pBuckets->size - 1)]);
+   while (currNode != NULL) {
+      uProbes++;
+      if (currNode == pFound) {
+         break;
+      }
+      currNode = SYMTABLE_LOAD_ACQUIRE(&currNode->next);
+   }
+   if (pFound != NULL) {
+      SymTable_addCount(&psStats->hits, 1);
+      SymTable_addCount(&psStats->hitProbes, uProbes);
+   } else {
+      SymTable_addCount(&psStats->misses, 1);
+      SymTable_addCount(&psStats->missProbes, uProbes);
+   }
+}
+
+/* SymTable_find takes in a bucket array pBuckets, a const char pointer
+pcKey, its length uLength, its full hash uHash, iAtom, which is 1 if
+pcKey is an atom, the comparison counter puCompares to count in and
+the Stats psStats to count the lookup in, or NULL. It returns the
+Binding whose key is pcKey, or NULL if there is none. The caller
+either holds the shard lock of uHash or is a reader. */
+static struct Binding *SymTable_find(struct Buckets *pBuckets,
+                                     const char *pcKey, size_t uLength,
+                                     size_t uHash, int iAtom,
+                                     size_t *puCompares,
+                                     struct Stats *psStats)
+{
+   struct Binding *currNode;
+   size_t uCompares = 0;
+
+   currNode = SYMTABLE_LOAD_ACQUIRE(
+      &pBuckets->chains[uHash & (pBuckets->size - 1)]);
+   while (currNode != NULL) {
+      if (currNode->hash == uHash && currNode->keyLength == uLength) {
+         if (currNode->key == pcKey) {
+            break;
+         }
+         /* equal strings always intern to the same atom */
+         if (! (iAtom && currNode->keyKind == KEY_ATOM)) {
+            uCompares++;
+            if (memcmp(currNode->key, pcKey, uLength) == 0) {
+               break;
+            }
+         }
+      }
+      currNode = SYMTABLE_LOAD_ACQUIRE(&currNode->next);
+   }
+   SymTable_addCount(puCompares, uCompares);
+   if (psStats != NULL) {
+      SymTable_countLookup(pBuckets, uHash, currNode, psStats);
+   }
+   return currNode;
+}
+
+/* SymTable_newBuckets takes in a bucket count uCount and returns a new
+bucket array of that many empty buckets, or NULL if there is
+insufficient memory */
+static struct Buckets *SymTable_newBuckets(size_t uCount)
+{
+   struct Buckets *pBuckets;
+
+   if (uCount > ((size_t)-1 - sizeof(struct Buckets)) /
+                sizeof(struct Binding*)) {
+      return NULL;
+   }
+   pBuckets = calloc(1, sizeof(struct Buckets) +
+                        uCount * sizeof(struct Binding*));
+   if (pBuckets == NULL) {
+      return NULL;
+   }
+   pBuckets->size = uCount;
+   return pBuckets;
+}
+
+/* SymTable_bucketOf takes in a Binding pNode and a bucket count
+uCount and returns the bucket pNode belongs in */
+static size_t SymTable_bucketOf(const struct Binding *pNode,
+                                size_t uCount)
+{
+   return pNode->hash & (uCount - 1);
+}
+
+/* SymTable_setExpandAt takes in a SymTable oSymTable and its locked
+Shard pShard and recomputes pShard's expandAt and shrinkAt from its
+bucket count and maxLoad */
+static void SymTable_setExpandAt(SymTable_T oSymTable,
+                                 struct Shard *pShard)
+{
+   double dExpandAt = (double)pShard->buckets->size * oSymTable->maxLoad;
+
+   if (dExpandAt >= (double)(size_t)-1) {
+      pShard->expandAt = (size_t)-1;
+   } else {
+      pShard->expandAt = (size_t)dExpandAt;
+   }
+   if (pShard->buckets->size <= pShard->minCount) {
+      pShard->shrinkAt = 0;
+   } else {
+      pShard->shrinkAt = pShard->expandAt / SHRINK_RATIO;
+   }
+}
+
+/* SymTable_expand takes in SymTable oSymTable, its locked Shard
+pShard and a bucket count uNewCount, a power of two larger than
+pShard's, and grows pShard's bucket array to uNewCount buckets. Only
+pShard's lock is held, so the other shards go on being read and
+changed meanwhile. It returns 0 and leaves pShard unchanged if there
+is insufficient memory, and 1 otherwise.
+
+Readers keep going while it works, so no Binding is moved or copied.
+Old bucket i splits into new buckets i, i + the old count, i + twice
+the old count and so on; each new bucket first points at its first
+Binding in the old chain, so every new chain runs through the old one
+and still reaches all its Bindings ("zipped"). Once no reader uses the
+old array, the chains are unzipped one run at a time: the last Binding
+of a run is pointed past the runs of the other buckets that follow
+it, to the next Binding of its own. A reader of another bucket might
+be standing on that Binding, so there is a grace period between
+rounds. */
+static int SymTable_expand(SymTable_T oSymTable, struct Shard *pShard,
+                           size_t uNewCount)
+{
+   struct Buckets *oldBuckets = pShard->buckets;
+   struct Buckets *newBuckets;
+   struct Binding *currNode;
+   struct Binding *nextNode;
+   size_t uBucket;
+   size_t i;
+   int iZipped;
+
+   assert(uNewCount > oldBuckets->size);
+
+   newBuckets = SymTable_newBuckets(uNewCount);
+   if (newBuckets == NULL) {
+      return 0;
+   }
+   pShard->allocCount++;
+
+   for (i = 0; i < oldBuckets->size; i++) {
+      for (currNode = oldBuckets->chains[i]; currNode != NULL;
+           currNode = currNode->next) {
+         uBucket = SymTable_bucketOf(currNode, uNewCount);
+         if (newBuckets->chains[uBucket] == NULL) {
+            newBuckets->chains[uBucket] = currNode;
+         }
+         pShard->rehashCount++;
+      }
+   }
+   SYMTABLE_STORE_RELEASE(&pShard->buckets, newBuckets);
+   SymTable_synchronize(oSymTable);
+
+   /* no reader uses the old array any more, so its chains now mark
+   where each old chain's next run to unzip starts */
+   do {
+      iZipped = 0;
+      for (i = 0; i < oldBuckets->size; i++) {
+         currNode = oldBuckets->chains[i];
+         if (currNode == NULL) {
+            continue;
+         }
+         uBucket = SymTable_bucketOf(currNode, uNewCount);
+         while (currNode->next != NULL &&
+                SymTable_bucketOf(currNode->next, uNewCount) == uBucket) {
+            currNode = currNode->next;
+         }
+         oldBuckets->chains[i] = currNode->next;
+         if (currNode->next == NULL) {
+            continue;
+         }
+         nextNode = currNode->next->next;
+         while (nextNode != NULL &&
+                SymTable_bucketOf(nextNode, uNewCount) != uBucket) {
+            nextNode = nextNode->next;
+         }
+         SYMTABLE_STORE_RELEASE(&currNode->next, nextNode);
+         iZipped = 1;
+      }
+      if (iZipped) {
+         SymTable_synchronize(oSymTable);
+      }
+   } while (iZipped);
+   free(oldBuckets);
+   SymTable_setExpandAt(oSymTable, pShard);
+   return 1;
+}
+
+/* SymTable_growShard takes in SymTable oSymTable, one of its locked
+Shards pShard and a binding count uBindings. If pShard has too few
+buckets to hold uBindings bindings under the max load, it expands
+straight to the fewest that do, so its bindings are rehashed once
+however far it grows. It returns 1, or 0 (leaving pShard unchanged)
+if there is insufficient memory or the bucket count cannot grow. */
+static int SymTable_growShard(SymTable_T oSymTable, struct Shard *pShard,
+                              size_t uBindings)
+{
+   size_t uCount = pShard->buckets->size;
+
+   while ((double)uCount * oSymTable->maxLoad < (double)uBindings) {
+      if (uCount > (size_t)-1 / 2 / sizeof(struct Binding*)) {
+         return 0;
+      }
+      uCount *= 2;
+   }
+   if (uCount == pShard->buckets->size) {
+      return 1;
+   }
+   return SymTable_expand(oSymTable, pShard, uCount);
+}
+
+/* SymTable_shrink takes in SymTable oSymTable, its locked Shard
+pShard and a bucket count uNewCount, a power of two smaller than
+pShard's, and shrinks pShard's bucket array to uNewCount buckets. It
+returns 0 and leaves pShard unchanged if there is insufficient memory,
+and 1 otherwise.
+
+As in SymTable_expand no Binding is moved or copied. Old buckets i,
+i + uNewCount, i + twice uNewCount and so on merge into new bucket i
+by pointing the last Binding of each of their chains at the first
+Binding of the next. A reader still on one of the old chains walks on
+into the chains merged after it, which costs it a few comparisons but
+never a Binding, so one grace period is enough before the old array is
+freed. */
+static int SymTable_shrink(SymTable_T oSymTable, struct Shard *pShard,
+                           size_t uNewCount)
+{
+   struct Buckets *oldBuckets = pShard->buckets;
+   struct Buckets *newBuckets;
+   struct Binding *currNode;
+   struct Binding **ppTail;
+   size_t i;
+   size_t j;
+
+   assert(uNewCount < oldBuckets->size);
+
+   newBuckets = SymTable_newBuckets(uNewCount);
+   if (newBuckets == NULL) {
+      return 0;
+   }
+   pShard->allocCount++;
+
+   for (i = 0; i < uNewCount; i++) {
+      ppTail = &newBuckets->chains[i];
+      for (j = i; j < oldBuckets->size; j += uNewCount) {
+         currNode = oldBuckets->chains[j];
+         if (currNode == NULL) {
+            continue;
+         }
+         SYMTABLE_STORE_RELEASE(ppTail, currNode);
+         pShard->rehashCount++;
+         while (currNode->next != NULL) {
+            currNode = currNode->next;
+            pShard->rehashCount++;
+         }
+         ppTail = &currNode->next;
+      }
+   }
+   SYMTABLE_STORE_RELEASE(&pShard->buckets, newBuckets);
+   SymTable_synchronize(oSymTable);
+   free(oldBuckets);
+   SymTable_setExpandAt(oSymTable, pShard);
+   return 1;
+}
+
+/* SymTable_fitCount takes in SymTable oSymTable and a binding count
+uBindings, and returns the fewest buckets (a power of two, from
+bucketMin on) that hold uBindings Bindings under the max load, or the
+most there can be if none do */
+static size_t SymTable_fitCount(SymTable_T oSymTable, size_t uBindings)
+{
+   size_t uCount = bucketMin;
+
+   while ((double)uCount * oSymTable->maxLoad < (double)uBindings &&
+          uCount <= (size_t)-1 / 2 / sizeof(struct Binding*)) {
+      uCount *= 2;
+   }
+   return uCount;
+}
+
+/* SymTable_shrinkShard takes in SymTable oSymTable and one of its
+locked Shards pShard, which holds fewer Bindings than its shrinkAt, and
+shrinks pShard to the fewest buckets (but not below its minCount) that
+hold twice its Bindings under the max load. If there is insufficient
+memory pShard is left as it is. */
+static void SymTable_shrinkShard(SymTable_T oSymTable,
+                                 struct Shard *pShard)
+{
+   size_t uCount;
+
+   uCount = SymTable_fitCount(oSymTable, 2 * pShard->bindingsSize);
+   if (uCount < pShard->minCount) {
+      uCount = pShard->minCount;
+   }
+   if (uCount < pShard->buckets->size) {
+      (void)SymTable_shrink(oSymTable, pShard, uCount);
+   }
+}
+
+/* SymTable_newBinding takes in the locked Shard pShard, a const
+char pointer pcKey, its length uLength and iKind, one of KeyKinds. It
+returns a new Binding from the shard's arena holding pcKey itself if
+it is an atom or borrowed, and otherwise a '\0' terminated copy of
+pcKey (inside the Binding if it is short enough), or NULL if there is
+insufficient memory. */
+static struct Binding *SymTable_newBinding(struct Shard *pShard,
+                                           const char *pcKey,
+                                           size_t uLength, int iKind)
+{
+   struct Binding *nNode;
+   size_t uKeySize;
+   char *defCopy;
+
+   nNode = Arena_alloc(pShard->arena, sizeof(struct Binding));
+   if (nNode == NULL) {
+      return NULL;
+   }
+   nNode->keyKind = iKind;
+   nNode->keyLength = uLength;
+   if (iKind != KEY_COPY) {
+      /* atoms live as long as the program, and borrowed keys as long
+      as the client promised, so no copy is needed */
+      nNode->key = pcKey;
+      return nNode;
+   }
+   uKeySize = uLength + 1;
+   if (uKeySize <= INLINE_KEY_SIZE) {
+      defCopy = nNode->inlineKey;
+   } else {
+      defCopy = Arena_alloc(pShard->arena, uKeySize);
+      if (defCopy == NULL) {
+         Arena_release(pShard->arena, nNode, sizeof(struct Binding));
+         return NULL;
+      }
+   }
+   memcpy(defCopy, pcKey, uLength);
+   defCopy[uLength] = '\0';
+   nNode->key = defCopy;
+   return nNode;
+}
+
+/* SymTable_add takes in SymTable oSymTable, the locked Shard pShard
+of uHash, a const char pointer pcKey that is not in oSymTable, its
+length uLength, its full hash uHash, a const void pointer pvValue and
+iKind, one of KeyKinds. It adds a new binding, expanding pShard if it
+is over its limit, and returns its Binding, or returns NULL and leaves
+oSymTable unchanged if there is insufficient memory. */
+static struct Binding *SymTable_add(SymTable_T oSymTable,
+                                    struct Shard *pShard,
+                                    const char *pcKey, size_t uLength,
+                                    size_t uHash, const void *pvValue,
+                                    int iKind)
+{
+   struct Binding *nNode;
+   size_t uBucket;
+   double dStart = 0.0;
+
+   nNode = SymTable_newBinding(pShard, pcKey, uLength, iKind);
+   if (nNode == NULL) {
+      return NULL;
+   }
+
+   uBucket = uHash & (pShard->buckets->size - 1);
+   nNode->value = pvValue;
+   nNode->hash = uHash;
+   nNode->next = pShard->buckets->chains[uBucket];
+   /* readers may see nNode as soon as it is stored, so it must be
+   complete first */
+   SYMTABLE_STORE_RELEASE(&pShard->buckets->chains[uBucket], nNode);
+   SYMTABLE_STORE_RELAXED(&pShard->bindingsSize,
+                          pShard->bindingsSize + 1);
+
+   /* a failed expansion leaves the shard as it is, only slower */
+   if (pShard->bindingsSize > pShard->expandAt) {
+      if (oSymTable->collectStats) {
+         dStart = Stats_now();
+      }
+      if (SymTable_growShard(oSymTable, pShard, pShard->bindingsSize) &&
+          oSymTable->collectStats) {
+         Stats_addExpansion(&pShard->stats, dStart);
+      }
+   }
+   return nNode;
+}
+
+/* SymTable_insert takes in SymTable oSymTable, a const char pointer
+pcKey, its length uLength, its full hash uHash, a const void pointer
+pvValue and iKind, one of KeyKinds. If oSymTable doesn't contain
+pcKey, a new binding is added and 1 is returned. If it does, or there
+is insufficient memory, oSymTable is left unchanged and 0 is
+returned. */
+static int SymTable_insert(SymTable_T oSymTable, const char *pcKey,
+                           size_t uLength, size_t uHash,
+                           const void *pvValue, int iKind)
+{
+   struct Shard *pShard;
+   int iSuccessful = 0;
+
+   /* a mapped SymTable is read-only */
+   if (oSymTable->snapshot != NULL) {
+      return 0;
+   }
+   pShard = SymTable_lockShard(oSymTable, uHash);
+   if (SymTable_find(pShard->buckets, pcKey, uLength, uHash,
+                     iKind == KEY_ATOM, &pShard->compareCount,
+                     SymTable_statsOf(oSymTable, &pShard->stats)) == NULL &&
+       SymTable_add(oSymTable, pShard, pcKey, uLength, uHash, pvValue,
+                    iKind) != NULL) {
+      iSuccessful = 1;
+   }
+   pthread_mutex_unlock(&pShard->lock);
+   return iSuccessful;
+}
+
+/* SymTable_lookup takes in SymTable oSymTable, a const char pointer
+pcKey, its length uLength, its full hash uHash and iAtom, which is 1
+if pcKey is an atom. It sets *ppvValue to the value of pcKey and
+returns 1, or returns 0 if oSymTable doesn't contain pcKey. It takes
+no lock. */
+static int SymTable_lookup(SymTable_T oSymTable, const char *pcKey,
+                           size_t uLength, size_t uHash, int iAtom,
+                           void **ppvValue)
+{
+   struct ReaderSlot *pSlot;
+   struct Binding *currNode;
+   size_t *puReaders;
+
+   /* a snapshot never changes, so reading it needs no grace period
+   bookkeeping. It has its own hash function, so uHash is of no use. */
+   if (oSymTable->snapshot != NULL) {
+      return Snapshot_find(oSymTable->snapshot, pcKey, uLength, ppvValue);
+   }
+   puReaders = SymTable_beginRead(oSymTable, &pSlot);
+   currNode = SymTable_find(SymTable_readBuckets(oSymTable, uHash),
+                            pcKey, uLength, uHash, iAtom,
+                            &pSlot->compareCount,
+                            SymTable_statsOf(oSymTable, &pSlot->stats));
+   if (currNode != NULL) {
+      *ppvValue = (void*)SYMTABLE_LOAD_ACQUIRE(&currNode->value);
+   }
+   SymTable_endRead(puReaders);
+   return currNode != NULL;
+}
+
+/* SymTable_releaseBinding takes in the locked Shard pShard and a
+Binding pNode of it that no reader can reach, and gives pNode and its
+key copy back to the shard's arena */
+static void SymTable_releaseBinding(struct Shard *pShard,
+                                    struct Binding *pNode)
+{
+   if (pNode->keyKind == KEY_COPY && pNode->key != pNode->inlineKey) {
+      Arena_release(pShard->arena, (char *)pNode->key,
+                    pNode->keyLength + 1);
+   }
+   Arena_release(pShard->arena, pNode, sizeof(struct Binding));
+}
+
+/* SymTable_reclaim takes in SymTable oSymTable, one of its Shards
+pShard, which the calling thread does not hold, a list pRetired of
+Bindings taken off pShard's retired list and pShard's compactions
+count uCompactions at the time. It waits until no reader can be
+looking at them and releases them, unless SymTable_compact has freed
+them with the arena they were in meanwhile. */
+static void SymTable_reclaim(SymTable_T oSymTable, struct Shard *pShard,
+                             struct Binding *pRetired,
+                             size_t uCompactions)
+{
+   struct Binding *nextNode;
+
+   SymTable_synchronize(oSymTable);
+   pthread_mutex_lock(&pShard->lock);
+   if (pShard->compactions != uCompactions) {
+      pRetired = NULL;
+   }
+   for (; pRetired != NULL; pRetired = nextNode) {
+      nextNode = pRetired->retired;
+      SymTable_releaseBinding(pShard, pRetired);
+   }
+   pthread_mutex_unlock(&pShard->lock);
+}
+
+/* SymTable_delete takes in SymTable oSymTable, a const char pointer
+pcKey, its length uLength and its full hash uHash. It removes the
+binding of pcKey and returns its value, or returns NULL if oSymTable
+doesn't contain pcKey. The Binding is unlinked at once but released
+only after a grace period. */
+static void *SymTable_delete(SymTable_T oSymTable, const char *pcKey,
+                             size_t uLength, size_t uHash)
+{
+   struct Shard *pShard;
+   struct Binding **ppNode;
+   struct Binding *currNode;
+   struct Binding *pRetired = NULL;
+   size_t uCompactions = 0;
+   void *value = NULL;
+
+   if (oSymTable->snapshot != NULL) {
+      return NULL;
+   }
+   pShard = SymTable_lockShard(oSymTable, uHash);
+   ppNode = &pShard->buckets->chains[uHash & (pShard->buckets->size - 1)];
+   while ((currNode = *ppNode) != NULL) {
+      if (currNode->hash == uHash && currNode->keyLength == uLength) {
+         if (currNode->key != pcKey) {
+            pShard->compareCount++;
+         }
+         if (currNode->key == pcKey ||
+             memcmp(currNode->key, pcKey, uLength) == 0) {
+            break;
+         }
+      }
+      ppNode = &currNode->next;
+   }
+   if (currNode != NULL) {
+      /* a reader on currNode can still follow its next */
+      SYMTABLE_STORE_RELEASE(ppNode, currNode->next);
+      value = (void*)currNode->value;
+      SYMTABLE_STORE_RELAXED(&pShard->bindingsSize,
+                             pShard->bindingsSize - 1);
+      currNode->retired = pShard->retired;
+      pShard->retired = currNode;
+      pShard->retiredCount++;
+      if (pShard->retiredCount >= RETIRE_BATCH) {
+         pRetired = pShard->retired;
+         pShard->retired = NULL;
+         pShard->retiredCount = 0;
+         uCompactions = pShard->compactions;
+      }
+      if (pShard->bindingsSize < pShard->shrinkAt) {
+         SymTable_shrinkShard(oSymTable, pShard);
+      }
+   }
+   pthread_mutex_unlock(&pShard->lock);
+
+   if (pRetired != NULL) {
+      SymTable_reclaim(oSymTable, pShard, pRetired, uCompactions);
+   }
+   return value;
+}
+
+/* SymTable_initShard takes in SymTable oSymTable and one of its
+Shards pShard and sets pShard up empty. It returns 1, or 0 with
+nothing left to free if there is insufficient memory. */
+static int SymTable_initShard(SymTable_T oSymTable, struct Shard *pShard)
+{
+   pShard->buckets = SymTable_newBuckets(bucketMin);
+   if (pShard->buckets == NULL) {
+      return 0;
+   }
+   pShard->arena = Arena_new();
+   if (pShard->arena == NULL) {
+      free(pShard->buckets);
+      return 0;
+   }
+   if (pthread_mutex_init(&pShard->lock, NULL) != 0) {
+      Arena_free(pShard->arena);
+      free(pShard->buckets);
+      return 0;
+   }
+   pShard->bindingsSize = 0;
+   pShard->compareCount = 0;
+   pShard->rehashCount = 0;
+   pShard->allocCount = 1;
+   pShard->retired = NULL;
+   pShard->retiredCount = 0;
+   pShard->compactions = 0;
+   pShard->minCount = bucketMin;
+   Stats_init(&pShard->stats);
+   SymTable_setExpandAt(oSymTable, pShard);
+   return 1;
+}
+
+/* SymTable_freeShard takes in a Shard pShard that no thread uses and
+frees everything it holds */
+static void SymTable_freeShard(struct Shard *pShard)
+{
+   pthread_mutex_destroy(&pShard->lock);
+   Arena_free(pShard->arena);
+   free(pShard->buckets);
+}
+
+SymTable_T SymTable_new(void){
+   return SymTable_newWithOptions(SYMTABLE_HASH_DEFAULT);
+}
+
+SymTable_T SymTable_newWithOptions(enum SymTableHash eHash){
+   struct SymTable *oSymTable;
+   size_t i;
+
+   if (eHash != SYMTABLE_HASH_DEFAULT && eHash != SYMTABLE_HASH_FAST &&
+       eHash != SYMTABLE_HASH_SIPHASH) {
+      return NULL;
+   }
+   oSymTable = malloc(sizeof(struct SymTable));
+   if(oSymTable == NULL){
+      return NULL;
+   }
+   oSymTable->hashKind = eHash;
+   oSymTable->seed.k0 = 0;
+   oSymTable->seed.k1 = 0;
+   if (eHash != SYMTABLE_HASH_DEFAULT) {
+      KeyHash_randomSeed(&oSymTable->seed);
+   }
+   oSymTable->maxLoad = DEFAULT_MAX_LOAD;
+   oSymTable->epoch = 0;
+   oSymTable->snapshot = NULL;
+   oSymTable->collectStats = 0;
+   if (pthread_mutex_init(&oSymTable->graceLock, NULL) != 0) {
+      free(oSymTable);
+      return NULL;
+   }
+   for (i = 0; i < READER_SLOTS; i++) {
+      oSymTable->readerSlots[i].readers[0] = 0;
+      oSymTable->readerSlots[i].readers[1] = 0;
+      oSymTable->readerSlots[i].compareCount = 0;
+      Stats_init(&oSymTable->readerSlots[i].stats);
+   }
+   for (i = 0; i < SHARD_COUNT; i++) {
+      if (! SymTable_initShard(oSymTable, &oSymTable->shards[i])) {
+         break;
+      }
+   }
+   if (i < SHARD_COUNT) {
+      /* undo the shards that were set up */
+      while (i > 0) {
+         i--;
+         SymTable_freeShard(&oSymTable->shards[i]);
+      }
+      pthread_mutex_destroy(&oSymTable->graceLock);
+      free(oSymTable);
+      return NULL;
+   }
+   return oSymTable;
+}
+
+void SymTable_free(SymTable_T oSymTable){
+   size_t i;
+
+   assert(oSymTable != NULL);
+
+   /* no other thread may still be using oSymTable, and every Binding
+   and key copy, retired or not, lives in a shard's arena */
+   for (i = 0; i < SHARD_COUNT; i++) {
+      SymTable_freeShard(&oSymTable->shards[i]);
+   }
+   pthread_mutex_destroy(&oSymTable->graceLock);
+   Snapshot_close(oSymTable->snapshot);
+   free(oSymTable);
+}
+
+size_t SymTable_getLength(SymTable_T oSymTable){
+   size_t uLength = 0;
+   size_t i;
+
+   assert(oSymTable != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      return Snapshot_getLength(oSymTable->snapshot);
+   }
+   /* the shard counts are read without locking, so while other
+   threads put and remove the sum is only approximate */
+   for (i = 0; i < SHARD_COUNT; i++) {
+      uLength += SYMTABLE_LOAD_RELAXED(&oSymTable->shards[i].bindingsSize);
+   }
+   return uLength;
+}
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey,
+                 const void *pvValue) {
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   return SymTable_putN(oSymTable, pcKey, strlen(pcKey), pvValue);
+}
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey,
+                       const void *pvValue){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   return SymTable_replaceN(oSymTable, pcKey, strlen(pcKey), pvValue);
+}
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   return SymTable_containsN(oSymTable, pcKey, strlen(pcKey));
+}
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   return SymTable_getN(oSymTable, pcKey, strlen(pcKey));
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   return SymTable_removeN(oSymTable, pcKey, strlen(pcKey));
+}
+
+int SymTable_putN(SymTable_T oSymTable, const void *pvKey,
+                  size_t uLength, const void *pvValue){
+   assert(oSymTable != NULL);
+   assert(pvKey != NULL);
+
+   return SymTable_insert(oSymTable, pvKey, uLength,
+                          SymTable_hash(oSymTable, pvKey, uLength),
+                          pvValue, KEY_COPY);
+}
+
+void *SymTable_replaceN(SymTable_T oSymTable, const void *pvKey,
+                        size_t uLength, const void *pvValue){
+   struct Shard *pShard;
+   struct Binding *currNode;
+   size_t uHash;
+   void* oldValue = NULL;
+
+   assert(oSymTable != NULL);
+   assert(pvKey != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      return NULL;
+   }
+   uHash = SymTable_hash(oSymTable, pvKey, uLength);
+   pShard = SymTable_lockShard(oSymTable, uHash);
+   currNode = SymTable_find(pShard->buckets, pvKey, uLength, uHash, 0,
+                            &pShard->compareCount,
+                            SymTable_statsOf(oSymTable, &pShard->stats));
+   if (currNode != NULL) {
+      oldValue = (void*)currNode->value;
+      SYMTABLE_STORE_RELEASE(&currNode->value, pvValue);
+   }
+   pthread_mutex_unlock(&pShard->lock);
+   return oldValue;
+}
+
+int SymTable_containsN(SymTable_T oSymTable, const void *pvKey,
+                       size_t uLength){
+   void *pvValue;
+
+   assert(oSymTable != NULL);
+   assert(pvKey != NULL);
+
+   return SymTable_lookup(oSymTable, pvKey, uLength,
+                          SymTable_hash(oSymTable, pvKey, uLength), 0,
+                          &pvValue);
+}
+
+void *SymTable_getN(SymTable_T oSymTable, const void *pvKey,
+                    size_t uLength){
+   void *pvValue = NULL;
+
+   assert(oSymTable != NULL);
+   assert(pvKey != NULL);
+
+   (void)SymTable_lookup(oSymTable, pvKey, uLength,
+                         SymTable_hash(oSymTable, pvKey, uLength), 0,
+                         &pvValue);
+   return pvValue;
+}
+
+void *SymTable_removeN(SymTable_T oSymTable, const void *pvKey,
+                       size_t uLength){
+   assert(oSymTable != NULL);
+   assert(pvKey != NULL);
+
+   return SymTable_delete(oSymTable, pvKey, uLength,
+                          SymTable_hash(oSymTable, pvKey, uLength));
+}
+
+void SymTable_map(SymTable_T oSymTable,
+                  void (*pfApply)(const char *pcKey,
+                                  void *pvValue, void *pvExtra),
+                  const void *pvExtra){
+   struct Buckets *pBuckets;
+   struct Binding *currNode;
+   size_t uShard;
+   size_t i;
+
+   assert(oSymTable != NULL);
+   assert(pfApply != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      Snapshot_map(oSymTable->snapshot, pfApply, pvExtra);
+      return;
+   }
+   /* the whole SymTable is locked, so pfApply sees a consistent
+   snapshot but must not call back into oSymTable */
+   SymTable_lockAll(oSymTable);
+   for (uShard = 0; uShard < SHARD_COUNT; uShard++) {
+      pBuckets = oSymTable->shards[uShard].buckets;
+      for (i = 0; i < pBuckets->size; i++) {
+         for (currNode = pBuckets->chains[i]; currNode != NULL;
+              currNode = currNode->next) {
+            (*pfApply)(currNode->key, (void*)currNode->value,
+                       (void*)pvExtra);
+         }
+      }
+   }
+   SymTable_unlockAll(oSymTable);
+}
+
+/* SymTable_order takes in keys pcKey and pcOther of uLength and
+uOtherLength bytes and returns less than, equal to or more than 0 as
+pcKey sorts before, equal to or after pcOther */
+static int SymTable_order(const char *pcKey, size_t uLength,
+                          const char *pcOther, size_t uOtherLength)
+{
+   int iResult;
+
+   iResult = memcmp(pcKey, pcOther,
+                    uLength < uOtherLength ? uLength : uOtherLength);
+   if (iResult != 0) {
+      return iResult;
+   }
+   return (uLength > uOtherLength) - (uLength < uOtherLength);
+}
+
+/* SymTable_inBounds takes in KeyBounds psBounds and a Binding
+currNode, and returns 1 if currNode's key is one psBounds maps and 0
+otherwise */
+static int SymTable_inBounds(const struct KeyBounds *psBounds,
+                             const struct Binding *currNode)
+{
+   if (psBounds->prefix != NULL) {
+      return currNode->keyLength >= psBounds->prefixLength &&
+             memcmp(currNode->key, psBounds->prefix,
+                    psBounds->prefixLength) == 0;
+   }
+   if (psBounds->low != NULL &&
+       SymTable_order(currNode->key, currNode->keyLength,
+                      psBounds->low, psBounds->lowLength) < 0) {
+      return 0;
+   }
+   return psBounds->high == NULL ||
+          SymTable_order(currNode->key, currNode->keyLength,
+                         psBounds->high, psBounds->highLength) < 0;
+}
+
+/* SymTable_mapBounded takes in SymTable oSymTable, KeyBounds
+psBounds, pfApply and pvExtra. Like SymTable_map it locks every shard
+and walks every chain, but only calls (*pfApply)(key, value, pvExtra)
+for the Bindings whose keys psBounds maps. */
+static void SymTable_mapBounded(SymTable_T oSymTable,
+                                const struct KeyBounds *psBounds,
+                                void (*pfApply)(const char *pcKey,
+                                                void *pvValue,
+                                                void *pvExtra),
+                                const void *pvExtra)
+{
+   struct Buckets *pBuckets;
+   struct Binding *currNode;
+   size_t uShard;
+   size_t i;
+
+   SymTable_lockAll(oSymTable);
+   for (uShard = 0; uShard < SHARD_COUNT; uShard++) {
+      pBuckets = oSymTable->shards[uShard].buckets;
+      for (i = 0; i < pBuckets->size; i++) {
+         for (currNode = pBuckets->chains[i]; currNode != NULL;
+              currNode = currNode->next) {
+            if (SymTable_inBounds(psBounds, currNode)) {
+               (*pfApply)(currNode->key, (void*)currNode->value,
+                          (void*)pvExtra);
+            }
+         }
+      }
+   }
+   SymTable_unlockAll(oSymTable);
+}
+
+void SymTable_getCounts(SymTable_T oSymTable, size_t *puRehashes,
+                        size_t *puCompares){
+   size_t i;
+
+   assert(oSymTable != NULL);
+   assert(puRehashes != NULL);
+   assert(puCompares != NULL);
+
+   SymTable_lockAll(oSymTable);
+   *puRehashes = 0;
+   *puCompares = 0;
+   for (i = 0; i < SHARD_COUNT; i++) {
+      *puRehashes += oSymTable->shards[i].rehashCount;
+      *puCompares += oSymTable->shards[i].compareCount;
+   }
+   /* readers count in their slots without any lock */
+   for (i = 0; i < READER_SLOTS; i++) {
+      *puCompares +=
+         SYMTABLE_LOAD_RELAXED(&oSymTable->readerSlots[i].compareCount);
+   }
+   SymTable_unlockAll(oSymTable);
+}
+
+int SymTable_setMaxLoad(SymTable_T oSymTable, double dMaxLoad){
+   struct Shard *pShard;
+   size_t i;
+
+   assert(oSymTable != NULL);
+
+   if (! (dMaxLoad > 0.0)) {
+      return 0;
+   }
+   SymTable_lockAll(oSymTable);
+   oSymTable->maxLoad = dMaxLoad;
+   for (i = 0; i < SHARD_COUNT; i++) {
+      pShard = &oSymTable->shards[i];
+      SymTable_setExpandAt(oSymTable, pShard);
+
+      /* a lower max load can leave a shard over its new limit */
+      (void)SymTable_growShard(oSymTable, pShard, pShard->bindingsSize);
+   }
+   SymTable_unlockAll(oSymTable);
+   return 1;
+}
+
+int SymTable_setIncremental(SymTable_T oSymTable, int iIncremental){
+   assert(oSymTable != NULL);
+
+   /* an expansion only holds up its own shard, which is a small part
+   of the SymTable, so there is little to gain from spreading it over
+   later operations */
+   return iIncremental == 0;
+}
+
+size_t SymTable_getAllocCount(SymTable_T oSymTable){
+   size_t uCount;
+   size_t i;
+
+   assert(oSymTable != NULL);
+
+   SymTable_lockAll(oSymTable);
+   /* one for the SymTable itself, and one for its Snapshot */
+   uCount = 1 + (oSymTable->snapshot != NULL);
+   for (i = 0; i < SHARD_COUNT; i++) {
+      uCount += oSymTable->shards[i].allocCount +
+                Arena_getAllocCount(oSymTable->shards[i].arena);
+   }
+   SymTable_unlockAll(oSymTable);
+   return uCount;
+}
+
+size_t SymTable_getBytes(SymTable_T oSymTable){
+   struct Shard *pShard;
+   size_t uBytes;
+   size_t i;
+
+   assert(oSymTable != NULL);
+
+   SymTable_lockAll(oSymTable);
+   uBytes = sizeof(struct SymTable);
+   if (oSymTable->snapshot != NULL) {
+      uBytes += Snapshot_getBytes(oSymTable->snapshot);
+   }
+   for (i = 0; i < SHARD_COUNT; i++) {
+      pShard = &oSymTable->shards[i];
+      uBytes += sizeof(struct Buckets) +
+                pShard->buckets->size * sizeof(struct Binding*) +
+                Arena_getBytes(pShard->arena);
+   }
+   SymTable_unlockAll(oSymTable);
+   return uBytes;
+}
+
+int SymTable_putAtom(SymTable_T oSymTable, const char *pcAtom,
+                     const void *pvValue){
+   size_t uLength;
+
+   assert(oSymTable != NULL);
+   assert(pcAtom != NULL);
+
+   uLength = Atom_getLength(pcAtom);
+   return SymTable_insert(oSymTable, pcAtom, uLength,
+      SymTable_rehash(oSymTable, pcAtom, uLength, Atom_getHash(pcAtom)),
+      pvValue, KEY_ATOM);
+}
+
+void *SymTable_getAtom(SymTable_T oSymTable, const char *pcAtom){
+   void *pvValue = NULL;
+   size_t uLength;
+
+   assert(oSymTable != NULL);
+   assert(pcAtom != NULL);
+
+   uLength = Atom_getLength(pcAtom);
+   (void)SymTable_lookup(oSymTable, pcAtom, uLength,
+      SymTable_rehash(oSymTable, pcAtom, uLength, Atom_getHash(pcAtom)),
+      1, &pvValue);
+   return pvValue;
+}
+
+int SymTable_putBorrowed(SymTable_T oSymTable, const char *pcKey,
+                         const void *pvValue){
+   size_t uLength;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   uLength = strlen(pcKey);
+   return SymTable_insert(oSymTable, pcKey, uLength,
+                          SymTable_hash(oSymTable, pcKey, uLength),
+                          pvValue, KEY_BORROWED);
+}
+
+void **SymTable_getOrPut(SymTable_T oSymTable, const char *pcKey,
+                         const void *pvValue, int *piFound){
+   struct Shard *pShard;
+   struct Binding *currNode;
+   size_t uLength;
+   size_t uHash;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      return NULL;
+   }
+   uLength = strlen(pcKey);
+   uHash = SymTable_hash(oSymTable, pcKey, uLength);
+   pShard = SymTable_lockShard(oSymTable, uHash);
+   currNode = SymTable_find(pShard->buckets, pcKey, uLength, uHash, 0,
+                            &pShard->compareCount,
+                            SymTable_statsOf(oSymTable, &pShard->stats));
+   if (piFound != NULL) {
+      *piFound = (currNode != NULL);
+   }
+   if (currNode == NULL) {
+      currNode = SymTable_add(oSymTable, pShard, pcKey, uLength, uHash,
+                              pvValue, KEY_COPY);
+   }
+   pthread_mutex_unlock(&pShard->lock);
+
+   /* Bindings never move, so the slot stays valid, but reading or
+   writing it races with other threads that use the same key */
+   return (currNode == NULL) ? NULL : (void **)&currNode->value;
+}
+
+int SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+                    const void *pvValue, void **ppvOldValue){
+   struct Shard *pShard;
+   struct Binding *currNode;
+   size_t uLength;
+   size_t uHash;
+   int iSuccessful = 1;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      return 0;
+   }
+   uLength = strlen(pcKey);
+   uHash = SymTable_hash(oSymTable, pcKey, uLength);
+   pShard = SymTable_lockShard(oSymTable, uHash);
+   currNode = SymTable_find(pShard->buckets, pcKey, uLength, uHash, 0,
+                            &pShard->compareCount,
+                            SymTable_statsOf(oSymTable, &pShard->stats));
+   if (currNode == NULL) {
+      if (SymTable_add(oSymTable, pShard, pcKey, uLength, uHash,
+                       pvValue, KEY_COPY) == NULL) {
+         iSuccessful = 0;
+      } else if (ppvOldValue != NULL) {
+         *ppvOldValue = NULL;
+      }
+   } else {
+      if (ppvOldValue != NULL) {
+         *ppvOldValue = (void*)currNode->value;
+      }
+      SYMTABLE_STORE_RELEASE(&currNode->value, pvValue);
+   }
+   pthread_mutex_unlock(&pShard->lock);
+   return iSuccessful;
+}
+
+int SymTable_putHashed(SymTable_T oSymTable, const char *pcKey,
+                       size_t uHash, const void *pvValue){
+   size_t uLength;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   uLength = strlen(pcKey);
+   return SymTable_insert(oSymTable, pcKey, uLength,
+                          SymTable_rehash(oSymTable, pcKey, uLength,
+                                          uHash),
+                          pvValue, KEY_COPY);
+}
+
+void *SymTable_getHashed(SymTable_T oSymTable, const char *pcKey,
+                         size_t uHash){
+   void *pvValue = NULL;
+   size_t uLength;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   uLength = strlen(pcKey);
+   (void)SymTable_lookup(oSymTable, pcKey, uLength,
+      SymTable_rehash(oSymTable, pcKey, uLength, uHash), 0, &pvValue);
+   return pvValue;
+}
+
+int SymTable_containsHashed(SymTable_T oSymTable, const char *pcKey,
+                            size_t uHash){
+   void *pvValue;
+   size_t uLength;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   uLength = strlen(pcKey);
+   return SymTable_lookup(oSymTable, pcKey, uLength,
+      SymTable_rehash(oSymTable, pcKey, uLength, uHash), 0, &pvValue);
+}
+
+void *SymTable_removeHashed(SymTable_T oSymTable, const char *pcKey,
+                            size_t uHash){
+   size_t uLength;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   uLength = strlen(pcKey);
+   return SymTable_delete(oSymTable, pcKey, uLength,
+      SymTable_rehash(oSymTable, pcKey, uLength, uHash));
+}
+
+void SymTable_getMany(SymTable_T oSymTable, const char *const apcKeys[],
+                      size_t uCount, void *apvValues[]){
+   struct ReaderSlot *pSlot;
+   struct Binding *currNode;
+   size_t *puReaders;
+   size_t uLength;
+   size_t uHash;
+   size_t i;
+
+   assert(oSymTable != NULL);
+   assert(uCount == 0 || (apcKeys != NULL && apvValues != NULL));
+
+   if (oSymTable->snapshot != NULL) {
+      for (i = 0; i < uCount; i++) {
+         apvValues[i] = NULL;
+         (void)Snapshot_find(oSymTable->snapshot, apcKeys[i],
+                             strlen(apcKeys[i]), &apvValues[i]);
+      }
+      return;
+   }
+   /* the whole batch is one read, so the thread announces itself
+   only once */
+   puReaders = SymTable_beginRead(oSymTable, &pSlot);
+   for (i = 0; i < uCount; i++) {
+      assert(apcKeys[i] != NULL);
+      uLength = strlen(apcKeys[i]);
+      uHash = SymTable_hash(oSymTable, apcKeys[i], uLength);
+      currNode = SymTable_find(SymTable_readBuckets(oSymTable, uHash),
+                               apcKeys[i], uLength, uHash, 0,
+                               &pSlot->compareCount,
+                               SymTable_statsOf(oSymTable, &pSlot->stats));
+      apvValues[i] = (currNode == NULL) ? NULL :
+         (void*)SYMTABLE_LOAD_ACQUIRE(&currNode->value);
+   }
+   SymTable_endRead(puReaders);
+}
+
+/* SymTable_mapUnits takes in a range of units [uBegin, uEnd) and a
+void pointer pvJob to a MapJob, and maps the bindings of those units.
+Unit u is the (u % MAP_SPLIT)-th of MAP_SPLIT equal shares of the
+buckets of shard u / MAP_SPLIT. */
+static void SymTable_mapUnits(size_t uBegin, size_t uEnd, void *pvJob)
+{
+   struct MapJob *pJob = pvJob;
+   struct Buckets *pBuckets;
+   struct Binding *currNode;
+   size_t uPart;
+   size_t i;
+   size_t u;
+
+   for (u = uBegin; u < uEnd; u++) {
+      pBuckets = pJob->oSymTable->shards[u / MAP_SPLIT].buckets;
+      uPart = u % MAP_SPLIT;
+      for (i = pBuckets->size * uPart / MAP_SPLIT;
+           i < pBuckets->size * (uPart + 1) / MAP_SPLIT; i++) {
+         for (currNode = pBuckets->chains[i]; currNode != NULL;
+              currNode = currNode->next) {
+            (*pJob->pfApply)(currNode->key, (void*)currNode->value,
+                             (void*)pJob->pvExtra);
+         }
+      }
+   }
+}
+
+void SymTable_mapParallel(SymTable_T oSymTable,
+                          void (*pfApply)(const char *pcKey,
+                                          void *pvValue, void *pvExtra),
+                          const void *pvExtra, size_t uThreads){
+   struct MapJob sJob;
+
+   assert(oSymTable != NULL);
+   assert(pfApply != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      Snapshot_mapParallel(oSymTable->snapshot, pfApply, pvExtra,
+                           uThreads);
+      return;
+   }
+   sJob.oSymTable = oSymTable;
+   sJob.pfApply = pfApply;
+   sJob.pvExtra = pvExtra;
+   /* as in SymTable_map, every shard stays locked for the whole map.
+   The pool threads read the shards without locks of their own, which
+   is safe because nothing can change them until they have joined. */
+   SymTable_lockAll(oSymTable);
+   Parallel_forRange((size_t)SHARD_COUNT * MAP_SPLIT, uThreads,
+                     SymTable_mapUnits, &sJob);
+   SymTable_unlockAll(oSymTable);
+}
+
+/* SymTable_reserveIter takes in an iterator pIter, an entry count
+uCount, a byte count uBytes and the number of bytes of keys already
+used uKeysUsed, and makes sure pIter has room for uCount more
+IterEntries and uBytes more bytes of keys. It returns 0 if
+there is insufficient memory and 1 otherwise. */
+static int SymTable_reserveIter(struct SymTableIter *pIter,
+                                size_t uCount, size_t uBytes,
+                                size_t uKeysUsed)
+{
+   struct IterEntry *pEntries;
+   char *pcKeys;
+   size_t uCap;
+
+   if (pIter->entryCount + uCount > pIter->entryCap) {
+      uCap = 2 * (pIter->entryCount + uCount);
+      pEntries = realloc(pIter->entries, uCap * sizeof(struct IterEntry));
+      if (pEntries == NULL) {
+         return 0;
+      }
+      pIter->entries = pEntries;
+      pIter->entryCap = uCap;
+   }
+   if (uKeysUsed + uBytes > pIter->keyCap) {
+      uCap = 2 * (uKeysUsed + uBytes);
+      pcKeys = realloc(pIter->keys, uCap);
+      if (pcKeys == NULL) {
+         return 0;
+      }
+      pIter->keys = pcKeys;
+      pIter->keyCap = uCap;
+   }
+   return 1;
+}
+
+/* SymTable_fillIter takes in an iterator pIter that has returned all
+of its copies. It locks pIter's shard, copies the Bindings of the
+shard's next non empty bucket and moves past it, moving on to the next
+shard if that was the last bucket. It returns 0 (leaving pIter where
+it was) if there is insufficient memory and 1 otherwise. */
+static int SymTable_fillIter(struct SymTableIter *pIter)
+{
+   struct Shard *pShard = &pIter->oSymTable->shards[pIter->shard];
+   struct Buckets *pBuckets;
+   struct Binding *currNode;
+   size_t uBucket = pIter->bucket;
+   size_t uKeysUsed = 0;
+   size_t uCount;
+   size_t uBytes;
+   size_t uFirst;
+   size_t i;
+
+   pIter->entryCount = 0;
+   pIter->nextEntry = 0;
+   pthread_mutex_lock(&pShard->lock);
+   pBuckets = pShard->buckets;
+   if (uBucket == 0) {
+      pIter->baseCount = pBuckets->size;
+   }
+   while (pIter->entryCount == 0 && uBucket < pIter->baseCount) {
+      /* a bucket is copied whole, so room is made for all of it
+      first. If the shard has shrunk, it is part of bucket uFirst. */
+      uFirst = uBucket & (pBuckets->size - 1);
+      uCount = 0;
+      uBytes = 0;
+      for (i = uFirst; i < pBuckets->size; i += pIter->baseCount) {
+         for (currNode = pBuckets->chains[i]; currNode != NULL;
+              currNode = currNode->next) {
+            uCount++;
+            uBytes += currNode->keyLength + 1;
+         }
+      }
+      if (! SymTable_reserveIter(pIter, uCount, uBytes, uKeysUsed)) {
+         pthread_mutex_unlock(&pShard->lock);
+         return 0;
+      }
+      for (i = uFirst; i < pBuckets->size; i += pIter->baseCount) {
+         for (currNode = pBuckets->chains[i]; currNode != NULL;
+              currNode = currNode->next) {
+            if (SymTable_bucketOf(currNode, pIter->baseCount) !=
+                uBucket) {
+               continue;
+            }
+            memcpy(pIter->keys + uKeysUsed, currNode->key,
+                   currNode->keyLength + 1);
+            pIter->entries[pIter->entryCount].keyOffset = uKeysUsed;
+            pIter->entries[pIter->entryCount].value = currNode->value;
+            pIter->entryCount++;
+            uKeysUsed += currNode->keyLength + 1;
+         }
+      }
+      uBucket++;
+   }
+   pthread_mutex_unlock(&pShard->lock);
+
+   if (uBucket == pIter->baseCount) {
+      pIter->shard++;
+      pIter->bucket = 0;
+   } else {
+      pIter->bucket = uBucket;
+   }
+   return 1;
+}
+
+SymTableIter_T SymTable_iterBegin(SymTable_T oSymTable){
+   struct SymTableIter *pIter;
+
+   assert(oSymTable != NULL);
+
+   pIter = malloc(sizeof(struct SymTableIter));
+   if (pIter == NULL) {
+      return NULL;
+   }
+   pIter->oSymTable = oSymTable;
+   pIter->shard = 0;
+   pIter->baseCount = 0;
+   pIter->bucket = 0;
+   pIter->entries = NULL;
+   pIter->entryCap = 0;
+   pIter->entryCount = 0;
+   pIter->nextEntry = 0;
+   pIter->keys = NULL;
+   pIter->keyCap = 0;
+   pIter->snapshotIndex = 0;
+   return pIter;
+}
+
+int SymTable_iterNext(SymTableIter_T oIter, const char **ppcKey,
+                      void **ppvValue){
+   struct IterEntry *pEntry;
+
+   assert(oIter != NULL);
+
+   /* a snapshot's keys stay put until the SymTable is freed, so they
+   need no copies */
+   if (oIter->oSymTable->snapshot != NULL) {
+      if (oIter->snapshotIndex ==
+          Snapshot_getLength(oIter->oSymTable->snapshot)) {
+         return 0;
+      }
+      Snapshot_getBinding(oIter->oSymTable->snapshot,
+                          oIter->snapshotIndex++, ppcKey, NULL,
+                          ppvValue);
+      return 1;
+   }
+   while (oIter->nextEntry == oIter->entryCount) {
+      if (oIter->shard == SHARD_COUNT) {
+         return 0;
+      }
+      if (! SymTable_fillIter(oIter)) {
+         return 0;
+      }
+   }
+   pEntry = &oIter->entries[oIter->nextEntry++];
+   if (ppcKey != NULL) {
+      *ppcKey = oIter->keys + pEntry->keyOffset;
+   }
+   if (ppvValue != NULL) {
+      *ppvValue = (void*)pEntry->value;
+   }
+   return 1;
+}
+
+void SymTable_iterEnd(SymTableIter_T oIter){
+   assert(oIter != NULL);
+
+   free(oIter->entries);
+   free(oIter->keys);
+   free(oIter);
+}
+
+void SymTable_mapRange(SymTable_T oSymTable, const char *pcLow,
+                       const char *pcHigh,
+                       void (*pfApply)(const char *pcKey,
+                                       void *pvValue, void *pvExtra),
+                       const void *pvExtra){
+   struct KeyBounds sBounds;
+
+   assert(oSymTable != NULL);
+   assert(pfApply != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      Snapshot_mapRange(oSymTable->snapshot, pcLow, pcHigh, pfApply,
+                        pvExtra);
+      return;
+   }
+   sBounds.low = pcLow;
+   sBounds.lowLength = (pcLow != NULL) ? strlen(pcLow) : 0;
+   sBounds.high = pcHigh;
+   sBounds.highLength = (pcHigh != NULL) ? strlen(pcHigh) : 0;
+   sBounds.prefix = NULL;
+   sBounds.prefixLength = 0;
+   SymTable_mapBounded(oSymTable, &sBounds, pfApply, pvExtra);
+}
+
+void SymTable_mapPrefix(SymTable_T oSymTable, const char *pcPrefix,
+                        void (*pfApply)(const char *pcKey,
+                                        void *pvValue, void *pvExtra),
+                        const void *pvExtra){
+   struct KeyBounds sBounds;
+
+   assert(oSymTable != NULL);
+   assert(pcPrefix != NULL);
+   assert(pfApply != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      Snapshot_mapPrefix(oSymTable->snapshot, pcPrefix, pfApply,
+                         pvExtra);
+      return;
+   }
+   sBounds.low = NULL;
+   sBounds.lowLength = 0;
+   sBounds.high = NULL;
+   sBounds.highLength = 0;
+   sBounds.prefix = pcPrefix;
+   sBounds.prefixLength = strlen(pcPrefix);
+   SymTable_mapBounded(oSymTable, &sBounds, pfApply, pvExtra);
+}
+
+int SymTable_save(SymTable_T oSymTable, const char *pcPath,
+                  size_t uValueSize){
+   SnapshotWriter_T oWriter;
+   struct Buckets *pBuckets;
+   struct Binding *currNode;
+   size_t uShard;
+   size_t i;
+   int iSuccessful = 1;
+
+   assert(oSymTable != NULL);
+   assert(pcPath != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      return Snapshot_save(oSymTable->snapshot, pcPath, uValueSize);
+   }
+   oWriter = SnapshotWriter_new(uValueSize);
+   if (oWriter == NULL) {
+      return 0;
+   }
+   /* as in SymTable_map, the whole SymTable is locked so the snapshot
+   is consistent, but only while the bindings are copied out. Sorting
+   and writing them happens after the locks are dropped. */
+   SymTable_lockAll(oSymTable);
+   for (uShard = 0; uShard < SHARD_COUNT && iSuccessful; uShard++) {
+      pBuckets = oSymTable->shards[uShard].buckets;
+      for (i = 0; i < pBuckets->size && iSuccessful; i++) {
+         for (currNode = pBuckets->chains[i];
+              currNode != NULL && iSuccessful;
+              currNode = currNode->next) {
+            iSuccessful = SnapshotWriter_add(oWriter, currNode->key,
+                                             currNode->keyLength,
+                                             currNode->value);
+         }
+      }
+   }
+   SymTable_unlockAll(oSymTable);
+   if (!iSuccessful) {
+      SnapshotWriter_free(oWriter);
+      return 0;
+   }
+   return SnapshotWriter_finish(oWriter, pcPath);
+}
+
+SymTable_T SymTable_openMapped(const char *pcPath){
+   SymTable_T oSymTable;
+
+   assert(pcPath != NULL);
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL) {
+      return NULL;
+   }
+   oSymTable->snapshot = Snapshot_open(pcPath);
+   if (oSymTable->snapshot == NULL) {
+      SymTable_free(oSymTable);
+      return NULL;
+   }
+   return oSymTable;
+}
+
+SymTable_T SymTable_newWithCapacity(size_t uCapacity){
+   SymTable_T oSymTable;
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL) {
+      return NULL;
+   }
+   if (! SymTable_reserve(oSymTable, uCapacity)) {
+      SymTable_free(oSymTable);
+      return NULL;
+   }
+   return oSymTable;
+}
+
+/* SymTable_sqrt takes in a size_t uValue and returns the square root
+of uValue rounded down */
+static size_t SymTable_sqrt(size_t uValue)
+{
+   size_t uRoot = 0;
+   size_t uBit = (size_t)1 << (sizeof(size_t) * CHAR_BIT - 2);
+
+   while (uBit > uValue) {
+      uBit >>= 2;
+   }
+   while (uBit != 0) {
+      if (uValue >= uRoot + uBit) {
+         uValue -= uRoot + uBit;
+         uRoot = (uRoot >> 1) + uBit;
+      } else {
+         uRoot >>= 1;
+      }
+      uBit >>= 2;
+   }
+   return uRoot;
+}
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity){
+   struct Shard *pShard;
+   size_t uShare;
+   size_t uBindings;
+   size_t i;
+   int iSuccessful = 1;
+
+   assert(oSymTable != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      return 0;
+   }
+   /* keys are spread over the shards by hash, so a shard gets its
+   share give or take a few times the square root of it */
+   uBindings = uCapacity / SHARD_COUNT + (uCapacity % SHARD_COUNT != 0);
+   uShare = uBindings + RESERVE_SPREAD * SymTable_sqrt(uBindings) +
+            RESERVE_SLACK;
+
+   SymTable_lockAll(oSymTable);
+   for (i = 0; i < SHARD_COUNT && iSuccessful; i++) {
+      pShard = &oSymTable->shards[i];
+      iSuccessful = SymTable_growShard(oSymTable, pShard, uShare);
+      /* removes do not shrink the shard below what was reserved */
+      if (iSuccessful && pShard->buckets->size > pShard->minCount) {
+         pShard->minCount = pShard->buckets->size;
+         SymTable_setExpandAt(oSymTable, pShard);
+      }
+      /* the arena only gets room for the average share, since a shard
+      that needs more just takes another chunk */
+      if (iSuccessful && uBindings > pShard->bindingsSize) {
+         iSuccessful = (uBindings - pShard->bindingsSize <=
+                        (size_t)-1 / sizeof(struct Binding)) &&
+                       Arena_reserve(pShard->arena,
+                                     (uBindings - pShard->bindingsSize) *
+                                     sizeof(struct Binding));
+      }
+   }
+   SymTable_unlockAll(oSymTable);
+   return iSuccessful;
+}
+
+/* SymTable_copyBuckets takes in a bucket array oldBuckets, an Arena
+oArena and an empty bucket array newBuckets. It copies every Binding
+of oldBuckets, with its key copy, into oArena and links the copy into
+newBuckets. The copies are not published until newBuckets is, so they
+are linked with plain stores. It returns 1, or 0 if there is
+insufficient memory. */
+static int SymTable_copyBuckets(struct Buckets *oldBuckets,
+                                Arena_T oArena,
+                                struct Buckets *newBuckets)
+{
+   struct Binding *currNode;
+   struct Binding *nNode;
+   size_t uBucket;
+   size_t i;
+   char *defCopy;
+
+   for (i = 0; i < oldBuckets->size; i++) {
+      for (currNode = oldBuckets->chains[i]; currNode != NULL;
+           currNode = currNode->next) {
+         nNode = Arena_alloc(oArena, sizeof(struct Binding));
+         if (nNode == NULL) {
+            return 0;
+         }
+         *nNode = *currNode;
+         nNode->retired = NULL;
+         if (currNode->key == currNode->inlineKey) {
+            nNode->key = nNode->inlineKey;
+         } else if (currNode->keyKind == KEY_COPY) {
+            defCopy = Arena_alloc(oArena, currNode->keyLength + 1);
+            if (defCopy == NULL) {
+               return 0;
+            }
+            memcpy(defCopy, currNode->key, currNode->keyLength + 1);
+            nNode->key = defCopy;
+         }
+         uBucket = SymTable_bucketOf(nNode, newBuckets->size);
+         nNode->next = newBuckets->chains[uBucket];
+         newBuckets->chains[uBucket] = nNode;
+      }
+   }
+   return 1;
+}
+
+/* SymTable_compactShard takes in SymTable oSymTable and one of its
+Shards pShard, which the calling thread does not hold. It copies
+pShard's Bindings and key copies into a new arena and a bucket array
+of the fewest buckets that hold twice them under the max load, and
+once no reader can be on the old ones frees them, along with the
+retired Bindings. It returns 1, or 0 (leaving pShard unchanged) if
+there is insufficient memory. */
+static int SymTable_compactShard(SymTable_T oSymTable,
+                                 struct Shard *pShard)
+{
+   struct Buckets *oldBuckets;
+   struct Buckets *newBuckets;
+   Arena_T newArena;
+   size_t uNewCount;
+
+   pthread_mutex_lock(&pShard->lock);
+   oldBuckets = pShard->buckets;
+   uNewCount = SymTable_fitCount(oSymTable, 2 * pShard->bindingsSize);
+   if (uNewCount > oldBuckets->size) {
+      uNewCount = oldBuckets->size;
+   }
+   newBuckets = SymTable_newBuckets(uNewCount);
+   if (newBuckets == NULL) {
+      pthread_mutex_unlock(&pShard->lock);
+      return 0;
+   }
+   newArena = Arena_new();
+   if (newArena == NULL ||
+       ! Arena_reserve(newArena, pShard->bindingsSize *
+                                 sizeof(struct Binding)) ||
+       ! SymTable_copyBuckets(oldBuckets, newArena, newBuckets)) {
+      if (newArena != NULL) {
+         Arena_free(newArena);
+      }
+      free(newBuckets);
+      pthread_mutex_unlock(&pShard->lock);
+      return 0;
+   }
+   SYMTABLE_STORE_RELEASE(&pShard->buckets, newBuckets);
+   SymTable_synchronize(oSymTable);
+
+   pShard->allocCount += 1 + Arena_getAllocCount(pShard->arena);
+   pShard->rehashCount += pShard->bindingsSize;
+   Arena_free(pShard->arena);
+   free(oldBuckets);
+   pShard->arena = newArena;
+   pShard->retired = NULL;
+   pShard->retiredCount = 0;
+   pShard->compactions++;
+   pShard->minCount = bucketMin;
+   SymTable_setExpandAt(oSymTable, pShard);
+   pthread_mutex_unlock(&pShard->lock);
+   return 1;
+}
+
+int SymTable_compact(SymTable_T oSymTable){
+   size_t i;
+
+   assert(oSymTable != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      return 0;
+   }
+   /* a shard at a time, so the others go on being read and changed
+   meanwhile. Iterators copy what they return, so they do not stand in
+   the way. */
+   for (i = 0; i < SHARD_COUNT; i++) {
+      if (! SymTable_compactShard(oSymTable, &oSymTable->shards[i])) {
+         return 0;
+      }
+   }
+   return 1;
+}
+
+SymTable_T SymTable_newWithStats(enum SymTableHash eHash){
+   SymTable_T oSymTable;
+
+   oSymTable = SymTable_newWithOptions(eHash);
+   if (oSymTable == NULL) {
+      return NULL;
+   }
+   /* the counts live in the shards and reader slots, which start at
+   0 anyway */
+   oSymTable->collectStats = 1;
+   return oSymTable;
+}
+
+int SymTable_getStats(SymTable_T oSymTable,
+                      struct SymTableStats *psStats){
+   struct Shard *pShard;
+   struct ReaderSlot *pSlot;
+   struct Binding *currNode;
+   struct Stats sTotal;
+   struct Stats sSlot;
+   size_t uBindings = 0;
+   size_t uLength;
+   size_t i;
+   size_t j;
+
+   assert(oSymTable != NULL);
+   assert(psStats != NULL);
+
+   Stats_clear(psStats);
+   /* these take every shard lock themselves */
+   psStats->allocCount = SymTable_getAllocCount(oSymTable);
+   psStats->bytes = SymTable_getBytes(oSymTable);
+
+   Stats_init(&sTotal);
+   SymTable_lockAll(oSymTable);
+   for (i = 0; i < SHARD_COUNT; i++) {
+      pShard = &oSymTable->shards[i];
+      Stats_add(&sTotal, &pShard->stats);
+      if (oSymTable->snapshot != NULL) {
+         continue;
+      }
+      psStats->bucketCount += pShard->buckets->size;
+      uBindings += pShard->bindingsSize;
+      for (j = 0; j < pShard->buckets->size; j++) {
+         uLength = 0;
+         for (currNode = pShard->buckets->chains[j]; currNode != NULL;
+              currNode = currNode->next) {
+            uLength++;
+         }
+         Stats_addChain(psStats, uLength);
+      }
+   }
+   /* readers count in their slots without any lock, and never
+   expand */
+   for (i = 0; i < READER_SLOTS; i++) {
+      pSlot = &oSymTable->readerSlots[i];
+      Stats_init(&sSlot);
+      sSlot.hits = SYMTABLE_LOAD_RELAXED(&pSlot->stats.hits);
+      sSlot.hitProbes = SYMTABLE_LOAD_RELAXED(&pSlot->stats.hitProbes);
+      sSlot.misses = SYMTABLE_LOAD_RELAXED(&pSlot->stats.misses);
+      sSlot.missProbes = SYMTABLE_LOAD_RELAXED(&pSlot->stats.missProbes);
+      Stats_add(&sTotal, &sSlot);
+   }
+   SymTable_unlockAll(oSymTable);
+
+   if (psStats->bucketCount != 0) {
+      psStats->load = (double)uBindings / (double)psStats->bucketCount;
+   }
+   if (! oSymTable->collectStats) {
+      return 0;
+   }
+   Stats_report(&sTotal, psStats);
+   return 1;
+}
@@ -1,29 +1,102 @@
 /* symtable hash implementation */
 #include "symtable.h"
+#include "symtablearena.h"
+#include "symtableatom.h"
+#include "symtablekeyhash.h"
+#include "symtableparallel.h"
+#include "symtablesnapshot.h"
+#include "symtablestats.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <limits.h>
 #include <stddef.h>
 #include <string.h>
 
-/* bucketCounts array holds all the possible configurations for the
-the size of bucket array we can either start with/ expand to */
+/* bucketCounts array holds the sizes of bucket array we can either
+start with/ expand to: the largest prime below each power of two.
+Past the last entry the table keeps growing as 2 * bucketSize + 1. */
 static const size_t bucketCounts[] = {509, 1021, 2039, 4093, 8191, 
-16381, 32749, 65521};
+16381, 32749, 65521, 131071, 262139, 524287, 1048573, 2097143, 
+4194301, 8388593, 16777213, 33554393, 67108859, 134217689, 268435399,
+536870909, 1073741789, 2147483647UL};
 
-/* denotes the min value for the number of buckets and the max number 
-buckets for a SymTable */
-enum BucketEnds{bucketMin = 509, bucketMax = 65521};
+/* denotes the min value for the number of buckets for a SymTable */
+enum BucketEnds{bucketMin = 509};
+
+/* a SymTable shrinks once it holds fewer Bindings than its expandAt
+divided by SHRINK_RATIO, to the fewest buckets that hold twice its
+Bindings under the max load. The load then sits well between the two
+limits, so puts and removes around either one do not rehash back and
+forth. */
+enum {SHRINK_RATIO = 8};
+
+/* how many buckets of the old bucket array each operation migrates
+while an incremental expansion is in progress */
+enum {MIGRATE_STEP = 4};
+
+/* how many keys SymTable_getMany hashes and prefetches at a time */
+enum {BATCH_SIZE = 16};
+
+/* keys shorter than INLINE_KEY_SIZE bytes (counting the '\0') are
+stored inside their Binding, longer keys are copied into the arena */
+enum {INLINE_KEY_SIZE = 24};
+
+/* how a Binding holds its key: a copy owned by the SymTable, an atom from
+SymTable_intern, or a key borrowed from the client by
+SymTable_putBorrowed. Only copies are released by the SymTable. */
+enum KeyKinds {KEY_COPY = 0, KEY_ATOM = 1, KEY_BORROWED = 2};
+
+/* a chain of more than TREEIFY_LENGTH Bindings is turned into an AVL
+tree, so a bucket that many keys collide in is still searched in
+O(log n). A tree turns back into a chain once its height drops to
+UNTREEIFY_HEIGHT (7 Bindings at most), which is far enough below
+TREEIFY_LENGTH that a bucket does not flip back and forth. */
+enum {TREEIFY_LENGTH = 8, UNTREEIFY_HEIGHT = 3};
+
+/* how many buckets one word of a bucket array's occupancy bitmap
+covers, see SymTable_bitmap */
+enum {WORD_BITS = sizeof(size_t) * CHAR_BIT};
+
+/* the default max load factor: a SymTable expands once it holds more
+Bindings than buckets */
+#define DEFAULT_MAX_LOAD 1.0
+
+/* SYMTABLE_PREFETCH asks the CPU to start loading the cache line at
+address p, so a later access to it does not stall. It does nothing
+with compilers that have no __builtin_prefetch. */
+#if defined(__GNUC__)
+#define SYMTABLE_PREFETCH(p) __builtin_prefetch(p)
+#else
+#define SYMTABLE_PREFETCH(p) ((void)(p))
+#endif
 
 /* Bindings can be formed to make a list of Bindings and hold
 certain variables: key, value, next. */ 
 struct Binding {
-    /* char pointer to the key */
+    /* char pointer to the key: inlineKey for short keys, otherwise
+    a copy in the arena. A copy is always followed by a '\0'. */
     const char *key;
     /* void pointer to the value */
     const void* value;
-    /* pointer to the next Binding in list */
+    /* full hash of the key, see SymTable_hash */
+    size_t hash;
+    /* how many bytes are in the key, not counting the '\0' */
+    size_t keyLength;
+    /* pointer to the next Binding in list. In a tree bucket, the
+    right child instead. */
     struct Binding *next;
+    /* in a tree bucket, the left child, and NULL in a chain */
+    struct Binding *left;
+    /* holds the key when it fits, so comparing it stays within the
+    Binding */
+    char inlineKey[INLINE_KEY_SIZE];
+    /* KEY_COPY, KEY_ATOM or KEY_BORROWED, see KeyKinds */
+    int keyKind;
+    /* 0 in a chain, and the height of the subtree rooted here (1 for
+    a leaf) in a tree bucket. A bucket is a tree if its first Binding
+    has a height. */
+    int height;
 }; 
 
 /* SymTable points first to the buckets by which the lists of
@@ -38,270 +111,2221 @@ struct SymTable {
     size_t bucketSize;
     /* keeps track of how many Bindings total are in the SymTable */
     size_t bindingsSize;
+    /* the max load factor (Bindings per bucket) before expanding */
+    double maxLoad;
+    /* the SymTable expands once bindingsSize exceeds this, which is
+    bucketSize * maxLoad */
+    size_t expandAt;
+    /* the SymTable shrinks once bindingsSize drops below this, which
+    is expandAt / SHRINK_RATIO, or 0 if it is as small as it may get */
+    size_t shrinkAt;
+    /* the fewest buckets the SymTable shrinks to: bucketMin, or what
+    SymTable_reserve grew it to */
+    size_t minBucketSize;
+    /* while an incremental expansion is in progress, the bucket array
+    being migrated into head, and NULL otherwise */
+    struct Binding **oldHead;
+    /* holds how many buckets oldHead has */
+    size_t oldBucketSize;
+    /* buckets of oldHead below this index have been migrated */
+    size_t migrateIndex;
+    /* 1 if SymTable_expand migrates bindings a few buckets at a time
+    during later operations, 0 if it rehashes them all at once */
+    int incremental;
+    /* how many Bindings have been moved to a new bucket array by
+    SymTable_expand */
+    size_t rehashCount;
+    /* how many times a key has been compared with memcmp */
+    size_t compareCount;
+    /* how many times the SymTable has called malloc for itself and
+    its bucket arrays, and the arenas SymTable_compact has replaced */
+    size_t allocCount;
+    /* the Arena that every Binding and key copy is allocated from */
+    Arena_T arena;
+    /* which hash function keys are hashed with, a SymTableHash */
+    enum SymTableHash hashKind;
+    /* the per table seed of the SYMTABLE_HASH_FAST and
+    SYMTABLE_HASH_SIPHASH hash functions */
+    struct KeyHashSeed seed;
+    /* the iterators that have not been ended, linked by their
+    nextIter fields. While there are any, the SymTable does not
+    expand, migrate or turn chains into trees and back, so every
+    Binding stays in its bucket and place. */
+    struct SymTableIter *iters;
+    /* the mapped snapshot that a SymTable from SymTable_openMapped
+    answers from instead of its (empty) buckets, or NULL */
+    Snapshot_T snapshot;
+    /* the lookups and expansions a SymTable made by
+    SymTable_newWithStats has counted, or NULL if it counts none */
+    struct Stats *stats;
 }; 
 
-/* this function takes in parameters const char pointer pcKey and 
-size_t uBucketCount and returns a hash index as a type size_t */
-static size_t SymTable_hash(const char *pcKey, size_t uBucketCount)
-{
-   const size_t HASH_MULTIPLIER = 65599;
-   size_t u;
-   size_t uHash = 0;
+/* MapJob is what the threads of SymTable_mapParallel share: the
+SymTable being mapped and the function to apply */
+struct MapJob {
+    /* the SymTable whose bindings are mapped */
+    SymTable_T oSymTable;
+    /* the function applied to every binding */
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra);
+    /* passed on to pfApply */
+    const void *pvExtra;
+};
 
-   assert(pcKey != NULL);
+/* KeyBounds is which keys SymTable_mapRange or SymTable_mapPrefix
+asks for: those in [low, high), or those that start with prefix */
+struct KeyBounds {
+    /* the smallest key asked for, or NULL for no lower bound */
+    const char *low;
+    /* how many bytes are in low */
+    size_t lowLength;
+    /* every key asked for is less than high, unless it is NULL */
+    const char *high;
+    /* how many bytes are in high */
+    size_t highLength;
+    /* what every key asked for starts with, or NULL for a range */
+    const char *prefix;
+    /* how many bytes are in prefix */
+    size_t prefixLength;
+};
 
-   /* hash function */ 
-   for (u = 0; pcKey[u] != '\0'; u++)
-      uHash = uHash * HASH_MULTIPLIER + (size_t)pcKey[u];
+/* SymTableIter is an iterator over the Bindings of a SymTable. It
+numbers the buckets as SymTable_mapUnits does: the buckets of head
+first, then the old buckets not yet migrated. */
+struct SymTableIter {
+    /* the SymTable being iterated over */
+    SymTable_T oSymTable;
+    /* the bucket that nextNode is in, or if nextNode is NULL the
+    first bucket that has not been looked in yet */
+    size_t bucket;
+    /* the Binding that SymTable_iterNext returns next, or NULL if it
+    has to look for one from bucket on */
+    struct Binding *nextNode;
+    /* the number of the snapshot binding returned next, if the
+    SymTable is mapped */
+    size_t snapshotIndex;
+    /* the next iterator of the same SymTable */
+    struct SymTableIter *nextIter;
+};
 
-   return uHash % uBucketCount;
+/* this function takes in SymTable oSymTable, a const char pointer
+pcKey and its length uLength and returns the full hash of pcKey as a
+type size_t, computed with oSymTable's hash function. The hash is
+stored in every Binding so the bucket index (uHash % bucketSize) can
+be recomputed during expansion without touching the key again. The
+default hash is the same hash that every atom carries, so atoms never
+need hashing. */
+static size_t SymTable_hash(SymTable_T oSymTable, const char *pcKey,
+                            size_t uLength)
+{
+   switch (oSymTable->hashKind) {
+   case SYMTABLE_HASH_FAST:
+      return KeyHash_fast(pcKey, uLength, &oSymTable->seed);
+   case SYMTABLE_HASH_SIPHASH:
+      return KeyHash_sip(pcKey, uLength, &oSymTable->seed);
+   default:
+      return Atom_hashBytes(pcKey, uLength);
+   }
 }
 
-SymTable_T SymTable_new(void){
-   struct SymTable *oSymTable = malloc(sizeof(struct SymTable));
-   if(oSymTable == NULL){
-      return NULL;
+/* SymTable_rehash takes in SymTable oSymTable, a const char pointer
+pcKey, its length uLength and uHash, the default hash of pcKey (from
+an atom or SymTable_hashKey). It returns SymTable_hash of pcKey,
+reusing uHash if oSymTable uses the default hash. */
+static size_t SymTable_rehash(SymTable_T oSymTable, const char *pcKey,
+                              size_t uLength, size_t uHash)
+{
+   if (oSymTable->hashKind == SYMTABLE_HASH_DEFAULT) {
+      return uHash;
    }
-   oSymTable->bucketSize = bucketMin;
-   oSymTable->bindingsSize = 0;
-   oSymTable->head = calloc(oSymTable->bucketSize, sizeof(oSymTable->head));
-   return oSymTable;
+   return SymTable_hash(oSymTable, pcKey, uLength);
 }
 
-void SymTable_free(SymTable_T oSymTable){
-   struct Binding *free_node;
-   struct Binding *next_node;
-   size_t i;
+/* SymTable_matches takes in SymTable oSymTable, a Binding currNode,
+a const char pointer pcKey, its length uLength, its full hash uHash
+and iAtom, which is 1 if pcKey is an atom. It returns 1 if currNode's
+key is pcKey and 0 otherwise. A Binding whose stored hash or length
+differs is rejected without calling memcmp, and so is a different atom
+when pcKey is an atom. */
+static int SymTable_matches(SymTable_T oSymTable,
+                            const struct Binding *currNode,
+                            const char *pcKey, size_t uLength,
+                            size_t uHash, int iAtom)
+{
+   if (currNode->hash != uHash || currNode->keyLength != uLength) {
+      return 0;
+   }
+   if (currNode->key == pcKey) {
+      return 1;
+   }
+   /* equal strings always intern to the same atom */
+   if (iAtom && currNode->keyKind == KEY_ATOM) {
+      return 0;
+   }
+   oSymTable->compareCount++;
+   return memcmp(currNode->key, pcKey, uLength) == 0;
+}
 
-   assert(oSymTable != NULL);
+/* SymTable_isTree takes in the first Binding currNode of a bucket
+(or NULL) and returns 1 if the bucket is a tree and 0 if it is a
+chain */
+static int SymTable_isTree(const struct Binding *currNode)
+{
+   return currNode != NULL && currNode->height > 0;
+}
 
-   for(i = 0; i < (size_t)oSymTable->bucketSize; i++){
-      free_node = oSymTable->head[i];
-      while (free_node != NULL) {
-        free((char *)free_node->key);
-        next_node = free_node->next;
-        free(free_node);
-        free_node = next_node;
-      }
+/* SymTable_compare takes in SymTable oSymTable, a const char pointer
+pcKey, its length uLength, its full hash uHash and a Binding currNode.
+It orders keys by hash, then length, then bytes, and returns a
+negative number, 0 or a positive number if pcKey comes before, is the
+same as or comes after currNode's key. This is the order of a tree
+bucket. */
+static int SymTable_compare(SymTable_T oSymTable, const char *pcKey,
+                            size_t uLength, size_t uHash,
+                            const struct Binding *currNode)
+{
+   if (uHash != currNode->hash) {
+      return (uHash < currNode->hash) ? -1 : 1;
    }
-   free(oSymTable);
+   if (uLength != currNode->keyLength) {
+      return (uLength < currNode->keyLength) ? -1 : 1;
+   }
+   if (currNode->key == pcKey) {
+      return 0;
+   }
+   oSymTable->compareCount++;
+   return memcmp(pcKey, currNode->key, uLength);
 }
 
-size_t SymTable_getLength(SymTable_T oSymTable){
-   assert(oSymTable != NULL);
-   return oSymTable->bindingsSize;
+/* SymTable_getHeight takes in a Binding currNode of a tree, or NULL,
+and returns the height of the subtree rooted at currNode */
+static int SymTable_getHeight(const struct Binding *currNode)
+{
+   return (currNode == NULL) ? 0 : currNode->height;
 }
 
-/* SymTable_expand takes in a parameter of a SymTable oSymTable. The 
-function first calculates the desired bucketSize to expand to. If the
-bucketSize cannot be expanded, the function returns 0 and leaves
-the SymTable unchanged. If oSymTable can be expanded, a new array is
-instantiated and all the previous bindings are rehashed into the new 
-set of buckets. However, if there is insufficient memory for a new 
-array of buckets, the function returns 0. If there is memory, and the 
-previous bindings are rehashed, the old array of buckets are freed,  
-oSymTable points to the new set of buckets, and 1 is returned. */
-static size_t SymTable_expand(SymTable_T oSymTable) {
-    size_t i;
-    size_t oldBucketCount;
-    size_t newBucket;
-    struct Binding **newHead;
-    struct Binding *currNode;
-    struct Binding *nextNode;
- 
-    assert(oSymTable != NULL);
+/* SymTable_setHeight takes in a Binding currNode of a tree and
+recomputes its height from the heights of its children */
+static void SymTable_setHeight(struct Binding *currNode)
+{
+   int iLeft = SymTable_getHeight(currNode->left);
+   int iRight = SymTable_getHeight(currNode->next);
 
-    oldBucketCount = oSymTable->bucketSize;
-    /*checks if SymTable can be expanded further */
-    if(oldBucketCount == bucketMax){
-        return 0;
-    }
-    /* determines the next size of buckets to expand to */
-    for (i = 1; i < sizeof(bucketCounts); i++) {
-        if (bucketCounts[i] > oSymTable->bucketSize) {
-            oSymTable->bucketSize = bucketCounts[i];
-            break;
-        }
-    }
+   currNode->height = 1 + ((iLeft > iRight) ? iLeft : iRight);
+}
 
-    /* allocates new array of buckets */
-    newHead = calloc(oSymTable->bucketSize, sizeof(struct Binding*));
-    
-    /*checks for insufficient memory allocation */
-    if (newHead == NULL) {
-        return 0;
-    }
+/* SymTable_rotateRight takes in a Binding currNode of a tree that has
+a left child, rotates the subtree rooted at currNode to the right and
+returns its new root */
+static struct Binding *SymTable_rotateRight(struct Binding *currNode)
+{
+   struct Binding *newRoot = currNode->left;
 
-    /* rehash old bindings to new array of buckets */
-    for (i = 0; i < oldBucketCount; i++) {
-        currNode = oSymTable->head[i];
-        while (currNode != NULL) {
-            nextNode = currNode->next;
-            newBucket = SymTable_hash(currNode->key,oSymTable->bucketSize);
-            currNode->next = newHead[newBucket];
-            newHead[newBucket] = currNode;
-            currNode = nextNode;
-        }
-    }
+   currNode->left = newRoot->next;
+   newRoot->next = currNode;
+   SymTable_setHeight(currNode);
+   SymTable_setHeight(newRoot);
+   return newRoot;
+}
 
-    free(oSymTable->head);
+/* SymTable_rotateLeft takes in a Binding currNode of a tree that has
+a right child, rotates the subtree rooted at currNode to the left and
+returns its new root */
+static struct Binding *SymTable_rotateLeft(struct Binding *currNode)
+{
+   struct Binding *newRoot = currNode->next;
 
-    oSymTable->head = newHead;
-    return 1;
+   currNode->next = newRoot->left;
+   newRoot->left = currNode;
+   SymTable_setHeight(currNode);
+   SymTable_setHeight(newRoot);
+   return newRoot;
 }
 
-int SymTable_put(SymTable_T oSymTable, const char *pcKey,
-                 const void *pvValue) {
-   size_t bucket; 
-   struct Binding *nNode;
-   struct Binding *currNode;
-   void *defCopy;
-
-   assert(oSymTable != NULL);
-   assert(pcKey != NULL); 
+/* SymTable_balance takes in a Binding currNode of a tree whose
+children are balanced and differ in height by at most 2. It rotates
+the subtree rooted at currNode so its children differ in height by at
+most 1 and returns its new root. */
+static struct Binding *SymTable_balance(struct Binding *currNode)
+{
+   int iBalance;
 
-   bucket = SymTable_hash(pcKey,oSymTable->bucketSize);
-   nNode = malloc(sizeof(struct Binding));
-   currNode = oSymTable->head[bucket];
-   defCopy = malloc(strlen(pcKey)+1);
+   SymTable_setHeight(currNode);
+   iBalance = SymTable_getHeight(currNode->left) -
+              SymTable_getHeight(currNode->next);
+   if (iBalance > 1) {
+      if (SymTable_getHeight(currNode->left->left) <
+          SymTable_getHeight(currNode->left->next)) {
+         currNode->left = SymTable_rotateLeft(currNode->left);
+      }
+      return SymTable_rotateRight(currNode);
+   }
+   if (iBalance < -1) {
+      if (SymTable_getHeight(currNode->next->next) <
+          SymTable_getHeight(currNode->next->left)) {
+         currNode->next = SymTable_rotateRight(currNode->next);
+      }
+      return SymTable_rotateLeft(currNode);
+   }
+   return currNode;
+}
 
-   if (nNode == NULL) {
-      return 0;
+/* SymTable_treeInsert takes in SymTable oSymTable, the root of a tree
+(or NULL) and a Binding nNode whose key is not in the tree. It adds
+nNode to the tree and returns the tree's new root. */
+static struct Binding *SymTable_treeInsert(SymTable_T oSymTable,
+                                           struct Binding *root,
+                                           struct Binding *nNode)
+{
+   if (root == NULL) {
+      nNode->left = NULL;
+      nNode->next = NULL;
+      nNode->height = 1;
+      return nNode;
    }
-   if (defCopy == NULL) {
-      free(nNode);
-      return 0;
+   if (SymTable_compare(oSymTable, nNode->key, nNode->keyLength,
+                        nNode->hash, root) < 0) {
+      root->left = SymTable_treeInsert(oSymTable, root->left, nNode);
+   } else {
+      root->next = SymTable_treeInsert(oSymTable, root->next, nNode);
    }
+   return SymTable_balance(root);
+}
 
-   strcpy(defCopy, pcKey);
-   nNode->key = defCopy;
-   nNode->value = pvValue;
-   nNode->next = oSymTable->head[bucket];
+/* SymTable_removeMin takes in the root of a non empty tree, unlinks
+its first Binding, sets *ppMin to it and returns the tree's new
+root */
+static struct Binding *SymTable_removeMin(struct Binding *root,
+                                          struct Binding **ppMin)
+{
+   if (root->left == NULL) {
+      *ppMin = root;
+      return root->next;
+   }
+   root->left = SymTable_removeMin(root->left, ppMin);
+   return SymTable_balance(root);
+}
 
-   while (currNode != NULL) {
-      if (strcmp(currNode->key, pcKey) == 0) {
-         free(defCopy);
-         free(nNode);
-         return 0;
+/* SymTable_treeRemove takes in SymTable oSymTable, the root of a tree
+(or NULL), a const char pointer pcKey, its length uLength and its full
+hash uHash. It unlinks the Binding whose key is pcKey from the tree,
+sets *ppFound to it (leaving *ppFound alone if there is none) and
+returns the tree's new root. Bindings are relinked, never copied, so
+pointers into the others stay valid. */
+static struct Binding *SymTable_treeRemove(SymTable_T oSymTable,
+                                           struct Binding *root,
+                                           const char *pcKey,
+                                           size_t uLength, size_t uHash,
+                                           struct Binding **ppFound)
+{
+   struct Binding *minNode;
+   struct Binding *right;
+   int iCmp;
+
+   if (root == NULL) {
+      return NULL;
+   }
+   iCmp = SymTable_compare(oSymTable, pcKey, uLength, uHash, root);
+   if (iCmp < 0) {
+      root->left = SymTable_treeRemove(oSymTable, root->left, pcKey,
+                                       uLength, uHash, ppFound);
+   } else if (iCmp > 0) {
+      root->next = SymTable_treeRemove(oSymTable, root->next, pcKey,
+                                       uLength, uHash, ppFound);
+   } else {
+      *ppFound = root;
+      if (root->left == NULL) {
+         return root->next;
       }
-      currNode = currNode->next;
+      if (root->next == NULL) {
+         return root->left;
+      }
+      /* the next Binding in order takes root's place */
+      right = SymTable_removeMin(root->next, &minNode);
+      minNode->left = root->left;
+      minNode->next = right;
+      return SymTable_balance(minNode);
    }
-   oSymTable->head[bucket] = nNode;
-   oSymTable->bindingsSize++;
-   if(oSymTable->bindingsSize > oSymTable->bucketSize)
-   {
-     SymTable_expand(oSymTable);
+   return SymTable_balance(root);
+}
+
+/* SymTable_toChain takes in the root of a tree (or NULL) and a chain
+rest. It turns the tree into a chain of its Bindings in order,
+followed by rest, and returns the chain's first Binding. */
+static struct Binding *SymTable_toChain(struct Binding *root,
+                                        struct Binding *rest)
+{
+   struct Binding *left;
+
+   /* the right subtree goes first, since the chain is built back to
+   front */
+   while (root != NULL) {
+      left = root->left;
+      rest = SymTable_toChain(root->next, rest);
+      root->next = rest;
+      root->left = NULL;
+      root->height = 0;
+      rest = root;
+      root = left;
    }
-   return 1;
+   return rest;
 }
 
-void *SymTable_replace(SymTable_T oSymTable, const char *pcKey,
-                       const void *pvValue){
+/* SymTable_link takes in SymTable oSymTable, a pointer ppBucket to a
+bucket and a Binding nNode whose key is not in the bucket. It adds
+nNode to the bucket's tree, or to the front of its chain, which is
+turned into a tree if it gets longer than TREEIFY_LENGTH (unless
+oSymTable has iterators). */
+static void SymTable_link(SymTable_T oSymTable, struct Binding **ppBucket,
+                          struct Binding *nNode)
+{
    struct Binding *currNode;
-   void* oldValue;
-   size_t bucket; 
+   struct Binding *nextNode;
+   struct Binding *root;
+   size_t uChainLength;
 
-   assert(oSymTable != NULL);
-   assert(pcKey != NULL);
+   if (SymTable_isTree(*ppBucket)) {
+      *ppBucket = SymTable_treeInsert(oSymTable, *ppBucket, nNode);
+      return;
+   }
+   nNode->next = *ppBucket;
+   nNode->left = NULL;
+   nNode->height = 0;
+   *ppBucket = nNode;
 
-   bucket = SymTable_hash(pcKey,oSymTable->bucketSize);
-   currNode = oSymTable->head[bucket];
-   while (currNode != NULL) {
-      if (strcmp(currNode->key, pcKey) == 0) {
-         oldValue = (void*)currNode->value;
-         currNode->value = pvValue;
-         return oldValue;
+   uChainLength = 0;
+   for (currNode = nNode; currNode != NULL; currNode = currNode->next) {
+      if (++uChainLength > TREEIFY_LENGTH) {
+         break;
       }
-      currNode = currNode->next;
    }
-   return NULL;
+   if (uChainLength <= TREEIFY_LENGTH || oSymTable->iters != NULL) {
+      return;
+   }
+   root = NULL;
+   for (currNode = *ppBucket; currNode != NULL; currNode = nextNode) {
+      nextNode = currNode->next;
+      root = SymTable_treeInsert(oSymTable, root, currNode);
+   }
+   *ppBucket = root;
 }
 
-int SymTable_contains(SymTable_T oSymTable, const char *pcKey){
-   struct Binding *currNode;
-   size_t bucket;
+/* SymTable_findInTree takes in SymTable oSymTable, the root currNode
+of a tree, a const char pointer pcKey, its length uLength and its full
+hash uHash. It returns the Binding in the tree whose key is pcKey, or
+NULL if there is none. */
+static struct Binding *SymTable_findInTree(SymTable_T oSymTable,
+                                           struct Binding *currNode,
+                                           const char *pcKey,
+                                           size_t uLength, size_t uHash)
+{
+   int iCmp;
 
-   assert(oSymTable != NULL);
-   assert(pcKey != NULL);
+   while (currNode != NULL) {
+      iCmp = SymTable_compare(oSymTable, pcKey, uLength, uHash,
+                              currNode);
+      if (iCmp == 0) {
+         return currNode;
+      }
+      currNode = (iCmp < 0) ? currNode->left : currNode->next;
+   }
+   return NULL;
+}
 
-   bucket = SymTable_hash(pcKey,oSymTable->bucketSize);
-   currNode = oSymTable->head[bucket];
+/* SymTable_findInChain takes in SymTable oSymTable, the first Binding
+currNode of a chain, a const char pointer pcKey, its length uLength,
+its full hash uHash and iAtom, which is 1 if pcKey is an atom. It
+returns the Binding in the chain whose key is pcKey, or NULL if there
+is none. */
+static struct Binding *SymTable_findInChain(SymTable_T oSymTable,
+                                            struct Binding *currNode,
+                                            const char *pcKey,
+                                            size_t uLength,
+                                            size_t uHash, int iAtom)
+{
    while (currNode != NULL) {
-      if (strcmp(currNode->key, pcKey) == 0) {
-         return 1;
+      if (SymTable_matches(oSymTable, currNode, pcKey, uLength, uHash,
+                           iAtom)) {
+         return currNode;
       }
       currNode = currNode->next;
    }
-   return 0;
+   return NULL;
 }
 
-void *SymTable_get(SymTable_T oSymTable, const char *pcKey){
-   struct Binding *currNode;
-   size_t bucket = SymTable_hash(pcKey,oSymTable->bucketSize);
+/* SymTable_findInBucket takes in SymTable oSymTable, the first
+Binding currNode of a bucket, a const char pointer pcKey, its length
+uLength, its full hash uHash and iAtom, which is 1 if pcKey is an
+atom. It returns the Binding in the bucket, chain or tree, whose key
+is pcKey, or NULL if there is none. */
+static struct Binding *SymTable_findInBucket(SymTable_T oSymTable,
+                                             struct Binding *currNode,
+                                             const char *pcKey,
+                                             size_t uLength,
+                                             size_t uHash, int iAtom)
+{
+   if (SymTable_isTree(currNode)) {
+      return SymTable_findInTree(oSymTable, currNode, pcKey, uLength,
+                                 uHash);
+   }
+   return SymTable_findInChain(oSymTable, currNode, pcKey, uLength,
+                               uHash, iAtom);
+}
 
-   assert(oSymTable != NULL);
-   assert(pcKey != NULL);
+/* SymTable_probeBucket takes in SymTable oSymTable, the first Binding
+currNode of a bucket, a const char pointer pcKey, its length uLength,
+its full hash uHash, the Binding pFound that a lookup of pcKey found
+(or NULL) and an int pointer piFound. It walks the bucket again as
+SymTable_findInBucket did, sets *piFound to 1 if it holds pFound and
+0 otherwise, and returns how many Bindings the walk looked at. */
+static size_t SymTable_probeBucket(SymTable_T oSymTable,
+                                   struct Binding *currNode,
+                                   const char *pcKey, size_t uLength,
+                                   size_t uHash,
+                                   const struct Binding *pFound,
+                                   int *piFound)
+{
+   size_t uProbes = 0;
+   size_t uCompares = oSymTable->compareCount;
+   int iCmp;
 
-   currNode = oSymTable->head[bucket];
+   *piFound = 0;
+   if (SymTable_isTree(currNode)) {
+      while (currNode != NULL) {
+         uProbes++;
+         iCmp = SymTable_compare(oSymTable, pcKey, uLength, uHash,
+                                 currNode);
+         if (iCmp == 0) {
+            *piFound = 1;
+            break;
+         }
+         currNode = (iCmp < 0) ? currNode->left : currNode->next;
+      }
+      /* the walk only counts probes, so its compares are not counted
+      as the lookup's */
+      oSymTable->compareCount = uCompares;
+      return uProbes;
+   }
    while (currNode != NULL) {
-      if (strcmp(currNode->key, pcKey) == 0) {
-         return (void*)currNode->value;
+      uProbes++;
+      if (currNode == pFound) {
+         *piFound = 1;
+         break;
       }
       currNode = currNode->next;
    }
-   return NULL;
+   return uProbes;
 }
 
-void *SymTable_remove(SymTable_T oSymTable, const char *pcKey){
-   struct Binding *currNode; 
+/* SymTable_countLookup takes in SymTable oSymTable, which has stats,
+a const char pointer pcKey, its length uLength, its full hash uHash
+and the Binding pFound that a lookup of pcKey found (or NULL), and
+counts the lookup and the Bindings it looked at in oSymTable's
+stats */
+static void SymTable_countLookup(SymTable_T oSymTable,
+                                 const char *pcKey, size_t uLength,
+                                 size_t uHash,
+                                 const struct Binding *pFound)
+{
+   size_t uProbes;
+   int iFound;
+
+   uProbes = SymTable_probeBucket(oSymTable,
+      oSymTable->head[uHash % oSymTable->bucketSize], pcKey, uLength,
+      uHash, pFound, &iFound);
+   if (! iFound && oSymTable->oldHead != NULL) {
+      uProbes += SymTable_probeBucket(oSymTable,
+         oSymTable->oldHead[uHash % oSymTable->oldBucketSize], pcKey,
+         uLength, uHash, pFound, &iFound);
+   }
+   Stats_addLookup(oSymTable->stats, uProbes, pFound != NULL);
+}
+
+/* SymTable_find takes in SymTable oSymTable, a const char pointer
+pcKey, its length uLength, its full hash uHash and iAtom, which is 1
+if pcKey is an atom. It returns the Binding whose key is pcKey, or
+NULL if there is none. While an incremental expansion is in progress
+the bucket of uHash in the old bucket array is searched too. */
+static struct Binding *SymTable_find(SymTable_T oSymTable,
+                                     const char *pcKey, size_t uLength,
+                                     size_t uHash, int iAtom)
+{
+   struct Binding *currNode;
+
+   currNode = SymTable_findInBucket(oSymTable,
+      oSymTable->head[uHash % oSymTable->bucketSize], pcKey, uLength,
+      uHash, iAtom);
+   if (currNode == NULL && oSymTable->oldHead != NULL) {
+      currNode = SymTable_findInBucket(oSymTable,
+         oSymTable->oldHead[uHash % oSymTable->oldBucketSize],
+         pcKey, uLength, uHash, iAtom);
+   }
+   if (oSymTable->stats != NULL) {
+      SymTable_countLookup(oSymTable, pcKey, uLength, uHash, currNode);
+   }
+   return currNode;
+}
+
+/* SymTable_unlink takes in SymTable oSymTable, a pointer ppBucket to
+a bucket, a const char pointer pcKey, its length uLength and its full
+hash uHash. It unlinks the Binding whose key is pcKey from the bucket
+and returns it, or returns NULL if the bucket holds no such Binding. A
+tree that has become short enough is turned back into a chain, unless
+oSymTable has iterators. */
+static struct Binding *SymTable_unlink(SymTable_T oSymTable,
+                                       struct Binding **ppBucket,
+                                       const char *pcKey,
+                                       size_t uLength, size_t uHash)
+{
+   struct Binding *currNode;
    struct Binding *prev;
-   size_t bucket;
-   void* value;
 
-   assert(oSymTable != NULL);
-   assert(pcKey != NULL);
+   if (SymTable_isTree(*ppBucket)) {
+      currNode = NULL;
+      *ppBucket = SymTable_treeRemove(oSymTable, *ppBucket, pcKey,
+                                      uLength, uHash, &currNode);
+      if (*ppBucket != NULL && oSymTable->iters == NULL &&
+          (*ppBucket)->height <= UNTREEIFY_HEIGHT) {
+         *ppBucket = SymTable_toChain(*ppBucket, NULL);
+      }
+      return currNode;
+   }
 
-   bucket = SymTable_hash(pcKey,oSymTable->bucketSize);
-   currNode = oSymTable->head[bucket];
+   currNode = *ppBucket;
    prev = NULL;
    while (currNode != NULL) {
-      if (strcmp(currNode->key, pcKey) == 0) {
-         value = (void*)currNode->value;
-         oSymTable->bindingsSize--;
-
+      if (SymTable_matches(oSymTable, currNode, pcKey, uLength, uHash,
+                           0)) {
          if (prev != NULL) {
             prev->next = currNode->next;
          } else {
-            oSymTable->head[bucket] = currNode->next;
+            *ppBucket = currNode->next;
          }
-         free((void*)currNode->key);
-         free((void*)currNode);
+         return currNode;
+      }
+      prev = currNode;
+      currNode = currNode->next;
+   }
+   return NULL;
+}
 
-         return value;
-     }
-     prev = currNode;
-     currNode = currNode->next;
-    }
-    return NULL;
+/* SymTable_bucketBytes takes in a bucket count uBucketCount and
+returns the size in bytes of an array of uBucketCount buckets and its
+occupancy bitmap */
+static size_t SymTable_bucketBytes(size_t uBucketCount)
+{
+   size_t uWords = (uBucketCount + WORD_BITS - 1) / WORD_BITS;
+
+   return uBucketCount * sizeof(struct Binding*) +
+          uWords * sizeof(size_t);
 }
 
-void SymTable_map(SymTable_T oSymTable,
-                  void (*pfApply)(const char *pcKey,
-                                  void *pvValue, void *pvExtra),
-                  const void *pvExtra){
+/* SymTable_newBuckets takes in a bucket count uBucketCount and
+returns a new array of uBucketCount empty buckets followed by its
+occupancy bitmap (see SymTable_bitmap), or NULL if there is
+insufficient memory */
+static struct Binding **SymTable_newBuckets(size_t uBucketCount)
+{
+   return calloc(1, SymTable_bucketBytes(uBucketCount));
+}
+
+/* SymTable_bitmap takes in a bucket array ppHead made by
+SymTable_newBuckets and its bucket count uBucketCount, and returns the
+occupancy bitmap that follows the buckets: bit i % WORD_BITS of word
+i / WORD_BITS is set if bucket i is not empty. It lets an iterator
+skip WORD_BITS empty buckets at a time. */
+static size_t *SymTable_bitmap(struct Binding **ppHead,
+                               size_t uBucketCount)
+{
+   return (size_t *)(ppHead + uBucketCount);
+}
+
+/* SymTable_setOccupied takes in a bucket array ppHead made by
+SymTable_newBuckets, its bucket count uBucketCount, a bucket uBucket
+and iOccupied. It sets the bit of uBucket in the occupancy bitmap if
+iOccupied is 1 and clears it if iOccupied is 0. */
+static void SymTable_setOccupied(struct Binding **ppHead,
+                                 size_t uBucketCount, size_t uBucket,
+                                 int iOccupied)
+{
+   size_t *puWord = &SymTable_bitmap(ppHead, uBucketCount)
+                       [uBucket / WORD_BITS];
+   size_t uBit = (size_t)1 << (uBucket % WORD_BITS);
+
+   if (iOccupied) {
+      *puWord |= uBit;
+   } else {
+      *puWord &= ~uBit;
+   }
+}
+
+/* SymTable_lowestBit takes in a non zero word uBits and returns the
+index of its lowest set bit */
+static size_t SymTable_lowestBit(size_t uBits)
+{
+#if defined(__GNUC__)
+   return (size_t)__builtin_ctzll((unsigned long long)uBits);
+#else
+   size_t i = 0;
+
+   while ((uBits & 1) == 0) {
+      uBits >>= 1;
+      i++;
+   }
+   return i;
+#endif
+}
+
+/* SymTable_nextOccupied takes in a bucket array ppHead made by
+SymTable_newBuckets, its bucket count uBucketCount and a bucket
+uBucket. It returns the first bucket from uBucket on that is not
+empty, or uBucketCount if there is none. */
+static size_t SymTable_nextOccupied(struct Binding **ppHead,
+                                    size_t uBucketCount, size_t uBucket)
+{
+   size_t *puBitmap = SymTable_bitmap(ppHead, uBucketCount);
+   size_t uWord;
+   size_t uBits;
+
+   if (uBucket >= uBucketCount) {
+      return uBucketCount;
+   }
+   uWord = uBucket / WORD_BITS;
+   uBits = puBitmap[uWord] & ((size_t)-1 << (uBucket % WORD_BITS));
+   while (uBits == 0) {
+      uWord++;
+      if (uWord * WORD_BITS >= uBucketCount) {
+         return uBucketCount;
+      }
+      uBits = puBitmap[uWord];
+   }
+   return uWord * WORD_BITS + SymTable_lowestBit(uBits);
+}
+
+/* SymTable_bucketCount takes in SymTable oSymTable and returns how
+many buckets an iterator looks in: those of head and the old buckets
+not yet migrated */
+static size_t SymTable_bucketCount(SymTable_T oSymTable)
+{
+   if (oSymTable->oldHead == NULL) {
+      return oSymTable->bucketSize;
+   }
+   return oSymTable->bucketSize + oSymTable->oldBucketSize -
+          oSymTable->migrateIndex;
+}
+
+/* SymTable_bucketAt takes in SymTable oSymTable and a bucket uBucket
+numbered as in SymTableIter, and returns the bucket's first Binding
+(or NULL) */
+static struct Binding *SymTable_bucketAt(SymTable_T oSymTable,
+                                         size_t uBucket)
+{
+   if (uBucket < oSymTable->bucketSize) {
+      return oSymTable->head[uBucket];
+   }
+   return oSymTable->oldHead[uBucket - oSymTable->bucketSize +
+                             oSymTable->migrateIndex];
+}
+
+/* SymTable_nextBucket takes in SymTable oSymTable and a bucket
+uBucket numbered as in SymTableIter, and returns the first bucket
+from uBucket on that is not empty, or SymTable_bucketCount(oSymTable)
+if there is none */
+static size_t SymTable_nextBucket(SymTable_T oSymTable, size_t uBucket)
+{
+   size_t uOld;
+
+   if (uBucket < oSymTable->bucketSize) {
+      uBucket = SymTable_nextOccupied(oSymTable->head,
+                                      oSymTable->bucketSize, uBucket);
+      if (uBucket < oSymTable->bucketSize ||
+          oSymTable->oldHead == NULL) {
+         return uBucket;
+      }
+   } else if (oSymTable->oldHead == NULL) {
+      return oSymTable->bucketSize;
+   }
+   uOld = SymTable_nextOccupied(oSymTable->oldHead,
+                                oSymTable->oldBucketSize,
+                                uBucket - oSymTable->bucketSize +
+                                oSymTable->migrateIndex);
+   return uOld - oSymTable->migrateIndex + oSymTable->bucketSize;
+}
+
+/* SymTable_after takes in SymTable oSymTable, the first Binding root
+of a bucket and a Binding currNode, and returns the Binding of the
+bucket that comes after currNode, or NULL if there is none. In a tree
+it is found by currNode's key, so currNode itself need not be in the
+tree any more. */
+static struct Binding *SymTable_after(SymTable_T oSymTable,
+                                      struct Binding *root,
+                                      const struct Binding *currNode)
+{
+   struct Binding *afterNode = NULL;
+
+   if (! SymTable_isTree(root)) {
+      return currNode->next;
+   }
+   while (root != NULL) {
+      if (SymTable_compare(oSymTable, currNode->key,
+                           currNode->keyLength, currNode->hash,
+                           root) < 0) {
+         afterNode = root;
+         root = root->left;
+      } else {
+         root = root->next;
+      }
+   }
+   return afterNode;
+}
+
+/* SymTable_skipRemoved takes in SymTable oSymTable and a Binding
+currNode that has just been unlinked. Every iterator that would have
+returned currNode next moves on to the Binding after it. */
+static void SymTable_skipRemoved(SymTable_T oSymTable,
+                                 const struct Binding *currNode)
+{
+   struct SymTableIter *pIter;
+
+   for (pIter = oSymTable->iters; pIter != NULL;
+        pIter = pIter->nextIter) {
+      if (pIter->nextNode == currNode) {
+         pIter->nextNode = SymTable_after(oSymTable,
+            SymTable_bucketAt(oSymTable, pIter->bucket), currNode);
+         if (pIter->nextNode == NULL) {
+            pIter->bucket++;
+         }
+      }
+   }
+}
+
+/* SymTable_migrate takes in SymTable oSymTable and a bucket count
+uSteps. If an incremental expansion is in progress, the Bindings of
+the next uSteps buckets of the old bucket array are moved into the
+current one by their stored hash, so keys that collided in a tree
+may form a tree again in their new bucket. Once every bucket has been
+moved the old bucket array is freed. Nothing is moved while oSymTable
+has iterators. */
+static void SymTable_migrate(SymTable_T oSymTable, size_t uSteps)
+{
    struct Binding *currNode;
-   size_t i;
- 
-   assert(oSymTable != NULL);
-   assert(pfApply != NULL);
+   struct Binding *nextNode;
+   size_t uBucket;
 
-    for (i = 0; i < (size_t)oSymTable->bucketSize; i++){
-      currNode = oSymTable->head[i];
+   if (oSymTable->oldHead == NULL || oSymTable->iters != NULL) {
+      return;
+   }
+   while (uSteps > 0 &&
+          oSymTable->migrateIndex < oSymTable->oldBucketSize) {
+      currNode = oSymTable->oldHead[oSymTable->migrateIndex];
+      if (SymTable_isTree(currNode)) {
+         currNode = SymTable_toChain(currNode, NULL);
+      }
       while (currNode != NULL) {
-        (*pfApply)(currNode->key, (void*)currNode->value, (void*)pvExtra);
-        currNode = currNode->next;
+         nextNode = currNode->next;
+         uBucket = currNode->hash % oSymTable->bucketSize;
+         SymTable_link(oSymTable, &oSymTable->head[uBucket], currNode);
+         SymTable_setOccupied(oSymTable->head, oSymTable->bucketSize,
+                              uBucket, 1);
+         oSymTable->rehashCount++;
+         currNode = nextNode;
+      }
+      oSymTable->oldHead[oSymTable->migrateIndex] = NULL;
+      SymTable_setOccupied(oSymTable->oldHead, oSymTable->oldBucketSize,
+                           oSymTable->migrateIndex, 0);
+      oSymTable->migrateIndex++;
+      uSteps--;
+   }
+   if (oSymTable->migrateIndex == oSymTable->oldBucketSize) {
+      free(oSymTable->oldHead);
+      oSymTable->oldHead = NULL;
+      oSymTable->oldBucketSize = 0;
+   }
+}
+
+/* SymTable_newBinding takes in SymTable oSymTable, a const char
+pointer pcKey, its length uLength and iKind, one of KeyKinds. It
+returns a new Binding from the arena holding pcKey itself if it is an
+atom or borrowed, and otherwise a '\0' terminated copy of pcKey
+(inside the Binding if it is short enough), or NULL if there is
+insufficient memory. */
+static struct Binding *SymTable_newBinding(SymTable_T oSymTable,
+                                           const char *pcKey,
+                                           size_t uLength, int iKind)
+{
+   struct Binding *nNode;
+   size_t uKeySize;
+   char *defCopy;
+
+   nNode = Arena_alloc(oSymTable->arena, sizeof(struct Binding));
+   if (nNode == NULL) {
+      return NULL;
+   }
+   nNode->keyKind = iKind;
+   nNode->keyLength = uLength;
+   if (iKind != KEY_COPY) {
+      /* atoms live as long as the program, and borrowed keys as long
+      as the client promised, so no copy is needed */
+      nNode->key = pcKey;
+      return nNode;
+   }
+   uKeySize = uLength + 1;
+   if (uKeySize <= INLINE_KEY_SIZE) {
+      defCopy = nNode->inlineKey;
+   } else {
+      defCopy = Arena_alloc(oSymTable->arena, uKeySize);
+      if (defCopy == NULL) {
+         Arena_release(oSymTable->arena, nNode, sizeof(struct Binding));
+         return NULL;
       }
    }
+   memcpy(defCopy, pcKey, uLength);
+   defCopy[uLength] = '\0';
+   nNode->key = defCopy;
+   return nNode;
+}
+
+/* SymTable_freeBinding takes in SymTable oSymTable and a Binding
+currNode and releases currNode and its key copy back to the arena */
+static void SymTable_freeBinding(SymTable_T oSymTable,
+                                 struct Binding *currNode)
+{
+   if (currNode->keyKind == KEY_COPY &&
+       currNode->key != currNode->inlineKey) {
+      Arena_release(oSymTable->arena, (char *)currNode->key,
+                    currNode->keyLength + 1);
+   }
+   Arena_release(oSymTable->arena, currNode, sizeof(struct Binding));
 }
 
+/* SymTable_setExpandAt takes in a SymTable oSymTable and recomputes
+its expandAt and shrinkAt from its bucketSize and maxLoad */
+static void SymTable_setExpandAt(SymTable_T oSymTable)
+{
+   double dExpandAt = (double)oSymTable->bucketSize * oSymTable->maxLoad;
 
+   if (dExpandAt >= (double)(size_t)-1) {
+      oSymTable->expandAt = (size_t)-1;
+   } else {
+      oSymTable->expandAt = (size_t)dExpandAt;
+   }
+   if (oSymTable->bucketSize <= oSymTable->minBucketSize) {
+      oSymTable->shrinkAt = 0;
+   } else {
+      oSymTable->shrinkAt = oSymTable->expandAt / SHRINK_RATIO;
+   }
+}
+
+/* SymTable_nextBucketCount takes in a bucket count uBucketCount and
+returns the bucket count to expand to, or uBucketCount itself if
+the bucket array cannot grow any further */
+static size_t SymTable_nextBucketCount(size_t uBucketCount)
+{
+   size_t i;
+
+   for (i = 0; i < sizeof(bucketCounts) / sizeof(bucketCounts[0]); i++) {
+      if (bucketCounts[i] > uBucketCount) {
+         return bucketCounts[i];
+      }
+   }
+   if (uBucketCount > ((size_t)-1 - 1) / 2) {
+      return uBucketCount;
+   }
+   return 2 * uBucketCount + 1;
+}
+
+/* SymTable_fitBucketCount takes in a SymTable oSymTable and a binding
+count uBindings, and returns the fewest buckets of bucketCounts (from
+bucketMin on) that hold uBindings Bindings under oSymTable's max
+load, or the most there can be if none do */
+static size_t SymTable_fitBucketCount(SymTable_T oSymTable,
+                                      size_t uBindings)
+{
+   size_t uBucketCount = bucketMin;
+   size_t uNextCount;
+
+   while ((double)uBucketCount * oSymTable->maxLoad < (double)uBindings) {
+      uNextCount = SymTable_nextBucketCount(uBucketCount);
+      if (uNextCount == uBucketCount) {
+         break;
+      }
+      uBucketCount = uNextCount;
+   }
+   return uBucketCount;
+}
+
+SymTable_T SymTable_new(void){
+   return SymTable_newWithOptions(SYMTABLE_HASH_DEFAULT);
+}
+
+SymTable_T SymTable_newWithOptions(enum SymTableHash eHash){
+   struct SymTable *oSymTable;
+
+   if (eHash != SYMTABLE_HASH_DEFAULT && eHash != SYMTABLE_HASH_FAST &&
+       eHash != SYMTABLE_HASH_SIPHASH) {
+      return NULL;
+   }
+   oSymTable = malloc(sizeof(struct SymTable));
+   if(oSymTable == NULL){
+      return NULL;
+   }
+   oSymTable->hashKind = eHash;
+   oSymTable->seed.k0 = 0;
+   oSymTable->seed.k1 = 0;
+   if (eHash != SYMTABLE_HASH_DEFAULT) {
+      KeyHash_randomSeed(&oSymTable->seed);
+   }
+   oSymTable->bucketSize = bucketMin;
+   oSymTable->minBucketSize = bucketMin;
+   oSymTable->bindingsSize = 0;
+   oSymTable->maxLoad = DEFAULT_MAX_LOAD;
+   SymTable_setExpandAt(oSymTable);
+   oSymTable->oldHead = NULL;
+   oSymTable->oldBucketSize = 0;
+   oSymTable->migrateIndex = 0;
+   oSymTable->incremental = 0;
+   oSymTable->rehashCount = 0;
+   oSymTable->compareCount = 0;
+   oSymTable->allocCount = 2;
+   oSymTable->iters = NULL;
+   oSymTable->snapshot = NULL;
+   oSymTable->stats = NULL;
+   oSymTable->head = SymTable_newBuckets(oSymTable->bucketSize);
+   if(oSymTable->head == NULL){
+      free(oSymTable);
+      return NULL;
+   }
+   oSymTable->arena = Arena_new();
+   if(oSymTable->arena == NULL){
+      free(oSymTable->head);
+      free(oSymTable);
+      return NULL;
+   }
+   return oSymTable;
+}
+
+void SymTable_free(SymTable_T oSymTable){
+   assert(oSymTable != NULL);
+   assert(oSymTable->iters == NULL);
+
+   /* every Binding and key copy lives in the arena, so the chains
+   never have to be walked */
+   Arena_free(oSymTable->arena);
+   free(oSymTable->oldHead);
+   free(oSymTable->head);
+   Snapshot_close(oSymTable->snapshot);
+   free(oSymTable->stats);
+   free(oSymTable);
+}
+
+size_t SymTable_getLength(SymTable_T oSymTable){
+   assert(oSymTable != NULL);
+   if (oSymTable->snapshot != NULL) {
+      return Snapshot_getLength(oSymTable->snapshot);
+   }
+   return oSymTable->bindingsSize;
+}
+
+/* SymTable_getMapped takes in a mapped SymTable oSymTable and a key
+pvKey of uLength bytes, and returns the value of pvKey in oSymTable's
+snapshot, or NULL if there is none. The snapshot has its own hash
+function, so any hash the client passed in is of no use. */
+static void *SymTable_getMapped(SymTable_T oSymTable, const void *pvKey,
+                                size_t uLength)
+{
+   void *pvValue;
+
+   if (!Snapshot_find(oSymTable->snapshot, pvKey, uLength, &pvValue)) {
+      return NULL;
+   }
+   return pvValue;
+}
+
+/* SymTable_resize takes in a SymTable oSymTable and a bucket count
+newBucketCount other than its own, larger to expand or smaller to
+shrink. The function first finishes any incremental expansion in
+progress. Then a new array of newBucketCount buckets is instantiated
+and becomes the current set of buckets, and the previous set becomes
+the old one that bindings are migrated out of. Unless oSymTable is
+incremental, every binding is rehashed right away and the old array
+of buckets is freed. However, if there is insufficient memory for a
+new array of buckets, or oSymTable has iterators, the function
+returns 0 and leaves the buckets unchanged. Otherwise 1 is
+returned. */
+static size_t SymTable_resize(SymTable_T oSymTable,
+                              size_t newBucketCount) {
+    size_t oldBucketCount;
+    struct Binding **newHead;
+ 
+    assert(oSymTable != NULL);
+    assert(newBucketCount != oSymTable->bucketSize);
+
+    /* the next put or remove after the last iterator has ended
+    resizes */
+    if (oSymTable->iters != NULL) {
+        return 0;
+    }
+    SymTable_migrate(oSymTable, oSymTable->oldBucketSize);
+
+    oldBucketCount = oSymTable->bucketSize;
+
+    /* allocates new array of buckets */
+    newHead = SymTable_newBuckets(newBucketCount);
+    
+    /*checks for insufficient memory allocation */
+    if (newHead == NULL) {
+        return 0;
+    }
+    oSymTable->allocCount++;
+
+    oSymTable->oldHead = oSymTable->head;
+    oSymTable->oldBucketSize = oldBucketCount;
+    oSymTable->migrateIndex = 0;
+    oSymTable->head = newHead;
+    oSymTable->bucketSize = newBucketCount;
+    SymTable_setExpandAt(oSymTable);
+
+    /* rehash old bindings to new array of buckets using the stored
+    hash, so no key is read again */
+    if (! oSymTable->incremental) {
+        SymTable_migrate(oSymTable, oldBucketCount);
+    }
+    return 1;
+}
+
+/* SymTable_expand takes in a parameter of a SymTable oSymTable and
+expands it to the next bucket count of bucketCounts, as
+SymTable_resize does. If the bucketSize cannot be expanded (it would
+overflow size_t), the function returns 0 and leaves the SymTable
+unchanged. Otherwise it returns what SymTable_resize does. */
+static size_t SymTable_expand(SymTable_T oSymTable) {
+    size_t newBucketCount;
+    size_t uResized;
+    double dStart = 0.0;
+
+    assert(oSymTable != NULL);
+
+    newBucketCount = SymTable_nextBucketCount(oSymTable->bucketSize);
+    if(newBucketCount == oSymTable->bucketSize){
+        return 0;
+    }
+    if (oSymTable->stats != NULL) {
+        dStart = Stats_now();
+    }
+    uResized = SymTable_resize(oSymTable, newBucketCount);
+    if (uResized && oSymTable->stats != NULL) {
+        Stats_addExpansion(oSymTable->stats, dStart);
+    }
+    return uResized;
+}
+
+/* SymTable_shrink takes in a SymTable oSymTable that holds fewer
+Bindings than its shrinkAt and shrinks it, as SymTable_resize does,
+to the fewest buckets of bucketCounts (but not below minBucketSize)
+that hold twice its Bindings under the max load. A SymTable that
+cannot shrink now, because it has iterators or there is insufficient
+memory, is left as it is and tried again on a later remove. */
+static void SymTable_shrink(SymTable_T oSymTable)
+{
+   size_t newBucketCount;
+
+   if (oSymTable->iters != NULL) {
+      return;
+   }
+   newBucketCount = SymTable_fitBucketCount(oSymTable,
+                                            2 * oSymTable->bindingsSize);
+   if (newBucketCount < oSymTable->minBucketSize) {
+      newBucketCount = oSymTable->minBucketSize;
+   }
+   if (newBucketCount < oSymTable->bucketSize) {
+      (void)SymTable_resize(oSymTable, newBucketCount);
+   }
+}
+
+/* SymTable_add takes in SymTable oSymTable, a const char pointer
+pcKey that is not in oSymTable, its length uLength, its full hash
+uHash, a const void pointer pvValue and iKind, one of KeyKinds. It
+adds a new binding and returns its Binding, or returns NULL and leaves
+oSymTable unchanged if there is insufficient memory. */
+static struct Binding *SymTable_add(SymTable_T oSymTable,
+                                    const char *pcKey, size_t uLength,
+                                    size_t uHash, const void *pvValue,
+                                    int iKind)
+{
+   struct Binding *nNode;
+   size_t uBucket;
+
+   nNode = SymTable_newBinding(oSymTable, pcKey, uLength, iKind);
+   if (nNode == NULL) {
+      return NULL;
+   }
+
+   nNode->value = pvValue;
+   nNode->hash = uHash;
+   uBucket = uHash % oSymTable->bucketSize;
+   SymTable_link(oSymTable, &oSymTable->head[uBucket], nNode);
+   SymTable_setOccupied(oSymTable->head, oSymTable->bucketSize, uBucket,
+                        1);
+   oSymTable->bindingsSize++;
+   /* Bindings never move, so nNode stays valid after expanding */
+   if(oSymTable->bindingsSize > oSymTable->expandAt)
+   {
+     SymTable_expand(oSymTable);
+   }
+   return nNode;
+}
+
+/* SymTable_insert takes in SymTable oSymTable, a const char pointer
+pcKey, its length uLength, its full hash uHash, a const void pointer
+pvValue and iKind, one of KeyKinds. If oSymTable doesn't contain
+pcKey, a new binding is added and 1 is returned. If it does, or there
+is insufficient memory, oSymTable is left unchanged and 0 is
+returned. */
+static int SymTable_insert(SymTable_T oSymTable, const char *pcKey,
+                           size_t uLength, size_t uHash,
+                           const void *pvValue, int iKind)
+{
+   /* a mapped SymTable is read-only */
+   if (oSymTable->snapshot != NULL) {
+      return 0;
+   }
+   SymTable_migrate(oSymTable, MIGRATE_STEP);
+
+   if (SymTable_find(oSymTable, pcKey, uLength, uHash,
+                     iKind == KEY_ATOM) != NULL) {
+      return 0;
+   }
+   return SymTable_add(oSymTable, pcKey, uLength, uHash, pvValue,
+                       iKind) != NULL;
+}
+
+/* SymTable_delete takes in SymTable oSymTable, a const char pointer
+pcKey, its length uLength and its full hash uHash. It removes the
+binding of pcKey and returns its value, or returns NULL if oSymTable
+doesn't contain pcKey. */
+static void *SymTable_delete(SymTable_T oSymTable, const char *pcKey,
+                             size_t uLength, size_t uHash)
+{
+   struct Binding *currNode; 
+   size_t uBucket;
+   void* value;
+
+   if (oSymTable->snapshot != NULL) {
+      return NULL;
+   }
+   SymTable_migrate(oSymTable, MIGRATE_STEP);
+
+   uBucket = uHash % oSymTable->bucketSize;
+   currNode = SymTable_unlink(oSymTable, &oSymTable->head[uBucket],
+                              pcKey, uLength, uHash);
+   if (currNode != NULL) {
+      if (oSymTable->head[uBucket] == NULL) {
+         SymTable_setOccupied(oSymTable->head, oSymTable->bucketSize,
+                              uBucket, 0);
+      }
+   } else if (oSymTable->oldHead != NULL) {
+      uBucket = uHash % oSymTable->oldBucketSize;
+      currNode = SymTable_unlink(oSymTable, &oSymTable->oldHead[uBucket],
+                                 pcKey, uLength, uHash);
+      if (currNode != NULL && oSymTable->oldHead[uBucket] == NULL) {
+         SymTable_setOccupied(oSymTable->oldHead,
+                              oSymTable->oldBucketSize, uBucket, 0);
+      }
+   }
+   if (currNode == NULL) {
+      return NULL;
+   }
+
+   value = (void*)currNode->value;
+   oSymTable->bindingsSize--;
+   SymTable_skipRemoved(oSymTable, currNode);
+   SymTable_freeBinding(oSymTable, currNode);
+   if (oSymTable->bindingsSize < oSymTable->shrinkAt) {
+      SymTable_shrink(oSymTable);
+   }
+   return value;
+}
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey,
+                 const void *pvValue) {
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL); 
+
+   return SymTable_putN(oSymTable, pcKey, strlen(pcKey), pvValue);
+}
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey,
+                       const void *pvValue){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   return SymTable_replaceN(oSymTable, pcKey, strlen(pcKey), pvValue);
+}
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   return SymTable_containsN(oSymTable, pcKey, strlen(pcKey));
+}
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   return SymTable_getN(oSymTable, pcKey, strlen(pcKey));
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   return SymTable_removeN(oSymTable, pcKey, strlen(pcKey));
+}
+
+int SymTable_putN(SymTable_T oSymTable, const void *pvKey,
+                  size_t uLength, const void *pvValue){
+   assert(oSymTable != NULL);
+   assert(pvKey != NULL);
+
+   return SymTable_insert(oSymTable, pvKey, uLength,
+                          SymTable_hash(oSymTable, pvKey, uLength),
+                          pvValue, KEY_COPY);
+}
+
+void *SymTable_replaceN(SymTable_T oSymTable, const void *pvKey,
+                        size_t uLength, const void *pvValue){
+   struct Binding *currNode;
+   void* oldValue;
+
+   assert(oSymTable != NULL);
+   assert(pvKey != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      return NULL;
+   }
+   SymTable_migrate(oSymTable, MIGRATE_STEP);
+
+   currNode = SymTable_find(oSymTable, pvKey, uLength,
+                            SymTable_hash(oSymTable, pvKey, uLength), 0);
+   if (currNode == NULL) {
+      return NULL;
+   }
+   oldValue = (void*)currNode->value;
+   currNode->value = pvValue;
+   return oldValue;
+}
+
+int SymTable_containsN(SymTable_T oSymTable, const void *pvKey,
+                       size_t uLength){
+   assert(oSymTable != NULL);
+   assert(pvKey != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      return Snapshot_find(oSymTable->snapshot, pvKey, uLength, NULL);
+   }
+   SymTable_migrate(oSymTable, MIGRATE_STEP);
+
+   return SymTable_find(oSymTable, pvKey, uLength,
+                        SymTable_hash(oSymTable, pvKey, uLength), 0)
+          != NULL;
+}
+
+void *SymTable_getN(SymTable_T oSymTable, const void *pvKey,
+                    size_t uLength){
+   struct Binding *currNode;
+
+   assert(oSymTable != NULL);
+   assert(pvKey != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      return SymTable_getMapped(oSymTable, pvKey, uLength);
+   }
+   SymTable_migrate(oSymTable, MIGRATE_STEP);
+
+   currNode = SymTable_find(oSymTable, pvKey, uLength,
+                            SymTable_hash(oSymTable, pvKey, uLength), 0);
+   if (currNode == NULL) {
+      return NULL;
+   }
+   return (void*)currNode->value;
+}
+
+void *SymTable_removeN(SymTable_T oSymTable, const void *pvKey,
+                       size_t uLength){
+   assert(oSymTable != NULL);
+   assert(pvKey != NULL);
+
+   return SymTable_delete(oSymTable, pvKey, uLength,
+                          SymTable_hash(oSymTable, pvKey, uLength));
+}
+
+/* SymTable_order takes in keys pcKey and pcOther of uLength and
+uOtherLength bytes and returns a number less than, equal to or greater
+than 0 as pcKey is ordered before, the same as or after pcOther */
+static int SymTable_order(const char *pcKey, size_t uLength,
+                          const char *pcOther, size_t uOtherLength)
+{
+   int iResult;
+
+   iResult = memcmp(pcKey, pcOther,
+                    uLength < uOtherLength ? uLength : uOtherLength);
+   if (iResult != 0) {
+      return iResult;
+   }
+   return (uLength > uOtherLength) - (uLength < uOtherLength);
+}
+
+/* SymTable_inBounds takes in KeyBounds psBounds, which may be NULL to
+ask for every key, and a Binding currNode. It returns 1 if psBounds
+asks for currNode's key and 0 otherwise. */
+static int SymTable_inBounds(const struct KeyBounds *psBounds,
+                             const struct Binding *currNode)
+{
+   if (psBounds == NULL) {
+      return 1;
+   }
+   if (psBounds->prefix != NULL) {
+      return currNode->keyLength >= psBounds->prefixLength &&
+             memcmp(currNode->key, psBounds->prefix,
+                    psBounds->prefixLength) == 0;
+   }
+   if (psBounds->low != NULL &&
+       SymTable_order(currNode->key, currNode->keyLength,
+                      psBounds->low, psBounds->lowLength) < 0) {
+      return 0;
+   }
+   return psBounds->high == NULL ||
+          SymTable_order(currNode->key, currNode->keyLength,
+                         psBounds->high, psBounds->highLength) < 0;
+}
+
+/* SymTable_mapBucket takes in the first Binding currNode of a bucket
+(or NULL), KeyBounds psBounds (or NULL), pfApply and pvExtra, and
+calls (*pfApply)(key, value, pvExtra) for every Binding in the bucket
+whose key psBounds asks for. A chain's Bindings have no left child, so
+the same loop walks a chain and a tree in order. */
+static void SymTable_mapBucket(struct Binding *currNode,
+                               const struct KeyBounds *psBounds,
+                               void (*pfApply)(const char *pcKey,
+                                               void *pvValue,
+                                               void *pvExtra),
+                               const void *pvExtra)
+{
+   while (currNode != NULL) {
+      if (currNode->left != NULL) {
+         SymTable_mapBucket(currNode->left, psBounds, pfApply, pvExtra);
+      }
+      if (SymTable_inBounds(psBounds, currNode)) {
+         (*pfApply)(currNode->key, (void*)currNode->value,
+                    (void*)pvExtra);
+      }
+      currNode = currNode->next;
+   }
+}
+
+/* SymTable_mapBounded takes in SymTable oSymTable, KeyBounds psBounds
+(or NULL for every binding), pfApply and pvExtra, and maps the
+bindings of oSymTable whose keys psBounds asks for. Hashing scatters
+neighbouring keys, so every bucket is looked in. */
+static void SymTable_mapBounded(SymTable_T oSymTable,
+                                const struct KeyBounds *psBounds,
+                                void (*pfApply)(const char *pcKey,
+                                                void *pvValue,
+                                                void *pvExtra),
+                                const void *pvExtra)
+{
+   size_t i;
+
+   for (i = 0; i < (size_t)oSymTable->bucketSize; i++){
+      SymTable_mapBucket(oSymTable->head[i], psBounds, pfApply,
+                         pvExtra);
+   }
+   /* bindings not yet migrated by an incremental expansion */
+   for (i = oSymTable->migrateIndex; i < oSymTable->oldBucketSize; i++){
+      SymTable_mapBucket(oSymTable->oldHead[i], psBounds, pfApply,
+                         pvExtra);
+   }
+}
+
+void SymTable_map(SymTable_T oSymTable,
+                  void (*pfApply)(const char *pcKey,
+                                  void *pvValue, void *pvExtra),
+                  const void *pvExtra){
+   assert(oSymTable != NULL);
+   assert(pfApply != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      Snapshot_map(oSymTable->snapshot, pfApply, pvExtra);
+      return;
+   }
+   SymTable_mapBounded(oSymTable, NULL, pfApply, pvExtra);
+}
+
+void SymTable_getCounts(SymTable_T oSymTable, size_t *puRehashes,
+                        size_t *puCompares){
+   assert(oSymTable != NULL);
+   assert(puRehashes != NULL);
+   assert(puCompares != NULL);
+
+   *puRehashes = oSymTable->rehashCount;
+   *puCompares = oSymTable->compareCount;
+}
+
+int SymTable_setMaxLoad(SymTable_T oSymTable, double dMaxLoad){
+   assert(oSymTable != NULL);
+
+   if (! (dMaxLoad > 0.0)) {
+      return 0;
+   }
+   oSymTable->maxLoad = dMaxLoad;
+   SymTable_setExpandAt(oSymTable);
+
+   /* a lower max load can leave the SymTable over its new limit */
+   while (oSymTable->bindingsSize > oSymTable->expandAt) {
+      if (! SymTable_expand(oSymTable)) {
+         break;
+      }
+   }
+   return 1;
+}
+
+int SymTable_setIncremental(SymTable_T oSymTable, int iIncremental){
+   assert(oSymTable != NULL);
+
+   oSymTable->incremental = (iIncremental != 0);
+   if (! oSymTable->incremental) {
+      SymTable_migrate(oSymTable, oSymTable->oldBucketSize);
+   }
+   return 1;
+}
+
+size_t SymTable_getAllocCount(SymTable_T oSymTable){
+   assert(oSymTable != NULL);
+   return oSymTable->allocCount + Arena_getAllocCount(oSymTable->arena);
+}
+
+size_t SymTable_getBytes(SymTable_T oSymTable){
+   size_t uBytes;
+
+   assert(oSymTable != NULL);
+
+   uBytes = sizeof(struct SymTable) +
+            SymTable_bucketBytes(oSymTable->bucketSize) +
+            Arena_getBytes(oSymTable->arena);
+   if (oSymTable->snapshot != NULL) {
+      uBytes += Snapshot_getBytes(oSymTable->snapshot);
+   }
+   if (oSymTable->stats != NULL) {
+      uBytes += sizeof(struct Stats);
+   }
+   /* an incremental expansion holds both bucket arrays until the old
+   one is drained */
+   if (oSymTable->oldHead != NULL) {
+      uBytes += SymTable_bucketBytes(oSymTable->oldBucketSize);
+   }
+   return uBytes;
+}
+
+int SymTable_putAtom(SymTable_T oSymTable, const char *pcAtom,
+                     const void *pvValue){
+   size_t uLength;
+
+   assert(oSymTable != NULL);
+   assert(pcAtom != NULL);
+
+   uLength = Atom_getLength(pcAtom);
+   return SymTable_insert(oSymTable, pcAtom, uLength,
+      SymTable_rehash(oSymTable, pcAtom, uLength, Atom_getHash(pcAtom)),
+      pvValue, KEY_ATOM);
+}
+
+void *SymTable_getAtom(SymTable_T oSymTable, const char *pcAtom){
+   struct Binding *currNode;
+   size_t uLength;
+
+   assert(oSymTable != NULL);
+   assert(pcAtom != NULL);
+
+   uLength = Atom_getLength(pcAtom);
+   if (oSymTable->snapshot != NULL) {
+      return SymTable_getMapped(oSymTable, pcAtom, uLength);
+   }
+   SymTable_migrate(oSymTable, MIGRATE_STEP);
+
+   currNode = SymTable_find(oSymTable, pcAtom, uLength,
+      SymTable_rehash(oSymTable, pcAtom, uLength, Atom_getHash(pcAtom)),
+      1);
+   if (currNode == NULL) {
+      return NULL;
+   }
+   return (void*)currNode->value;
+}
+
+int SymTable_putBorrowed(SymTable_T oSymTable, const char *pcKey,
+                         const void *pvValue){
+   size_t uLength;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   uLength = strlen(pcKey);
+   return SymTable_insert(oSymTable, pcKey, uLength,
+                          SymTable_hash(oSymTable, pcKey, uLength),
+                          pvValue, KEY_BORROWED);
+}
+
+void **SymTable_getOrPut(SymTable_T oSymTable, const char *pcKey,
+                         const void *pvValue, int *piFound){
+   struct Binding *currNode;
+   size_t uLength;
+   size_t uHash;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      return NULL;
+   }
+   SymTable_migrate(oSymTable, MIGRATE_STEP);
+
+   uLength = strlen(pcKey);
+   uHash = SymTable_hash(oSymTable, pcKey, uLength);
+   currNode = SymTable_find(oSymTable, pcKey, uLength, uHash, 0);
+   if (piFound != NULL) {
+      *piFound = (currNode != NULL);
+   }
+   if (currNode == NULL) {
+      currNode = SymTable_add(oSymTable, pcKey, uLength, uHash,
+                              pvValue, KEY_COPY);
+      if (currNode == NULL) {
+         return NULL;
+      }
+   }
+   return (void **)&currNode->value;
+}
+
+int SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+                    const void *pvValue, void **ppvOldValue){
+   struct Binding *currNode;
+   size_t uLength;
+   size_t uHash;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      return 0;
+   }
+   SymTable_migrate(oSymTable, MIGRATE_STEP);
+
+   uLength = strlen(pcKey);
+   uHash = SymTable_hash(oSymTable, pcKey, uLength);
+   currNode = SymTable_find(oSymTable, pcKey, uLength, uHash, 0);
+   if (currNode == NULL) {
+      if (SymTable_add(oSymTable, pcKey, uLength, uHash, pvValue,
+                       KEY_COPY) == NULL) {
+         return 0;
+      }
+      if (ppvOldValue != NULL) {
+         *ppvOldValue = NULL;
+      }
+      return 1;
+   }
+   if (ppvOldValue != NULL) {
+      *ppvOldValue = (void*)currNode->value;
+   }
+   currNode->value = pvValue;
+   return 1;
+}
+
+int SymTable_putHashed(SymTable_T oSymTable, const char *pcKey,
+                       size_t uHash, const void *pvValue){
+   size_t uLength;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   uLength = strlen(pcKey);
+   return SymTable_insert(oSymTable, pcKey, uLength,
+                          SymTable_rehash(oSymTable, pcKey, uLength,
+                                          uHash),
+                          pvValue, KEY_COPY);
+}
+
+void *SymTable_getHashed(SymTable_T oSymTable, const char *pcKey,
+                         size_t uHash){
+   struct Binding *currNode;
+   size_t uLength;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   uLength = strlen(pcKey);
+   if (oSymTable->snapshot != NULL) {
+      return SymTable_getMapped(oSymTable, pcKey, uLength);
+   }
+   SymTable_migrate(oSymTable, MIGRATE_STEP);
+
+   currNode = SymTable_find(oSymTable, pcKey, uLength,
+      SymTable_rehash(oSymTable, pcKey, uLength, uHash), 0);
+   if (currNode == NULL) {
+      return NULL;
+   }
+   return (void*)currNode->value;
+}
+
+int SymTable_containsHashed(SymTable_T oSymTable, const char *pcKey,
+                            size_t uHash){
+   size_t uLength;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   uLength = strlen(pcKey);
+   if (oSymTable->snapshot != NULL) {
+      return Snapshot_find(oSymTable->snapshot, pcKey, uLength, NULL);
+   }
+   SymTable_migrate(oSymTable, MIGRATE_STEP);
+
+   return SymTable_find(oSymTable, pcKey, uLength,
+      SymTable_rehash(oSymTable, pcKey, uLength, uHash), 0) != NULL;
+}
+
+void *SymTable_removeHashed(SymTable_T oSymTable, const char *pcKey,
+                            size_t uHash){
+   size_t uLength;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   uLength = strlen(pcKey);
+   return SymTable_delete(oSymTable, pcKey, uLength,
+      SymTable_rehash(oSymTable, pcKey, uLength, uHash));
+}
+
+void SymTable_getMany(SymTable_T oSymTable, const char *const apcKeys[],
+                      size_t uCount, void *apvValues[]){
+   size_t auHashes[BATCH_SIZE];
+   size_t auLengths[BATCH_SIZE];
+   struct Binding **appBuckets[BATCH_SIZE];
+   struct Binding *apNodes[BATCH_SIZE];
+   struct Binding *currNode;
+   size_t uStart;
+   size_t uBatch;
+   size_t i;
+
+   assert(oSymTable != NULL);
+   assert(uCount == 0 || (apcKeys != NULL && apvValues != NULL));
+
+   if (oSymTable->snapshot != NULL) {
+      for (i = 0; i < uCount; i++) {
+         apvValues[i] = SymTable_getMapped(oSymTable, apcKeys[i],
+                                           strlen(apcKeys[i]));
+      }
+      return;
+   }
+   SymTable_migrate(oSymTable, MIGRATE_STEP);
+
+   for (uStart = 0; uStart < uCount; uStart += uBatch) {
+      uBatch = uCount - uStart;
+      if (uBatch > BATCH_SIZE) {
+         uBatch = BATCH_SIZE;
+      }
+
+      /* hash every key of the batch and start loading its bucket */
+      for (i = 0; i < uBatch; i++) {
+         assert(apcKeys[uStart + i] != NULL);
+         auLengths[i] = strlen(apcKeys[uStart + i]);
+         auHashes[i] = SymTable_hash(oSymTable, apcKeys[uStart + i],
+                                     auLengths[i]);
+         appBuckets[i] =
+            &oSymTable->head[auHashes[i] % oSymTable->bucketSize];
+         SYMTABLE_PREFETCH(appBuckets[i]);
+      }
+
+      /* by now the buckets have arrived, so start loading the first
+      Binding of every chain */
+      for (i = 0; i < uBatch; i++) {
+         apNodes[i] = *appBuckets[i];
+         if (apNodes[i] != NULL) {
+            SYMTABLE_PREFETCH(apNodes[i]);
+         }
+      }
+
+      /* walk the buckets, whose first Bindings are now in cache */
+      for (i = 0; i < uBatch; i++) {
+         currNode = SymTable_findInBucket(oSymTable, apNodes[i],
+            apcKeys[uStart + i], auLengths[i], auHashes[i], 0);
+         if (currNode == NULL && oSymTable->oldHead != NULL) {
+            currNode = SymTable_findInBucket(oSymTable,
+               oSymTable->oldHead[auHashes[i] % oSymTable->oldBucketSize],
+               apcKeys[uStart + i], auLengths[i], auHashes[i], 0);
+         }
+         if (oSymTable->stats != NULL) {
+            SymTable_countLookup(oSymTable, apcKeys[uStart + i],
+                                 auLengths[i], auHashes[i], currNode);
+         }
+         apvValues[uStart + i] =
+            (currNode == NULL) ? NULL : (void*)currNode->value;
+      }
+   }
+}
+
+/* SymTable_mapUnits takes in a range of bucket numbers [uBegin, uEnd)
+and a void pointer pvJob to a MapJob, and maps the bindings of those
+buckets. The new buckets come first, followed by the old buckets an
+incremental expansion has not migrated yet. */
+static void SymTable_mapUnits(size_t uBegin, size_t uEnd, void *pvJob)
+{
+   struct MapJob *pJob = pvJob;
+   SymTable_T oSymTable = pJob->oSymTable;
+   size_t i;
+
+   for (i = uBegin; i < uEnd; i++) {
+      if (i < oSymTable->bucketSize) {
+         SymTable_mapBucket(oSymTable->head[i], NULL, pJob->pfApply,
+                            pJob->pvExtra);
+      } else {
+         SymTable_mapBucket(oSymTable->oldHead[i - oSymTable->bucketSize +
+                                               oSymTable->migrateIndex],
+                            NULL, pJob->pfApply, pJob->pvExtra);
+      }
+   }
+}
+
+void SymTable_mapParallel(SymTable_T oSymTable,
+                          void (*pfApply)(const char *pcKey,
+                                          void *pvValue, void *pvExtra),
+                          const void *pvExtra, size_t uThreads){
+   struct MapJob sJob;
+   size_t uOldLeft = 0;
+
+   assert(oSymTable != NULL);
+   assert(pfApply != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      Snapshot_mapParallel(oSymTable->snapshot, pfApply, pvExtra,
+                           uThreads);
+      return;
+   }
+   if (oSymTable->oldHead != NULL) {
+      uOldLeft = oSymTable->oldBucketSize - oSymTable->migrateIndex;
+   }
+   sJob.oSymTable = oSymTable;
+   sJob.pfApply = pfApply;
+   sJob.pvExtra = pvExtra;
+   Parallel_forRange(oSymTable->bucketSize + uOldLeft, uThreads,
+                     SymTable_mapUnits, &sJob);
+}
+
+SymTableIter_T SymTable_iterBegin(SymTable_T oSymTable){
+   struct SymTableIter *pIter;
+
+   assert(oSymTable != NULL);
+
+   pIter = malloc(sizeof(struct SymTableIter));
+   if (pIter == NULL) {
+      return NULL;
+   }
+   pIter->oSymTable = oSymTable;
+   pIter->bucket = 0;
+   pIter->nextNode = NULL;
+   pIter->snapshotIndex = 0;
+   pIter->nextIter = oSymTable->iters;
+   oSymTable->iters = pIter;
+   return pIter;
+}
+
+int SymTable_iterNext(SymTableIter_T oIter, const char **ppcKey,
+                      void **ppvValue){
+   SymTable_T oSymTable;
+   struct Binding *currNode;
+
+   assert(oIter != NULL);
+
+   oSymTable = oIter->oSymTable;
+   if (oSymTable->snapshot != NULL) {
+      if (oIter->snapshotIndex == Snapshot_getLength(oSymTable->snapshot)) {
+         return 0;
+      }
+      Snapshot_getBinding(oSymTable->snapshot, oIter->snapshotIndex++,
+                          ppcKey, NULL, ppvValue);
+      return 1;
+   }
+   if (oIter->nextNode == NULL) {
+      oIter->bucket = SymTable_nextBucket(oSymTable, oIter->bucket);
+      if (oIter->bucket == SymTable_bucketCount(oSymTable)) {
+         return 0;
+      }
+      /* the first Binding of a tree is its leftmost one, and a chain
+      has no left children */
+      currNode = SymTable_bucketAt(oSymTable, oIter->bucket);
+      while (currNode->left != NULL) {
+         currNode = currNode->left;
+      }
+      oIter->nextNode = currNode;
+   }
+
+   currNode = oIter->nextNode;
+   oIter->nextNode = SymTable_after(oSymTable,
+      SymTable_bucketAt(oSymTable, oIter->bucket), currNode);
+   if (oIter->nextNode == NULL) {
+      oIter->bucket++;
+   }
+   if (ppcKey != NULL) {
+      *ppcKey = currNode->key;
+   }
+   if (ppvValue != NULL) {
+      *ppvValue = (void*)currNode->value;
+   }
+   return 1;
+}
+
+void SymTable_iterEnd(SymTableIter_T oIter){
+   struct SymTableIter **ppIter;
+
+   assert(oIter != NULL);
+
+   for (ppIter = &oIter->oSymTable->iters; *ppIter != oIter;
+        ppIter = &(*ppIter)->nextIter) {
+      assert(*ppIter != NULL);
+   }
+   *ppIter = oIter->nextIter;
+   free(oIter);
+}
+
+void SymTable_mapRange(SymTable_T oSymTable, const char *pcLow,
+                       const char *pcHigh,
+                       void (*pfApply)(const char *pcKey,
+                                       void *pvValue, void *pvExtra),
+                       const void *pvExtra){
+   struct KeyBounds sBounds;
+
+   assert(oSymTable != NULL);
+   assert(pfApply != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      Snapshot_mapRange(oSymTable->snapshot, pcLow, pcHigh, pfApply,
+                        pvExtra);
+      return;
+   }
+   sBounds.low = pcLow;
+   sBounds.lowLength = (pcLow != NULL) ? strlen(pcLow) : 0;
+   sBounds.high = pcHigh;
+   sBounds.highLength = (pcHigh != NULL) ? strlen(pcHigh) : 0;
+   sBounds.prefix = NULL;
+   sBounds.prefixLength = 0;
+   SymTable_mapBounded(oSymTable, &sBounds, pfApply, pvExtra);
+}
+
+void SymTable_mapPrefix(SymTable_T oSymTable, const char *pcPrefix,
+                        void (*pfApply)(const char *pcKey,
+                                        void *pvValue, void *pvExtra),
+                        const void *pvExtra){
+   struct KeyBounds sBounds;
+
+   assert(oSymTable != NULL);
+   assert(pcPrefix != NULL);
+   assert(pfApply != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      Snapshot_mapPrefix(oSymTable->snapshot, pcPrefix, pfApply,
+                         pvExtra);
+      return;
+   }
+   sBounds.low = NULL;
+   sBounds.lowLength = 0;
+   sBounds.high = NULL;
+   sBounds.highLength = 0;
+   sBounds.prefix = pcPrefix;
+   sBounds.prefixLength = strlen(pcPrefix);
+   SymTable_mapBounded(oSymTable, &sBounds, pfApply, pvExtra);
+}
+
+/* SymTable_saveBucket takes in the first Binding currNode of a bucket
+(or NULL) and a SnapshotWriter oWriter, and adds every Binding of the
+bucket to oWriter, walking a tree as SymTable_mapBucket does. It
+returns 1, or 0 if there is insufficient memory. */
+static int SymTable_saveBucket(struct Binding *currNode,
+                               SnapshotWriter_T oWriter)
+{
+   while (currNode != NULL) {
+      if (currNode->left != NULL &&
+          !SymTable_saveBucket(currNode->left, oWriter)) {
+         return 0;
+      }
+      if (!SnapshotWriter_add(oWriter, currNode->key, currNode->keyLength,
+                              currNode->value)) {
+         return 0;
+      }
+      currNode = currNode->next;
+   }
+   return 1;
+}
+
+int SymTable_save(SymTable_T oSymTable, const char *pcPath,
+                  size_t uValueSize){
+   SnapshotWriter_T oWriter;
+   size_t i;
+
+   assert(oSymTable != NULL);
+   assert(pcPath != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      return Snapshot_save(oSymTable->snapshot, pcPath, uValueSize);
+   }
+   oWriter = SnapshotWriter_new(uValueSize);
+   if (oWriter == NULL) {
+      return 0;
+   }
+   for (i = 0; i < SymTable_bucketCount(oSymTable); i++) {
+      if (!SymTable_saveBucket(SymTable_bucketAt(oSymTable, i), oWriter)) {
+         SnapshotWriter_free(oWriter);
+         return 0;
+      }
+   }
+   return SnapshotWriter_finish(oWriter, pcPath);
+}
+
+SymTable_T SymTable_openMapped(const char *pcPath){
+   SymTable_T oSymTable;
+
+   assert(pcPath != NULL);
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL) {
+      return NULL;
+   }
+   oSymTable->snapshot = Snapshot_open(pcPath);
+   if (oSymTable->snapshot == NULL) {
+      SymTable_free(oSymTable);
+      return NULL;
+   }
+   oSymTable->allocCount++;
+   return oSymTable;
+}
+
+SymTable_T SymTable_newWithCapacity(size_t uCapacity){
+   SymTable_T oSymTable;
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL) {
+      return NULL;
+   }
+   if (! SymTable_reserve(oSymTable, uCapacity)) {
+      SymTable_free(oSymTable);
+      return NULL;
+   }
+   return oSymTable;
+}
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity){
+   size_t uBucketCount;
+   size_t uNextCount;
+   size_t uNewBindings;
+
+   assert(oSymTable != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      return 0;
+   }
+   /* climb bucketCounts to the first count whose expandAt is at least
+   uCapacity, and go there in one step instead of one rehash per
+   rung */
+   uBucketCount = oSymTable->bucketSize;
+   while ((double)uBucketCount * oSymTable->maxLoad < (double)uCapacity) {
+      uNextCount = SymTable_nextBucketCount(uBucketCount);
+      if (uNextCount == uBucketCount) {
+         return 0;
+      }
+      uBucketCount = uNextCount;
+   }
+   if (uBucketCount != oSymTable->bucketSize &&
+       ! SymTable_resize(oSymTable, uBucketCount)) {
+      return 0;
+   }
+   /* removes do not shrink the SymTable below what was reserved */
+   if (uBucketCount > oSymTable->minBucketSize) {
+      oSymTable->minBucketSize = uBucketCount;
+      SymTable_setExpandAt(oSymTable);
+   }
+
+   /* keys that fit in inlineKey need nothing but their Binding */
+   if (uCapacity <= oSymTable->bindingsSize) {
+      return 1;
+   }
+   uNewBindings = uCapacity - oSymTable->bindingsSize;
+   if (uNewBindings > (size_t)-1 / sizeof(struct Binding)) {
+      return 0;
+   }
+   return Arena_reserve(oSymTable->arena,
+                        uNewBindings * sizeof(struct Binding));
+}
+
+/* SymTable_copyBucket takes in SymTable oSymTable, the first Binding
+currNode of a bucket (or the root of a subtree of a tree bucket), an
+Arena oArena and a bucket array ppHead of uBucketCount buckets made by
+SymTable_newBuckets. It copies each Binding of the bucket, with its
+key copy, into oArena and links the copy into ppHead by its stored
+hash. It returns 1, or 0 if there is insufficient memory. */
+static int SymTable_copyBucket(SymTable_T oSymTable,
+                               struct Binding *currNode, Arena_T oArena,
+                               struct Binding **ppHead,
+                               size_t uBucketCount)
+{
+   struct Binding *nNode;
+   char *defCopy;
+   size_t uBucket;
+
+   /* a chain has no left children, and a tree is copied in order */
+   for (; currNode != NULL; currNode = currNode->next) {
+      if (! SymTable_copyBucket(oSymTable, currNode->left, oArena,
+                                ppHead, uBucketCount)) {
+         return 0;
+      }
+      nNode = Arena_alloc(oArena, sizeof(struct Binding));
+      if (nNode == NULL) {
+         return 0;
+      }
+      *nNode = *currNode;
+      if (currNode->key == currNode->inlineKey) {
+         nNode->key = nNode->inlineKey;
+      } else if (currNode->keyKind == KEY_COPY) {
+         defCopy = Arena_alloc(oArena, currNode->keyLength + 1);
+         if (defCopy == NULL) {
+            return 0;
+         }
+         memcpy(defCopy, currNode->key, currNode->keyLength + 1);
+         nNode->key = defCopy;
+      }
+      uBucket = nNode->hash % uBucketCount;
+      SymTable_link(oSymTable, &ppHead[uBucket], nNode);
+      SymTable_setOccupied(ppHead, uBucketCount, uBucket, 1);
+   }
+   return 1;
+}
+
+int SymTable_compact(SymTable_T oSymTable){
+   struct Binding **newHead;
+   Arena_T newArena;
+   size_t newBucketCount;
+   size_t uBucket;
+   int iSuccessful;
+
+   assert(oSymTable != NULL);
+
+   if (oSymTable->snapshot != NULL || oSymTable->iters != NULL) {
+      return 0;
+   }
+   SymTable_migrate(oSymTable, oSymTable->oldBucketSize);
+
+   newBucketCount = SymTable_fitBucketCount(oSymTable,
+                                            2 * oSymTable->bindingsSize);
+   if (newBucketCount > oSymTable->bucketSize) {
+      newBucketCount = oSymTable->bucketSize;
+   }
+   newHead = SymTable_newBuckets(newBucketCount);
+   if (newHead == NULL) {
+      return 0;
+   }
+   newArena = Arena_new();
+   if (newArena == NULL) {
+      free(newHead);
+      return 0;
+   }
+
+   /* the copies are made bucket by bucket, so the Bindings of a
+   chain end up next to each other */
+   iSuccessful = Arena_reserve(newArena, oSymTable->bindingsSize *
+                                         sizeof(struct Binding));
+   for (uBucket = SymTable_nextOccupied(oSymTable->head,
+                                        oSymTable->bucketSize, 0);
+        iSuccessful && uBucket < oSymTable->bucketSize;
+        uBucket = SymTable_nextOccupied(oSymTable->head,
+                                        oSymTable->bucketSize,
+                                        uBucket + 1)) {
+      iSuccessful = SymTable_copyBucket(oSymTable,
+                                        oSymTable->head[uBucket],
+                                        newArena, newHead,
+                                        newBucketCount);
+   }
+   if (! iSuccessful) {
+      Arena_free(newArena);
+      free(newHead);
+      return 0;
+   }
+
+   oSymTable->allocCount += 1 + Arena_getAllocCount(oSymTable->arena);
+   oSymTable->rehashCount += oSymTable->bindingsSize;
+   Arena_free(oSymTable->arena);
+   free(oSymTable->head);
+   oSymTable->arena = newArena;
+   oSymTable->head = newHead;
+   oSymTable->bucketSize = newBucketCount;
+   oSymTable->minBucketSize = bucketMin;
+   SymTable_setExpandAt(oSymTable);
+   return 1;
+}
+
+SymTable_T SymTable_newWithStats(enum SymTableHash eHash){
+   SymTable_T oSymTable;
+
+   oSymTable = SymTable_newWithOptions(eHash);
+   if (oSymTable == NULL) {
+      return NULL;
+   }
+   oSymTable->stats = malloc(sizeof(struct Stats));
+   if (oSymTable->stats == NULL) {
+      SymTable_free(oSymTable);
+      return NULL;
+   }
+   oSymTable->allocCount++;
+   Stats_init(oSymTable->stats);
+   return oSymTable;
+}
+
+/* SymTable_bucketLength takes in the first Binding currNode of a
+bucket, chain or tree, and returns how many Bindings the bucket
+holds */
+static size_t SymTable_bucketLength(const struct Binding *currNode)
+{
+   size_t uLength = 0;
+
+   if (SymTable_isTree(currNode)) {
+      return 1 + SymTable_bucketLength(currNode->left) +
+             SymTable_bucketLength(currNode->next);
+   }
+   for (; currNode != NULL; currNode = currNode->next) {
+      uLength++;
+   }
+   return uLength;
+}
+
+int SymTable_getStats(SymTable_T oSymTable,
+                      struct SymTableStats *psStats){
+   size_t uBucket;
+
+   assert(oSymTable != NULL);
+   assert(psStats != NULL);
+
+   Stats_clear(psStats);
+   psStats->allocCount = SymTable_getAllocCount(oSymTable);
+   psStats->bytes = SymTable_getBytes(oSymTable);
+   if (oSymTable->snapshot == NULL) {
+      psStats->bucketCount = oSymTable->bucketSize;
+      psStats->load = (double)oSymTable->bindingsSize /
+                      (double)oSymTable->bucketSize;
+      /* the buckets of an incremental expansion's old array that are
+      still to be migrated are chains too */
+      for (uBucket = 0; uBucket < SymTable_bucketCount(oSymTable);
+           uBucket++) {
+         Stats_addChain(psStats, SymTable_bucketLength(
+            SymTable_bucketAt(oSymTable, uBucket)));
+      }
+   }
+   if (oSymTable->stats == NULL) {
+      return 0;
+   }
+   Stats_report(oSymTable->stats, psStats);
+   return 1;
+}
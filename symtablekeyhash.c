@@ -0,0 +1,278 @@
+/* symtable key hash implementation */
+#include "symtablekeyhash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+
+/* the constants of KeyHash_fast, from wyhash */
+static const uint64_t wyConstants[4] = {
+   0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL,
+   0x8ebc6af09c88c6e3ULL, 0x589965cc75374cc3ULL};
+
+/* KeyHash_read64 takes in a pointer pucBytes to 8 bytes and returns
+them as a little endian 64 bit integer, whatever the byte order of
+the machine, so every machine computes the same hashes */
+static uint64_t KeyHash_read64(const unsigned char *pucBytes)
+{
+   return (uint64_t)pucBytes[0] | ((uint64_t)pucBytes[1] << 8) |
+          ((uint64_t)pucBytes[2] << 16) | ((uint64_t)pucBytes[3] << 24) |
+          ((uint64_t)pucBytes[4] << 32) | ((uint64_t)pucBytes[5] << 40) |
+          ((uint64_t)pucBytes[6] << 48) | ((uint64_t)pucBytes[7] << 56);
+}
+
+/* KeyHash_read32 takes in a pointer pucBytes to 4 bytes and returns
+them as a little endian 32 bit integer */
+static uint64_t KeyHash_read32(const unsigned char *pucBytes)
+{
+   return (uint64_t)pucBytes[0] | ((uint64_t)pucBytes[1] << 8) |
+          ((uint64_t)pucBytes[2] << 16) | ((uint64_t)pucBytes[3] << 24);
+}
+
+/* KeyHash_multiply takes in pointers pA and pB to two 64 bit integers
+and replaces them with the low and high 64 bits of their 128 bit
+product */
+static void KeyHash_multiply(uint64_t *pA, uint64_t *pB)
+{
+#if defined(__SIZEOF_INT128__)
+   __extension__ typedef unsigned __int128 uint128;
+   uint128 uProduct = (uint128)*pA * *pB;
+   *pA = (uint64_t)uProduct;
+   *pB = (uint64_t)(uProduct >> 64);
+#else
+   /* schoolbook multiplication of 32 bit halves */
+   uint64_t uHighA = *pA >> 32, uHighB = *pB >> 32;
+   uint64_t uLowA = (uint32_t)*pA, uLowB = (uint32_t)*pB;
+   uint64_t uHigh = uHighA * uHighB;
+   uint64_t uMid0 = uHighA * uLowB;
+   uint64_t uMid1 = uHighB * uLowA;
+   uint64_t uLow = uLowA * uLowB;
+   uint64_t uSum = uLow + (uMid0 << 32);
+   uint64_t uCarry = uSum < uLow;
+   uint64_t uResult = uSum + (uMid1 << 32);
+   uCarry += uResult < uSum;
+   *pA = uResult;
+   *pB = uHigh + (uMid0 >> 32) + (uMid1 >> 32) + uCarry;
+#endif
+}
+
+/* KeyHash_mix takes in two 64 bit integers uA and uB and returns the
+low and high halves of their 128 bit product xored together */
+static uint64_t KeyHash_mix(uint64_t uA, uint64_t uB)
+{
+   KeyHash_multiply(&uA, &uB);
+   return uA ^ uB;
+}
+
+size_t KeyHash_fast(const void *pvKey, size_t uLength,
+                    const struct KeyHashSeed *psSeed)
+{
+   const unsigned char *pucKey = pvKey;
+   uint64_t uSeed;
+   uint64_t uSeed1;
+   uint64_t uSeed2;
+   uint64_t uA;
+   uint64_t uB;
+   size_t uLeft;
+
+   assert(pvKey != NULL || uLength == 0);
+   assert(psSeed != NULL);
+
+   uSeed = psSeed->k0 ^ KeyHash_mix(psSeed->k0 ^ wyConstants[0],
+                                    wyConstants[1]);
+   if (uLength <= 16) {
+      if (uLength >= 4) {
+         /* two overlapping pairs of 4 byte reads cover every byte */
+         uA = (KeyHash_read32(pucKey) << 32) |
+              KeyHash_read32(pucKey + ((uLength >> 3) << 2));
+         uB = (KeyHash_read32(pucKey + uLength - 4) << 32) |
+              KeyHash_read32(pucKey + uLength - 4 -
+                             ((uLength >> 3) << 2));
+      } else if (uLength > 0) {
+         uA = ((uint64_t)pucKey[0] << 16) |
+              ((uint64_t)pucKey[uLength >> 1] << 8) |
+              (uint64_t)pucKey[uLength - 1];
+         uB = 0;
+      } else {
+         uA = 0;
+         uB = 0;
+      }
+   } else {
+      uLeft = uLength;
+      if (uLeft > 48) {
+         /* three independent lanes keep the multipliers busy */
+         uSeed1 = uSeed;
+         uSeed2 = uSeed;
+         do {
+            uSeed = KeyHash_mix(KeyHash_read64(pucKey) ^ wyConstants[1],
+                                KeyHash_read64(pucKey + 8) ^ uSeed);
+            uSeed1 = KeyHash_mix(
+               KeyHash_read64(pucKey + 16) ^ wyConstants[2],
+               KeyHash_read64(pucKey + 24) ^ uSeed1);
+            uSeed2 = KeyHash_mix(
+               KeyHash_read64(pucKey + 32) ^ wyConstants[3],
+               KeyHash_read64(pucKey + 40) ^ uSeed2);
+            pucKey += 48;
+            uLeft -= 48;
+         } while (uLeft > 48);
+         uSeed ^= uSeed1 ^ uSeed2;
+      }
+      while (uLeft > 16) {
+         uSeed = KeyHash_mix(KeyHash_read64(pucKey) ^ wyConstants[1],
+                             KeyHash_read64(pucKey + 8) ^ uSeed);
+         pucKey += 16;
+         uLeft -= 16;
+      }
+      uA = KeyHash_read64(pucKey + uLeft - 16);
+      uB = KeyHash_read64(pucKey + uLeft - 8);
+   }
+   uA ^= wyConstants[1];
+   uB ^= uSeed;
+   KeyHash_multiply(&uA, &uB);
+   return (size_t)KeyHash_mix(uA ^ wyConstants[0] ^ (uint64_t)uLength,
+                              uB ^ wyConstants[1]);
+}
+
+/* KEYHASH_ROTATE returns the 64 bit integer u rotated left by b bits */
+#define KEYHASH_ROTATE(u, b) (((u) << (b)) | ((u) >> (64 - (b))))
+
+/* KeyHash_sipRound takes in the four state words of SipHash and
+applies one SipRound to them */
+static void KeyHash_sipRound(uint64_t auState[4])
+{
+   auState[0] += auState[1];
+   auState[1] = KEYHASH_ROTATE(auState[1], 13);
+   auState[1] ^= auState[0];
+   auState[0] = KEYHASH_ROTATE(auState[0], 32);
+   auState[2] += auState[3];
+   auState[3] = KEYHASH_ROTATE(auState[3], 16);
+   auState[3] ^= auState[2];
+   auState[0] += auState[3];
+   auState[3] = KEYHASH_ROTATE(auState[3], 21);
+   auState[3] ^= auState[0];
+   auState[2] += auState[1];
+   auState[1] = KEYHASH_ROTATE(auState[1], 17);
+   auState[1] ^= auState[2];
+   auState[2] = KEYHASH_ROTATE(auState[2], 32);
+}
+
+size_t KeyHash_sip(const void *pvKey, size_t uLength,
+                   const struct KeyHashSeed *psSeed)
+{
+   const unsigned char *pucKey = pvKey;
+   uint64_t auState[4];
+   uint64_t uWord;
+   size_t uLeft;
+   size_t i;
+
+   assert(pvKey != NULL || uLength == 0);
+   assert(psSeed != NULL);
+
+   auState[0] = psSeed->k0 ^ 0x736f6d6570736575ULL;
+   auState[1] = psSeed->k1 ^ 0x646f72616e646f6dULL;
+   auState[2] = psSeed->k0 ^ 0x6c7967656e657261ULL;
+   auState[3] = psSeed->k1 ^ 0x7465646279746573ULL;
+
+   /* compression: two rounds per 8 byte word */
+   for (uLeft = uLength; uLeft >= 8; uLeft -= 8) {
+      uWord = KeyHash_read64(pucKey);
+      auState[3] ^= uWord;
+      KeyHash_sipRound(auState);
+      KeyHash_sipRound(auState);
+      auState[0] ^= uWord;
+      pucKey += 8;
+   }
+
+   /* the last word holds the leftover bytes and the length */
+   uWord = (uint64_t)uLength << 56;
+   for (i = 0; i < uLeft; i++)
+      uWord |= (uint64_t)pucKey[i] << (8 * i);
+   auState[3] ^= uWord;
+   KeyHash_sipRound(auState);
+   KeyHash_sipRound(auState);
+   auState[0] ^= uWord;
+
+   /* finalization: four rounds */
+   auState[2] ^= 0xff;
+   for (i = 0; i < 4; i++)
+      KeyHash_sipRound(auState);
+   return (size_t)(auState[0] ^ auState[1] ^ auState[2] ^ auState[3]);
+}
+
+/* the seed read from the operating system on the first call to
+KeyHash_randomSeed, which every table's seed is derived from */
+static struct KeyHashSeed sMasterSeed;
+
+/* keeps sMasterSeed from being read more than once */
+static pthread_once_t masterOnce = PTHREAD_ONCE_INIT;
+
+/* how many seeds KeyHash_randomSeed has derived */
+static uint64_t uSeedCount = 0;
+
+/* KeyHash_readMasterSeed fills sMasterSeed with random bits from the
+operating system, or, if there are none to be had, with bits mixed
+from the time and the address of a local variable */
+static void KeyHash_readMasterSeed(void)
+{
+   unsigned char aucBytes[16];
+   FILE *psFile;
+   size_t uRead = 0;
+
+   psFile = fopen("/dev/urandom", "rb");
+   if (psFile != NULL) {
+      uRead = fread(aucBytes, 1, sizeof(aucBytes), psFile);
+      fclose(psFile);
+   }
+   if (uRead == sizeof(aucBytes)) {
+      sMasterSeed.k0 = KeyHash_read64(aucBytes);
+      sMasterSeed.k1 = KeyHash_read64(aucBytes + 8);
+      return;
+   }
+
+   /* no random bits: mix whatever differs between runs */
+   sMasterSeed.k0 = KeyHash_mix((uint64_t)time(NULL) ^ wyConstants[0],
+                                (uint64_t)clock() ^ wyConstants[1]);
+   sMasterSeed.k1 = KeyHash_mix((uint64_t)(uintptr_t)aucBytes ^
+                                wyConstants[2], wyConstants[3]);
+}
+
+/* KeyHash_deriveWord takes in a seed number uCount and a byte ucHalf
+telling the two halves of a seed apart, and returns 64 bits of the
+SipHash of them under sMasterSeed, so no table's seed gives away
+another's or the master seed */
+static uint64_t KeyHash_deriveWord(uint64_t uCount, unsigned char ucHalf)
+{
+   unsigned char aucBytes[9];
+   uint64_t uWord;
+   int i;
+
+   for (i = 0; i < 8; i++)
+      aucBytes[i] = (unsigned char)(uCount >> (8 * i));
+   aucBytes[8] = ucHalf;
+   uWord = (uint64_t)KeyHash_sip(aucBytes, sizeof(aucBytes),
+                                 &sMasterSeed);
+   /* a size_t narrower than 64 bits only holds half a word */
+   if (sizeof(size_t) < sizeof(uint64_t)) {
+      aucBytes[8] = (unsigned char)(ucHalf | 0x80);
+      uWord = (uWord << 32) ^ (uint64_t)KeyHash_sip(aucBytes,
+         sizeof(aucBytes), &sMasterSeed);
+   }
+   return uWord;
+}
+
+void KeyHash_randomSeed(struct KeyHashSeed *psSeed)
+{
+   uint64_t uCount;
+
+   assert(psSeed != NULL);
+
+   /* only the first table pays for reading the operating system's
+   random bits; later ones derive theirs from a counter */
+   (void)pthread_once(&masterOnce, KeyHash_readMasterSeed);
+   uCount = __atomic_add_fetch(&uSeedCount, 1, __ATOMIC_RELAXED);
+   psSeed->k0 = KeyHash_deriveWord(uCount, 0);
+   psSeed->k1 = KeyHash_deriveWord(uCount, 1);
+}
@@ -0,0 +1,44 @@
+/* symtable key hash header file */
+#include <stddef.h>
+#include <stdint.h>
+#ifndef SYMTABLEKEYHASH_INCLUDED
+#define SYMTABLEKEYHASH_INCLUDED
+
+/* The hash functions a SymTable can be created with besides the
+assignment's 65599 hash (see SymTable_newWithOptions in symtable.h).
+Both read keys a word at a time and both take a per-table seed, so
+which keys collide differs from one SymTable to the next. */
+
+/* KeyHashSeed is the 128 bit seed of a SymTable: the key of
+KeyHash_sip, or the seed of KeyHash_fast */
+struct KeyHashSeed {
+    /* the first 64 bits of the seed */
+    uint64_t k0;
+    /* the last 64 bits of the seed */
+    uint64_t k1;
+};
+
+/* KeyHash_randomSeed takes in a pointer psSeed to a KeyHashSeed and
+fills it with a seed no other call returns. The first call reads a
+master seed of random bits from the operating system (or, if there are
+none to be had, mixes one from the time and an address); every call
+then derives its seed from the master seed and a counter by SipHash,
+so only the first one makes system calls. It may be called from
+several threads at once. */
+void KeyHash_randomSeed(struct KeyHashSeed *psSeed);
+
+/* KeyHash_fast takes in a const void pointer pvKey to uLength bytes
+and a seed psSeed and returns a wyhash style hash of the bytes, which
+mixes 16 bytes per 64 bit multiply. It is much faster than the 65599
+hash on long keys but is not meant to resist an attacker who can see
+hash values. */
+size_t KeyHash_fast(const void *pvKey, size_t uLength,
+                    const struct KeyHashSeed *psSeed);
+
+/* KeyHash_sip takes in a const void pointer pvKey to uLength bytes
+and a key psSeed and returns SipHash-2-4 of the bytes. Without psSeed
+an attacker cannot choose keys that collide. */
+size_t KeyHash_sip(const void *pvKey, size_t uLength,
+                   const struct KeyHashSeed *psSeed);
+
+#endif
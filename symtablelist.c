@@ -1,20 +1,41 @@
 /* symtable linkedList implementation */
 #include "symtable.h"
+#include "symtablearena.h"
+#include "symtableatom.h"
+#include "symtablesnapshot.h"
+#include "symtablestats.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
 #include <stddef.h>
 #include <string.h>
 
+/* keys shorter than INLINE_KEY_SIZE bytes (counting the '\0') are
+stored inside their Node, longer keys are copied into the arena */
+enum {INLINE_KEY_SIZE = 24};
+
+/* how a Node holds its key: a copy owned by the SymTable, an atom from
+SymTable_intern, or a key borrowed from the client by
+SymTable_putBorrowed. Only copies are released by the SymTable. */
+enum KeyKinds {KEY_COPY = 0, KEY_ATOM = 1, KEY_BORROWED = 2};
+
 /* Node is a struct that can be linked together to form 
 a list of Nodes and holds certain variables: key, value, next */
 struct Node {
-    /* char pointer to the key */
+    /* char pointer to the key: inlineKey for short keys, otherwise a
+    copy in the arena. A copy is always followed by a '\0'. */
     const char *key;
+    /* how many bytes are in the key, not counting the '\0' */
+    size_t keyLength;
     /* void pointer to the value */
     const void* value;
     /* pointer to the next Node in list */
     struct Node *next;
+    /* holds the key when it fits, so comparing it stays within the
+    Node */
+    char inlineKey[INLINE_KEY_SIZE];
+    /* KEY_COPY, KEY_ATOM or KEY_BORROWED, see KeyKinds */
+    int keyKind;
 }; 
 
 /* SymTable is a struct that points to the head/first Node in 
@@ -24,8 +45,151 @@ struct SymTable {
     struct Node *head;
     /* size holds the length of a list of Nodes in SymTable */
     size_t size;
+    /* how many times a key has been compared with memcmp */
+    size_t compareCount;
+    /* how many times the SymTable has called malloc for itself and
+    the arenas SymTable_compact has replaced */
+    size_t allocCount;
+    /* the Arena that every Node and key copy is allocated from */
+    Arena_T arena;
+    /* the iterators that have not been ended, linked by their
+    nextIter fields */
+    struct SymTableIter *iters;
+    /* the mapped snapshot that a SymTable from SymTable_openMapped
+    answers from, or NULL */
+    Snapshot_T snapshot;
 }; 
 
+/* SymTableIter is an iterator over the Nodes of a SymTable */
+struct SymTableIter {
+    /* the SymTable being iterated over */
+    SymTable_T oSymTable;
+    /* the Node that SymTable_iterNext returns next, or NULL once
+    every Node has been returned */
+    struct Node *nextNode;
+    /* the number of the snapshot binding returned next, if the
+    SymTable is mapped */
+    size_t snapshotIndex;
+    /* the next iterator of the same SymTable */
+    struct SymTableIter *nextIter;
+};
+
+/* KeyBounds is which keys SymTable_mapRange or SymTable_mapPrefix
+wants: those in [low, high), or those starting with prefix */
+struct KeyBounds {
+    /* the smallest key wanted, or NULL if there is none */
+    const char *low;
+    /* how many bytes are in low */
+    size_t lowLength;
+    /* the key every wanted key is less than, or NULL if there is none */
+    const char *high;
+    /* how many bytes are in high */
+    size_t highLength;
+    /* what every wanted key starts with, or NULL for a range */
+    const char *prefix;
+    /* how many bytes are in prefix */
+    size_t prefixLength;
+};
+
+/* SymTable_matches takes in SymTable oSymTable, a Node currNode, a
+const char pointer pcKey, its length uLength and iAtom, which is 1 if
+pcKey is an atom. It returns 1 if currNode's key is pcKey and 0
+otherwise, and counts any memcmp in oSymTable. Keys of different
+lengths and two different atoms are told apart without calling
+memcmp. */
+static int SymTable_matches(SymTable_T oSymTable,
+                            const struct Node *currNode,
+                            const char *pcKey, size_t uLength,
+                            int iAtom)
+{
+   if (currNode->keyLength != uLength) {
+      return 0;
+   }
+   if (currNode->key == pcKey) {
+      return 1;
+   }
+   /* equal strings always intern to the same atom */
+   if (iAtom && currNode->keyKind == KEY_ATOM) {
+      return 0;
+   }
+   oSymTable->compareCount++;
+   return memcmp(currNode->key, pcKey, uLength) == 0;
+}
+
+/* SymTable_find takes in SymTable oSymTable, a const char pointer
+pcKey, its length uLength and iAtom, which is 1 if pcKey is an atom.
+It returns the Node whose key is pcKey, or NULL if there is none. */
+static struct Node *SymTable_find(SymTable_T oSymTable,
+                                  const char *pcKey, size_t uLength,
+                                  int iAtom)
+{
+   struct Node *currNode;
+
+   currNode = oSymTable->head;
+   while (currNode != NULL) {
+      if (SymTable_matches(oSymTable, currNode, pcKey, uLength, iAtom)) {
+         return currNode;
+      }
+      currNode = currNode->next;
+   }
+   return NULL;
+}
+
+/* SymTable_newNode takes in SymTable oSymTable, a const char
+pointer pcKey, its length uLength and iKind, one of KeyKinds. It
+returns a new Node from the arena holding pcKey itself if it is an
+atom or borrowed, and otherwise a '\0' terminated copy of pcKey
+(inside the Node if it is short enough), or NULL if there is
+insufficient memory. */
+static struct Node *SymTable_newNode(SymTable_T oSymTable,
+                                     const char *pcKey, size_t uLength,
+                                     int iKind)
+{
+   struct Node *nNode;
+   size_t uKeySize;
+   char *defCopy;
+
+   nNode = Arena_alloc(oSymTable->arena, sizeof(struct Node));
+   if (nNode == NULL) {
+      return NULL;
+   }
+   nNode->keyKind = iKind;
+   nNode->keyLength = uLength;
+   if (iKind != KEY_COPY) {
+      /* atoms live as long as the program, and borrowed keys as long
+      as the client promised, so no copy is needed */
+      nNode->key = pcKey;
+      return nNode;
+   }
+   uKeySize = uLength + 1;
+   if (uKeySize <= INLINE_KEY_SIZE) {
+      defCopy = nNode->inlineKey;
+   } else {
+      defCopy = Arena_alloc(oSymTable->arena, uKeySize);
+      if (defCopy == NULL) {
+         Arena_release(oSymTable->arena, nNode, sizeof(struct Node));
+         return NULL;
+      }
+   }
+   memcpy(defCopy, pcKey, uLength);
+   defCopy[uLength] = '\0';
+   nNode->key = defCopy;
+   return nNode;
+}
+
+/* SymTable_freeNode takes in SymTable oSymTable and a Node currNode
+and releases currNode and its key copy back to the arena */
+static void SymTable_freeNode(SymTable_T oSymTable,
+                              struct Node *currNode)
+{
+   if (currNode->keyKind == KEY_COPY &&
+       currNode->key != currNode->inlineKey) {
+      Arena_release(oSymTable->arena, (char *)currNode->key,
+                    currNode->keyLength + 1);
+   }
+   Arena_release(oSymTable->arena, currNode, sizeof(struct Node));
+}
+
 SymTable_T SymTable_new(void){
    struct SymTable *oSymTable = malloc(sizeof(struct SymTable));
    if(oSymTable == NULL){
@@ -33,133 +197,204 @@ SymTable_T SymTable_new(void){
    }
    oSymTable->head = NULL;
    oSymTable->size = 0;
+   oSymTable->compareCount = 0;
+   oSymTable->allocCount = 1;
+   oSymTable->iters = NULL;
+   oSymTable->snapshot = NULL;
+   oSymTable->arena = Arena_new();
+   if(oSymTable->arena == NULL){
+      free(oSymTable);
+      return NULL;
+   }
    return oSymTable;
 }
 
-void SymTable_free(SymTable_T oSymTable){
-   struct Node *free_node;
-   struct Node *next_node;
+SymTable_T SymTable_newWithOptions(enum SymTableHash eHash){
+   if (eHash != SYMTABLE_HASH_DEFAULT && eHash != SYMTABLE_HASH_FAST &&
+       eHash != SYMTABLE_HASH_SIPHASH) {
+      return NULL;
+   }
+   /* a list never hashes its keys, so every kind of hash gives the
+   same SymTable */
+   return SymTable_new();
+}
 
+void SymTable_free(SymTable_T oSymTable){
    assert(oSymTable != NULL);
+   assert(oSymTable->iters == NULL);
 
-   free_node = oSymTable->head;
-   while (free_node != NULL) {
-      free((char *)free_node->key);
-      next_node = free_node->next;
-      free(free_node);
-      free_node = next_node;
-   }
+   /* every Node and key copy lives in the arena */
+   Arena_free(oSymTable->arena);
+   Snapshot_close(oSymTable->snapshot);
    free(oSymTable);
 }
 
 size_t SymTable_getLength(SymTable_T oSymTable){
    assert(oSymTable != NULL);
+   if (oSymTable->snapshot != NULL) {
+      return Snapshot_getLength(oSymTable->snapshot);
+   }
    return oSymTable->size;
 }
 
-int SymTable_put(SymTable_T oSymTable, const char *pcKey,
-                 const void *pvValue) {
+/* SymTable_add takes in SymTable oSymTable, a const char pointer
+pcKey that is not in oSymTable, its length uLength, a const void
+pointer pvValue and iKind, one of KeyKinds. It adds a new binding and
+returns its Node, or returns NULL and leaves oSymTable unchanged if
+there is insufficient memory. */
+static struct Node *SymTable_add(SymTable_T oSymTable,
+                                 const char *pcKey, size_t uLength,
+                                 const void *pvValue, int iKind)
+{
    struct Node *nNode; 
-   struct Node *currNode; 
-   void *defCopy;
 
-   assert(oSymTable != NULL);
-   assert(pcKey != NULL); 
+   nNode = SymTable_newNode(oSymTable, pcKey, uLength, iKind);
+   if (nNode == NULL) {
+      return NULL;
+   }
 
-   nNode = malloc(sizeof(struct Node));
-   currNode = oSymTable->head;
-   defCopy = malloc(strlen(pcKey)+1);
+   nNode->value = pvValue;
+   nNode->next = oSymTable->head;
+   oSymTable->head = nNode;
+   oSymTable->size++;
+   return nNode;
+}
 
-   if (nNode == NULL) {
+/* SymTable_insert takes in SymTable oSymTable, a const char pointer
+pcKey, its length uLength, a const void pointer pvValue and iKind, one
+of KeyKinds. If oSymTable doesn't contain pcKey, a new binding is
+added and 1 is returned. If it does, or there is insufficient memory,
+oSymTable is left unchanged and 0 is returned. */
+static int SymTable_insert(SymTable_T oSymTable, const char *pcKey,
+                           size_t uLength, const void *pvValue,
+                           int iKind)
+{
+   /* a mapped SymTable is read-only */
+   if (oSymTable->snapshot != NULL) {
       return 0;
    }
-   if (defCopy == NULL) {
-      free(nNode);
+   if (SymTable_find(oSymTable, pcKey, uLength, iKind == KEY_ATOM)
+       != NULL) {
       return 0;
    }
+   return SymTable_add(oSymTable, pcKey, uLength, pvValue, iKind)
+          != NULL;
+}
 
-   strcpy(defCopy, pcKey);
-   nNode->key = defCopy;
-   nNode->value = pvValue;
-   nNode->next = oSymTable->head;
+int SymTable_put(SymTable_T oSymTable, const char *pcKey,
+                 const void *pvValue) {
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL); 
 
-   while (currNode != NULL) {
-      if (strcmp(currNode->key, pcKey) == 0) {
-         free(defCopy);
-         free(nNode);
-         return 0;
-      }
-      currNode = currNode->next;
-   }
-   oSymTable->head = nNode;
-   oSymTable->size++;
-   return 1;
+   return SymTable_putN(oSymTable, pcKey, strlen(pcKey), pvValue);
 }
 
 void *SymTable_replace(SymTable_T oSymTable, const char *pcKey,
                        const void *pvValue){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   return SymTable_replaceN(oSymTable, pcKey, strlen(pcKey), pvValue);
+}
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   return SymTable_containsN(oSymTable, pcKey, strlen(pcKey));
+}
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   return SymTable_getN(oSymTable, pcKey, strlen(pcKey));
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   return SymTable_removeN(oSymTable, pcKey, strlen(pcKey));
+}
+
+int SymTable_putN(SymTable_T oSymTable, const void *pvKey,
+                  size_t uLength, const void *pvValue){
+   assert(oSymTable != NULL);
+   assert(pvKey != NULL);
+
+   return SymTable_insert(oSymTable, pvKey, uLength, pvValue, KEY_COPY);
+}
+
+void *SymTable_replaceN(SymTable_T oSymTable, const void *pvKey,
+                        size_t uLength, const void *pvValue){
    struct Node *currNode;
    void* oldValue;
 
    assert(oSymTable != NULL);
-   assert(pcKey != NULL);
+   assert(pvKey != NULL);
 
-   currNode = oSymTable->head;
-   while (currNode != NULL) {
-      if (strcmp(currNode->key, pcKey) == 0) {
-         oldValue = (void*)currNode->value;
-         currNode->value = pvValue;
-         return oldValue;
-      }
-      currNode = currNode->next;
+   if (oSymTable->snapshot != NULL) {
+      return NULL;
    }
-   return NULL;
+   currNode = SymTable_find(oSymTable, pvKey, uLength, 0);
+   if (currNode == NULL) {
+      return NULL;
+   }
+   oldValue = (void*)currNode->value;
+   currNode->value = pvValue;
+   return oldValue;
 }
 
-int SymTable_contains(SymTable_T oSymTable, const char *pcKey){
-   struct Node *currNode;
-   
+int SymTable_containsN(SymTable_T oSymTable, const void *pvKey,
+                       size_t uLength){
    assert(oSymTable != NULL);
-   assert(pcKey != NULL);
+   assert(pvKey != NULL);
 
-   currNode = oSymTable->head;
-   while (currNode != NULL) {
-      if (strcmp(currNode->key, pcKey) == 0) {
-         return 1;
-      }
-      currNode = currNode->next;
+   if (oSymTable->snapshot != NULL) {
+      return Snapshot_find(oSymTable->snapshot, pvKey, uLength, NULL);
    }
-   return 0;
+   return SymTable_find(oSymTable, pvKey, uLength, 0) != NULL;
 }
 
-void *SymTable_get(SymTable_T oSymTable, const char *pcKey){
+void *SymTable_getN(SymTable_T oSymTable, const void *pvKey,
+                    size_t uLength){
    struct Node *currNode;
+   void *pvValue;
    
    assert(oSymTable != NULL);
-   assert(pcKey != NULL);
+   assert(pvKey != NULL);
 
-   currNode = oSymTable->head;
-   while (currNode != NULL) {
-      if (strcmp(currNode->key, pcKey) == 0) {
-         return (void*)currNode->value;
+   if (oSymTable->snapshot != NULL) {
+      if (!Snapshot_find(oSymTable->snapshot, pvKey, uLength, &pvValue)) {
+         return NULL;
       }
-      currNode = currNode->next;
+      return pvValue;
    }
-   return NULL;
+   currNode = SymTable_find(oSymTable, pvKey, uLength, 0);
+   if (currNode == NULL) {
+      return NULL;
+   }
+   return (void*)currNode->value;
 }
 
-void *SymTable_remove(SymTable_T oSymTable, const char *pcKey){
+void *SymTable_removeN(SymTable_T oSymTable, const void *pvKey,
+                       size_t uLength){
    struct Node *currNode;
    struct Node *prev;
+   struct SymTableIter *pIter;
    void* value;
 
    assert(oSymTable != NULL);
-   assert(pcKey != NULL);
+   assert(pvKey != NULL);
 
+   if (oSymTable->snapshot != NULL) {
+      return NULL;
+   }
    currNode = oSymTable->head;
    prev = NULL;
    while (currNode != NULL) {
-      if (strcmp(currNode->key, pcKey) == 0) {
+      if (SymTable_matches(oSymTable, currNode, pvKey, uLength, 0)) {
          value = (void*)currNode->value;
          oSymTable->size--;
 
@@ -168,8 +403,14 @@ void *SymTable_remove(SymTable_T oSymTable, const char *pcKey){
          } else {
             oSymTable->head = currNode->next;
          }
-         free((void*)currNode->key);
-         free((void*)currNode);
+         /* an iterator about to return currNode skips it instead */
+         for (pIter = oSymTable->iters; pIter != NULL;
+              pIter = pIter->nextIter) {
+            if (pIter->nextNode == currNode) {
+               pIter->nextNode = currNode->next;
+            }
+         }
+         SymTable_freeNode(oSymTable, currNode);
 
          return value;
      }
@@ -188,9 +429,535 @@ void SymTable_map(SymTable_T oSymTable,
    assert(oSymTable != NULL);
    assert(pfApply != NULL);
 
+   if (oSymTable->snapshot != NULL) {
+      Snapshot_map(oSymTable->snapshot, pfApply, pvExtra);
+      return;
+   }
    currNode = oSymTable->head;
    while (currNode != NULL) {
       (*pfApply)(currNode->key, (void*)currNode->value, (void*)pvExtra);
       currNode = currNode->next;
    }
 }
+
+void SymTable_getCounts(SymTable_T oSymTable, size_t *puRehashes,
+                        size_t *puCompares){
+   assert(oSymTable != NULL);
+   assert(puRehashes != NULL);
+   assert(puCompares != NULL);
+
+   /* a list is never rehashed */
+   *puRehashes = 0;
+   *puCompares = oSymTable->compareCount;
+}
+
+int SymTable_setMaxLoad(SymTable_T oSymTable, double dMaxLoad){
+   assert(oSymTable != NULL);
+
+   /* a list has no buckets, so any positive load factor is accepted
+   and has no effect */
+   return dMaxLoad > 0.0;
+}
+
+int SymTable_setIncremental(SymTable_T oSymTable, int iIncremental){
+   assert(oSymTable != NULL);
+
+   /* a list never expands, so there is nothing to do incrementally */
+   return iIncremental == 0;
+}
+
+size_t SymTable_getAllocCount(SymTable_T oSymTable){
+   assert(oSymTable != NULL);
+
+   /* the SymTable itself plus everything in its arena */
+   return oSymTable->allocCount + Arena_getAllocCount(oSymTable->arena) +
+          (oSymTable->snapshot != NULL);
+}
+
+size_t SymTable_getBytes(SymTable_T oSymTable){
+   assert(oSymTable != NULL);
+   return sizeof(struct SymTable) + Arena_getBytes(oSymTable->arena) +
+          (oSymTable->snapshot != NULL ?
+           Snapshot_getBytes(oSymTable->snapshot) : 0);
+}
+
+int SymTable_putAtom(SymTable_T oSymTable, const char *pcAtom,
+                     const void *pvValue){
+   assert(oSymTable != NULL);
+   assert(pcAtom != NULL);
+
+   return SymTable_insert(oSymTable, pcAtom, Atom_getLength(pcAtom),
+                          pvValue, KEY_ATOM);
+}
+
+void *SymTable_getAtom(SymTable_T oSymTable, const char *pcAtom){
+   struct Node *currNode;
+
+   assert(oSymTable != NULL);
+   assert(pcAtom != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      return SymTable_getN(oSymTable, pcAtom, Atom_getLength(pcAtom));
+   }
+   currNode = SymTable_find(oSymTable, pcAtom, Atom_getLength(pcAtom),
+                            1);
+   if (currNode == NULL) {
+      return NULL;
+   }
+   return (void*)currNode->value;
+}
+
+int SymTable_putBorrowed(SymTable_T oSymTable, const char *pcKey,
+                         const void *pvValue){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   return SymTable_insert(oSymTable, pcKey, strlen(pcKey), pvValue,
+                          KEY_BORROWED);
+}
+
+void **SymTable_getOrPut(SymTable_T oSymTable, const char *pcKey,
+                         const void *pvValue, int *piFound){
+   struct Node *currNode;
+   size_t uLength;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      return NULL;
+   }
+   uLength = strlen(pcKey);
+   currNode = SymTable_find(oSymTable, pcKey, uLength, 0);
+   if (piFound != NULL) {
+      *piFound = (currNode != NULL);
+   }
+   if (currNode == NULL) {
+      currNode = SymTable_add(oSymTable, pcKey, uLength, pvValue,
+                              KEY_COPY);
+      if (currNode == NULL) {
+         return NULL;
+      }
+   }
+   return (void **)&currNode->value;
+}
+
+int SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+                    const void *pvValue, void **ppvOldValue){
+   struct Node *currNode;
+   size_t uLength;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      return 0;
+   }
+   uLength = strlen(pcKey);
+   currNode = SymTable_find(oSymTable, pcKey, uLength, 0);
+   if (currNode == NULL) {
+      if (SymTable_add(oSymTable, pcKey, uLength, pvValue, KEY_COPY)
+          == NULL) {
+         return 0;
+      }
+      if (ppvOldValue != NULL) {
+         *ppvOldValue = NULL;
+      }
+      return 1;
+   }
+   if (ppvOldValue != NULL) {
+      *ppvOldValue = (void*)currNode->value;
+   }
+   currNode->value = pvValue;
+   return 1;
+}
+
+int SymTable_putHashed(SymTable_T oSymTable, const char *pcKey,
+                       size_t uHash, const void *pvValue){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   /* a list has no use for the hash */
+   (void)uHash;
+   return SymTable_put(oSymTable, pcKey, pvValue);
+}
+
+void *SymTable_getHashed(SymTable_T oSymTable, const char *pcKey,
+                         size_t uHash){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   (void)uHash;
+   return SymTable_get(oSymTable, pcKey);
+}
+
+int SymTable_containsHashed(SymTable_T oSymTable, const char *pcKey,
+                            size_t uHash){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   (void)uHash;
+   return SymTable_contains(oSymTable, pcKey);
+}
+
+void *SymTable_removeHashed(SymTable_T oSymTable, const char *pcKey,
+                            size_t uHash){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   (void)uHash;
+   return SymTable_remove(oSymTable, pcKey);
+}
+
+void SymTable_getMany(SymTable_T oSymTable, const char *const apcKeys[],
+                      size_t uCount, void *apvValues[]){
+   size_t i;
+
+   assert(oSymTable != NULL);
+   assert(uCount == 0 || (apcKeys != NULL && apvValues != NULL));
+
+   /* a list has no buckets to prefetch, so each key is just looked
+   up in turn */
+   for (i = 0; i < uCount; i++) {
+      apvValues[i] = SymTable_get(oSymTable, apcKeys[i]);
+   }
+}
+
+void SymTable_mapParallel(SymTable_T oSymTable,
+                          void (*pfApply)(const char *pcKey,
+                                          void *pvValue, void *pvExtra),
+                          const void *pvExtra, size_t uThreads){
+   assert(oSymTable != NULL);
+   assert(pfApply != NULL);
+
+   /* a mapped SymTable's bindings are an array, which splits easily */
+   if (oSymTable->snapshot != NULL) {
+      Snapshot_mapParallel(oSymTable->snapshot, pfApply, pvExtra,
+                           uThreads);
+      return;
+   }
+   /* a list can only be split into ranges by walking it, which costs
+   as much as mapping it, so it is mapped on the calling thread */
+   (void)uThreads;
+   SymTable_map(oSymTable, pfApply, pvExtra);
+}
+
+SymTableIter_T SymTable_iterBegin(SymTable_T oSymTable){
+   struct SymTableIter *pIter;
+
+   assert(oSymTable != NULL);
+
+   pIter = malloc(sizeof(struct SymTableIter));
+   if (pIter == NULL) {
+      return NULL;
+   }
+   pIter->oSymTable = oSymTable;
+   /* Nodes are put at the front, so later ones are never returned */
+   pIter->nextNode = oSymTable->head;
+   pIter->snapshotIndex = 0;
+   pIter->nextIter = oSymTable->iters;
+   oSymTable->iters = pIter;
+   return pIter;
+}
+
+int SymTable_iterNext(SymTableIter_T oIter, const char **ppcKey,
+                      void **ppvValue){
+   struct Node *currNode;
+
+   assert(oIter != NULL);
+
+   if (oIter->oSymTable->snapshot != NULL) {
+      if (oIter->snapshotIndex ==
+          Snapshot_getLength(oIter->oSymTable->snapshot)) {
+         return 0;
+      }
+      Snapshot_getBinding(oIter->oSymTable->snapshot,
+                          oIter->snapshotIndex++, ppcKey, NULL,
+                          ppvValue);
+      return 1;
+   }
+   currNode = oIter->nextNode;
+   if (currNode == NULL) {
+      return 0;
+   }
+   oIter->nextNode = currNode->next;
+   if (ppcKey != NULL) {
+      *ppcKey = currNode->key;
+   }
+   if (ppvValue != NULL) {
+      *ppvValue = (void*)currNode->value;
+   }
+   return 1;
+}
+
+void SymTable_iterEnd(SymTableIter_T oIter){
+   struct SymTableIter **ppIter;
+
+   assert(oIter != NULL);
+
+   for (ppIter = &oIter->oSymTable->iters; *ppIter != oIter;
+        ppIter = &(*ppIter)->nextIter) {
+      assert(*ppIter != NULL);
+   }
+   *ppIter = oIter->nextIter;
+   free(oIter);
+}
+
+
+/* SymTable_order takes in keys pcKey and pcOther of uLength and
+uOtherLength bytes and returns a negative number, 0 or a positive
+number as pcKey comes before, is or comes after pcOther */
+static int SymTable_order(const char *pcKey, size_t uLength,
+                          const char *pcOther, size_t uOtherLength)
+{
+   int iResult;
+
+   iResult = memcmp(pcKey, pcOther,
+                    uLength < uOtherLength ? uLength : uOtherLength);
+   if (iResult != 0) {
+      return iResult;
+   }
+   return (uLength > uOtherLength) - (uLength < uOtherLength);
+}
+
+/* SymTable_inBounds takes in KeyBounds psBounds and a key pcKey of
+uLength bytes and returns 1 if psBounds wants pcKey and 0 otherwise */
+static int SymTable_inBounds(const struct KeyBounds *psBounds,
+                             const char *pcKey, size_t uLength)
+{
+   if (psBounds->prefix != NULL) {
+      return uLength >= psBounds->prefixLength &&
+             memcmp(pcKey, psBounds->prefix, psBounds->prefixLength)
+             == 0;
+   }
+   if (psBounds->low != NULL &&
+       SymTable_order(pcKey, uLength, psBounds->low,
+                      psBounds->lowLength) < 0) {
+      return 0;
+   }
+   return psBounds->high == NULL ||
+          SymTable_order(pcKey, uLength, psBounds->high,
+                         psBounds->highLength) < 0;
+}
+
+/* SymTable_mapBounded takes in SymTable oSymTable, KeyBounds
+psBounds, pfApply and pvExtra, and calls (*pfApply)(key, value,
+pvExtra) for every Node whose key psBounds wants. A list is in no
+order, so every Node is looked at. */
+static void SymTable_mapBounded(SymTable_T oSymTable,
+                                const struct KeyBounds *psBounds,
+                                void (*pfApply)(const char *pcKey,
+                                                void *pvValue,
+                                                void *pvExtra),
+                                const void *pvExtra)
+{
+   struct Node *currNode;
+
+   for (currNode = oSymTable->head; currNode != NULL;
+        currNode = currNode->next) {
+      if (SymTable_inBounds(psBounds, currNode->key,
+                            currNode->keyLength)) {
+         (*pfApply)(currNode->key, (void*)currNode->value,
+                    (void*)pvExtra);
+      }
+   }
+}
+
+void SymTable_mapRange(SymTable_T oSymTable, const char *pcLow,
+                       const char *pcHigh,
+                       void (*pfApply)(const char *pcKey,
+                                       void *pvValue, void *pvExtra),
+                       const void *pvExtra){
+   struct KeyBounds sBounds;
+
+   assert(oSymTable != NULL);
+   assert(pfApply != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      Snapshot_mapRange(oSymTable->snapshot, pcLow, pcHigh, pfApply,
+                        pvExtra);
+      return;
+   }
+   sBounds.low = pcLow;
+   sBounds.lowLength = (pcLow != NULL) ? strlen(pcLow) : 0;
+   sBounds.high = pcHigh;
+   sBounds.highLength = (pcHigh != NULL) ? strlen(pcHigh) : 0;
+   sBounds.prefix = NULL;
+   sBounds.prefixLength = 0;
+   SymTable_mapBounded(oSymTable, &sBounds, pfApply, pvExtra);
+}
+
+void SymTable_mapPrefix(SymTable_T oSymTable, const char *pcPrefix,
+                        void (*pfApply)(const char *pcKey,
+                                        void *pvValue, void *pvExtra),
+                        const void *pvExtra){
+   struct KeyBounds sBounds;
+
+   assert(oSymTable != NULL);
+   assert(pcPrefix != NULL);
+   assert(pfApply != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      Snapshot_mapPrefix(oSymTable->snapshot, pcPrefix, pfApply,
+                         pvExtra);
+      return;
+   }
+   sBounds.low = NULL;
+   sBounds.lowLength = 0;
+   sBounds.high = NULL;
+   sBounds.highLength = 0;
+   sBounds.prefix = pcPrefix;
+   sBounds.prefixLength = strlen(pcPrefix);
+   SymTable_mapBounded(oSymTable, &sBounds, pfApply, pvExtra);
+}
+
+int SymTable_save(SymTable_T oSymTable, const char *pcPath,
+                  size_t uValueSize){
+   SnapshotWriter_T oWriter;
+   struct Node *currNode;
+
+   assert(oSymTable != NULL);
+   assert(pcPath != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      return Snapshot_save(oSymTable->snapshot, pcPath, uValueSize);
+   }
+   oWriter = SnapshotWriter_new(uValueSize);
+   if (oWriter == NULL) {
+      return 0;
+   }
+   for (currNode = oSymTable->head; currNode != NULL;
+        currNode = currNode->next) {
+      if (!SnapshotWriter_add(oWriter, currNode->key, currNode->keyLength,
+                              currNode->value)) {
+         SnapshotWriter_free(oWriter);
+         return 0;
+      }
+   }
+   return SnapshotWriter_finish(oWriter, pcPath);
+}
+
+SymTable_T SymTable_openMapped(const char *pcPath){
+   SymTable_T oSymTable;
+
+   assert(pcPath != NULL);
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL) {
+      return NULL;
+   }
+   oSymTable->snapshot = Snapshot_open(pcPath);
+   if (oSymTable->snapshot == NULL) {
+      SymTable_free(oSymTable);
+      return NULL;
+   }
+   return oSymTable;
+}
+
+SymTable_T SymTable_newWithCapacity(size_t uCapacity){
+   SymTable_T oSymTable;
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL) {
+      return NULL;
+   }
+   if (! SymTable_reserve(oSymTable, uCapacity)) {
+      SymTable_free(oSymTable);
+      return NULL;
+   }
+   return oSymTable;
+}
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity){
+   size_t uNewNodes;
+
+   assert(oSymTable != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      return 0;
+   }
+   /* a list has no buckets, so only its Nodes can be made room for.
+   Keys that fit in inlineKey need nothing more. */
+   if (uCapacity <= oSymTable->size) {
+      return 1;
+   }
+   uNewNodes = uCapacity - oSymTable->size;
+   if (uNewNodes > (size_t)-1 / sizeof(struct Node)) {
+      return 0;
+   }
+   return Arena_reserve(oSymTable->arena,
+                        uNewNodes * sizeof(struct Node));
+}
+
+int SymTable_compact(SymTable_T oSymTable){
+   struct Node *currNode;
+   struct Node *nNode;
+   struct Node *newHead = NULL;
+   struct Node **ppTail = &newHead;
+   Arena_T newArena;
+   char *defCopy;
+
+   assert(oSymTable != NULL);
+
+   /* the iterators point at the Nodes that are about to move */
+   if (oSymTable->snapshot != NULL || oSymTable->iters != NULL) {
+      return 0;
+   }
+   newArena = Arena_new();
+   if (newArena == NULL) {
+      return 0;
+   }
+   if (! Arena_reserve(newArena, oSymTable->size * sizeof(struct Node))) {
+      Arena_free(newArena);
+      return 0;
+   }
+
+   /* the copies keep the order of the list and lie next to each
+   other in it, so a search walks memory in one direction */
+   for (currNode = oSymTable->head; currNode != NULL;
+        currNode = currNode->next) {
+      nNode = Arena_alloc(newArena, sizeof(struct Node));
+      if (nNode == NULL) {
+         Arena_free(newArena);
+         return 0;
+      }
+      *nNode = *currNode;
+      if (currNode->key == currNode->inlineKey) {
+         nNode->key = nNode->inlineKey;
+      } else if (currNode->keyKind == KEY_COPY) {
+         defCopy = Arena_alloc(newArena, currNode->keyLength + 1);
+         if (defCopy == NULL) {
+            Arena_free(newArena);
+            return 0;
+         }
+         memcpy(defCopy, currNode->key, currNode->keyLength + 1);
+         nNode->key = defCopy;
+      }
+      nNode->next = NULL;
+      *ppTail = nNode;
+      ppTail = &nNode->next;
+   }
+
+   oSymTable->allocCount += Arena_getAllocCount(oSymTable->arena);
+   Arena_free(oSymTable->arena);
+   oSymTable->arena = newArena;
+   oSymTable->head = newHead;
+   return 1;
+}
+
+SymTable_T SymTable_newWithStats(enum SymTableHash eHash){
+   /* a list has no buckets to probe and never expands, so there is
+   nothing more to count */
+   return SymTable_newWithOptions(eHash);
+}
+
+int SymTable_getStats(SymTable_T oSymTable,
+                      struct SymTableStats *psStats){
+   assert(oSymTable != NULL);
+   assert(psStats != NULL);
+
+   Stats_clear(psStats);
+   psStats->allocCount = SymTable_getAllocCount(oSymTable);
+   psStats->bytes = SymTable_getBytes(oSymTable);
+   return 0;
+}
@@ -0,0 +1,1625 @@
+/* symtable open addressing implementation */
+#include "symtable.h"
+#include "symtablearena.h"
+#include "symtableatom.h"
+#include "symtablekeyhash.h"
+#include "symtableparallel.h"
+#include "symtablesnapshot.h"
+#include "symtablestats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <limits.h>
+#include <stddef.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* the number of control bytes (and slots) that make up one group. A
+lookup compares a whole group of control bytes against a hash tag at
+once, so every probe looks at 16 slots instead of 1. */
+enum {GROUP_WIDTH = 16};
+
+/* denotes the min value for the number of slots. slotCount is always
+a power of two and a multiple of GROUP_WIDTH. */
+enum SlotEnds {slotMin = 512};
+
+/* the default max load factor: used (full or DELETED) slots may fill
+7/8 of the table before it is expanded */
+#define DEFAULT_MAX_LOAD 0.875
+
+/* a SymTable shrinks once it holds fewer bindings than 1 /
+SHRINK_RATIO of the slots its max load lets it use, to the fewest
+slots that hold twice its bindings. Its load then sits well between
+the two limits, so puts and removes around either one do not rebuild
+the slots back and forth. */
+enum {SHRINK_RATIO = 8};
+
+/* how many keys SymTable_getMany hashes and prefetches at a time */
+enum {BATCH_SIZE = 16};
+
+/* SYMTABLE_PREFETCH asks the CPU to start loading the cache line at
+address p, so a later access to it does not stall. It does nothing
+with compilers that have no __builtin_prefetch. */
+#if defined(__GNUC__)
+#define SYMTABLE_PREFETCH(p) __builtin_prefetch(p)
+#else
+#define SYMTABLE_PREFETCH(p) ((void)(p))
+#endif
+
+/* control byte values. A full slot holds the low 7 bits of its key's
+hash (0x00 - 0x7F) so the high bit marks the special states. */
+enum CtrlValues {CTRL_EMPTY = 0x80, CTRL_DELETED = 0xFE};
+
+/* KeyCopy is how a key copy is laid out in the arena: the length of
+the key, followed by the key itself and a '\0'. A Slot points to
+string, so the length sits just before the key it describes. */
+struct KeyCopy {
+    /* how many bytes are in the key, not counting the '\0' */
+    size_t length;
+    /* the bytes of the key, followed by a '\0' */
+    char string[1];
+};
+
+/* Slot holds a single binding: key and value. Slots are stored in
+one flat array, parallel to the array of control bytes. */
+struct Slot {
+    /* char pointer to the string of the key's KeyCopy */
+    const char *key;
+    /* void pointer to the value */
+    const void *value;
+};
+
+/* SymTable holds the array of control bytes, the parallel array of
+slots, and variables regarding the entire table such as: slotCount,
+bindingsSize and growthLeft. */
+struct SymTable {
+    /* one control byte per slot: CTRL_EMPTY, CTRL_DELETED or the 7
+    bit hash tag of the key stored in the slot */
+    unsigned char *ctrl;
+    /* array of slotCount slots */
+    struct Slot *slots;
+    /* holds how many slots are in the SymTable */
+    size_t slotCount;
+    /* keeps track of how many Bindings total are in the SymTable */
+    size_t bindingsSize;
+    /* how many more EMPTY slots can be filled before the SymTable
+    has to be expanded */
+    size_t growthLeft;
+    /* the SymTable shrinks once bindingsSize drops below this, or
+    never if it is 0 */
+    size_t shrinkAt;
+    /* the fewest slots the SymTable shrinks to: slotMin, or what
+    SymTable_reserve grew it to */
+    size_t minSlotCount;
+    /* the max fraction of slots that may be used before expanding */
+    double maxLoad;
+    /* how many bindings have been moved to new arrays by
+    SymTable_expand */
+    size_t rehashCount;
+    /* how many times a key has been compared with memcmp */
+    size_t compareCount;
+    /* how many times the SymTable has called malloc for itself and
+    its arrays, and the arenas SymTable_compact has replaced */
+    size_t allocCount;
+    /* the Arena that every key copy is allocated from */
+    Arena_T arena;
+    /* which hash function the SymTable was created with */
+    enum SymTableHash hashKind;
+    /* the per table seed of the SYMTABLE_HASH_FAST and
+    SYMTABLE_HASH_SIPHASH hashes */
+    struct KeyHashSeed seed;
+    /* the iterators that have not been ended, linked by their
+    nextIter fields */
+    struct SymTableIter *iters;
+    /* the mapped snapshot that a SymTable from SymTable_openMapped
+    answers from instead of its (empty) slots, or NULL */
+    Snapshot_T snapshot;
+    /* the lookups and expansions a SymTable made by
+    SymTable_newWithStats has counted, or NULL if it counts none */
+    struct Stats *stats;
+};
+
+/* MapJob is what the threads of SymTable_mapParallel share: the
+SymTable being mapped and the function to apply */
+struct MapJob {
+    /* the SymTable whose bindings are mapped */
+    SymTable_T oSymTable;
+    /* the function applied to every binding */
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra);
+    /* passed on to pfApply */
+    const void *pvExtra;
+};
+
+/* KeyBounds says which keys SymTable_mapRange or SymTable_mapPrefix
+is after: the keys in [low, high), or the keys starting with prefix */
+struct KeyBounds {
+    /* the smallest key wanted, or NULL for no lower bound */
+    const char *low;
+    /* how many bytes are in low */
+    size_t lowLength;
+    /* wanted keys are less than high, unless it is NULL */
+    const char *high;
+    /* how many bytes are in high */
+    size_t highLength;
+    /* what wanted keys start with, or NULL for a range */
+    const char *prefix;
+    /* how many bytes are in prefix */
+    size_t prefixLength;
+};
+
+/* SymTableIter is an iterator over the slots of a SymTable. Slots
+never move except when the SymTable expands, which rehashes them all;
+the iterator then starts again from slot 0 of the new arrays, skipping
+the slots whose bindings it had already returned. */
+struct SymTableIter {
+    /* the SymTable being iterated over */
+    SymTable_T oSymTable;
+    /* the first slot that has not been looked at yet */
+    size_t slot;
+    /* NULL until the SymTable expands during the iteration. Then a
+    bitmap with a bit per slot, set if the slot's binding has already
+    been returned. */
+    unsigned char *returned;
+    /* the bitmap that becomes returned, while SymTable_expand builds
+    it */
+    unsigned char *newReturned;
+    /* the number of the snapshot binding returned next, if the
+    SymTable is mapped */
+    size_t snapshotIndex;
+    /* the next iterator of the same SymTable */
+    struct SymTableIter *nextIter;
+};
+
+/* SymTable_mix takes in a hash uHash from Atom_hashString and returns
+it mixed so that both the low bits (the tag) and the high bits (the
+group) are well spread */
+static size_t SymTable_mix(size_t uHash)
+{
+   uHash ^= uHash >> 16;
+   uHash *= (size_t)0x45d9f3bUL;
+   uHash ^= uHash >> 16;
+   uHash *= (size_t)0x45d9f3bUL;
+   uHash ^= uHash >> 16;
+   return uHash;
+}
+
+/* this function takes in SymTable oSymTable, a const char pointer
+pcKey and its length uLength and returns the full hash of pcKey as a
+type size_t. By default that is the byte at a time hash from the
+assignment followed by a mixing step; the seeded hashes are already
+well spread and are used as they are. */
+static size_t SymTable_hash(SymTable_T oSymTable, const char *pcKey,
+                            size_t uLength)
+{
+   switch (oSymTable->hashKind) {
+   case SYMTABLE_HASH_FAST:
+      return KeyHash_fast(pcKey, uLength, &oSymTable->seed);
+   case SYMTABLE_HASH_SIPHASH:
+      return KeyHash_sip(pcKey, uLength, &oSymTable->seed);
+   default:
+      return SymTable_mix(Atom_hashBytes(pcKey, uLength));
+   }
+}
+
+/* SymTable_rehash takes in SymTable oSymTable, a const char pointer
+pcKey, its length uLength and uHash, the default hash of pcKey (from
+an atom or SymTable_hashKey). It returns SymTable_hash of pcKey,
+mixing uHash instead of hashing pcKey if oSymTable uses the default
+hash. */
+static size_t SymTable_rehash(SymTable_T oSymTable, const char *pcKey,
+                              size_t uLength, size_t uHash)
+{
+   if (oSymTable->hashKind == SYMTABLE_HASH_DEFAULT) {
+      return SymTable_mix(uHash);
+   }
+   return SymTable_hash(oSymTable, pcKey, uLength);
+}
+
+/* SymTable_keyLength takes in the key pcKey of a Slot and returns the
+length stored in its KeyCopy */
+static size_t SymTable_keyLength(const char *pcKey)
+{
+   return ((const struct KeyCopy *)
+           (pcKey - offsetof(struct KeyCopy, string)))->length;
+}
+
+/* SymTable_tag takes in a full hash uHash and returns the 7 bit tag
+that is stored in the control byte of the slot holding the key */
+static unsigned char SymTable_tag(size_t uHash)
+{
+   return (unsigned char)(uHash & 0x7F);
+}
+
+/* SymTable_group takes in a full hash uHash and a slot count
+uSlotCount and returns the index of the first slot of the first group
+to probe */
+static size_t SymTable_group(size_t uHash, size_t uSlotCount)
+{
+   return ((uHash >> 7) * GROUP_WIDTH) & (uSlotCount - 1);
+}
+
+/* SymTable_match takes in a pointer pucCtrl to the GROUP_WIDTH
+control bytes of a group and a control byte value ucValue. It returns
+a bit mask where bit i is set if pucCtrl[i] == ucValue. */
+static unsigned SymTable_match(const unsigned char *pucCtrl,
+                               unsigned char ucValue)
+{
+#if defined(__SSE2__)
+   __m128i group = _mm_loadu_si128((const __m128i *)pucCtrl);
+   __m128i value = _mm_set1_epi8((char)ucValue);
+   return (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(group, value));
+#else
+   unsigned uMask = 0;
+   size_t i;
+   for (i = 0; i < GROUP_WIDTH; i++) {
+      if (pucCtrl[i] == ucValue)
+         uMask |= 1U << i;
+   }
+   return uMask;
+#endif
+}
+
+/* SymTable_matchFree takes in a pointer pucCtrl to the GROUP_WIDTH
+control bytes of a group and returns a bit mask where bit i is set if
+slot i is EMPTY or DELETED (the high bit of the control byte is set) */
+static unsigned SymTable_matchFree(const unsigned char *pucCtrl)
+{
+#if defined(__SSE2__)
+   __m128i group = _mm_loadu_si128((const __m128i *)pucCtrl);
+   return (unsigned)_mm_movemask_epi8(group);
+#else
+   unsigned uMask = 0;
+   size_t i;
+   for (i = 0; i < GROUP_WIDTH; i++) {
+      if (pucCtrl[i] & 0x80)
+         uMask |= 1U << i;
+   }
+   return uMask;
+#endif
+}
+
+/* SymTable_lowestBit takes in a non zero bit mask uMask and returns
+the index of its lowest set bit */
+static size_t SymTable_lowestBit(unsigned uMask)
+{
+   size_t i = 0;
+
+   assert(uMask != 0);
+
+   while ((uMask & 1U) == 0) {
+      uMask >>= 1;
+      i++;
+   }
+   return i;
+}
+
+/* SymTable_maxUsed takes in a SymTable oSymTable and a slot count
+uSlotCount and returns how many of uSlotCount slots may be used (full
+or DELETED) under oSymTable's max load factor. At least one slot is
+always left EMPTY so every probe sequence ends. */
+static size_t SymTable_maxUsed(SymTable_T oSymTable, size_t uSlotCount)
+{
+   size_t uMaxUsed = (size_t)((double)uSlotCount * oSymTable->maxLoad);
+
+   if (uMaxUsed == 0) {
+      return 1;
+   }
+   if (uMaxUsed >= uSlotCount) {
+      return uSlotCount - 1;
+   }
+   return uMaxUsed;
+}
+
+/* SymTable_setShrinkAt takes in a SymTable oSymTable and recomputes
+its shrinkAt from its slotCount, minSlotCount and maxLoad */
+static void SymTable_setShrinkAt(SymTable_T oSymTable)
+{
+   if (oSymTable->slotCount <= oSymTable->minSlotCount) {
+      oSymTable->shrinkAt = 0;
+   } else {
+      oSymTable->shrinkAt =
+         SymTable_maxUsed(oSymTable, oSymTable->slotCount) / SHRINK_RATIO;
+   }
+}
+
+/* SymTable_fitSlotCount takes in a SymTable oSymTable and a binding
+count uBindings, and returns the fewest slots (a power of two, from
+slotMin on) that may hold uBindings bindings under oSymTable's max
+load, or the most there can be if none may */
+static size_t SymTable_fitSlotCount(SymTable_T oSymTable,
+                                    size_t uBindings)
+{
+   size_t uSlotCount = slotMin;
+
+   while (SymTable_maxUsed(oSymTable, uSlotCount) < uBindings &&
+          uSlotCount <= (size_t)-1 / 2 / sizeof(struct Slot)) {
+      uSlotCount *= 2;
+   }
+   return uSlotCount;
+}
+
+/* SymTable_find takes in SymTable oSymTable, a const char pointer
+pcKey, its length uLength, its full hash uHash and iCount, which is 0
+for a remove. It returns the index of the slot that holds pcKey, or
+oSymTable->slotCount if pcKey is not in oSymTable. If oSymTable has
+stats and iCount is 1, the lookup is counted in them with the groups
+it probed. */
+static size_t SymTable_find(SymTable_T oSymTable, const char *pcKey,
+                            size_t uLength, size_t uHash, int iCount)
+{
+   size_t uMask = oSymTable->slotCount - 1;
+   size_t uPos = SymTable_group(uHash, oSymTable->slotCount);
+   size_t uStride = 0;
+   unsigned char ucTag = SymTable_tag(uHash);
+   unsigned uMatch;
+   size_t uSlot;
+   const char *pcSlotKey;
+
+   for (;;) {
+      const unsigned char *pucCtrl = oSymTable->ctrl + uPos;
+      uMatch = SymTable_match(pucCtrl, ucTag);
+      while (uMatch != 0) {
+         uSlot = uPos + SymTable_lowestBit(uMatch);
+         pcSlotKey = oSymTable->slots[uSlot].key;
+         if (SymTable_keyLength(pcSlotKey) == uLength) {
+            oSymTable->compareCount++;
+            if (memcmp(pcSlotKey, pcKey, uLength) == 0) {
+               if (oSymTable->stats != NULL && iCount)
+                  Stats_addLookup(oSymTable->stats,
+                                  uStride / GROUP_WIDTH + 1, 1);
+               return uSlot;
+            }
+         }
+         uMatch &= uMatch - 1;
+      }
+      /* an EMPTY slot in this group means pcKey was never pushed
+      past it, so the probe sequence ends here */
+      if (SymTable_match(pucCtrl, CTRL_EMPTY) != 0) {
+         if (oSymTable->stats != NULL && iCount)
+            Stats_addLookup(oSymTable->stats,
+                            uStride / GROUP_WIDTH + 1, 0);
+         return oSymTable->slotCount;
+      }
+      uStride += GROUP_WIDTH;
+      uPos = (uPos + uStride) & uMask;
+   }
+}
+
+/* SymTable_findFree takes in arrays pucCtrl of control bytes with
+uSlotCount entries and a full hash uHash. It returns the index of the
+first EMPTY or DELETED slot on the probe sequence of uHash. */
+static size_t SymTable_findFree(const unsigned char *pucCtrl,
+                                size_t uSlotCount, size_t uHash)
+{
+   size_t uMask = uSlotCount - 1;
+   size_t uPos = SymTable_group(uHash, uSlotCount);
+   size_t uStride = 0;
+   unsigned uFree;
+
+   for (;;) {
+      uFree = SymTable_matchFree(pucCtrl + uPos);
+      if (uFree != 0)
+         return uPos + SymTable_lowestBit(uFree);
+      uStride += GROUP_WIDTH;
+      uPos = (uPos + uStride) & uMask;
+   }
+}
+
+/* SymTable_alloc takes in a SymTable oSymTable and a slot count
+uSlotCount and allocates new arrays of control bytes and slots for
+oSymTable. It returns 0 if there is insufficient memory (and leaves
+oSymTable unchanged) and 1 otherwise. */
+static int SymTable_alloc(SymTable_T oSymTable, size_t uSlotCount)
+{
+   unsigned char *pucCtrl;
+   struct Slot *psSlots;
+
+   pucCtrl = malloc(uSlotCount);
+   if (pucCtrl == NULL) {
+      return 0;
+   }
+   psSlots = malloc(uSlotCount * sizeof(struct Slot));
+   if (psSlots == NULL) {
+      free(pucCtrl);
+      return 0;
+   }
+   memset(pucCtrl, CTRL_EMPTY, uSlotCount);
+
+   oSymTable->allocCount += 2;
+   oSymTable->ctrl = pucCtrl;
+   oSymTable->slots = psSlots;
+   oSymTable->slotCount = uSlotCount;
+   oSymTable->growthLeft = SymTable_maxUsed(oSymTable, uSlotCount);
+   SymTable_setShrinkAt(oSymTable);
+   return 1;
+}
+
+/* SymTable_isMarked takes in a bitmap pucBitmap (or NULL) and a slot
+uSlot, and returns 1 if the bit of uSlot is set and 0 otherwise */
+static int SymTable_isMarked(const unsigned char *pucBitmap,
+                             size_t uSlot)
+{
+   return pucBitmap != NULL &&
+          (pucBitmap[uSlot / CHAR_BIT] >> (uSlot % CHAR_BIT) & 1) != 0;
+}
+
+/* SymTable_mark takes in a bitmap pucBitmap and a slot uSlot, and
+sets the bit of uSlot */
+static void SymTable_mark(unsigned char *pucBitmap, size_t uSlot)
+{
+   pucBitmap[uSlot / CHAR_BIT] |= (unsigned char)(1U << (uSlot % CHAR_BIT));
+}
+
+/* SymTable_freeNewReturned takes in SymTable oSymTable and frees the
+newReturned bitmaps of its iterators, for a SymTable_expand that
+could not finish */
+static void SymTable_freeNewReturned(SymTable_T oSymTable)
+{
+   struct SymTableIter *pIter;
+
+   for (pIter = oSymTable->iters; pIter != NULL;
+        pIter = pIter->nextIter) {
+      free(pIter->newReturned);
+      pIter->newReturned = NULL;
+   }
+}
+
+SymTable_T SymTable_new(void){
+   return SymTable_newWithOptions(SYMTABLE_HASH_DEFAULT);
+}
+
+SymTable_T SymTable_newWithOptions(enum SymTableHash eHash){
+   struct SymTable *oSymTable;
+
+   if (eHash != SYMTABLE_HASH_DEFAULT && eHash != SYMTABLE_HASH_FAST &&
+       eHash != SYMTABLE_HASH_SIPHASH) {
+      return NULL;
+   }
+   oSymTable = malloc(sizeof(struct SymTable));
+   if(oSymTable == NULL){
+      return NULL;
+   }
+   oSymTable->hashKind = eHash;
+   oSymTable->seed.k0 = 0;
+   oSymTable->seed.k1 = 0;
+   if (eHash != SYMTABLE_HASH_DEFAULT) {
+      KeyHash_randomSeed(&oSymTable->seed);
+   }
+   oSymTable->bindingsSize = 0;
+   oSymTable->minSlotCount = slotMin;
+   oSymTable->maxLoad = DEFAULT_MAX_LOAD;
+   oSymTable->rehashCount = 0;
+   oSymTable->compareCount = 0;
+   oSymTable->allocCount = 1;
+   oSymTable->iters = NULL;
+   oSymTable->snapshot = NULL;
+   oSymTable->stats = NULL;
+   oSymTable->arena = Arena_new();
+   if (oSymTable->arena == NULL) {
+      free(oSymTable);
+      return NULL;
+   }
+   if (! SymTable_alloc(oSymTable, slotMin)) {
+      Arena_free(oSymTable->arena);
+      free(oSymTable);
+      return NULL;
+   }
+   return oSymTable;
+}
+
+void SymTable_free(SymTable_T oSymTable){
+   assert(oSymTable != NULL);
+   assert(oSymTable->iters == NULL);
+
+   /* every key copy lives in the arena */
+   Arena_free(oSymTable->arena);
+   free(oSymTable->ctrl);
+   free(oSymTable->slots);
+   Snapshot_close(oSymTable->snapshot);
+   free(oSymTable->stats);
+   free(oSymTable);
+}
+
+size_t SymTable_getLength(SymTable_T oSymTable){
+   assert(oSymTable != NULL);
+   if (oSymTable->snapshot != NULL) {
+      return Snapshot_getLength(oSymTable->snapshot);
+   }
+   return oSymTable->bindingsSize;
+}
+
+/* SymTable_getMapped takes in a mapped SymTable oSymTable and a key
+pvKey of uLength bytes, and returns the value of pvKey in oSymTable's
+snapshot, or NULL if there is none. The snapshot has its own hash
+function, so any hash the client passed in is of no use. */
+static void *SymTable_getMapped(SymTable_T oSymTable, const void *pvKey,
+                                size_t uLength)
+{
+   void *pvValue;
+
+   if (!Snapshot_find(oSymTable->snapshot, pvKey, uLength, &pvValue)) {
+      return NULL;
+   }
+   return pvValue;
+}
+
+/* SymTable_resize takes in a SymTable oSymTable and a slot count
+uNewCount, a power of two with room for all its bindings. The function
+allocates new arrays of control bytes and uNewCount slots and
+reinserts every binding into them, which also drops every DELETED
+slot. Each iterator of oSymTable gets a new bitmap of the bindings it
+has returned. If there is insufficient memory for the new arrays or
+bitmaps, the function returns 0 and leaves oSymTable unchanged.
+Otherwise the old arrays are freed and 1 is returned. */
+static int SymTable_resize(SymTable_T oSymTable, size_t uNewCount)
+{
+   struct SymTable oldTable = *oSymTable;
+   struct SymTableIter *pIter;
+   size_t i;
+   size_t uHash;
+   size_t uSlot;
+
+   if (! SymTable_alloc(oSymTable, uNewCount)) {
+      *oSymTable = oldTable;
+      return 0;
+   }
+   for (pIter = oSymTable->iters; pIter != NULL;
+        pIter = pIter->nextIter) {
+      pIter->newReturned = calloc((uNewCount + CHAR_BIT - 1) / CHAR_BIT,
+                                  1);
+      if (pIter->newReturned == NULL) {
+         SymTable_freeNewReturned(oSymTable);
+         free(oSymTable->ctrl);
+         free(oSymTable->slots);
+         *oSymTable = oldTable;
+         return 0;
+      }
+   }
+
+   for (i = 0; i < oldTable.slotCount; i++) {
+      if ((oldTable.ctrl[i] & 0x80) != 0)
+         continue;
+      uHash = SymTable_hash(oSymTable, oldTable.slots[i].key,
+                            SymTable_keyLength(oldTable.slots[i].key));
+      uSlot = SymTable_findFree(oSymTable->ctrl, uNewCount, uHash);
+      oSymTable->ctrl[uSlot] = SymTable_tag(uHash);
+      oSymTable->slots[uSlot] = oldTable.slots[i];
+      oSymTable->rehashCount++;
+      /* a binding in a slot an iterator has passed was returned */
+      for (pIter = oSymTable->iters; pIter != NULL;
+           pIter = pIter->nextIter) {
+         if (i < pIter->slot || SymTable_isMarked(pIter->returned, i))
+            SymTable_mark(pIter->newReturned, uSlot);
+      }
+   }
+   oSymTable->growthLeft -= oldTable.bindingsSize;
+
+   for (pIter = oSymTable->iters; pIter != NULL;
+        pIter = pIter->nextIter) {
+      free(pIter->returned);
+      pIter->returned = pIter->newReturned;
+      pIter->newReturned = NULL;
+      pIter->slot = 0;
+   }
+   free(oldTable.ctrl);
+   free(oldTable.slots);
+   return 1;
+}
+
+/* SymTable_expand takes in a parameter of a SymTable oSymTable and
+resizes it as SymTable_resize does, to twice as many slots, or the
+same number if most used slots are DELETED. It returns what
+SymTable_resize returns. */
+static int SymTable_expand(SymTable_T oSymTable) {
+   size_t uNewCount = oSymTable->slotCount;
+   int iResized;
+   double dStart = 0.0;
+
+   assert(oSymTable != NULL);
+
+   /* only grow while bindings would fill more than half the usable
+   slots, otherwise rehashing in place is enough to clear out DELETED
+   slots */
+   while (oSymTable->bindingsSize >=
+          SymTable_maxUsed(oSymTable, uNewCount) / 2) {
+      uNewCount *= 2;
+   }
+   if (oSymTable->stats != NULL) {
+      dStart = Stats_now();
+   }
+   iResized = SymTable_resize(oSymTable, uNewCount);
+   if (iResized && oSymTable->stats != NULL) {
+      Stats_addExpansion(oSymTable->stats, dStart);
+   }
+   return iResized;
+}
+
+/* SymTable_shrink takes in a SymTable oSymTable that holds fewer
+bindings than its shrinkAt and resizes it as SymTable_resize does, to
+the fewest slots (but not below minSlotCount) that hold twice its
+bindings. If there is insufficient memory it is left as it is and
+tried again on a later remove. */
+static void SymTable_shrink(SymTable_T oSymTable)
+{
+   size_t uNewCount;
+
+   uNewCount = SymTable_fitSlotCount(oSymTable,
+                                     2 * oSymTable->bindingsSize);
+   if (uNewCount < oSymTable->minSlotCount) {
+      uNewCount = oSymTable->minSlotCount;
+   }
+   if (uNewCount < oSymTable->slotCount) {
+      (void)SymTable_resize(oSymTable, uNewCount);
+   }
+}
+
+/* SymTable_add takes in SymTable oSymTable, a const char pointer
+pcKey that is not in oSymTable, its length uLength, its full hash
+uHash and a const void pointer pvValue. It adds a binding with a
+KeyCopy of pcKey and returns the index of its slot, or returns
+oSymTable->slotCount and leaves oSymTable unchanged if there is
+insufficient memory. */
+static size_t SymTable_add(SymTable_T oSymTable, const char *pcKey,
+                           size_t uLength, size_t uHash,
+                           const void *pvValue)
+{
+   size_t uSlot;
+   struct KeyCopy *defCopy;
+
+   uSlot = SymTable_findFree(oSymTable->ctrl, oSymTable->slotCount,
+                             uHash);
+   /* filling an EMPTY slot uses up growth, reusing a DELETED one
+   does not */
+   if (oSymTable->ctrl[uSlot] == CTRL_EMPTY &&
+       oSymTable->growthLeft == 0) {
+      if (! SymTable_expand(oSymTable)) {
+         return oSymTable->slotCount;
+      }
+      uSlot = SymTable_findFree(oSymTable->ctrl, oSymTable->slotCount,
+                                uHash);
+   }
+
+   defCopy = Arena_alloc(oSymTable->arena,
+                         offsetof(struct KeyCopy, string) + uLength + 1);
+   if (defCopy == NULL) {
+      return oSymTable->slotCount;
+   }
+   defCopy->length = uLength;
+   memcpy(defCopy->string, pcKey, uLength);
+   defCopy->string[uLength] = '\0';
+
+   if (oSymTable->ctrl[uSlot] == CTRL_EMPTY) {
+      oSymTable->growthLeft--;
+   }
+   oSymTable->ctrl[uSlot] = SymTable_tag(uHash);
+   oSymTable->slots[uSlot].key = defCopy->string;
+   oSymTable->slots[uSlot].value = pvValue;
+   oSymTable->bindingsSize++;
+   return uSlot;
+}
+
+/* SymTable_insert takes in SymTable oSymTable, a const char pointer
+pcKey, its length uLength, its full hash uHash and a const void
+pointer pvValue. If oSymTable doesn't contain pcKey, a binding with a
+copy of pcKey is added and 1 is returned. If it does, or there is
+insufficient memory, oSymTable is left unchanged and 0 is returned. */
+static int SymTable_insert(SymTable_T oSymTable, const char *pcKey,
+                           size_t uLength, size_t uHash,
+                           const void *pvValue)
+{
+   /* a mapped SymTable is read-only */
+   if (oSymTable->snapshot != NULL) {
+      return 0;
+   }
+   if (SymTable_find(oSymTable, pcKey, uLength, uHash, 1)
+       != oSymTable->slotCount) {
+      return 0;
+   }
+   return SymTable_add(oSymTable, pcKey, uLength, uHash, pvValue)
+          != oSymTable->slotCount;
+}
+
+/* SymTable_delete takes in SymTable oSymTable, a const char pointer
+pcKey, its length uLength and its full hash uHash. It removes the
+binding of pcKey and returns its value, or returns NULL if oSymTable
+doesn't contain pcKey. */
+static void *SymTable_delete(SymTable_T oSymTable, const char *pcKey,
+                             size_t uLength, size_t uHash)
+{
+   size_t uSlot;
+   size_t uGroup;
+   void *value;
+
+   if (oSymTable->snapshot != NULL) {
+      return NULL;
+   }
+   uSlot = SymTable_find(oSymTable, pcKey, uLength, uHash, 0);
+   if (uSlot == oSymTable->slotCount) {
+      return NULL;
+   }
+   value = (void*)oSymTable->slots[uSlot].value;
+   Arena_release(oSymTable->arena,
+                 (char *)oSymTable->slots[uSlot].key
+                 - offsetof(struct KeyCopy, string),
+                 offsetof(struct KeyCopy, string) + uLength + 1);
+   oSymTable->bindingsSize--;
+
+   /* if the group still has an EMPTY slot then no probe sequence
+   ever continued past it, so the slot can go back to EMPTY. Otherwise
+   it has to stay DELETED so later probes keep going. */
+   uGroup = uSlot & ~(size_t)(GROUP_WIDTH - 1);
+   if (SymTable_match(oSymTable->ctrl + uGroup, CTRL_EMPTY) != 0) {
+      oSymTable->ctrl[uSlot] = CTRL_EMPTY;
+      oSymTable->growthLeft++;
+   } else {
+      oSymTable->ctrl[uSlot] = CTRL_DELETED;
+   }
+   if (oSymTable->bindingsSize < oSymTable->shrinkAt) {
+      SymTable_shrink(oSymTable);
+   }
+   return value;
+}
+
+int SymTable_put(SymTable_T oSymTable, const char *pcKey,
+                 const void *pvValue) {
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   return SymTable_putN(oSymTable, pcKey, strlen(pcKey), pvValue);
+}
+
+void *SymTable_replace(SymTable_T oSymTable, const char *pcKey,
+                       const void *pvValue){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   return SymTable_replaceN(oSymTable, pcKey, strlen(pcKey), pvValue);
+}
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   return SymTable_containsN(oSymTable, pcKey, strlen(pcKey));
+}
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   return SymTable_getN(oSymTable, pcKey, strlen(pcKey));
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   return SymTable_removeN(oSymTable, pcKey, strlen(pcKey));
+}
+
+int SymTable_putN(SymTable_T oSymTable, const void *pvKey,
+                  size_t uLength, const void *pvValue){
+   assert(oSymTable != NULL);
+   assert(pvKey != NULL);
+
+   return SymTable_insert(oSymTable, pvKey, uLength,
+                          SymTable_hash(oSymTable, pvKey, uLength),
+                          pvValue);
+}
+
+void *SymTable_replaceN(SymTable_T oSymTable, const void *pvKey,
+                        size_t uLength, const void *pvValue){
+   size_t uSlot;
+   void *oldValue;
+
+   assert(oSymTable != NULL);
+   assert(pvKey != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      return NULL;
+   }
+   uSlot = SymTable_find(oSymTable, pvKey, uLength,
+                         SymTable_hash(oSymTable, pvKey, uLength), 1);
+   if (uSlot == oSymTable->slotCount) {
+      return NULL;
+   }
+   oldValue = (void*)oSymTable->slots[uSlot].value;
+   oSymTable->slots[uSlot].value = pvValue;
+   return oldValue;
+}
+
+int SymTable_containsN(SymTable_T oSymTable, const void *pvKey,
+                       size_t uLength){
+   assert(oSymTable != NULL);
+   assert(pvKey != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      return Snapshot_find(oSymTable->snapshot, pvKey, uLength, NULL);
+   }
+   return SymTable_find(oSymTable, pvKey, uLength,
+                        SymTable_hash(oSymTable, pvKey, uLength), 1)
+          != oSymTable->slotCount;
+}
+
+void *SymTable_getN(SymTable_T oSymTable, const void *pvKey,
+                    size_t uLength){
+   size_t uSlot;
+
+   assert(oSymTable != NULL);
+   assert(pvKey != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      return SymTable_getMapped(oSymTable, pvKey, uLength);
+   }
+   uSlot = SymTable_find(oSymTable, pvKey, uLength,
+                         SymTable_hash(oSymTable, pvKey, uLength), 1);
+   if (uSlot == oSymTable->slotCount) {
+      return NULL;
+   }
+   return (void*)oSymTable->slots[uSlot].value;
+}
+
+void *SymTable_removeN(SymTable_T oSymTable, const void *pvKey,
+                       size_t uLength){
+   assert(oSymTable != NULL);
+   assert(pvKey != NULL);
+
+   return SymTable_delete(oSymTable, pvKey, uLength,
+                          SymTable_hash(oSymTable, pvKey, uLength));
+}
+
+void SymTable_map(SymTable_T oSymTable,
+                  void (*pfApply)(const char *pcKey,
+                                  void *pvValue, void *pvExtra),
+                  const void *pvExtra){
+   size_t i;
+
+   assert(oSymTable != NULL);
+   assert(pfApply != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      Snapshot_map(oSymTable->snapshot, pfApply, pvExtra);
+      return;
+   }
+   for (i = 0; i < oSymTable->slotCount; i++) {
+      if ((oSymTable->ctrl[i] & 0x80) == 0)
+         (*pfApply)(oSymTable->slots[i].key,
+                    (void*)oSymTable->slots[i].value, (void*)pvExtra);
+   }
+}
+
+/* SymTable_order takes in keys pcKey and pcOther of uLength and
+uOtherLength bytes and returns a negative number if pcKey comes first,
+0 if they are the same key and a positive number otherwise */
+static int SymTable_order(const char *pcKey, size_t uLength,
+                          const char *pcOther, size_t uOtherLength)
+{
+   int iResult;
+
+   iResult = memcmp(pcKey, pcOther,
+                    uLength < uOtherLength ? uLength : uOtherLength);
+   if (iResult != 0) {
+      return iResult;
+   }
+   return (uLength > uOtherLength) - (uLength < uOtherLength);
+}
+
+/* SymTable_inBounds takes in KeyBounds psBounds and the key pcKey of a
+slot, and returns 1 if psBounds wants pcKey and 0 otherwise */
+static int SymTable_inBounds(const struct KeyBounds *psBounds,
+                             const char *pcKey)
+{
+   size_t uLength = SymTable_keyLength(pcKey);
+
+   if (psBounds->prefix != NULL) {
+      return uLength >= psBounds->prefixLength &&
+             memcmp(pcKey, psBounds->prefix, psBounds->prefixLength)
+             == 0;
+   }
+   if (psBounds->low != NULL &&
+       SymTable_order(pcKey, uLength, psBounds->low,
+                      psBounds->lowLength) < 0) {
+      return 0;
+   }
+   return psBounds->high == NULL ||
+          SymTable_order(pcKey, uLength, psBounds->high,
+                         psBounds->highLength) < 0;
+}
+
+/* SymTable_mapBounded takes in SymTable oSymTable, KeyBounds
+psBounds, pfApply and pvExtra, and calls (*pfApply)(key, value,
+pvExtra) for every full slot whose key psBounds wants. Slots are in
+hash order, so all of them are looked at. */
+static void SymTable_mapBounded(SymTable_T oSymTable,
+                                const struct KeyBounds *psBounds,
+                                void (*pfApply)(const char *pcKey,
+                                                void *pvValue,
+                                                void *pvExtra),
+                                const void *pvExtra)
+{
+   size_t i;
+
+   for (i = 0; i < oSymTable->slotCount; i++) {
+      if ((oSymTable->ctrl[i] & 0x80) == 0 &&
+          SymTable_inBounds(psBounds, oSymTable->slots[i].key)) {
+         (*pfApply)(oSymTable->slots[i].key,
+                    (void*)oSymTable->slots[i].value, (void*)pvExtra);
+      }
+   }
+}
+
+void SymTable_getCounts(SymTable_T oSymTable, size_t *puRehashes,
+                        size_t *puCompares){
+   assert(oSymTable != NULL);
+   assert(puRehashes != NULL);
+   assert(puCompares != NULL);
+
+   *puRehashes = oSymTable->rehashCount;
+   *puCompares = oSymTable->compareCount;
+}
+
+int SymTable_setMaxLoad(SymTable_T oSymTable, double dMaxLoad){
+   size_t uUsed;
+   size_t uMaxUsed;
+
+   assert(oSymTable != NULL);
+
+   /* open addressing needs EMPTY slots to end probe sequences */
+   if (! (dMaxLoad > 0.0 && dMaxLoad < 1.0)) {
+      return 0;
+   }
+   uUsed = SymTable_maxUsed(oSymTable, oSymTable->slotCount)
+           - oSymTable->growthLeft;
+   oSymTable->maxLoad = dMaxLoad;
+   uMaxUsed = SymTable_maxUsed(oSymTable, oSymTable->slotCount);
+   if (uUsed < uMaxUsed) {
+      oSymTable->growthLeft = uMaxUsed - uUsed;
+   } else {
+      /* the next put into an EMPTY slot expands the SymTable */
+      oSymTable->growthLeft = 0;
+   }
+   SymTable_setShrinkAt(oSymTable);
+   return 1;
+}
+
+int SymTable_setIncremental(SymTable_T oSymTable, int iIncremental){
+   assert(oSymTable != NULL);
+
+   /* open addressing keeps every binding in one slot array, so
+   expansion is always done at once */
+   return iIncremental == 0;
+}
+
+size_t SymTable_getAllocCount(SymTable_T oSymTable){
+   assert(oSymTable != NULL);
+   return oSymTable->allocCount + Arena_getAllocCount(oSymTable->arena);
+}
+
+size_t SymTable_getBytes(SymTable_T oSymTable){
+   assert(oSymTable != NULL);
+
+   /* the SymTable, one control byte and one Slot per slot, and the
+   key copies in the arena */
+   return sizeof(struct SymTable) +
+          oSymTable->slotCount * (1 + sizeof(struct Slot)) +
+          Arena_getBytes(oSymTable->arena) +
+          (oSymTable->snapshot != NULL ?
+           Snapshot_getBytes(oSymTable->snapshot) : 0) +
+          (oSymTable->stats != NULL ? sizeof(struct Stats) : 0);
+}
+
+int SymTable_putAtom(SymTable_T oSymTable, const char *pcAtom,
+                     const void *pvValue){
+   size_t uLength;
+
+   assert(oSymTable != NULL);
+   assert(pcAtom != NULL);
+
+   /* the key is still copied, since removing a binding releases its
+   key back to the arena, but the string is never hashed */
+   uLength = Atom_getLength(pcAtom);
+   return SymTable_insert(oSymTable, pcAtom, uLength,
+      SymTable_rehash(oSymTable, pcAtom, uLength, Atom_getHash(pcAtom)),
+      pvValue);
+}
+
+void *SymTable_getAtom(SymTable_T oSymTable, const char *pcAtom){
+   size_t uSlot;
+   size_t uLength;
+
+   assert(oSymTable != NULL);
+   assert(pcAtom != NULL);
+
+   uLength = Atom_getLength(pcAtom);
+   if (oSymTable->snapshot != NULL) {
+      return SymTable_getMapped(oSymTable, pcAtom, uLength);
+   }
+   uSlot = SymTable_find(oSymTable, pcAtom, uLength,
+      SymTable_rehash(oSymTable, pcAtom, uLength, Atom_getHash(pcAtom)),
+      1);
+   if (uSlot == oSymTable->slotCount) {
+      return NULL;
+   }
+   return (void*)oSymTable->slots[uSlot].value;
+}
+
+int SymTable_putBorrowed(SymTable_T oSymTable, const char *pcKey,
+                         const void *pvValue){
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   /* a Slot has no room to remember who owns its key, so the key is
+   copied like in SymTable_put. The client's key is still never freed
+   or modified. */
+   return SymTable_put(oSymTable, pcKey, pvValue);
+}
+
+void **SymTable_getOrPut(SymTable_T oSymTable, const char *pcKey,
+                         const void *pvValue, int *piFound){
+   size_t uLength;
+   size_t uHash;
+   size_t uSlot;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      return NULL;
+   }
+   uLength = strlen(pcKey);
+   uHash = SymTable_hash(oSymTable, pcKey, uLength);
+   uSlot = SymTable_find(oSymTable, pcKey, uLength, uHash, 1);
+   if (piFound != NULL) {
+      *piFound = (uSlot != oSymTable->slotCount);
+   }
+   if (uSlot == oSymTable->slotCount) {
+      uSlot = SymTable_add(oSymTable, pcKey, uLength, uHash, pvValue);
+      if (uSlot == oSymTable->slotCount) {
+         return NULL;
+      }
+   }
+   return (void **)&oSymTable->slots[uSlot].value;
+}
+
+int SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+                    const void *pvValue, void **ppvOldValue){
+   size_t uLength;
+   size_t uHash;
+   size_t uSlot;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      return 0;
+   }
+   uLength = strlen(pcKey);
+   uHash = SymTable_hash(oSymTable, pcKey, uLength);
+   uSlot = SymTable_find(oSymTable, pcKey, uLength, uHash, 1);
+   if (uSlot == oSymTable->slotCount) {
+      if (SymTable_add(oSymTable, pcKey, uLength, uHash, pvValue)
+          == oSymTable->slotCount) {
+         return 0;
+      }
+      if (ppvOldValue != NULL) {
+         *ppvOldValue = NULL;
+      }
+      return 1;
+   }
+   if (ppvOldValue != NULL) {
+      *ppvOldValue = (void*)oSymTable->slots[uSlot].value;
+   }
+   oSymTable->slots[uSlot].value = pvValue;
+   return 1;
+}
+
+int SymTable_putHashed(SymTable_T oSymTable, const char *pcKey,
+                       size_t uHash, const void *pvValue){
+   size_t uLength;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   uLength = strlen(pcKey);
+   return SymTable_insert(oSymTable, pcKey, uLength,
+                          SymTable_rehash(oSymTable, pcKey, uLength,
+                                          uHash),
+                          pvValue);
+}
+
+void *SymTable_getHashed(SymTable_T oSymTable, const char *pcKey,
+                         size_t uHash){
+   size_t uSlot;
+   size_t uLength;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   uLength = strlen(pcKey);
+   if (oSymTable->snapshot != NULL) {
+      return SymTable_getMapped(oSymTable, pcKey, uLength);
+   }
+   uSlot = SymTable_find(oSymTable, pcKey, uLength,
+      SymTable_rehash(oSymTable, pcKey, uLength, uHash), 1);
+   if (uSlot == oSymTable->slotCount) {
+      return NULL;
+   }
+   return (void*)oSymTable->slots[uSlot].value;
+}
+
+int SymTable_containsHashed(SymTable_T oSymTable, const char *pcKey,
+                            size_t uHash){
+   size_t uLength;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   uLength = strlen(pcKey);
+   if (oSymTable->snapshot != NULL) {
+      return Snapshot_find(oSymTable->snapshot, pcKey, uLength, NULL);
+   }
+   return SymTable_find(oSymTable, pcKey, uLength,
+      SymTable_rehash(oSymTable, pcKey, uLength, uHash), 1)
+      != oSymTable->slotCount;
+}
+
+void *SymTable_removeHashed(SymTable_T oSymTable, const char *pcKey,
+                            size_t uHash){
+   size_t uLength;
+
+   assert(oSymTable != NULL);
+   assert(pcKey != NULL);
+
+   uLength = strlen(pcKey);
+   return SymTable_delete(oSymTable, pcKey, uLength,
+      SymTable_rehash(oSymTable, pcKey, uLength, uHash));
+}
+
+void SymTable_getMany(SymTable_T oSymTable, const char *const apcKeys[],
+                      size_t uCount, void *apvValues[]){
+   size_t auHashes[BATCH_SIZE];
+   size_t auLengths[BATCH_SIZE];
+   size_t uStart;
+   size_t uBatch;
+   size_t uPos;
+   size_t uSlot;
+   size_t i;
+
+   assert(oSymTable != NULL);
+   assert(uCount == 0 || (apcKeys != NULL && apvValues != NULL));
+
+   if (oSymTable->snapshot != NULL) {
+      for (i = 0; i < uCount; i++) {
+         apvValues[i] = SymTable_getMapped(oSymTable, apcKeys[i],
+                                           strlen(apcKeys[i]));
+      }
+      return;
+   }
+   for (uStart = 0; uStart < uCount; uStart += uBatch) {
+      uBatch = uCount - uStart;
+      if (uBatch > BATCH_SIZE) {
+         uBatch = BATCH_SIZE;
+      }
+
+      /* hash every key of the batch and start loading the control
+      bytes and slots of its first group */
+      for (i = 0; i < uBatch; i++) {
+         assert(apcKeys[uStart + i] != NULL);
+         auLengths[i] = strlen(apcKeys[uStart + i]);
+         auHashes[i] = SymTable_hash(oSymTable, apcKeys[uStart + i],
+                                     auLengths[i]);
+         uPos = SymTable_group(auHashes[i], oSymTable->slotCount);
+         SYMTABLE_PREFETCH(oSymTable->ctrl + uPos);
+         SYMTABLE_PREFETCH(oSymTable->slots + uPos);
+      }
+
+      for (i = 0; i < uBatch; i++) {
+         uSlot = SymTable_find(oSymTable, apcKeys[uStart + i],
+                               auLengths[i], auHashes[i], 1);
+         apvValues[uStart + i] = (uSlot == oSymTable->slotCount)
+            ? NULL : (void*)oSymTable->slots[uSlot].value;
+      }
+   }
+}
+
+/* SymTable_mapUnits takes in a range of slot numbers [uBegin, uEnd)
+and a void pointer pvJob to a MapJob, and maps the bindings in those
+slots */
+static void SymTable_mapUnits(size_t uBegin, size_t uEnd, void *pvJob)
+{
+   struct MapJob *pJob = pvJob;
+   SymTable_T oSymTable = pJob->oSymTable;
+   size_t i;
+
+   for (i = uBegin; i < uEnd; i++) {
+      if ((oSymTable->ctrl[i] & 0x80) == 0)
+         (*pJob->pfApply)(oSymTable->slots[i].key,
+                          (void*)oSymTable->slots[i].value,
+                          (void*)pJob->pvExtra);
+   }
+}
+
+void SymTable_mapParallel(SymTable_T oSymTable,
+                          void (*pfApply)(const char *pcKey,
+                                          void *pvValue, void *pvExtra),
+                          const void *pvExtra, size_t uThreads){
+   struct MapJob sJob;
+
+   assert(oSymTable != NULL);
+   assert(pfApply != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      Snapshot_mapParallel(oSymTable->snapshot, pfApply, pvExtra,
+                           uThreads);
+      return;
+   }
+   sJob.oSymTable = oSymTable;
+   sJob.pfApply = pfApply;
+   sJob.pvExtra = pvExtra;
+   Parallel_forRange(oSymTable->slotCount, uThreads, SymTable_mapUnits,
+                     &sJob);
+}
+
+SymTableIter_T SymTable_iterBegin(SymTable_T oSymTable){
+   struct SymTableIter *pIter;
+
+   assert(oSymTable != NULL);
+
+   pIter = malloc(sizeof(struct SymTableIter));
+   if (pIter == NULL) {
+      return NULL;
+   }
+   pIter->oSymTable = oSymTable;
+   pIter->slot = 0;
+   pIter->returned = NULL;
+   pIter->newReturned = NULL;
+   pIter->snapshotIndex = 0;
+   pIter->nextIter = oSymTable->iters;
+   oSymTable->iters = pIter;
+   return pIter;
+}
+
+int SymTable_iterNext(SymTableIter_T oIter, const char **ppcKey,
+                      void **ppvValue){
+   SymTable_T oSymTable;
+   size_t uGroup;
+   size_t uSlot;
+   unsigned uFull;
+
+   assert(oIter != NULL);
+
+   oSymTable = oIter->oSymTable;
+   if (oSymTable->snapshot != NULL) {
+      if (oIter->snapshotIndex == Snapshot_getLength(oSymTable->snapshot)) {
+         return 0;
+      }
+      Snapshot_getBinding(oSymTable->snapshot, oIter->snapshotIndex++,
+                          ppcKey, NULL, ppvValue);
+      return 1;
+   }
+   while (oIter->slot < oSymTable->slotCount) {
+      /* a whole group of control bytes is checked at once, so empty
+      groups are skipped GROUP_WIDTH slots at a time */
+      uGroup = oIter->slot & ~(size_t)(GROUP_WIDTH - 1);
+      uFull = ~SymTable_matchFree(oSymTable->ctrl + uGroup) &
+              ((1U << GROUP_WIDTH) - 1) &
+              ~((1U << (oIter->slot - uGroup)) - 1);
+      if (uFull == 0) {
+         oIter->slot = uGroup + GROUP_WIDTH;
+         continue;
+      }
+      uSlot = uGroup + SymTable_lowestBit(uFull);
+      oIter->slot = uSlot + 1;
+      if (SymTable_isMarked(oIter->returned, uSlot))
+         continue;
+      if (ppcKey != NULL) {
+         *ppcKey = oSymTable->slots[uSlot].key;
+      }
+      if (ppvValue != NULL) {
+         *ppvValue = (void*)oSymTable->slots[uSlot].value;
+      }
+      return 1;
+   }
+   return 0;
+}
+
+void SymTable_iterEnd(SymTableIter_T oIter){
+   struct SymTableIter **ppIter;
+
+   assert(oIter != NULL);
+
+   for (ppIter = &oIter->oSymTable->iters; *ppIter != oIter;
+        ppIter = &(*ppIter)->nextIter) {
+      assert(*ppIter != NULL);
+   }
+   *ppIter = oIter->nextIter;
+   free(oIter->returned);
+   free(oIter);
+}
+
+void SymTable_mapRange(SymTable_T oSymTable, const char *pcLow,
+                       const char *pcHigh,
+                       void (*pfApply)(const char *pcKey,
+                                       void *pvValue, void *pvExtra),
+                       const void *pvExtra){
+   struct KeyBounds sBounds;
+
+   assert(oSymTable != NULL);
+   assert(pfApply != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      Snapshot_mapRange(oSymTable->snapshot, pcLow, pcHigh, pfApply,
+                        pvExtra);
+      return;
+   }
+   sBounds.low = pcLow;
+   sBounds.lowLength = (pcLow != NULL) ? strlen(pcLow) : 0;
+   sBounds.high = pcHigh;
+   sBounds.highLength = (pcHigh != NULL) ? strlen(pcHigh) : 0;
+   sBounds.prefix = NULL;
+   sBounds.prefixLength = 0;
+   SymTable_mapBounded(oSymTable, &sBounds, pfApply, pvExtra);
+}
+
+void SymTable_mapPrefix(SymTable_T oSymTable, const char *pcPrefix,
+                        void (*pfApply)(const char *pcKey,
+                                        void *pvValue, void *pvExtra),
+                        const void *pvExtra){
+   struct KeyBounds sBounds;
+
+   assert(oSymTable != NULL);
+   assert(pcPrefix != NULL);
+   assert(pfApply != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      Snapshot_mapPrefix(oSymTable->snapshot, pcPrefix, pfApply,
+                         pvExtra);
+      return;
+   }
+   sBounds.low = NULL;
+   sBounds.lowLength = 0;
+   sBounds.high = NULL;
+   sBounds.highLength = 0;
+   sBounds.prefix = pcPrefix;
+   sBounds.prefixLength = strlen(pcPrefix);
+   SymTable_mapBounded(oSymTable, &sBounds, pfApply, pvExtra);
+}
+
+int SymTable_save(SymTable_T oSymTable, const char *pcPath,
+                  size_t uValueSize){
+   SnapshotWriter_T oWriter;
+   size_t i;
+
+   assert(oSymTable != NULL);
+   assert(pcPath != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      return Snapshot_save(oSymTable->snapshot, pcPath, uValueSize);
+   }
+   oWriter = SnapshotWriter_new(uValueSize);
+   if (oWriter == NULL) {
+      return 0;
+   }
+   for (i = 0; i < oSymTable->slotCount; i++) {
+      if ((oSymTable->ctrl[i] & 0x80) != 0)
+         continue;
+      if (!SnapshotWriter_add(oWriter, oSymTable->slots[i].key,
+                              SymTable_keyLength(oSymTable->slots[i].key),
+                              oSymTable->slots[i].value)) {
+         SnapshotWriter_free(oWriter);
+         return 0;
+      }
+   }
+   return SnapshotWriter_finish(oWriter, pcPath);
+}
+
+SymTable_T SymTable_openMapped(const char *pcPath){
+   SymTable_T oSymTable;
+
+   assert(pcPath != NULL);
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL) {
+      return NULL;
+   }
+   oSymTable->snapshot = Snapshot_open(pcPath);
+   if (oSymTable->snapshot == NULL) {
+      SymTable_free(oSymTable);
+      return NULL;
+   }
+   oSymTable->allocCount++;
+   return oSymTable;
+}
+
+SymTable_T SymTable_newWithCapacity(size_t uCapacity){
+   SymTable_T oSymTable;
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL) {
+      return NULL;
+   }
+   if (! SymTable_reserve(oSymTable, uCapacity)) {
+      SymTable_free(oSymTable);
+      return NULL;
+   }
+   return oSymTable;
+}
+
+int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity){
+   size_t uNewCount;
+
+   assert(oSymTable != NULL);
+
+   if (oSymTable->snapshot != NULL) {
+      return 0;
+   }
+   if (uCapacity <= oSymTable->bindingsSize) {
+      return 1;
+   }
+   /* the fewest slots (a power of two) whose max load holds
+   uCapacity bindings */
+   uNewCount = oSymTable->slotCount;
+   while (SymTable_maxUsed(oSymTable, uNewCount) < uCapacity) {
+      if (uNewCount > (size_t)-1 / 2 / sizeof(struct Slot)) {
+         return 0;
+      }
+      uNewCount *= 2;
+   }
+   /* DELETED slots use up growth too, so a SymTable with enough slots
+   may still have to be rebuilt to clear them out. The keys are copied
+   into the arena in sizes only known at each put, so nothing is
+   reserved there. */
+   if ((uNewCount != oSymTable->slotCount ||
+        oSymTable->growthLeft < uCapacity - oSymTable->bindingsSize) &&
+       ! SymTable_resize(oSymTable, uNewCount)) {
+      return 0;
+   }
+   /* removes do not shrink the SymTable below what was reserved */
+   if (uNewCount > oSymTable->minSlotCount) {
+      oSymTable->minSlotCount = uNewCount;
+      SymTable_setShrinkAt(oSymTable);
+   }
+   return 1;
+}
+
+int SymTable_compact(SymTable_T oSymTable){
+   struct SymTable oldTable;
+   struct KeyCopy *defCopy;
+   size_t uNewCount;
+   size_t uCopySize;
+   size_t uHash;
+   size_t uSlot;
+   size_t i;
+
+   assert(oSymTable != NULL);
+
+   /* the iterators hand out the keys that are about to move */
+   if (oSymTable->snapshot != NULL || oSymTable->iters != NULL) {
+      return 0;
+   }
+   uNewCount = SymTable_fitSlotCount(oSymTable,
+                                     2 * oSymTable->bindingsSize);
+   if (uNewCount > oSymTable->slotCount) {
+      uNewCount = oSymTable->slotCount;
+   }
+   oldTable = *oSymTable;
+   if (! SymTable_alloc(oSymTable, uNewCount)) {
+      *oSymTable = oldTable;
+      return 0;
+   }
+   oSymTable->arena = Arena_new();
+   if (oSymTable->arena == NULL) {
+      free(oSymTable->ctrl);
+      free(oSymTable->slots);
+      *oSymTable = oldTable;
+      return 0;
+   }
+
+   /* every KeyCopy is copied into the new arena in slot order, and
+   the DELETED slots are left behind */
+   for (i = 0; i < oldTable.slotCount; i++) {
+      if ((oldTable.ctrl[i] & 0x80) != 0)
+         continue;
+      uCopySize = offsetof(struct KeyCopy, string) +
+                  SymTable_keyLength(oldTable.slots[i].key) + 1;
+      defCopy = Arena_alloc(oSymTable->arena, uCopySize);
+      if (defCopy == NULL) {
+         Arena_free(oSymTable->arena);
+         free(oSymTable->ctrl);
+         free(oSymTable->slots);
+         *oSymTable = oldTable;
+         return 0;
+      }
+      memcpy(defCopy, oldTable.slots[i].key -
+                      offsetof(struct KeyCopy, string), uCopySize);
+      uHash = SymTable_hash(oSymTable, defCopy->string,
+                            defCopy->length);
+      uSlot = SymTable_findFree(oSymTable->ctrl, uNewCount, uHash);
+      oSymTable->ctrl[uSlot] = SymTable_tag(uHash);
+      oSymTable->slots[uSlot].key = defCopy->string;
+      oSymTable->slots[uSlot].value = oldTable.slots[i].value;
+   }
+   oSymTable->growthLeft -= oldTable.bindingsSize;
+   oSymTable->rehashCount += oldTable.bindingsSize;
+   oSymTable->allocCount += Arena_getAllocCount(oldTable.arena);
+   oSymTable->minSlotCount = slotMin;
+   SymTable_setShrinkAt(oSymTable);
+
+   Arena_free(oldTable.arena);
+   free(oldTable.ctrl);
+   free(oldTable.slots);
+   return 1;
+}
+
+SymTable_T SymTable_newWithStats(enum SymTableHash eHash){
+   SymTable_T oSymTable;
+
+   oSymTable = SymTable_newWithOptions(eHash);
+   if (oSymTable == NULL) {
+      return NULL;
+   }
+   oSymTable->stats = malloc(sizeof(struct Stats));
+   if (oSymTable->stats == NULL) {
+      SymTable_free(oSymTable);
+      return NULL;
+   }
+   oSymTable->allocCount++;
+   Stats_init(oSymTable->stats);
+   return oSymTable;
+}
+
+/* SymTable_probeLength takes in a full hash uHash, a slot count
+uSlotCount and the index uSlot of a slot on the probe sequence of
+uHash, and returns how many groups are probed to reach uSlot */
+static size_t SymTable_probeLength(size_t uHash, size_t uSlotCount,
+                                   size_t uSlot)
+{
+   size_t uMask = uSlotCount - 1;
+   size_t uPos = SymTable_group(uHash, uSlotCount);
+   size_t uStride = 0;
+
+   /* groups start at multiples of GROUP_WIDTH */
+   while (uPos != (uSlot & ~(size_t)(GROUP_WIDTH - 1))) {
+      uStride += GROUP_WIDTH;
+      uPos = (uPos + uStride) & uMask;
+   }
+   return uStride / GROUP_WIDTH + 1;
+}
+
+int SymTable_getStats(SymTable_T oSymTable,
+                      struct SymTableStats *psStats){
+   const char *pcKey;
+   size_t uHash;
+   size_t i;
+
+   assert(oSymTable != NULL);
+   assert(psStats != NULL);
+
+   Stats_clear(psStats);
+   psStats->allocCount = SymTable_getAllocCount(oSymTable);
+   psStats->bytes = SymTable_getBytes(oSymTable);
+   if (oSymTable->snapshot == NULL) {
+      psStats->bucketCount = oSymTable->slotCount;
+      psStats->load = (double)oSymTable->bindingsSize /
+                      (double)oSymTable->slotCount;
+      /* a binding's chain is how far along its probe sequence it
+      sits, which needs its hash again */
+      for (i = 0; i < oSymTable->slotCount; i++) {
+         if ((oSymTable->ctrl[i] & 0x80) != 0)
+            continue;
+         pcKey = oSymTable->slots[i].key;
+         uHash = SymTable_hash(oSymTable, pcKey,
+                               SymTable_keyLength(pcKey));
+         Stats_addChain(psStats, SymTable_probeLength(uHash,
+            oSymTable->slotCount, i));
+      }
+   }
+   if (oSymTable->stats == NULL) {
+      return 0;
+   }
+   Stats_report(oSymTable->stats, psStats);
+   return 1;
+}
@@ -0,0 +1,221 @@
+/* symtable parallel implementation */
+#include "symtableparallel.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <stddef.h>
+
+/* how many units a worker takes from the front of its own range at a
+time. Small enough to leave thieves something, big enough that the
+worker's lock is not taken for every unit. */
+enum {PARALLEL_CHUNK = 64};
+
+/* the size of a cache line, which Workers are padded to so that two
+workers never share one */
+enum {CACHE_LINE = 64};
+
+struct Job;
+
+/* Worker is one thread of the pool and the range of units that it
+still has to do */
+struct Worker {
+    /* held while begin and end are read or changed */
+    pthread_mutex_t lock;
+    /* the next unit the worker does itself */
+    size_t begin;
+    /* one past the last unit of the range. Thieves take from here. */
+    size_t end;
+    /* the call of Parallel_forRange the worker is part of */
+    struct Job *job;
+    /* the thread of the worker, unless it is the calling thread */
+    pthread_t thread;
+    /* 1 if thread was started and must be joined */
+    int started;
+    /* keeps the next Worker off this one's cache line */
+    char padding[CACHE_LINE];
+};
+
+/* Job is one call of Parallel_forRange: the function its units are
+passed to and the workers that share them */
+struct Job {
+    /* the function that does a range of units */
+    void (*pfRange)(size_t uBegin, size_t uEnd, void *pvContext);
+    /* passed on to pfRange */
+    void *pvContext;
+    /* array of workerCount Workers */
+    struct Worker *workers;
+    /* holds how many Workers there are */
+    size_t workerCount;
+};
+
+/* Parallel_take takes in a Worker pWorker and takes up to
+PARALLEL_CHUNK units off the front of its range, setting *puBegin and
+*puEnd to them. It returns 1, or 0 if the range is empty. */
+static int Parallel_take(struct Worker *pWorker, size_t *puBegin,
+                         size_t *puEnd)
+{
+   int iTaken = 0;
+
+   pthread_mutex_lock(&pWorker->lock);
+   if (pWorker->begin < pWorker->end) {
+      *puBegin = pWorker->begin;
+      if (pWorker->end - pWorker->begin > PARALLEL_CHUNK) {
+         *puEnd = pWorker->begin + PARALLEL_CHUNK;
+      } else {
+         *puEnd = pWorker->end;
+      }
+      pWorker->begin = *puEnd;
+      iTaken = 1;
+   }
+   pthread_mutex_unlock(&pWorker->lock);
+   return iTaken;
+}
+
+/* Parallel_steal takes in a Worker pThief whose range is empty, finds
+the other worker with the most units left and moves the back half of
+its range (at least one unit) to pThief. It returns 1, or 0 if every
+other range is empty. No two locks are ever held at once. */
+static int Parallel_steal(struct Worker *pThief)
+{
+   struct Job *pJob = pThief->job;
+   struct Worker *pVictim;
+   size_t uMost;
+   size_t uLeft;
+   size_t uMiddle;
+   size_t uEnd;
+   size_t i;
+
+   for (;;) {
+      pVictim = NULL;
+      uMost = 0;
+      for (i = 0; i < pJob->workerCount; i++) {
+         if (&pJob->workers[i] == pThief) {
+            continue;
+         }
+         pthread_mutex_lock(&pJob->workers[i].lock);
+         uLeft = pJob->workers[i].end - pJob->workers[i].begin;
+         pthread_mutex_unlock(&pJob->workers[i].lock);
+         if (uLeft > uMost) {
+            uMost = uLeft;
+            pVictim = &pJob->workers[i];
+         }
+      }
+      if (pVictim == NULL) {
+         return 0;
+      }
+
+      pthread_mutex_lock(&pVictim->lock);
+      uLeft = pVictim->end - pVictim->begin;
+      if (uLeft == 0) {
+         /* emptied since it was looked at, so look again */
+         pthread_mutex_unlock(&pVictim->lock);
+         continue;
+      }
+      uMiddle = pVictim->begin + uLeft / 2;
+      uEnd = pVictim->end;
+      pVictim->end = uMiddle;
+      pthread_mutex_unlock(&pVictim->lock);
+
+      pthread_mutex_lock(&pThief->lock);
+      pThief->begin = uMiddle;
+      pThief->end = uEnd;
+      pthread_mutex_unlock(&pThief->lock);
+      return 1;
+   }
+}
+
+/* Parallel_work takes in a Worker pWorker and does units, its own
+first and then stolen ones, until there are none left anywhere */
+static void Parallel_work(struct Worker *pWorker)
+{
+   struct Job *pJob = pWorker->job;
+   size_t uBegin;
+   size_t uEnd;
+
+   do {
+      while (Parallel_take(pWorker, &uBegin, &uEnd)) {
+         (*pJob->pfRange)(uBegin, uEnd, pJob->pvContext);
+      }
+   } while (Parallel_steal(pWorker));
+}
+
+/* Parallel_thread is the start routine of a pool thread. It takes in
+a void pointer pvWorker to its Worker. */
+static void *Parallel_thread(void *pvWorker)
+{
+   Parallel_work(pvWorker);
+   return NULL;
+}
+
+void Parallel_forRange(size_t uCount, size_t uThreads,
+                       void (*pfRange)(size_t uBegin, size_t uEnd,
+                                       void *pvContext),
+                       void *pvContext)
+{
+   struct Job sJob;
+   struct Worker *pWorker;
+   size_t i;
+
+   assert(pfRange != NULL);
+
+   /* more threads than chunks would have nothing to do */
+   if (uThreads > uCount / PARALLEL_CHUNK + 1) {
+      uThreads = uCount / PARALLEL_CHUNK + 1;
+   }
+   if (uThreads <= 1) {
+      if (uCount > 0) {
+         (*pfRange)(0, uCount, pvContext);
+      }
+      return;
+   }
+
+   sJob.pfRange = pfRange;
+   sJob.pvContext = pvContext;
+   sJob.workerCount = uThreads;
+   sJob.workers = calloc(uThreads, sizeof(struct Worker));
+   if (sJob.workers == NULL) {
+      (*pfRange)(0, uCount, pvContext);
+      return;
+   }
+   for (i = 0; i < uThreads; i++) {
+      pWorker = &sJob.workers[i];
+      if (pthread_mutex_init(&pWorker->lock, NULL) != 0) {
+         break;
+      }
+      /* worker i gets the i-th of uThreads nearly equal ranges */
+      pWorker->begin = uCount / uThreads * i +
+                       (i < uCount % uThreads ? i : uCount % uThreads);
+      pWorker->end = pWorker->begin + uCount / uThreads +
+                     (i < uCount % uThreads ? 1 : 0);
+      pWorker->job = &sJob;
+      pWorker->started = 0;
+   }
+   if (i < uThreads) {
+      while (i > 0) {
+         i--;
+         pthread_mutex_destroy(&sJob.workers[i].lock);
+      }
+      free(sJob.workers);
+      (*pfRange)(0, uCount, pvContext);
+      return;
+   }
+
+   /* a worker whose thread cannot be started has its range stolen by
+   the others, so no unit is lost */
+   for (i = 1; i < uThreads; i++) {
+      pWorker = &sJob.workers[i];
+      pWorker->started = (pthread_create(&pWorker->thread, NULL,
+                                         Parallel_thread, pWorker) == 0);
+   }
+   Parallel_work(&sJob.workers[0]);
+   for (i = 1; i < uThreads; i++) {
+      if (sJob.workers[i].started) {
+         pthread_join(sJob.workers[i].thread, NULL);
+      }
+   }
+
+   for (i = 0; i < uThreads; i++) {
+      pthread_mutex_destroy(&sJob.workers[i].lock);
+   }
+   free(sJob.workers);
+}
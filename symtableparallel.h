@@ -0,0 +1,26 @@
+/* symtable parallel header file */
+#include <stddef.h>
+#ifndef SYMTABLEPARALLEL_INCLUDED
+#define SYMTABLEPARALLEL_INCLUDED
+
+/* Parallel_forRange runs the units of work numbered 0 to uCount - 1
+on a pool of threads, for SymTable_mapParallel. The units are dealt
+out evenly in contiguous ranges, one per thread. A thread works
+through its own range a few units at a time from the front, and once
+it runs out it steals the back half of the largest range left, so
+ranges whose units happen to be slow (long chains) are shared out
+instead of holding everyone up. */
+
+/* Parallel_forRange takes in a unit count uCount, a thread count
+uThreads, a function pfRange and a void pointer pvContext. It calls
+(*pfRange)(uBegin, uEnd, pvContext) on disjoint ranges of units
+[uBegin, uEnd) that together cover [0, uCount), from up to uThreads
+threads at once (the calling thread is one of them), and returns once
+every unit is done. If threads cannot be created, the threads that
+could be (at least the calling thread) do all the work. */
+void Parallel_forRange(size_t uCount, size_t uThreads,
+                       void (*pfRange)(size_t uBegin, size_t uEnd,
+                                       void *pvContext),
+                       void *pvContext);
+
+#endif
@@ -0,0 +1,903 @@
+/* symtable snapshot implementation */
+#define _POSIX_C_SOURCE 200112L
+#include "symtablesnapshot.h"
+#include "symtablekeyhash.h"
+#include "symtableparallel.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* the version of the file format. Bump it whenever the layout of the
+file changes. */
+enum {SNAPSHOT_VERSION = 1};
+
+/* the version of the hash function the buckets were built with:
+1 is KeyHash_fast with snapshotSeed. Bump it whenever either changes,
+since a file hashed one way cannot be searched the other. */
+enum {SNAPSHOT_HASH_VERSION = 1};
+
+/* the first eight bytes of every snapshot */
+static const char acSnapshotMagic[8] = {'S', 'Y', 'M', 'T',
+                                        'S', 'N', 'A', 'P'};
+
+/* written as a native integer, so a file from a machine with another
+byte order is recognized and refused */
+#define SNAPSHOT_BYTE_ORDER ((uint64_t)0x0102030405060708ULL)
+
+/* how many bytes a temporary file's name may add to the name of the
+snapshot: a '.', a process number, a '.', a counter and ".tmp" */
+enum {SNAPSHOT_TEMP_EXTRA = 48};
+
+/* how many names SnapshotWriter_finish tries for a temporary file
+before it gives up */
+enum {SNAPSHOT_TEMP_TRIES = 100};
+
+/* the value offset of a record whose value is NULL */
+#define SNAPSHOT_NO_VALUE ((uint64_t)-1)
+
+/* the fixed seed of KeyHash_fast for snapshots, so a file hashed by
+one process can be searched by the next */
+static const struct KeyHashSeed snapshotSeed = {
+   0x5f3759df9e3779b9ULL, 0xc2b2ae3d27d4eb4fULL};
+
+/* SnapshotHeader starts every snapshot. Every field after the magic
+number is a native integer, and every section starts at a multiple of
+8 bytes from the start of the file. */
+struct SnapshotHeader {
+    /* acSnapshotMagic */
+    char magic[8];
+    /* SNAPSHOT_VERSION */
+    uint32_t version;
+    /* SNAPSHOT_HASH_VERSION */
+    uint32_t hashVersion;
+    /* SNAPSHOT_BYTE_ORDER */
+    uint64_t byteOrder;
+    /* how many bits the hashes have, which is the width of size_t */
+    uint64_t hashBits;
+    /* how many bindings there are */
+    uint64_t count;
+    /* how many buckets there are, a power of two */
+    uint64_t bucketCount;
+    /* how many bytes of each non-NULL value were saved */
+    uint64_t valueSize;
+    /* where the bucketCount + 1 bucket starts are */
+    uint64_t bucketsOffset;
+    /* where the count SnapshotEntries are */
+    uint64_t entriesOffset;
+    /* where the count SnapshotRecords are */
+    uint64_t recordsOffset;
+    /* where the keys are */
+    uint64_t keysOffset;
+    /* where the values are */
+    uint64_t valuesOffset;
+    /* how many bytes the whole file has */
+    uint64_t fileSize;
+};
+
+/* SnapshotEntry is one binding in the bucket array. Bucket b holds
+the entries from bucket start b up to bucket start b + 1. */
+struct SnapshotEntry {
+    /* the full hash of the key, checked before the key is compared */
+    uint64_t hash;
+    /* the number of the binding's SnapshotRecord */
+    uint64_t record;
+};
+
+/* SnapshotRecord is one binding. The records are in ascending order
+of key. */
+struct SnapshotRecord {
+    /* where the key starts, from the start of the keys */
+    uint64_t keyOffset;
+    /* how many bytes the key has, not counting the '\0' after it */
+    uint64_t keyLength;
+    /* where the value starts, from the start of the values, or
+    SNAPSHOT_NO_VALUE for a NULL value */
+    uint64_t valueOffset;
+};
+
+/* Snapshot is a mapped snapshot file and where its sections are */
+struct Snapshot {
+    /* the start of the mapping */
+    void *base;
+    /* how many bytes are mapped */
+    size_t size;
+    /* how many bindings there are */
+    size_t count;
+    /* the bucket count minus one */
+    size_t bucketMask;
+    /* how many bytes of each value were saved */
+    size_t valueSize;
+    /* the bucket starts */
+    const uint64_t *buckets;
+    /* the bucket array */
+    const struct SnapshotEntry *entries;
+    /* the records, in ascending order of key */
+    const struct SnapshotRecord *records;
+    /* the keys */
+    const char *keys;
+    /* the values */
+    const unsigned char *values;
+};
+
+/* WriterRecord is a binding added to a SnapshotWriter */
+struct WriterRecord {
+    /* the key, once every binding has been added */
+    const char *key;
+    /* where the key starts in the writer's keys */
+    size_t keyOffset;
+    /* how many bytes the key has */
+    size_t keyLength;
+    /* where the value starts in the writer's values, or
+    SNAPSHOT_NO_VALUE */
+    uint64_t valueOffset;
+};
+
+/* SnapshotWriter holds copies of the bindings added so far */
+struct SnapshotWriter {
+    /* how many bytes of each value are saved */
+    size_t valueSize;
+    /* the value size rounded up to a multiple of 8 */
+    size_t valueStride;
+    /* the bindings, in the order they were added */
+    struct WriterRecord *records;
+    /* how many bindings have been added */
+    size_t count;
+    /* how many records there is room for */
+    size_t capacity;
+    /* every key added, each followed by a '\0' */
+    char *keys;
+    /* how many bytes of keys are in use */
+    size_t keyBytes;
+    /* how many bytes of keys there is room for */
+    size_t keyCapacity;
+    /* every non-NULL value added, valueStride bytes apart */
+    unsigned char *values;
+    /* how many bytes of values are in use */
+    size_t valueBytes;
+    /* how many bytes of values there is room for */
+    size_t valueCapacity;
+};
+
+/* SnapshotMapJob is what the threads of Snapshot_mapParallel share */
+struct SnapshotMapJob {
+    /* the Snapshot being mapped */
+    Snapshot_T snapshot;
+    /* the function to apply */
+    void (*apply)(const char *pcKey, void *pvValue, void *pvExtra);
+    /* the extra argument to apply */
+    void *extra;
+};
+
+/* Snapshot_compare takes in keys pcA of uALength bytes and pcB of
+uBLength bytes and returns a negative number, 0 or a positive number
+as pcA is less than, equal to or greater than pcB: bytes compare as
+unsigned chars, and a key sorts before every longer key it starts */
+static int Snapshot_compare(const char *pcA, size_t uALength,
+                            const char *pcB, size_t uBLength)
+{
+   int iCompare;
+
+   iCompare = memcmp(pcA, pcB, uALength < uBLength ? uALength : uBLength);
+   if (iCompare != 0)
+      return iCompare;
+   if (uALength < uBLength)
+      return -1;
+   return uALength > uBLength;
+}
+
+/* Snapshot_compareRecords takes in pointers pvA and pvB to two
+WriterRecords and compares their keys for qsort */
+static int Snapshot_compareRecords(const void *pvA, const void *pvB)
+{
+   const struct WriterRecord *psA = pvA;
+   const struct WriterRecord *psB = pvB;
+
+   return Snapshot_compare(psA->key, psA->keyLength,
+                           psB->key, psB->keyLength);
+}
+
+/* Snapshot_grow takes in a pointer ppvBlock to a malloc'd block, a
+pointer puCapacity to how many units it has room for, the size uUnit
+of a unit and how many units uNeeded it must hold. It doubles the
+block until they fit and returns 1, or 0 if there is insufficient
+memory (leaving the block as it was). */
+static int Snapshot_grow(void **ppvBlock, size_t *puCapacity,
+                         size_t uUnit, size_t uNeeded)
+{
+   size_t uCapacity = *puCapacity;
+   void *pvBlock;
+
+   if (uNeeded <= uCapacity)
+      return 1;
+   if (uCapacity == 0)
+      uCapacity = 64;
+   while (uCapacity < uNeeded) {
+      if (uCapacity > ((size_t)-1) / 2 / uUnit)
+         return 0;
+      uCapacity *= 2;
+   }
+   pvBlock = realloc(*ppvBlock, uCapacity * uUnit);
+   if (pvBlock == NULL)
+      return 0;
+   *ppvBlock = pvBlock;
+   *puCapacity = uCapacity;
+   return 1;
+}
+
+/* Snapshot_createTemp takes in a const char pointer pcPath and a
+buffer pcTemp with room for pcPath and SNAPSHOT_TEMP_EXTRA more bytes.
+It creates a file, named in pcTemp, beside pcPath that no other save
+in this or any other process is using, and returns its descriptor, or
+-1 if it cannot be created. The file gets mode 0666 less the umask,
+as fopen would give it. */
+static int Snapshot_createTemp(const char *pcPath, char *pcTemp)
+{
+   static unsigned long ulTempCount = 0;
+   unsigned long ulCount;
+   int iFd;
+   int i;
+
+   for (i = 0; i < SNAPSHOT_TEMP_TRIES; i++) {
+      ulCount = __atomic_add_fetch(&ulTempCount, 1, __ATOMIC_RELAXED);
+      sprintf(pcTemp, "%s.%lu.%lu.tmp", pcPath,
+              (unsigned long)getpid(), ulCount);
+      iFd = open(pcTemp, O_WRONLY | O_CREAT | O_EXCL, 0666);
+      /* a name left behind by a save that crashed is skipped */
+      if (iFd >= 0 || errno != EEXIST)
+         return iFd;
+   }
+   return -1;
+}
+
+SnapshotWriter_T SnapshotWriter_new(size_t uValueSize){
+   SnapshotWriter_T oWriter;
+
+   oWriter = calloc(1, sizeof(struct SnapshotWriter));
+   if (oWriter == NULL)
+      return NULL;
+   oWriter->valueSize = uValueSize;
+   oWriter->valueStride = (uValueSize + 7) & ~(size_t)7;
+   return oWriter;
+}
+
+int SnapshotWriter_add(SnapshotWriter_T oWriter, const char *pcKey,
+                       size_t uLength, const void *pvValue){
+   struct WriterRecord *psRecord;
+   void *pvBlock;
+
+   assert(oWriter != NULL);
+   assert(pcKey != NULL || uLength == 0);
+
+   if (uLength >= ((size_t)-1) - oWriter->keyBytes)
+      return 0;
+   pvBlock = oWriter->records;
+   if (!Snapshot_grow(&pvBlock, &oWriter->capacity,
+                      sizeof(struct WriterRecord), oWriter->count + 1))
+      return 0;
+   oWriter->records = pvBlock;
+   pvBlock = oWriter->keys;
+   if (!Snapshot_grow(&pvBlock, &oWriter->keyCapacity, 1,
+                      oWriter->keyBytes + uLength + 1))
+      return 0;
+   oWriter->keys = pvBlock;
+   psRecord = &oWriter->records[oWriter->count];
+   psRecord->valueOffset = SNAPSHOT_NO_VALUE;
+   if (pvValue != NULL) {
+      pvBlock = oWriter->values;
+      if (!Snapshot_grow(&pvBlock, &oWriter->valueCapacity, 1,
+                         oWriter->valueBytes + oWriter->valueStride))
+         return 0;
+      oWriter->values = pvBlock;
+      memset(oWriter->values + oWriter->valueBytes, 0,
+             oWriter->valueStride);
+      if (oWriter->valueSize != 0)
+         memcpy(oWriter->values + oWriter->valueBytes, pvValue,
+                oWriter->valueSize);
+      psRecord->valueOffset = oWriter->valueBytes;
+      oWriter->valueBytes += oWriter->valueStride;
+   }
+
+   if (uLength != 0)
+      memcpy(oWriter->keys + oWriter->keyBytes, pcKey, uLength);
+   oWriter->keys[oWriter->keyBytes + uLength] = '\0';
+   psRecord->keyOffset = oWriter->keyBytes;
+   psRecord->keyLength = uLength;
+   oWriter->keyBytes += uLength + 1;
+   oWriter->count++;
+   return 1;
+}
+
+void SnapshotWriter_free(SnapshotWriter_T oWriter){
+   if (oWriter == NULL)
+      return;
+   free(oWriter->records);
+   free(oWriter->keys);
+   free(oWriter->values);
+   free(oWriter);
+}
+
+/* SnapshotWriter_write takes in a SnapshotWriter oWriter whose records
+are sorted, bucket starts puStarts and the bucket array psEntries for
+its bucket count uBucketCount, and an open file psFile, and writes the
+snapshot to psFile. It returns 1, or 0 if writing failed. */
+static int SnapshotWriter_write(SnapshotWriter_T oWriter,
+                                const uint64_t *puStarts,
+                                const struct SnapshotEntry *psEntries,
+                                size_t uBucketCount, FILE *psFile)
+{
+   static const char acPadding[8] = {0};
+   struct SnapshotHeader sHeader;
+   struct SnapshotRecord sRecord;
+   const struct WriterRecord *psRecord;
+   uint64_t uValueBytes = 0;
+   size_t u;
+
+   memset(&sHeader, 0, sizeof(sHeader));
+   memcpy(sHeader.magic, acSnapshotMagic, sizeof(sHeader.magic));
+   sHeader.version = SNAPSHOT_VERSION;
+   sHeader.hashVersion = SNAPSHOT_HASH_VERSION;
+   sHeader.byteOrder = SNAPSHOT_BYTE_ORDER;
+   sHeader.hashBits = sizeof(size_t) * CHAR_BIT;
+   sHeader.count = oWriter->count;
+   sHeader.bucketCount = uBucketCount;
+   sHeader.valueSize = oWriter->valueSize;
+   sHeader.bucketsOffset = sizeof(struct SnapshotHeader);
+   sHeader.entriesOffset = sHeader.bucketsOffset +
+      ((uint64_t)uBucketCount + 1) * sizeof(uint64_t);
+   sHeader.recordsOffset = sHeader.entriesOffset +
+      (uint64_t)oWriter->count * sizeof(struct SnapshotEntry);
+   sHeader.keysOffset = sHeader.recordsOffset +
+      (uint64_t)oWriter->count * sizeof(struct SnapshotRecord);
+   sHeader.valuesOffset = (sHeader.keysOffset + oWriter->keyBytes + 7) &
+      ~(uint64_t)7;
+   sHeader.fileSize = sHeader.valuesOffset + oWriter->valueBytes;
+
+   if (fwrite(&sHeader, sizeof(sHeader), 1, psFile) != 1 ||
+       fwrite(puStarts, sizeof(uint64_t), uBucketCount + 1, psFile) !=
+          uBucketCount + 1 ||
+       fwrite(psEntries, sizeof(struct SnapshotEntry), oWriter->count,
+              psFile) != oWriter->count)
+      return 0;
+
+   /* the keys and values are written in order of key too, so a range
+   scan reads the mapping front to back */
+   sRecord.keyOffset = 0;
+   for (u = 0; u < oWriter->count; u++) {
+      psRecord = &oWriter->records[u];
+      sRecord.keyLength = psRecord->keyLength;
+      sRecord.valueOffset = SNAPSHOT_NO_VALUE;
+      if (psRecord->valueOffset != SNAPSHOT_NO_VALUE) {
+         sRecord.valueOffset = uValueBytes;
+         uValueBytes += oWriter->valueStride;
+      }
+      if (fwrite(&sRecord, sizeof(sRecord), 1, psFile) != 1)
+         return 0;
+      sRecord.keyOffset += psRecord->keyLength + 1;
+   }
+   for (u = 0; u < oWriter->count; u++) {
+      psRecord = &oWriter->records[u];
+      if (fwrite(psRecord->key, 1, psRecord->keyLength + 1, psFile) !=
+          psRecord->keyLength + 1)
+         return 0;
+   }
+   u = (size_t)(sHeader.valuesOffset - sHeader.keysOffset -
+                oWriter->keyBytes);
+   if (u != 0 && fwrite(acPadding, 1, u, psFile) != u)
+      return 0;
+   for (u = 0; u < oWriter->count; u++) {
+      psRecord = &oWriter->records[u];
+      if (psRecord->valueOffset != SNAPSHOT_NO_VALUE &&
+          fwrite(oWriter->values + psRecord->valueOffset, 1,
+                 oWriter->valueStride, psFile) != oWriter->valueStride)
+         return 0;
+   }
+   return 1;
+}
+
+/* SnapshotWriter_sortBuckets takes in a SnapshotWriter oWriter whose
+records are sorted, an array puStarts of uBucketCount + 1 zeros,
+arrays puNext of uBucketCount and puHashes of oWriter's count, and an
+array psEntries with room for every binding. It fills puStarts with
+each bucket's start and psEntries with the bucket array. */
+static void SnapshotWriter_sortBuckets(SnapshotWriter_T oWriter,
+                                       uint64_t *puStarts,
+                                       uint64_t *puNext,
+                                       size_t *puHashes,
+                                       struct SnapshotEntry *psEntries,
+                                       size_t uBucketCount)
+{
+   size_t uBucket;
+   size_t u;
+
+   /* a counting sort by bucket: count each bucket's entries, turn the
+   counts into starts, then drop each entry into place */
+   for (u = 0; u < oWriter->count; u++) {
+      puHashes[u] = KeyHash_fast(oWriter->records[u].key,
+                                 oWriter->records[u].keyLength,
+                                 &snapshotSeed);
+      puStarts[(puHashes[u] & (uBucketCount - 1)) + 1]++;
+   }
+   for (u = 0; u < uBucketCount; u++)
+      puStarts[u + 1] += puStarts[u];
+   memcpy(puNext, puStarts, uBucketCount * sizeof(uint64_t));
+   for (u = 0; u < oWriter->count; u++) {
+      uBucket = puHashes[u] & (uBucketCount - 1);
+      psEntries[puNext[uBucket]].hash = puHashes[u];
+      psEntries[puNext[uBucket]].record = u;
+      puNext[uBucket]++;
+   }
+}
+
+/* Snapshot_discardTemp takes in the temporary file pcTemp of a save
+that failed, open as psFile or (if psFile is NULL) as the descriptor
+iFd, or closed already if both are NULL and -1. It closes and removes
+the file and returns 0. */
+static int Snapshot_discardTemp(FILE *psFile, int iFd, const char *pcTemp)
+{
+   if (psFile != NULL)
+      (void)fclose(psFile);
+   else if (iFd >= 0)
+      (void)close(iFd);
+   (void)remove(pcTemp);
+   return 0;
+}
+
+/* SnapshotWriter_writeFile takes in a SnapshotWriter oWriter, its
+bucket starts puStarts and bucket array psEntries of uBucketCount
+buckets, a const char pointer pcPath and a buffer pcTemp as
+Snapshot_createTemp needs. It writes the snapshot to a temporary
+file that then replaces pcPath, and returns 1, or 0 (leaving pcPath
+as it was) if the file cannot be written. */
+static int SnapshotWriter_writeFile(SnapshotWriter_T oWriter,
+                                    const uint64_t *puStarts,
+                                    const struct SnapshotEntry *psEntries,
+                                    size_t uBucketCount,
+                                    const char *pcPath, char *pcTemp)
+{
+   FILE *psFile;
+   int iFd;
+
+   /* every save writes its own temporary file, so saves to the same
+   path at once cannot write into each other's before the rename */
+   iFd = Snapshot_createTemp(pcPath, pcTemp);
+   if (iFd == -1)
+      return 0;
+   psFile = fdopen(iFd, "wb");
+   if (psFile == NULL)
+      return Snapshot_discardTemp(NULL, iFd, pcTemp);
+   if (!SnapshotWriter_write(oWriter, puStarts, psEntries,
+                             uBucketCount, psFile))
+      return Snapshot_discardTemp(psFile, iFd, pcTemp);
+   if (fclose(psFile) != 0 || rename(pcTemp, pcPath) != 0)
+      return Snapshot_discardTemp(NULL, -1, pcTemp);
+   return 1;
+}
+
+int SnapshotWriter_finish(SnapshotWriter_T oWriter, const char *pcPath){
+   uint64_t *puStarts;
+   uint64_t *puNext;
+   size_t *puHashes;
+   struct SnapshotEntry *psEntries;
+   char *pcTemp;
+   size_t uBucketCount = 1;
+   size_t u;
+   int iSuccess = 0;
+
+   assert(oWriter != NULL);
+   assert(pcPath != NULL);
+
+   while (uBucketCount < oWriter->count)
+      uBucketCount *= 2;
+   for (u = 0; u < oWriter->count; u++)
+      oWriter->records[u].key = oWriter->keys +
+         oWriter->records[u].keyOffset;
+   if (oWriter->count != 0)
+      qsort(oWriter->records, oWriter->count,
+            sizeof(struct WriterRecord), Snapshot_compareRecords);
+
+   puStarts = calloc(uBucketCount + 1, sizeof(uint64_t));
+   puNext = malloc(uBucketCount * sizeof(uint64_t));
+   puHashes = malloc((oWriter->count + 1) * sizeof(size_t));
+   psEntries = malloc((oWriter->count + 1) *
+                      sizeof(struct SnapshotEntry));
+   pcTemp = malloc(strlen(pcPath) + SNAPSHOT_TEMP_EXTRA);
+   if (puStarts != NULL && puNext != NULL && puHashes != NULL &&
+       psEntries != NULL && pcTemp != NULL) {
+      SnapshotWriter_sortBuckets(oWriter, puStarts, puNext, puHashes,
+                                 psEntries, uBucketCount);
+      iSuccess = SnapshotWriter_writeFile(oWriter, puStarts, psEntries,
+                                          uBucketCount, pcPath, pcTemp);
+   }
+
+   free(puStarts);
+   free(puNext);
+   free(puHashes);
+   free(psEntries);
+   free(pcTemp);
+   SnapshotWriter_free(oWriter);
+   return iSuccess;
+}
+
+/* Snapshot_check takes in the header psHeader of a file of uSize
+bytes and returns 1 if it is a snapshot this code can read, 0
+otherwise. Each section must follow the one before it exactly, which
+also keeps every count small enough not to overflow. */
+static int Snapshot_check(const struct SnapshotHeader *psHeader,
+                          size_t uSize)
+{
+   uint64_t uBucketCount = psHeader->bucketCount;
+   uint64_t uCount = psHeader->count;
+
+   if (memcmp(psHeader->magic, acSnapshotMagic,
+              sizeof(acSnapshotMagic)) != 0 ||
+       psHeader->version != SNAPSHOT_VERSION ||
+       psHeader->hashVersion != SNAPSHOT_HASH_VERSION ||
+       psHeader->byteOrder != SNAPSHOT_BYTE_ORDER ||
+       psHeader->hashBits != sizeof(size_t) * CHAR_BIT ||
+       psHeader->fileSize != uSize)
+      return 0;
+   if (uBucketCount == 0 || (uBucketCount & (uBucketCount - 1)) != 0 ||
+       uBucketCount >= uSize / sizeof(uint64_t) ||
+       uCount > uSize / sizeof(struct SnapshotEntry))
+      return 0;
+   return psHeader->bucketsOffset == sizeof(struct SnapshotHeader) &&
+      psHeader->entriesOffset == psHeader->bucketsOffset +
+         (uBucketCount + 1) * sizeof(uint64_t) &&
+      psHeader->recordsOffset == psHeader->entriesOffset +
+         uCount * sizeof(struct SnapshotEntry) &&
+      psHeader->keysOffset == psHeader->recordsOffset +
+         uCount * sizeof(struct SnapshotRecord) &&
+      psHeader->keysOffset <= psHeader->valuesOffset &&
+      psHeader->valuesOffset % 8 == 0 &&
+      psHeader->valuesOffset <= uSize;
+}
+
+/* Snapshot_checkSections takes in the header psHeader, already
+accepted by Snapshot_check, of a snapshot mapped at pucBase, and
+returns 1 if every bucket start, entry and record points inside the
+mapping, 0 otherwise. The bucket starts must run from 0 to the count
+without going back, every entry must name a record, and every key
+must end with its '\0' before the values start and every value before
+the file ends, so no lookup or scan of a damaged file can read past
+the mapping. */
+static int Snapshot_checkSections(const struct SnapshotHeader *psHeader,
+                                  const unsigned char *pucBase)
+{
+   const uint64_t *puStarts;
+   const struct SnapshotEntry *psEntries;
+   const struct SnapshotRecord *psRecords;
+   const unsigned char *pucKeys;
+   uint64_t uKeyBytes = psHeader->valuesOffset - psHeader->keysOffset;
+   uint64_t uValueBytes = psHeader->fileSize - psHeader->valuesOffset;
+   uint64_t uCount = psHeader->count;
+   uint64_t u;
+
+   puStarts = (const uint64_t *)(const void *)
+      (pucBase + psHeader->bucketsOffset);
+   psEntries = (const struct SnapshotEntry *)(const void *)
+      (pucBase + psHeader->entriesOffset);
+   psRecords = (const struct SnapshotRecord *)(const void *)
+      (pucBase + psHeader->recordsOffset);
+   pucKeys = pucBase + psHeader->keysOffset;
+
+   if (puStarts[0] != 0 || puStarts[psHeader->bucketCount] != uCount)
+      return 0;
+   for (u = 0; u < psHeader->bucketCount; u++)
+      if (puStarts[u] > puStarts[u + 1])
+         return 0;
+   for (u = 0; u < uCount; u++)
+      if (psEntries[u].record >= uCount)
+         return 0;
+   for (u = 0; u < uCount; u++) {
+      if (psRecords[u].keyOffset >= uKeyBytes ||
+          psRecords[u].keyLength >=
+             uKeyBytes - psRecords[u].keyOffset ||
+          pucKeys[psRecords[u].keyOffset +
+                  psRecords[u].keyLength] != '\0')
+         return 0;
+      if (psRecords[u].valueOffset != SNAPSHOT_NO_VALUE &&
+          (psRecords[u].valueOffset % 8 != 0 ||
+           psRecords[u].valueOffset > uValueBytes ||
+           psHeader->valueSize >
+              uValueBytes - psRecords[u].valueOffset))
+         return 0;
+   }
+   return 1;
+}
+
+Snapshot_T Snapshot_open(const char *pcPath){
+   const struct SnapshotHeader *psHeader;
+   const unsigned char *pucBase;
+   Snapshot_T oSnapshot;
+   struct stat sStat;
+   void *pvBase;
+   int iFile;
+
+   assert(pcPath != NULL);
+
+   oSnapshot = malloc(sizeof(struct Snapshot));
+   if (oSnapshot == NULL)
+      return NULL;
+   iFile = open(pcPath, O_RDONLY);
+   if (iFile < 0) {
+      free(oSnapshot);
+      return NULL;
+   }
+   if (fstat(iFile, &sStat) != 0 ||
+       sStat.st_size < (off_t)sizeof(struct SnapshotHeader) ||
+       (uintmax_t)sStat.st_size > (uintmax_t)((size_t)-1)) {
+      close(iFile);
+      free(oSnapshot);
+      return NULL;
+   }
+   pvBase = mmap(NULL, (size_t)sStat.st_size, PROT_READ, MAP_SHARED,
+                 iFile, 0);
+   close(iFile);
+   if (pvBase == MAP_FAILED) {
+      free(oSnapshot);
+      return NULL;
+   }
+
+   pucBase = pvBase;
+   psHeader = pvBase;
+   if (!Snapshot_check(psHeader, (size_t)sStat.st_size) ||
+       !Snapshot_checkSections(psHeader, pucBase)) {
+      munmap(pvBase, (size_t)sStat.st_size);
+      free(oSnapshot);
+      return NULL;
+   }
+   oSnapshot->base = pvBase;
+   oSnapshot->size = (size_t)sStat.st_size;
+   oSnapshot->count = (size_t)psHeader->count;
+   oSnapshot->bucketMask = (size_t)psHeader->bucketCount - 1;
+   oSnapshot->valueSize = (size_t)psHeader->valueSize;
+   oSnapshot->buckets = (const uint64_t *)(const void *)
+      (pucBase + psHeader->bucketsOffset);
+   oSnapshot->entries = (const struct SnapshotEntry *)(const void *)
+      (pucBase + psHeader->entriesOffset);
+   oSnapshot->records = (const struct SnapshotRecord *)(const void *)
+      (pucBase + psHeader->recordsOffset);
+   oSnapshot->keys = (const char *)(pucBase + psHeader->keysOffset);
+   oSnapshot->values = pucBase + psHeader->valuesOffset;
+   return oSnapshot;
+}
+
+void Snapshot_close(Snapshot_T oSnapshot){
+   if (oSnapshot == NULL)
+      return;
+   munmap(oSnapshot->base, oSnapshot->size);
+   free(oSnapshot);
+}
+
+size_t Snapshot_getLength(Snapshot_T oSnapshot){
+   assert(oSnapshot != NULL);
+
+   return oSnapshot->count;
+}
+
+size_t Snapshot_getBytes(Snapshot_T oSnapshot){
+   assert(oSnapshot != NULL);
+
+   return sizeof(struct Snapshot);
+}
+
+/* Snapshot_value takes in a Snapshot oSnapshot and one of its records
+psRecord and returns a pointer to the record's value in the mapping,
+or NULL for a NULL value */
+static void *Snapshot_value(Snapshot_T oSnapshot,
+                            const struct SnapshotRecord *psRecord)
+{
+   if (psRecord->valueOffset == SNAPSHOT_NO_VALUE)
+      return NULL;
+   return (void *)(oSnapshot->values + psRecord->valueOffset);
+}
+
+int Snapshot_find(Snapshot_T oSnapshot, const void *pvKey,
+                  size_t uLength, void **ppvValue){
+   const struct SnapshotRecord *psRecord;
+   uint64_t uHash;
+   size_t uBucket;
+   size_t uEnd;
+   size_t u;
+
+   assert(oSnapshot != NULL);
+   assert(pvKey != NULL || uLength == 0);
+
+   uHash = KeyHash_fast(pvKey, uLength, &snapshotSeed);
+   uBucket = (size_t)uHash & oSnapshot->bucketMask;
+   uEnd = (size_t)oSnapshot->buckets[uBucket + 1];
+   for (u = (size_t)oSnapshot->buckets[uBucket]; u < uEnd; u++) {
+      if (oSnapshot->entries[u].hash != uHash)
+         continue;
+      psRecord = &oSnapshot->records[oSnapshot->entries[u].record];
+      if (psRecord->keyLength == uLength &&
+          memcmp(oSnapshot->keys + psRecord->keyOffset, pvKey,
+                 uLength) == 0) {
+         if (ppvValue != NULL)
+            *ppvValue = Snapshot_value(oSnapshot, psRecord);
+         return 1;
+      }
+   }
+   return 0;
+}
+
+void Snapshot_getBinding(Snapshot_T oSnapshot, size_t uIndex,
+                         const char **ppcKey, size_t *puLength,
+                         void **ppvValue){
+   const struct SnapshotRecord *psRecord;
+
+   assert(oSnapshot != NULL);
+   assert(uIndex < oSnapshot->count);
+
+   psRecord = &oSnapshot->records[uIndex];
+   if (ppcKey != NULL)
+      *ppcKey = oSnapshot->keys + psRecord->keyOffset;
+   if (puLength != NULL)
+      *puLength = (size_t)psRecord->keyLength;
+   if (ppvValue != NULL)
+      *ppvValue = Snapshot_value(oSnapshot, psRecord);
+}
+
+/* Snapshot_mapRecords takes in a Snapshot oSnapshot, record numbers
+uBegin and uEnd, a function pfApply and pvExtra, and applies pfApply
+to the records from uBegin up to uEnd */
+static void Snapshot_mapRecords(Snapshot_T oSnapshot, size_t uBegin,
+                                size_t uEnd,
+                                void (*pfApply)(const char *pcKey,
+                                                void *pvValue,
+                                                void *pvExtra),
+                                void *pvExtra)
+{
+   const struct SnapshotRecord *psRecord;
+   size_t u;
+
+   for (u = uBegin; u < uEnd; u++) {
+      psRecord = &oSnapshot->records[u];
+      (*pfApply)(oSnapshot->keys + psRecord->keyOffset,
+                 Snapshot_value(oSnapshot, psRecord), pvExtra);
+   }
+}
+
+void Snapshot_map(Snapshot_T oSnapshot,
+                  void (*pfApply)(const char *pcKey,
+                                  void *pvValue, void *pvExtra),
+                  const void *pvExtra){
+   assert(oSnapshot != NULL);
+   assert(pfApply != NULL);
+
+   Snapshot_mapRecords(oSnapshot, 0, oSnapshot->count, pfApply,
+                       (void *)pvExtra);
+}
+
+/* Snapshot_mapUnits takes in a range of record numbers [uBegin, uEnd)
+and a SnapshotMapJob pvContext and maps the records in the range, as
+a unit of work for Parallel_forRange */
+static void Snapshot_mapUnits(size_t uBegin, size_t uEnd,
+                              void *pvContext)
+{
+   struct SnapshotMapJob *psJob = pvContext;
+
+   Snapshot_mapRecords(psJob->snapshot, uBegin, uEnd, psJob->apply,
+                       psJob->extra);
+}
+
+void Snapshot_mapParallel(Snapshot_T oSnapshot,
+                          void (*pfApply)(const char *pcKey,
+                                          void *pvValue, void *pvExtra),
+                          const void *pvExtra, size_t uThreads){
+   struct SnapshotMapJob sJob;
+
+   assert(oSnapshot != NULL);
+   assert(pfApply != NULL);
+
+   sJob.snapshot = oSnapshot;
+   sJob.apply = pfApply;
+   sJob.extra = (void *)pvExtra;
+   Parallel_forRange(oSnapshot->count, uThreads, Snapshot_mapUnits,
+                     &sJob);
+}
+
+/* Snapshot_lowerBound takes in a Snapshot oSnapshot and a key pcKey of
+uLength bytes and returns the number of the first record whose key is
+not less than pcKey, or the record count if there is none */
+static size_t Snapshot_lowerBound(Snapshot_T oSnapshot,
+                                  const char *pcKey, size_t uLength)
+{
+   const struct SnapshotRecord *psRecord;
+   size_t uLow = 0;
+   size_t uHigh = oSnapshot->count;
+   size_t uMiddle;
+
+   while (uLow < uHigh) {
+      uMiddle = uLow + (uHigh - uLow) / 2;
+      psRecord = &oSnapshot->records[uMiddle];
+      if (Snapshot_compare(oSnapshot->keys + psRecord->keyOffset,
+                           (size_t)psRecord->keyLength,
+                           pcKey, uLength) < 0)
+         uLow = uMiddle + 1;
+      else
+         uHigh = uMiddle;
+   }
+   return uLow;
+}
+
+void Snapshot_mapRange(Snapshot_T oSnapshot, const char *pcLow,
+                       const char *pcHigh,
+                       void (*pfApply)(const char *pcKey,
+                                       void *pvValue, void *pvExtra),
+                       const void *pvExtra){
+   size_t uBegin = 0;
+   size_t uEnd;
+
+   assert(oSnapshot != NULL);
+   assert(pfApply != NULL);
+
+   uEnd = oSnapshot->count;
+   if (pcLow != NULL)
+      uBegin = Snapshot_lowerBound(oSnapshot, pcLow, strlen(pcLow));
+   if (pcHigh != NULL)
+      uEnd = Snapshot_lowerBound(oSnapshot, pcHigh, strlen(pcHigh));
+   if (uBegin < uEnd)
+      Snapshot_mapRecords(oSnapshot, uBegin, uEnd, pfApply,
+                          (void *)pvExtra);
+}
+
+void Snapshot_mapPrefix(Snapshot_T oSnapshot, const char *pcPrefix,
+                        void (*pfApply)(const char *pcKey,
+                                        void *pvValue, void *pvExtra),
+                        const void *pvExtra){
+   const struct SnapshotRecord *psRecord;
+   size_t uLength;
+   size_t u;
+
+   assert(oSnapshot != NULL);
+   assert(pcPrefix != NULL);
+   assert(pfApply != NULL);
+
+   uLength = strlen(pcPrefix);
+   for (u = Snapshot_lowerBound(oSnapshot, pcPrefix, uLength);
+        u < oSnapshot->count; u++) {
+      psRecord = &oSnapshot->records[u];
+      if (psRecord->keyLength < uLength ||
+          memcmp(oSnapshot->keys + psRecord->keyOffset, pcPrefix,
+                 uLength) != 0)
+         break;
+      (*pfApply)(oSnapshot->keys + psRecord->keyOffset,
+                 Snapshot_value(oSnapshot, psRecord), (void *)pvExtra);
+   }
+}
+
+int Snapshot_save(Snapshot_T oSnapshot, const char *pcPath,
+                  size_t uValueSize){
+   SnapshotWriter_T oWriter;
+   const char *pcKey;
+   size_t uLength;
+   void *pvValue;
+   size_t u;
+
+   assert(oSnapshot != NULL);
+   assert(pcPath != NULL);
+
+   if (uValueSize > oSnapshot->valueSize)
+      return 0;
+   oWriter = SnapshotWriter_new(uValueSize);
+   if (oWriter == NULL)
+      return 0;
+   for (u = 0; u < oSnapshot->count; u++) {
+      Snapshot_getBinding(oSnapshot, u, &pcKey, &uLength, &pvValue);
+      if (!SnapshotWriter_add(oWriter, pcKey, uLength, pvValue)) {
+         SnapshotWriter_free(oWriter);
+         return 0;
+      }
+   }
+   return SnapshotWriter_finish(oWriter, pcPath);
+}
@@ -0,0 +1,130 @@
+/* symtable snapshot header file */
+#include <stddef.h>
+#ifndef SYMTABLESNAPSHOT_INCLUDED
+#define SYMTABLESNAPSHOT_INCLUDED
+
+/* A snapshot is a SymTable saved to a file in a form that can be
+searched right where it is mapped into memory, for SymTable_save and
+SymTable_openMapped. After a header that names the version of the
+format and of the hash function, the file holds a bucket array of
+offsets into an array of (hash, record number) entries, so each
+bucket's entries are contiguous; the records (key offset, key length,
+value offset) in ascending order of key; every key followed by a
+'\0'; and the bytes of every value. Offsets are relative to their own
+section, so the file holds no pointers and nothing has to be fixed up
+or rebuilt when it is opened. */
+struct Snapshot;
+
+/* pointer Snapshot_T to object Snapshot initialization */
+typedef struct Snapshot *Snapshot_T;
+
+/* A SnapshotWriter collects the bindings of a SymTable being saved,
+then sorts, hashes and writes them out in one go */
+struct SnapshotWriter;
+
+/* pointer SnapshotWriter_T to object SnapshotWriter initialization */
+typedef struct SnapshotWriter *SnapshotWriter_T;
+
+/* SnapshotWriter_new takes in a value size uValueSize and returns a
+new, empty SnapshotWriter that saves uValueSize bytes of each value,
+or NULL if there is insufficient memory */
+SnapshotWriter_T SnapshotWriter_new(size_t uValueSize);
+
+/* SnapshotWriter_add takes in a SnapshotWriter oWriter, a key pcKey of
+uLength bytes and a value pvValue, which is NULL or points to at least
+the writer's value size of bytes. It copies the binding into oWriter
+and returns 1, or 0 if there is insufficient memory. */
+int SnapshotWriter_add(SnapshotWriter_T oWriter, const char *pcKey,
+                       size_t uLength, const void *pvValue);
+
+/* SnapshotWriter_finish takes in a SnapshotWriter oWriter and a const
+char pointer pcPath, writes a snapshot of the bindings added to oWriter
+to the file pcPath and frees oWriter. The snapshot is written to a
+temporary file of its own beside pcPath that then replaces it, so a
+reader never sees half of one and saves to the same path at once do
+not mix. It returns 1, or 0 (leaving pcPath as it was) if the file
+cannot be written or there is insufficient memory. */
+int SnapshotWriter_finish(SnapshotWriter_T oWriter, const char *pcPath);
+
+/* SnapshotWriter_free takes in a SnapshotWriter oWriter and frees it
+without writing anything */
+void SnapshotWriter_free(SnapshotWriter_T oWriter);
+
+/* Snapshot_open takes in a const char pointer pcPath and maps the
+snapshot in the file pcPath into memory read-only. It returns the
+Snapshot, or NULL if the file cannot be mapped, is not a snapshot, or
+was written with another version of the format or the hash, or on a
+machine with another byte order or word size, or if any bucket,
+entry or record points outside the file. Checking them reads the
+index once, but nothing is copied or rebuilt. */
+Snapshot_T Snapshot_open(const char *pcPath);
+
+/* Snapshot_close takes in a Snapshot oSnapshot, unmaps its file and
+frees it */
+void Snapshot_close(Snapshot_T oSnapshot);
+
+/* Snapshot_getLength takes in a Snapshot oSnapshot and returns how
+many bindings it holds */
+size_t Snapshot_getLength(Snapshot_T oSnapshot);
+
+/* Snapshot_getBytes takes in a Snapshot oSnapshot and returns how many
+bytes of memory from malloc it holds. The mapping is not counted. */
+size_t Snapshot_getBytes(Snapshot_T oSnapshot);
+
+/* Snapshot_find takes in a Snapshot oSnapshot, a key pvKey of uLength
+bytes and a void double pointer ppvValue. If oSnapshot has a binding
+of pvKey, *ppvValue is set to a pointer to its value's bytes in the
+mapping (or NULL for a NULL value) and 1 is returned. Otherwise 0 is
+returned. */
+int Snapshot_find(Snapshot_T oSnapshot, const void *pvKey,
+                  size_t uLength, void **ppvValue);
+
+/* Snapshot_getBinding takes in a Snapshot oSnapshot, a binding number
+uIndex below its length, and pointers ppcKey, puLength and ppvValue,
+any of which may be NULL. It sets them to the key, key length and
+value of the binding uIndex bindings into oSnapshot in ascending order
+of key. The key is followed by a '\0' and stays valid until oSnapshot
+is closed. */
+void Snapshot_getBinding(Snapshot_T oSnapshot, size_t uIndex,
+                         const char **ppcKey, size_t *puLength,
+                         void **ppvValue);
+
+/* Snapshot_map takes in a Snapshot oSnapshot, a function pfApply and
+pvExtra, and calls (*pfApply)(key, value, pvExtra) for every binding
+of oSnapshot in ascending order of key */
+void Snapshot_map(Snapshot_T oSnapshot,
+                  void (*pfApply)(const char *pcKey,
+                                  void *pvValue, void *pvExtra),
+                  const void *pvExtra);
+
+/* Snapshot_mapParallel works like Snapshot_map, but splits the
+bindings among up to uThreads threads as SymTable_mapParallel does */
+void Snapshot_mapParallel(Snapshot_T oSnapshot,
+                          void (*pfApply)(const char *pcKey,
+                                          void *pvValue, void *pvExtra),
+                          const void *pvExtra, size_t uThreads);
+
+/* Snapshot_mapRange works like Snapshot_map, but only for the keys at
+least pcLow and less than pcHigh (either of which may be NULL), which
+it finds by binary search as SymTable_mapRange describes */
+void Snapshot_mapRange(Snapshot_T oSnapshot, const char *pcLow,
+                       const char *pcHigh,
+                       void (*pfApply)(const char *pcKey,
+                                       void *pvValue, void *pvExtra),
+                       const void *pvExtra);
+
+/* Snapshot_mapPrefix works like Snapshot_map, but only for the keys
+starting with pcPrefix */
+void Snapshot_mapPrefix(Snapshot_T oSnapshot, const char *pcPrefix,
+                        void (*pfApply)(const char *pcKey,
+                                        void *pvValue, void *pvExtra),
+                        const void *pvExtra);
+
+/* Snapshot_save takes in a Snapshot oSnapshot, a const char pointer
+pcPath and a value size uValueSize no larger than oSnapshot's, and
+writes oSnapshot's bindings to a new snapshot at pcPath as
+SnapshotWriter_finish does. It returns 1, or 0 on failure. */
+int Snapshot_save(Snapshot_T oSnapshot, const char *pcPath,
+                  size_t uValueSize);
+
+#endif
@@ -0,0 +1,112 @@
+/* symtable stats implementation */
+#define _POSIX_C_SOURCE 200112L
+#include "symtablestats.h"
+#include <assert.h>
+#include <stddef.h>
+#include <time.h>
+
+void Stats_init(struct Stats *psStats)
+{
+   assert(psStats != NULL);
+
+   psStats->hits = 0;
+   psStats->hitProbes = 0;
+   psStats->misses = 0;
+   psStats->missProbes = 0;
+   psStats->expansions = 0;
+   psStats->expandNanoseconds = 0.0;
+}
+
+double Stats_now(void)
+{
+   struct timespec sTime;
+
+   clock_gettime(CLOCK_MONOTONIC, &sTime);
+   return (double)sTime.tv_sec * 1e9 + (double)sTime.tv_nsec;
+}
+
+void Stats_addLookup(struct Stats *psStats, size_t uProbes, int iFound)
+{
+   assert(psStats != NULL);
+
+   if (iFound) {
+      psStats->hits++;
+      psStats->hitProbes += uProbes;
+   } else {
+      psStats->misses++;
+      psStats->missProbes += uProbes;
+   }
+}
+
+void Stats_addExpansion(struct Stats *psStats, double dStart)
+{
+   assert(psStats != NULL);
+
+   psStats->expansions++;
+   psStats->expandNanoseconds += Stats_now() - dStart;
+}
+
+void Stats_add(struct Stats *psTo, const struct Stats *psFrom)
+{
+   assert(psTo != NULL);
+   assert(psFrom != NULL);
+
+   psTo->hits += psFrom->hits;
+   psTo->hitProbes += psFrom->hitProbes;
+   psTo->misses += psFrom->misses;
+   psTo->missProbes += psFrom->missProbes;
+   psTo->expansions += psFrom->expansions;
+   psTo->expandNanoseconds += psFrom->expandNanoseconds;
+}
+
+void Stats_clear(struct SymTableStats *psReport)
+{
+   size_t i;
+
+   assert(psReport != NULL);
+
+   psReport->bucketCount = 0;
+   psReport->load = 0.0;
+   for (i = 0; i < SYMTABLE_STATS_CHAINS; i++) {
+      psReport->chainCounts[i] = 0;
+   }
+   psReport->maxChain = 0;
+   psReport->hits = 0;
+   psReport->misses = 0;
+   psReport->probesPerHit = 0.0;
+   psReport->probesPerMiss = 0.0;
+   psReport->expansions = 0;
+   psReport->expandSeconds = 0.0;
+   psReport->allocCount = 0;
+   psReport->bytes = 0;
+}
+
+void Stats_addChain(struct SymTableStats *psReport, size_t uLength)
+{
+   assert(psReport != NULL);
+
+   if (uLength < SYMTABLE_STATS_CHAINS) {
+      psReport->chainCounts[uLength]++;
+   } else {
+      psReport->chainCounts[SYMTABLE_STATS_CHAINS - 1]++;
+   }
+   if (uLength > psReport->maxChain) {
+      psReport->maxChain = uLength;
+   }
+}
+
+void Stats_report(const struct Stats *psStats,
+                  struct SymTableStats *psReport)
+{
+   assert(psStats != NULL);
+   assert(psReport != NULL);
+
+   psReport->hits = psStats->hits;
+   psReport->misses = psStats->misses;
+   psReport->probesPerHit = (psStats->hits == 0) ? 0.0 :
+      (double)psStats->hitProbes / (double)psStats->hits;
+   psReport->probesPerMiss = (psStats->misses == 0) ? 0.0 :
+      (double)psStats->missProbes / (double)psStats->misses;
+   psReport->expansions = psStats->expansions;
+   psReport->expandSeconds = psStats->expandNanoseconds / 1e9;
+}
@@ -0,0 +1,63 @@
+/* symtable stats header file */
+#include "symtable.h"
+#include <stddef.h>
+#ifndef SYMTABLESTATS_INCLUDED
+#define SYMTABLESTATS_INCLUDED
+
+/* Stats is what a SymTable made by SymTable_newWithStats counts as it
+goes. The rest of a SymTableStats is worked out from the table when
+SymTable_getStats is called, so a SymTable that does not count keeps
+no Stats and does no more than check that it has none. */
+struct Stats {
+    /* how many lookups found their key */
+    size_t hits;
+    /* how many probes those lookups took in all */
+    size_t hitProbes;
+    /* how many lookups did not find their key */
+    size_t misses;
+    /* how many probes those lookups took in all */
+    size_t missProbes;
+    /* how many times puts expanded the SymTable */
+    size_t expansions;
+    /* how many nanoseconds those expansions took in all */
+    double expandNanoseconds;
+};
+
+/* Stats_init takes in a pointer psStats to a Stats and sets every
+count of it to 0 */
+void Stats_init(struct Stats *psStats);
+
+/* Stats_now returns the time on a clock that only moves forward, in
+nanoseconds, for timing expansions */
+double Stats_now(void);
+
+/* Stats_addLookup takes in a pointer psStats to a Stats, a probe
+count uProbes and iFound, which is 1 if a lookup found its key and 0
+if it did not, and counts a lookup of uProbes probes */
+void Stats_addLookup(struct Stats *psStats, size_t uProbes, int iFound);
+
+/* Stats_addExpansion takes in a pointer psStats to a Stats and the
+Stats_now dStart at which an expansion started, and counts the
+expansion and the time since dStart */
+void Stats_addExpansion(struct Stats *psStats, double dStart);
+
+/* Stats_add takes in pointers psTo and psFrom to two Stats and adds
+the counts of psFrom to those of psTo */
+void Stats_add(struct Stats *psTo, const struct Stats *psFrom);
+
+/* Stats_clear takes in a pointer psReport to a SymTableStats and sets
+every field of it to 0 */
+void Stats_clear(struct SymTableStats *psReport);
+
+/* Stats_addChain takes in a pointer psReport to a SymTableStats and a
+chain length uLength, and counts a chain of uLength in its histogram
+and maxChain */
+void Stats_addChain(struct SymTableStats *psReport, size_t uLength);
+
+/* Stats_report takes in a pointer psStats to a Stats and a pointer
+psReport to a SymTableStats, and fills in the lookup and expansion
+fields of psReport from psStats */
+void Stats_report(const struct Stats *psStats,
+                  struct SymTableStats *psReport);
+
+#endif
@@ -0,0 +1,800 @@
+/*--------------------------------------------------------------------*/
+/* testconcurrent.c                                                   */
+/*--------------------------------------------------------------------*/
+
+/* for clock_gettime() */
+#define _POSIX_C_SOURCE 200112L
+
+#include "symtable.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string.h>
+#include <assert.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* The most threads any test or benchmark starts. */
+
+enum {MAX_THREADS = 64};
+
+/* The length of the keys that makeKeys() writes, counting the '\0'. */
+
+enum {MAX_KEY_LENGTH = 12};
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the current time of a monotonic clock in nanoseconds. */
+
+static double getNanoseconds(void)
+{
+   struct timespec sTime;
+   clock_gettime(CLOCK_MONOTONIC, &sTime);
+   return (double)sTime.tv_sec * 1e9 + (double)sTime.tv_nsec;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return a new array of iKeyCount keys "0", "1", ..., each
+   MAX_KEY_LENGTH characters apart, or NULL if there is insufficient
+   memory. */
+
+static char *makeKeys(int iKeyCount)
+{
+   char *pcKeys;
+   int i;
+
+   pcKeys = (char*)malloc((size_t)iKeyCount * MAX_KEY_LENGTH);
+   if (pcKeys == NULL)
+      return NULL;
+   for (i = 0; i < iKeyCount; i++)
+      sprintf(pcKeys + (size_t)i * MAX_KEY_LENGTH, "%d", i);
+   return pcKeys;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Count the binding whose key is pcKey and whose value is pvValue in
+   the size_t that pvExtra points to. */
+
+static void countBinding(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   assert(pcKey != NULL);
+   assert(pvExtra != NULL);
+
+   (void)pvValue;
+   (*(size_t*)pvExtra)++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* A Worker is what one thread of a test or benchmark works on. */
+
+struct Worker
+{
+   /* The SymTable object that every thread shares. */
+   SymTable_T oSymTable;
+
+   /* The keys the thread works on: iKeyCount keys MAX_KEY_LENGTH
+      characters apart, starting at pcKeys. */
+   char *pcKeys;
+   int iKeyCount;
+
+   /* How many operations the thread does, and how many of every 100
+      are gets and puts (the rest are removes). */
+   int iOpCount;
+   int iGetPercent;
+   int iPutPercent;
+
+   /* If nonzero, every call is wrapped in one global mutex. */
+   int iGlobalLock;
+
+   /* The state of the thread's random number generator. */
+   unsigned long ulRandom;
+
+   /* How many of the thread's calls put a new binding. */
+   int iAddCount;
+
+   /* The longest any one of the thread's calls took, in nanoseconds. */
+   double dWorstNs;
+};
+
+/* The one mutex that the iGlobalLock benchmark wraps every call in. */
+
+static pthread_mutex_t globalLock = PTHREAD_MUTEX_INITIALIZER;
+
+/*--------------------------------------------------------------------*/
+
+/* Put every key of the Worker that pvWorker points to, with the key
+   itself as its value, then remove every second one. */
+
+static void *putThenRemove(void *pvWorker)
+{
+   struct Worker *psWorker = (struct Worker*)pvWorker;
+   char *pcKey;
+   int i;
+
+   for (i = 0; i < psWorker->iKeyCount; i++)
+   {
+      pcKey = psWorker->pcKeys + (size_t)i * MAX_KEY_LENGTH;
+      psWorker->iAddCount +=
+         SymTable_put(psWorker->oSymTable, pcKey, pcKey);
+   }
+   for (i = 0; i < psWorker->iKeyCount; i += 2)
+   {
+      pcKey = psWorker->pcKeys + (size_t)i * MAX_KEY_LENGTH;
+      ASSURE(SymTable_remove(psWorker->oSymTable, pcKey) == pcKey);
+      pcKey += MAX_KEY_LENGTH;
+      if (i + 1 < psWorker->iKeyCount)
+         ASSURE(SymTable_get(psWorker->oSymTable, pcKey) == pcKey);
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Call SymTable_getOrPut() on every key of the Worker that pvWorker
+   points to, counting the calls that added a binding. */
+
+static void *getOrPutAll(void *pvWorker)
+{
+   struct Worker *psWorker = (struct Worker*)pvWorker;
+   void **ppvValue;
+   int iFound;
+   int i;
+
+   for (i = 0; i < psWorker->iKeyCount; i++)
+   {
+      ppvValue = SymTable_getOrPut(psWorker->oSymTable,
+         psWorker->pcKeys + (size_t)i * MAX_KEY_LENGTH, psWorker,
+         &iFound);
+      ASSURE(ppvValue != NULL);
+      if (! iFound)
+         psWorker->iAddCount++;
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Do the random mix of gets, puts and removes that the Worker that
+   pvWorker points to describes. */
+
+static void *mixedWork(void *pvWorker)
+{
+   struct Worker *psWorker = (struct Worker*)pvWorker;
+   unsigned long ulRandom = psWorker->ulRandom;
+   char *pcKey;
+   int iChoice;
+   int i;
+
+   for (i = 0; i < psWorker->iOpCount; i++)
+   {
+      ulRandom = ulRandom * 6364136223846793005UL + 1442695040888963407UL;
+      pcKey = psWorker->pcKeys + (size_t)((ulRandom >> 33) %
+         (unsigned long)psWorker->iKeyCount) * MAX_KEY_LENGTH;
+      iChoice = (int)((ulRandom >> 16) % 100);
+
+      if (psWorker->iGlobalLock)
+         pthread_mutex_lock(&globalLock);
+      if (iChoice < psWorker->iGetPercent)
+         (void)SymTable_get(psWorker->oSymTable, pcKey);
+      else if (iChoice < psWorker->iGetPercent + psWorker->iPutPercent)
+         (void)SymTable_put(psWorker->oSymTable, pcKey, pcKey);
+      else
+         (void)SymTable_remove(psWorker->oSymTable, pcKey);
+      if (psWorker->iGlobalLock)
+         pthread_mutex_unlock(&globalLock);
+   }
+   psWorker->ulRandom = ulRandom;
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put every key of the Worker that pvWorker points to, timing each
+   call and keeping the longest. */
+
+static void *putTimed(void *pvWorker)
+{
+   struct Worker *psWorker = (struct Worker*)pvWorker;
+   char *pcKey;
+   double dStart;
+   double dTime;
+   int i;
+
+   psWorker->dWorstNs = 0.0;
+   for (i = 0; i < psWorker->iKeyCount; i++)
+   {
+      pcKey = psWorker->pcKeys + (size_t)i * MAX_KEY_LENGTH;
+      dStart = getNanoseconds();
+      if (psWorker->iGlobalLock)
+         pthread_mutex_lock(&globalLock);
+      ASSURE(SymTable_put(psWorker->oSymTable, pcKey, pcKey));
+      if (psWorker->iGlobalLock)
+         pthread_mutex_unlock(&globalLock);
+      dTime = getNanoseconds() - dStart;
+      if (dTime > psWorker->dWorstNs)
+         psWorker->dWorstNs = dTime;
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* If the Worker that pvWorker points to is a reader (its iGetPercent
+   is 100), get each of its keys iOpCount times over and check that
+   the value is the key itself.  Otherwise put each of its keys and
+   remove them again, iOpCount times over. */
+
+static void *readOrChurn(void *pvWorker)
+{
+   struct Worker *psWorker = (struct Worker*)pvWorker;
+   char *pcKey;
+   int iRound;
+   int i;
+
+   for (iRound = 0; iRound < psWorker->iOpCount; iRound++)
+   {
+      for (i = 0; i < psWorker->iKeyCount; i++)
+      {
+         pcKey = psWorker->pcKeys + (size_t)i * MAX_KEY_LENGTH;
+         if (psWorker->iGetPercent == 100)
+            ASSURE(SymTable_get(psWorker->oSymTable, pcKey) == pcKey);
+         else
+            ASSURE(SymTable_put(psWorker->oSymTable, pcKey, pcKey));
+      }
+      if (psWorker->iGetPercent == 100)
+         continue;
+      for (i = 0; i < psWorker->iKeyCount; i++)
+      {
+         pcKey = psWorker->pcKeys + (size_t)i * MAX_KEY_LENGTH;
+         ASSURE(SymTable_remove(psWorker->oSymTable, pcKey) == pcKey);
+      }
+   }
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Iterate iOpCount times over the SymTable object of the Worker that
+   pvWorker points to, whose first iKeyCount keys are in it for the
+   whole time and are their own values.  Every one of those keys must
+   be returned exactly once by each iteration. */
+
+static void *iterateStable(void *pvWorker)
+{
+   struct Worker *psWorker = (struct Worker*)pvWorker;
+   SymTableIter_T oIter;
+   const char *pcKey;
+   void *pvValue;
+   size_t uIndex;
+   int *piSeen;
+   int iRound;
+   int i;
+
+   piSeen = (int*)malloc((size_t)psWorker->iKeyCount * sizeof(int));
+   ASSURE(piSeen != NULL);
+   if (piSeen == NULL)
+      return NULL;
+   for (iRound = 0; iRound < psWorker->iOpCount; iRound++)
+   {
+      for (i = 0; i < psWorker->iKeyCount; i++)
+         piSeen[i] = 0;
+      oIter = SymTable_iterBegin(psWorker->oSymTable);
+      ASSURE(oIter != NULL);
+      if (oIter == NULL)
+         break;
+      while (SymTable_iterNext(oIter, &pcKey, &pvValue))
+      {
+         ASSURE(strcmp(pcKey, (const char*)pvValue) == 0);
+         uIndex = (size_t)((char*)pvValue - psWorker->pcKeys) /
+            MAX_KEY_LENGTH;
+         if (uIndex < (size_t)psWorker->iKeyCount)
+            piSeen[uIndex]++;
+      }
+      SymTable_iterEnd(oIter);
+      for (i = 0; i < psWorker->iKeyCount; i++)
+         ASSURE(piSeen[i] == 1);
+   }
+   free(piSeen);
+   return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Run iterateStable() on the Worker that pvWorker points to if its
+   iGetPercent is 100, and readOrChurn() otherwise. */
+
+static void *iterateOrChurn(void *pvWorker)
+{
+   if (((struct Worker*)pvWorker)->iGetPercent == 100)
+      return iterateStable(pvWorker);
+   return readOrChurn(pvWorker);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Run pfWork on iThreadCount threads, giving thread i the Worker
+   asWorkers[i], and wait for all of them.  Return the time that took
+   in nanoseconds. */
+
+static double runThreads(void *(*pfWork)(void *), struct Worker asWorkers[],
+   int iThreadCount)
+{
+   pthread_t aThreads[MAX_THREADS];
+   double dStart;
+   int i;
+
+   assert(iThreadCount <= MAX_THREADS);
+
+   dStart = getNanoseconds();
+   for (i = 0; i < iThreadCount; i++)
+      ASSURE(pthread_create(&aThreads[i], NULL, pfWork, &asWorkers[i])
+         == 0);
+   for (i = 0; i < iThreadCount; i++)
+      ASSURE(pthread_join(aThreads[i], NULL) == 0);
+   return getNanoseconds() - dStart;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test threads that put and remove disjoint sets of keys at the same
+   time, so that the SymTable object expands while they run. */
+
+static void testDisjointKeys(void)
+{
+   enum {THREAD_COUNT = 8, KEY_COUNT = 80000};
+
+   struct Worker asWorkers[THREAD_COUNT];
+   SymTable_T oSymTable;
+   char *pcKeys;
+   size_t uCount;
+   int iPerThread;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing threads that use disjoint keys.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   pcKeys = makeKeys(KEY_COUNT);
+   ASSURE(pcKeys != NULL);
+   if (pcKeys == NULL)
+      return;
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   iPerThread = KEY_COUNT / THREAD_COUNT;
+   for (i = 0; i < THREAD_COUNT; i++)
+   {
+      asWorkers[i].oSymTable = oSymTable;
+      asWorkers[i].pcKeys = pcKeys + (size_t)i * iPerThread *
+         MAX_KEY_LENGTH;
+      asWorkers[i].iKeyCount = iPerThread;
+      asWorkers[i].iAddCount = 0;
+   }
+   (void)runThreads(putThenRemove, asWorkers, THREAD_COUNT);
+
+   for (i = 0; i < THREAD_COUNT; i++)
+      ASSURE(asWorkers[i].iAddCount == iPerThread);
+   ASSURE(SymTable_getLength(oSymTable) ==
+      (size_t)(THREAD_COUNT * (iPerThread / 2)));
+   for (i = 0; i < THREAD_COUNT * iPerThread; i++)
+   {
+      if (i % iPerThread % 2 == 0)
+         ASSURE(! SymTable_contains(oSymTable,
+            pcKeys + (size_t)i * MAX_KEY_LENGTH));
+      else
+         ASSURE(SymTable_get(oSymTable,
+            pcKeys + (size_t)i * MAX_KEY_LENGTH) ==
+            pcKeys + (size_t)i * MAX_KEY_LENGTH);
+   }
+   uCount = 0;
+   SymTable_map(oSymTable, countBinding, &uCount);
+   ASSURE(uCount == SymTable_getLength(oSymTable));
+
+   SymTable_free(oSymTable);
+   free(pcKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test threads that all call SymTable_getOrPut() on the same keys at
+   the same time.  Each key must be added exactly once. */
+
+static void testSharedKeys(void)
+{
+   enum {THREAD_COUNT = 8, KEY_COUNT = 20000};
+
+   struct Worker asWorkers[THREAD_COUNT];
+   struct Worker *psWorker;
+   SymTable_T oSymTable;
+   char *pcKeys;
+   int iAddCount;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing threads that use the same keys.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   pcKeys = makeKeys(KEY_COUNT);
+   ASSURE(pcKeys != NULL);
+   if (pcKeys == NULL)
+      return;
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   for (i = 0; i < THREAD_COUNT; i++)
+   {
+      asWorkers[i].oSymTable = oSymTable;
+      asWorkers[i].pcKeys = pcKeys;
+      asWorkers[i].iKeyCount = KEY_COUNT;
+      asWorkers[i].iAddCount = 0;
+   }
+   (void)runThreads(getOrPutAll, asWorkers, THREAD_COUNT);
+
+   iAddCount = 0;
+   for (i = 0; i < THREAD_COUNT; i++)
+      iAddCount += asWorkers[i].iAddCount;
+   ASSURE(iAddCount == KEY_COUNT);
+   ASSURE(SymTable_getLength(oSymTable) == KEY_COUNT);
+
+   /* Each key's value is the Worker of the thread that added it. */
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      psWorker = (struct Worker*)SymTable_get(oSymTable,
+         pcKeys + (size_t)i * MAX_KEY_LENGTH);
+      ASSURE(psWorker >= asWorkers && psWorker < asWorkers + THREAD_COUNT);
+   }
+
+   SymTable_free(oSymTable);
+   free(pcKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test readers that get keys that are always present while writers
+   put and remove other keys, so that the SymTable object expands and
+   releases removed bindings under the readers. */
+
+static void testReadersDuringWrites(void)
+{
+   enum {READER_COUNT = 4, WRITER_COUNT = 4, STABLE_COUNT = 5000,
+      CHURN_COUNT = 20000, READ_ROUNDS = 40, CHURN_ROUNDS = 3};
+
+   struct Worker asWorkers[READER_COUNT + WRITER_COUNT];
+   SymTable_T oSymTable;
+   char *pcKeys;
+   size_t uCount;
+   int iPerWriter;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing readers while writers expand the SymTable.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   pcKeys = makeKeys(STABLE_COUNT + CHURN_COUNT);
+   ASSURE(pcKeys != NULL);
+   if (pcKeys == NULL)
+      return;
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < STABLE_COUNT; i++)
+      ASSURE(SymTable_put(oSymTable, pcKeys + (size_t)i * MAX_KEY_LENGTH,
+         pcKeys + (size_t)i * MAX_KEY_LENGTH));
+
+   iPerWriter = CHURN_COUNT / WRITER_COUNT;
+   for (i = 0; i < READER_COUNT + WRITER_COUNT; i++)
+   {
+      asWorkers[i].oSymTable = oSymTable;
+      if (i < READER_COUNT)
+      {
+         asWorkers[i].pcKeys = pcKeys;
+         asWorkers[i].iKeyCount = STABLE_COUNT;
+         asWorkers[i].iOpCount = READ_ROUNDS;
+         asWorkers[i].iGetPercent = 100;
+      }
+      else
+      {
+         asWorkers[i].pcKeys = pcKeys + (size_t)(STABLE_COUNT +
+            (i - READER_COUNT) * iPerWriter) * MAX_KEY_LENGTH;
+         asWorkers[i].iKeyCount = iPerWriter;
+         asWorkers[i].iOpCount = CHURN_ROUNDS;
+         asWorkers[i].iGetPercent = 0;
+      }
+   }
+   (void)runThreads(readOrChurn, asWorkers, READER_COUNT + WRITER_COUNT);
+
+   ASSURE(SymTable_getLength(oSymTable) == STABLE_COUNT);
+   uCount = 0;
+   SymTable_map(oSymTable, countBinding, &uCount);
+   ASSURE(uCount == STABLE_COUNT);
+
+   SymTable_free(oSymTable);
+   free(pcKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test iterators while writers put and remove other keys, so that
+   the shards expand under them. */
+
+static void testIteratorsDuringWrites(void)
+{
+   enum {ITERATOR_COUNT = 2, WRITER_COUNT = 4, STABLE_COUNT = 5000,
+      CHURN_COUNT = 20000, ITERATE_ROUNDS = 10, CHURN_ROUNDS = 3};
+
+   struct Worker asWorkers[ITERATOR_COUNT + WRITER_COUNT];
+   SymTable_T oSymTable;
+   char *pcKeys;
+   int iPerWriter;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing iterators while writers expand the SymTable.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   pcKeys = makeKeys(STABLE_COUNT + CHURN_COUNT);
+   ASSURE(pcKeys != NULL);
+   if (pcKeys == NULL)
+      return;
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < STABLE_COUNT; i++)
+      ASSURE(SymTable_put(oSymTable, pcKeys + (size_t)i * MAX_KEY_LENGTH,
+         pcKeys + (size_t)i * MAX_KEY_LENGTH));
+
+   iPerWriter = CHURN_COUNT / WRITER_COUNT;
+   for (i = 0; i < ITERATOR_COUNT + WRITER_COUNT; i++)
+   {
+      asWorkers[i].oSymTable = oSymTable;
+      if (i < ITERATOR_COUNT)
+      {
+         asWorkers[i].pcKeys = pcKeys;
+         asWorkers[i].iKeyCount = STABLE_COUNT;
+         asWorkers[i].iOpCount = ITERATE_ROUNDS;
+         asWorkers[i].iGetPercent = 100;
+      }
+      else
+      {
+         asWorkers[i].pcKeys = pcKeys + (size_t)(STABLE_COUNT +
+            (i - ITERATOR_COUNT) * iPerWriter) * MAX_KEY_LENGTH;
+         asWorkers[i].iKeyCount = iPerWriter;
+         asWorkers[i].iOpCount = CHURN_ROUNDS;
+         asWorkers[i].iGetPercent = 0;
+      }
+   }
+   (void)runThreads(iterateOrChurn, asWorkers,
+      ITERATOR_COUNT + WRITER_COUNT);
+
+   ASSURE(SymTable_getLength(oSymTable) == STABLE_COUNT);
+
+   SymTable_free(oSymTable);
+   free(pcKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Time a mix of gets, puts and removes, iGetPercent and iPutPercent of
+   every 100 of them gets and puts, on a SymTable object that starts
+   with iBindingCount bindings, at 1 to MAX_THREADS threads.  The keys
+   are drawn from twice that many, so about half the gets miss and the
+   SymTable object stays about the same size.  Each thread count is
+   run once with every call wrapped in one global mutex, and once
+   without.  Write the throughput of each and its speedup over one
+   thread to stdout. */
+
+static void timeMixedWork(int iBindingCount, int iGetPercent,
+   int iPutPercent)
+{
+   enum {OP_COUNT = 2000000};
+
+   struct Worker asWorkers[MAX_THREADS];
+   SymTable_T oSymTable;
+   char *pcKeys;
+   double adBase[2];
+   double dMops;
+   int iThreadCount;
+   int iGlobalLock;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Timing %d%% gets, %d%% puts, %d%% removes.\n", iGetPercent,
+      iPutPercent, 100 - iGetPercent - iPutPercent);
+   fflush(stdout);
+
+   if (iBindingCount == 0)
+      return;
+   pcKeys = makeKeys(2 * iBindingCount);
+   ASSURE(pcKeys != NULL);
+   if (pcKeys == NULL)
+      return;
+
+   for (iThreadCount = 1; iThreadCount <= MAX_THREADS; iThreadCount *= 2)
+   {
+      printf("%2d threads:", iThreadCount);
+      for (iGlobalLock = 1; iGlobalLock >= 0; iGlobalLock--)
+      {
+         oSymTable = SymTable_new();
+         ASSURE(oSymTable != NULL);
+         for (i = 0; i < iBindingCount; i++)
+            ASSURE(SymTable_put(oSymTable,
+               pcKeys + (size_t)i * 2 * MAX_KEY_LENGTH, NULL));
+
+         for (i = 0; i < iThreadCount; i++)
+         {
+            asWorkers[i].oSymTable = oSymTable;
+            asWorkers[i].pcKeys = pcKeys;
+            asWorkers[i].iKeyCount = 2 * iBindingCount;
+            asWorkers[i].iOpCount = OP_COUNT / iThreadCount;
+            asWorkers[i].iGetPercent = iGetPercent;
+            asWorkers[i].iPutPercent = iPutPercent;
+            asWorkers[i].iGlobalLock = iGlobalLock;
+            asWorkers[i].ulRandom = (unsigned long)i + 1;
+         }
+         dMops = (double)(OP_COUNT / iThreadCount * iThreadCount) /
+            runThreads(mixedWork, asWorkers, iThreadCount) * 1e3;
+         if (iThreadCount == 1)
+            adBase[iGlobalLock] = dMops;
+         printf("  %s %7.2f Mops/s (%.2fx)",
+            iGlobalLock ? "global mutex" : "concurrent", dMops,
+            dMops / adBase[iGlobalLock]);
+
+         SymTable_free(oSymTable);
+      }
+      printf("\n");
+      fflush(stdout);
+   }
+
+   free(pcKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Time threads that put iBindingCount distinct keys between them into
+   an empty SymTable object, which therefore keeps expanding, at 1 to
+   MAX_THREADS threads, once with every call wrapped in one global
+   mutex and once without.  Write the throughput of each and the
+   longest that any one put took to stdout. */
+
+static void timeGrowth(int iBindingCount)
+{
+   struct Worker asWorkers[MAX_THREADS];
+   SymTable_T oSymTable;
+   char *pcKeys;
+   double dWorstNs;
+   double dMops;
+   int iPerThread;
+   int iThreadCount;
+   int iGlobalLock;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Timing puts into a growing SymTable.\n");
+   fflush(stdout);
+
+   if (iBindingCount == 0)
+      return;
+   pcKeys = makeKeys(iBindingCount);
+   ASSURE(pcKeys != NULL);
+   if (pcKeys == NULL)
+      return;
+
+   for (iThreadCount = 1; iThreadCount <= MAX_THREADS; iThreadCount *= 2)
+   {
+      printf("%2d threads:", iThreadCount);
+      iPerThread = iBindingCount / iThreadCount;
+      for (iGlobalLock = 1; iGlobalLock >= 0; iGlobalLock--)
+      {
+         oSymTable = SymTable_new();
+         ASSURE(oSymTable != NULL);
+         for (i = 0; i < iThreadCount; i++)
+         {
+            asWorkers[i].oSymTable = oSymTable;
+            asWorkers[i].pcKeys = pcKeys + (size_t)i * iPerThread *
+               MAX_KEY_LENGTH;
+            asWorkers[i].iKeyCount = iPerThread;
+            asWorkers[i].iGlobalLock = iGlobalLock;
+         }
+         dMops = (double)(iPerThread * iThreadCount) /
+            runThreads(putTimed, asWorkers, iThreadCount) * 1e3;
+         dWorstNs = 0.0;
+         for (i = 0; i < iThreadCount; i++)
+            if (asWorkers[i].dWorstNs > dWorstNs)
+               dWorstNs = asWorkers[i].dWorstNs;
+         printf("  %s %7.2f Mops/s, worst put %8.1f us",
+            iGlobalLock ? "global mutex" : "concurrent", dMops,
+            dWorstNs / 1e3);
+
+         SymTable_free(oSymTable);
+      }
+      printf("\n");
+      fflush(stdout);
+   }
+
+   free(pcKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test a SymTable object that several threads use at once.  As
+   always, argc is the command-line argument count, argv contains the
+   command-line arguments, and argv[0] is the name of the executable
+   binary file.  argv[1] is the number of bindings the benchmarks
+   start with.  argv[2], if present, must be "bench" and turns on
+   the scaling benchmarks.  Exit with EXIT_FAILURE if argv[1] is
+   missing or not numeric, or argv[2] is not "bench".  Otherwise
+   return 0. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount;
+   int iBenchmark = 0;
+
+   if ((argc != 2) && (argc != 3))
+   {
+      fprintf(stderr, "Usage: %s bindingcount [bench]\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   if (argc == 3)
+   {
+      if (strcmp(argv[2], "bench") != 0)
+      {
+         fprintf(stderr, "Usage: %s bindingcount [bench]\n", argv[0]);
+         exit(EXIT_FAILURE);
+      }
+      iBenchmark = 1;
+   }
+
+   if (sscanf(argv[1], "%d", &iBindingCount) != 1)
+   {
+      fprintf(stderr, "bindingcount must be numeric\n");
+      exit(EXIT_FAILURE);
+   }
+   if (iBindingCount < 0)
+   {
+      fprintf(stderr, "bindingcount cannot be negative\n");
+      exit(EXIT_FAILURE);
+   }
+
+   testDisjointKeys();
+   testSharedKeys();
+   testReadersDuringWrites();
+   testIteratorsDuringWrites();
+   if (iBenchmark)
+   {
+      timeMixedWork(iBindingCount, 100, 0);
+      timeMixedWork(iBindingCount, 90, 5);
+      timeMixedWork(iBindingCount, 50, 25);
+      timeGrowth(iBindingCount);
+   }
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
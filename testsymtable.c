@@ -3,6 +3,9 @@
 /* Author: Bob Dondero                                                */
 /*--------------------------------------------------------------------*/
 
+/* for clock_gettime() */
+#define _POSIX_C_SOURCE 200112L
+
 #include "symtable.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -696,6 +699,48 @@ static void testTableOfTables(void)
 
 /*--------------------------------------------------------------------*/
 
+/* Count the binding whose key is pcKey and whose value is pvValue in
+   the size_t that pvExtra points to. */
+
+static void countBinding(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   assert(pcKey != NULL);
+   assert(pvExtra != NULL);
+
+   (void)pvValue;
+   (*(size_t*)pvExtra)++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The number of 12 character blocks in a key made by
+   makeCollidingKey(), and so the number of keys it can make is
+   2 to the COLLIDING_BLOCKS. */
+
+enum {COLLIDING_BLOCKS = 11, BLOCK_LENGTH = 12};
+
+/* Write to pcKey the key number iIndex of a set of keys that all have
+   the same hash under the hash function from the assignment
+   specification.  The two blocks have the same hash and the same
+   length, so any string of them does too: bit i of iIndex picks block
+   i.  pcKey must have room for COLLIDING_BLOCKS * BLOCK_LENGTH + 1
+   characters. */
+
+static void makeCollidingKey(char *pcKey, int iIndex)
+{
+   static const char acBlocks[2][BLOCK_LENGTH + 1] =
+      {"dajaehaaraea", "acapaagmaeah"};
+   int i;
+
+   for (i = 0; i < COLLIDING_BLOCKS; i++)
+      memcpy(pcKey + i * BLOCK_LENGTH, acBlocks[(iIndex >> i) & 1],
+         BLOCK_LENGTH);
+   pcKey[COLLIDING_BLOCKS * BLOCK_LENGTH] = '\0';
+}
+
+/*--------------------------------------------------------------------*/
+
 /* Test the ability of a SymTable object to handle collisions.  This
    test assumes that a SymTable object is implemented as a hash table,
    that there are 509 buckets in the hash table, and that the
@@ -704,8 +749,14 @@ static void testTableOfTables(void)
 
 static void testCollisions(void)
 {
+   enum {KEY_COUNT = 1 << COLLIDING_BLOCKS,
+      KEY_LENGTH = COLLIDING_BLOCKS * BLOCK_LENGTH + 1, KEPT_COUNT = 5};
+
    SymTable_T oSymTable;
    int iSuccessful;
+   char *pcKeys;
+   size_t uCount;
+   int i;
    char acCenterField[] = "pitcher";
    char acCatcher[] = "catcher";
    char acFirstBase[] = "first base";
@@ -772,182 +823,2823 @@ static void testCollisions(void)
    ASSURE(pcValue == acRightField);
 
    SymTable_free(oSymTable);
+
+   /* Thousands of keys whose full hashes are all the same, so they
+      share one bucket whatever the bucket count. */
+
+   pcKeys = (char*)malloc((size_t)KEY_COUNT * KEY_LENGTH);
+   ASSURE(pcKeys != NULL);
+   if (pcKeys == NULL)
+      return;
+   for (i = 0; i < KEY_COUNT; i++)
+      makeCollidingKey(pcKeys + i * KEY_LENGTH, i);
+   ASSURE(SymTable_hashKey(pcKeys) ==
+      SymTable_hashKey(pcKeys + (KEY_COUNT - 1) * KEY_LENGTH));
+
+   /* Expand incrementally where supported, so the colliding keys are
+      looked up while they are split between two bucket arrays. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   (void)SymTable_setIncremental(oSymTable, 1);
+
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      iSuccessful = SymTable_put(oSymTable, pcKeys + i * KEY_LENGTH,
+         pcKeys + i * KEY_LENGTH);
+      ASSURE(iSuccessful);
+   }
+   iSuccessful = SymTable_put(oSymTable, pcKeys, acCatcher);
+   ASSURE(! iSuccessful);
+   ASSURE(SymTable_getLength(oSymTable) == KEY_COUNT);
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      pcValue = SymTable_get(oSymTable, pcKeys + i * KEY_LENGTH);
+      ASSURE(pcValue == pcKeys + i * KEY_LENGTH);
+   }
+   uCount = 0;
+   SymTable_map(oSymTable, countBinding, &uCount);
+   ASSURE(uCount == KEY_COUNT);
+
+   /* Remove all but a few, so the bucket shrinks back to a chain. */
+   for (i = KEPT_COUNT; i < KEY_COUNT; i++)
+   {
+      pcValue = SymTable_remove(oSymTable, pcKeys + i * KEY_LENGTH);
+      ASSURE(pcValue == pcKeys + i * KEY_LENGTH);
+   }
+   ASSURE(SymTable_getLength(oSymTable) == KEPT_COUNT);
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      pcValue = SymTable_get(oSymTable, pcKeys + i * KEY_LENGTH);
+      ASSURE(pcValue == ((i < KEPT_COUNT) ? pcKeys + i * KEY_LENGTH
+                                           : NULL));
+   }
+   for (i = KEPT_COUNT; i < KEY_COUNT; i++)
+   {
+      iSuccessful = SymTable_put(oSymTable, pcKeys + i * KEY_LENGTH,
+         acFirstBase);
+      ASSURE(iSuccessful);
+   }
+   pcValue = SymTable_get(oSymTable,
+      pcKeys + (KEY_COUNT - 1) * KEY_LENGTH);
+   ASSURE(pcValue == acFirstBase);
+
+   SymTable_free(oSymTable);
+   free(pcKeys);
 }
 
 /*--------------------------------------------------------------------*/
 
-/* Test the ability of a SymTable object to be large, that is, to
-   contain iBindingCount bindings. Write the time consumed to stdout. */
+/* Test the SymTable_setMaxLoad() function. */
 
-static void testLargeTable(int iBindingCount)
+static void testMaxLoad(void)
 {
-   enum {MAX_KEY_LENGTH = 10};
+   enum {BINDING_COUNT = 5000, MAX_KEY_LENGTH = 10};
 
    SymTable_T oSymTable;
-   SymTable_T oSymTableSmall;
    char acKey[MAX_KEY_LENGTH];
+   char acShortstop[] = "Shortstop";
    char *pcValue;
    int i;
-   int iSmall;
-   int iLarge;
    int iSuccessful;
-   clock_t iInitialClock;
-   clock_t iFinalClock;
-   size_t uLength = 0;
-   size_t uLength2;
+   size_t uLength;
 
    printf("------------------------------------------------------\n");
-   printf("Testing a potentially large SymTable object.\n");
-   printf("No output except CPU time consumed should appear here:\n");
+   printf("Testing the SymTable_setMaxLoad() function.\n");
+   printf("No output should appear here:\n");
    fflush(stdout);
 
-   /* Note the current time. */
-   iInitialClock = clock();
-
-   /* Create oSymTableSmall, and put a couple of bindings into it. */
-   oSymTableSmall = SymTable_new();
-   ASSURE(oSymTableSmall != NULL);
-   iSuccessful = SymTable_put(oSymTableSmall, "xxx", "xxx");
-   ASSURE(iSuccessful);
-   iSuccessful = SymTable_put(oSymTableSmall, "yyy", "yyy");
-   ASSURE(iSuccessful);
-
-   /* Create oSymTable, the primary SymTable object. */
    oSymTable = SymTable_new();
    ASSURE(oSymTable != NULL);
 
-   /* Put iBindingCount new bindings into oSymTable.  Each binding's
-      key and value contain the same characters. */
-   for (i = 0; i < iBindingCount; i++)
+   iSuccessful = SymTable_setMaxLoad(oSymTable, 0.0);
+   ASSURE(! iSuccessful);
+   iSuccessful = SymTable_setMaxLoad(oSymTable, -1.0);
+   ASSURE(! iSuccessful);
+   iSuccessful = SymTable_setMaxLoad(oSymTable, 0.5);
+   ASSURE(iSuccessful);
+
+   for (i = 0; i < BINDING_COUNT; i++)
    {
       sprintf(acKey, "%d", i);
-      pcValue = (char*)malloc(sizeof(char) * (strlen(acKey) + 1));
-      ASSURE(pcValue != NULL);
-      strcpy(pcValue, acKey);
-      iSuccessful = SymTable_put(oSymTable, acKey, pcValue);
+      iSuccessful = SymTable_put(oSymTable, acKey, acShortstop);
       ASSURE(iSuccessful);
-      uLength = SymTable_getLength(oSymTable);
-      ASSURE(uLength == (size_t)(i+1));
    }
 
-   /* Get each binding's value, and make sure that it contains
-      the same characters as its key. */
-   iSmall = 0;
-   iLarge = iBindingCount - 1;
-   while (iSmall < iLarge)
+   /* Lowering the max load of a full SymTable must keep every
+      binding. */
+   iSuccessful = SymTable_setMaxLoad(oSymTable, 0.25);
+   ASSURE(iSuccessful);
+
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == BINDING_COUNT);
+
+   for (i = 0; i < BINDING_COUNT; i++)
    {
-      /* Get the smallest of the remaining bindings. */
-      sprintf(acKey, "%d", iSmall);
-      pcValue = (char*)SymTable_get(oSymTable, acKey);
-      ASSURE(pcValue != NULL);
-      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
-      iSmall++;
-      /* Get the largest of the remaining bindings. */
-      sprintf(acKey, "%d", iLarge);
+      sprintf(acKey, "%d", i);
       pcValue = (char*)SymTable_get(oSymTable, acKey);
-      ASSURE(pcValue != NULL);
-      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
-      iLarge--;
+      ASSURE(pcValue == acShortstop);
    }
-   /* Get the middle binding -- if there is one. */
-   if (iSmall == iLarge)
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test a SymTable object that expands incrementally, while some of
+   its bindings are still in the old set of buckets. */
+
+static void testIncremental(void)
+{
+   enum {BINDING_COUNT = 5000, MAX_KEY_LENGTH = 10};
+
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   char acShortstop[] = "Shortstop";
+   char *pcValue;
+   int i;
+   int iSuccessful;
+   size_t uCount;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a SymTable object that expands incrementally.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   /* Not every implementation supports incremental expansion. */
+   if (! SymTable_setIncremental(oSymTable, 1))
    {
-      sprintf(acKey, "%d", iSmall);
-      pcValue = (char*)SymTable_get(oSymTable, acKey);
-      ASSURE(pcValue != NULL);
-      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
+      SymTable_free(oSymTable);
+      return;
    }
 
-   /* Remove each binding. Also free each binding's value. */
-   iSmall = 0;
-   iLarge = iBindingCount - 1;
-   while (iSmall < iLarge)
+   for (i = 0; i < BINDING_COUNT; i++)
    {
-      /* Remove the smallest of the remaining bindings. */
-      sprintf(acKey, "%d", iSmall);
-      pcValue = (char*)SymTable_remove(oSymTable, acKey);
-      ASSURE(pcValue != NULL);
-      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
-      free(pcValue);
-      uLength--;
-      uLength2 = SymTable_getLength(oSymTable);
-      ASSURE(uLength2 == uLength);
-      iSmall++;
-      /* Remove the largest of the remaining bindings. */
-      sprintf(acKey, "%d", iLarge);
-      pcValue = (char*)SymTable_remove(oSymTable, acKey);
-      ASSURE(pcValue != NULL);
-      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
-      free(pcValue);
-      uLength--;
-      uLength2 = SymTable_getLength(oSymTable);
-      ASSURE(uLength2 == uLength);
-      iLarge--;
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, acShortstop);
+      ASSURE(iSuccessful);
+      /* Every binding must stay reachable mid migration. */
+      iSuccessful = SymTable_put(oSymTable, "0", acShortstop);
+      ASSURE(! iSuccessful);
+      pcValue = (char*)SymTable_get(oSymTable, "0");
+      ASSURE(pcValue == acShortstop);
    }
-   /* Remove the middle binding -- if there is one. */
-   if (iSmall == iLarge)
+
+   uCount = 0;
+   SymTable_map(oSymTable, countBinding, &uCount);
+   ASSURE(uCount == BINDING_COUNT);
+
+   for (i = 0; i < BINDING_COUNT; i += 2)
    {
-      sprintf(acKey, "%d", iSmall);
+      sprintf(acKey, "%d", i);
       pcValue = (char*)SymTable_remove(oSymTable, acKey);
-      ASSURE(pcValue != NULL);
-      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
-      free(pcValue);
-      uLength--;
-      uLength2 = SymTable_getLength(oSymTable);
-      ASSURE(uLength2 == uLength);  
+      ASSURE(pcValue == acShortstop);
+   }
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      pcValue = (char*)SymTable_get(oSymTable, acKey);
+      ASSURE(pcValue == ((i % 2 == 0) ? NULL : acShortstop));
    }
+   ASSURE(SymTable_getLength(oSymTable) == BINDING_COUNT / 2);
 
-   /* Make sure oSymTableSmall hasn't been corrupted by expansion
-      of oSymTable. */
-   pcValue = (char*)SymTable_get(oSymTableSmall, "xxx");
-   ASSURE((pcValue != NULL) && (strcmp(pcValue, "xxx") == 0));
-   pcValue = (char*)SymTable_get(oSymTableSmall, "yyy");
-   ASSURE((pcValue != NULL) && (strcmp(pcValue, "yyy") == 0));
+   iSuccessful = SymTable_setIncremental(oSymTable, 0);
+   ASSURE(iSuccessful);
 
-   /* Free both SymTable objects. */
    SymTable_free(oSymTable);
-   SymTable_free(oSymTableSmall);
+}
 
-   /* Note the current time, and print the time consumed to stdout. */
-   iFinalClock = clock();
-   printf("CPU time (%d bindings):  %f seconds\n", iBindingCount,
-      ((double)(iFinalClock - iInitialClock)) / CLOCKS_PER_SEC);
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTable_intern(), SymTable_putAtom() and
+   SymTable_getAtom() functions. */
+
+static void testAtoms(void)
+{
+   SymTable_T oSymTable;
+   const char *pcJeter;
+   const char *pcRuth;
+   char acJeter[] = "Jeter";
+   char acShortstop[] = "Shortstop";
+   char acRightField[] = "RightField";
+   char *pcValue;
+   int iSuccessful;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_intern() function.\n");
+   printf("No output should appear here:\n");
    fflush(stdout);
+
+   pcJeter = SymTable_intern("Jeter");
+   ASSURE(pcJeter != NULL);
+   ASSURE(strcmp(pcJeter, "Jeter") == 0);
+   ASSURE(SymTable_intern("Jeter") == pcJeter);
+   ASSURE(SymTable_intern(acJeter) == pcJeter);
+   pcRuth = SymTable_intern("Ruth");
+   ASSURE(pcRuth != NULL);
+   ASSURE(pcRuth != pcJeter);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   iSuccessful = SymTable_putAtom(oSymTable, pcJeter, acShortstop);
+   ASSURE(iSuccessful);
+   pcValue = (char*)SymTable_getAtom(oSymTable, pcJeter);
+   ASSURE(pcValue == acShortstop);
+
+   /* Atom and string keys are the same keys. */
+   pcValue = (char*)SymTable_get(oSymTable, acJeter);
+   ASSURE(pcValue == acShortstop);
+   iSuccessful = SymTable_put(oSymTable, acJeter, acRightField);
+   ASSURE(! iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "Ruth", acRightField);
+   ASSURE(iSuccessful);
+   pcValue = (char*)SymTable_getAtom(oSymTable, pcRuth);
+   ASSURE(pcValue == acRightField);
+   iSuccessful = SymTable_putAtom(oSymTable, pcRuth, acShortstop);
+   ASSURE(! iSuccessful);
+   pcValue = (char*)SymTable_getAtom(oSymTable, SymTable_intern("Gehrig"));
+   ASSURE(pcValue == NULL);
+   ASSURE(SymTable_getLength(oSymTable) == 2);
+
+   pcValue = (char*)SymTable_remove(oSymTable, "Jeter");
+   ASSURE(pcValue == acShortstop);
+   pcValue = (char*)SymTable_getAtom(oSymTable, pcJeter);
+   ASSURE(pcValue == NULL);
+   ASSURE(strcmp(pcJeter, "Jeter") == 0);
+
+   SymTable_free(oSymTable);
 }
 
 /*--------------------------------------------------------------------*/
 
-/* Test the SymTable ADT.  Write the output of the tests to stdout.
-   As always, argc is the command-line argument count, argv contains
-   the command-line arguments, and argv[0] is the name of the
-   executable binary file. argv[1] is the number of bindings to put
-   into a potentially large SymTable object.  Exit with EXIT_FAILURE
-   if argv[1] is missing or not numeric.  Otherwise return 0. */
+/* Test the SymTable_putBorrowed() function. */
 
-int main(int argc, char *argv[])
+static void testBorrowedKeys(void)
 {
-   int iBindingCount;
+   SymTable_T oSymTable;
+   char acJeter[] = "Jeter";
+   char acLongKey[] = "Mariano Rivera, closer, New York Yankees";
+   char acShortstop[] = "Shortstop";
+   char acCloser[] = "Closer";
+   char *pcValue;
+   int iSuccessful;
 
-   if (argc != 2)
-   {
-      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
-      exit(EXIT_FAILURE);
-   }
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_putBorrowed() function.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
 
-   if (sscanf(argv[1], "%d", &iBindingCount) != 1)
-   {
-      fprintf(stderr, "bindingcount must be numeric\n");
-      exit(EXIT_FAILURE);
-   }
-   if (iBindingCount < 0)
-   {
-      fprintf(stderr, "bindingcount cannot be negative\n");
-      exit(EXIT_FAILURE);
-   }
-   
-#ifndef S_SPLINT_S
-   setCpuTimeLimit();
-#endif
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   iSuccessful = SymTable_putBorrowed(oSymTable, acJeter, acShortstop);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_putBorrowed(oSymTable, acLongKey, acCloser);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "Jeter", acCloser);
+   ASSURE(! iSuccessful);
+   iSuccessful = SymTable_putBorrowed(oSymTable, "Jeter", acCloser);
+   ASSURE(! iSuccessful);
+
+   pcValue = (char*)SymTable_get(oSymTable, "Jeter");
+   ASSURE(pcValue == acShortstop);
+   pcValue = (char*)SymTable_get(oSymTable,
+      "Mariano Rivera, closer, New York Yankees");
+   ASSURE(pcValue == acCloser);
+
+   /* Removing a binding and freeing the SymTable object must leave
+      the borrowed keys alone. */
+   pcValue = (char*)SymTable_remove(oSymTable, "Jeter");
+   ASSURE(pcValue == acShortstop);
+   ASSURE(strcmp(acJeter, "Jeter") == 0);
+   ASSURE(SymTable_getLength(oSymTable) == 1);
+
+   SymTable_free(oSymTable);
+   ASSURE(strcmp(acLongKey, "Mariano Rivera, closer, New York Yankees")
+      == 0);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTable_getOrPut() and SymTable_upsert() functions. */
+
+static void testGetOrPut(void)
+{
+   enum {WORD_COUNT = 7};
+
+   SymTable_T oSymTable;
+   const char *apcWords[WORD_COUNT] =
+      {"Ruth", "Gehrig", "Ruth", "Mantle", "Ruth", "Gehrig", "Jeter"};
+   int aiCounts[WORD_COUNT];
+   void **ppvValue;
+   void *pvOldValue;
+   char acShortstop[] = "Shortstop";
+   char acCenterField[] = "CenterField";
+   char *pcValue;
+   int iFound;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_getOrPut() and SymTable_upsert() "
+      "functions.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   /* Count words, updating each count in place. */
+   for (i = 0; i < WORD_COUNT; i++)
+   {
+      aiCounts[i] = 0;
+      ppvValue = SymTable_getOrPut(oSymTable, apcWords[i], &aiCounts[i],
+         &iFound);
+      ASSURE(ppvValue != NULL);
+      ASSURE(iFound == (i == 2 || i == 4 || i == 5));
+      (*(int*)*ppvValue)++;
+   }
+   ASSURE(SymTable_getLength(oSymTable) == 4);
+   ASSURE(*(int*)SymTable_get(oSymTable, "Ruth") == 3);
+   ASSURE(*(int*)SymTable_get(oSymTable, "Gehrig") == 2);
+   ASSURE(*(int*)SymTable_get(oSymTable, "Mantle") == 1);
+
+   ppvValue = SymTable_getOrPut(oSymTable, "Jeter", NULL, NULL);
+   ASSURE(ppvValue != NULL);
+   *ppvValue = acShortstop;
+   pcValue = (char*)SymTable_get(oSymTable, "Jeter");
+   ASSURE(pcValue == acShortstop);
+
+   iSuccessful = SymTable_upsert(oSymTable, "Jeter", acCenterField,
+      &pvOldValue);
+   ASSURE(iSuccessful);
+   ASSURE(pvOldValue == acShortstop);
+   pcValue = (char*)SymTable_get(oSymTable, "Jeter");
+   ASSURE(pcValue == acCenterField);
+
+   iSuccessful = SymTable_upsert(oSymTable, "Maris", acShortstop,
+      &pvOldValue);
+   ASSURE(iSuccessful);
+   ASSURE(pvOldValue == NULL);
+   iSuccessful = SymTable_upsert(oSymTable, "Maris", acCenterField, NULL);
+   ASSURE(iSuccessful);
+   pcValue = (char*)SymTable_get(oSymTable, "Maris");
+   ASSURE(pcValue == acCenterField);
+   ASSURE(SymTable_getLength(oSymTable) == 5);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the length delimited functions SymTable_putN(),
+   SymTable_getN(), SymTable_containsN(), SymTable_replaceN() and
+   SymTable_removeN(). */
+
+static void testBinaryKeys(void)
+{
+   SymTable_T oSymTable;
+   const char acBuffer[] = "Ruth Gehrig Mantle";
+   const char acNulKey1[] = {'a', '\0', 'b'};
+   const char acNulKey2[] = {'a', '\0', 'c'};
+   char acRightField[] = "RightField";
+   char acFirstBase[] = "FirstBase";
+   char acCenterField[] = "CenterField";
+   char *pcValue;
+   int iSuccessful;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the length delimited key functions.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   /* Keys can be slices of a larger buffer. */
+   iSuccessful = SymTable_putN(oSymTable, acBuffer, 4, acRightField);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_putN(oSymTable, acBuffer + 5, 6, acFirstBase);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_putN(oSymTable, acBuffer + 12, 6,
+      acCenterField);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "Ruth", acFirstBase);
+   ASSURE(! iSuccessful);
+   pcValue = (char*)SymTable_get(oSymTable, "Gehrig");
+   ASSURE(pcValue == acFirstBase);
+   pcValue = (char*)SymTable_getN(oSymTable, "Mantle", 6);
+   ASSURE(pcValue == acCenterField);
+   ASSURE(SymTable_containsN(oSymTable, acBuffer, 4));
+   ASSURE(! SymTable_containsN(oSymTable, acBuffer, 3));
+   ASSURE(! SymTable_containsN(oSymTable, acBuffer, 5));
+
+   /* Keys can contain '\0' bytes. */
+   iSuccessful = SymTable_putN(oSymTable, acNulKey1, 3, acRightField);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_putN(oSymTable, acNulKey2, 3, acFirstBase);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "a", acCenterField);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_getLength(oSymTable) == 6);
+   pcValue = (char*)SymTable_getN(oSymTable, acNulKey1, 3);
+   ASSURE(pcValue == acRightField);
+   pcValue = (char*)SymTable_getN(oSymTable, acNulKey2, 3);
+   ASSURE(pcValue == acFirstBase);
+   pcValue = (char*)SymTable_getN(oSymTable, acNulKey1, 1);
+   ASSURE(pcValue == acCenterField);
+   ASSURE(! SymTable_containsN(oSymTable, acNulKey1, 2));
+
+   pcValue = (char*)SymTable_replaceN(oSymTable, acNulKey1, 3,
+      acCenterField);
+   ASSURE(pcValue == acRightField);
+   pcValue = (char*)SymTable_removeN(oSymTable, acNulKey2, 3);
+   ASSURE(pcValue == acFirstBase);
+   pcValue = (char*)SymTable_getN(oSymTable, acNulKey1, 3);
+   ASSURE(pcValue == acCenterField);
+   pcValue = (char*)SymTable_removeN(oSymTable, acNulKey2, 3);
+   ASSURE(pcValue == NULL);
+
+   /* The empty key is a key too. */
+   iSuccessful = SymTable_putN(oSymTable, acBuffer, 0, acRightField);
+   ASSURE(iSuccessful);
+   pcValue = (char*)SymTable_get(oSymTable, "");
+   ASSURE(pcValue == acRightField);
+   ASSURE(SymTable_getLength(oSymTable) == 6);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTable_hashKey() function and the functions that take a
+   precomputed hash, looking a key up in a chain of scopes. */
+
+static void testHashedKeys(void)
+{
+   enum {SCOPE_COUNT = 3};
+
+   SymTable_T aoScopes[SCOPE_COUNT];
+   char acGlobal[] = "Global";
+   char acLocal[] = "Local";
+   char acKey[] = "Jeter";
+   char *pcValue;
+   size_t uHash;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_hashKey() function.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   uHash = SymTable_hashKey("Jeter");
+   ASSURE(uHash == SymTable_hashKey(acKey));
+
+   for (i = 0; i < SCOPE_COUNT; i++)
+   {
+      aoScopes[i] = SymTable_new();
+      ASSURE(aoScopes[i] != NULL);
+   }
+   iSuccessful = SymTable_putHashed(aoScopes[0], "Jeter", uHash,
+      acGlobal);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_putHashed(aoScopes[0], acKey, uHash, acLocal);
+   ASSURE(! iSuccessful);
+   pcValue = (char*)SymTable_get(aoScopes[0], "Jeter");
+   ASSURE(pcValue == acGlobal);
+
+   /* Look the key up from the innermost scope out. */
+   pcValue = NULL;
+   for (i = SCOPE_COUNT - 1; i >= 0 && pcValue == NULL; i--)
+      pcValue = (char*)SymTable_getHashed(aoScopes[i], acKey, uHash);
+   ASSURE(pcValue == acGlobal);
+
+   iSuccessful = SymTable_put(aoScopes[2], "Jeter", acLocal);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_containsHashed(aoScopes[2], acKey, uHash));
+   ASSURE(! SymTable_containsHashed(aoScopes[1], acKey, uHash));
+   pcValue = (char*)SymTable_removeHashed(aoScopes[2], acKey, uHash);
+   ASSURE(pcValue == acLocal);
+   ASSURE(! SymTable_contains(aoScopes[2], "Jeter"));
+
+   for (i = 0; i < SCOPE_COUNT; i++)
+      SymTable_free(aoScopes[i]);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTable_getMany() function. */
+
+static void testGetMany(void)
+{
+   enum {BINDING_COUNT = 100, KEY_COUNT = 150, MAX_KEY_LENGTH = 10};
+
+   SymTable_T oSymTable;
+   char aacKeys[KEY_COUNT][MAX_KEY_LENGTH];
+   const char *apcKeys[KEY_COUNT];
+   void *apvValues[KEY_COUNT];
+   char acShortstop[] = "Shortstop";
+   int i;
+   int iSuccessful;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_getMany() function.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(aacKeys[0], "%d", i);
+      iSuccessful = SymTable_put(oSymTable, aacKeys[0],
+         acShortstop + i % 9);
+      ASSURE(iSuccessful);
+   }
+
+   /* Keys KEY_COUNT - 1 down to 0, so some are missing and they do not
+      come in the order they were put in. */
+   for (i = 0; i < KEY_COUNT; i++)
+   {
+      sprintf(aacKeys[i], "%d", KEY_COUNT - 1 - i);
+      apcKeys[i] = aacKeys[i];
+      apvValues[i] = acShortstop;
+   }
+   SymTable_getMany(oSymTable, apcKeys, KEY_COUNT, apvValues);
+   for (i = 0; i < KEY_COUNT; i++)
+      ASSURE(apvValues[i] == SymTable_get(oSymTable, apcKeys[i]));
+   ASSURE(apvValues[KEY_COUNT - 1] == acShortstop);
+   ASSURE(apvValues[0] == NULL);
+
+   SymTable_getMany(oSymTable, apcKeys, 0, apvValues);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add 1 to the int that pvValue points to.  pcKey and pvExtra are
+   unused. */
+
+static void incrementBinding(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   assert(pcKey != NULL);
+   assert(pvValue != NULL);
+
+   (void)pvExtra;
+   (*(int*)pvValue)++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTable_mapParallel() function: every binding must be
+   visited exactly once, whatever the number of threads, and also
+   while a SymTable object is expanding incrementally. */
+
+static void testMapParallel(void)
+{
+   enum {BINDING_COUNT = 5000, MAX_KEY_LENGTH = 10, CHECK_EVERY = 97,
+      THREAD_COUNT = 4};
+
+   static const size_t auThreads[] = {0, 1, 2, THREAD_COUNT};
+
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   int *piCounts;
+   int i;
+   int j;
+   int iSuccessful;
+   size_t u;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_mapParallel() function.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   piCounts = (int*)calloc(BINDING_COUNT, sizeof(int));
+   ASSURE(piCounts != NULL);
+   if (piCounts == NULL)
+      return;
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   SymTable_mapParallel(oSymTable, incrementBinding, NULL,
+      THREAD_COUNT);
+
+   /* Not every implementation supports incremental expansion, but
+      those that do must also map the bindings not yet migrated. */
+   (void)SymTable_setIncremental(oSymTable, 1);
+
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &piCounts[i]);
+      ASSURE(iSuccessful);
+      if (i % CHECK_EVERY != 0 && i != BINDING_COUNT - 1)
+         continue;
+      for (u = 0; u < sizeof(auThreads) / sizeof(auThreads[0]); u++)
+      {
+         memset(piCounts, 0, BINDING_COUNT * sizeof(int));
+         SymTable_mapParallel(oSymTable, incrementBinding, NULL,
+            auThreads[u]);
+         for (j = 0; j < BINDING_COUNT; j++)
+            ASSURE(piCounts[j] == (j <= i));
+      }
+   }
+
+   SymTable_free(oSymTable);
+   free(piCounts);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTable_iterBegin(), SymTable_iterNext() and
+   SymTable_iterEnd() functions, also while the SymTable object is
+   changed (and expands) in the middle of an iteration. */
+
+static void testIterator(void)
+{
+   enum {BINDING_COUNT = 3000, MAX_KEY_LENGTH = 16, PUT_EVERY = 3,
+      MIGRATING_COUNT = 600};
+
+   SymTable_T oSymTable;
+   SymTableIter_T oIter;
+   SymTableIter_T oIter2;
+   char acKey[MAX_KEY_LENGTH];
+   const char *pcKey;
+   void *pvValue;
+   int *piCounts;
+   int i;
+   int j;
+   int iIndex;
+   int iPutCount;
+   int iSuccessful;
+   size_t uLength;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_iterNext() function.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* The counts of the original bindings, then of the ones put
+      during an iteration. */
+   piCounts = (int*)calloc((1 + PUT_EVERY) * BINDING_COUNT,
+      sizeof(int));
+   ASSURE(piCounts != NULL);
+   if (piCounts == NULL)
+      return;
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   /* Iterators must also see bindings that are not migrated yet. */
+   (void)SymTable_setIncremental(oSymTable, 1);
+
+   oIter = SymTable_iterBegin(oSymTable);
+   ASSURE(oIter != NULL);
+   ASSURE(! SymTable_iterNext(oIter, &pcKey, &pvValue));
+   SymTable_iterEnd(oIter);
+
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &piCounts[i]);
+      ASSURE(iSuccessful);
+   }
+
+   /* Two iterators at once each return every binding once. */
+   oIter = SymTable_iterBegin(oSymTable);
+   oIter2 = SymTable_iterBegin(oSymTable);
+   ASSURE(oIter != NULL && oIter2 != NULL);
+   while (SymTable_iterNext(oIter, &pcKey, &pvValue))
+   {
+      ASSURE(SymTable_get(oSymTable, pcKey) == pvValue);
+      (*(int*)pvValue)++;
+      ASSURE(SymTable_iterNext(oIter2, NULL, &pvValue));
+      (*(int*)pvValue)++;
+   }
+   ASSURE(! SymTable_iterNext(oIter2, NULL, NULL));
+   SymTable_iterEnd(oIter2);
+   SymTable_iterEnd(oIter);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      ASSURE(piCounts[i] == 2);
+      piCounts[i] = 0;
+   }
+
+   /* Stopping early. */
+   oIter = SymTable_iterBegin(oSymTable);
+   ASSURE(oIter != NULL);
+   ASSURE(SymTable_iterNext(oIter, &pcKey, NULL));
+   ASSURE(SymTable_contains(oSymTable, pcKey));
+   SymTable_iterEnd(oIter);
+
+   /* Put PUT_EVERY new bindings for every one returned, so the
+      SymTable object expands, and remove bindings that have and have
+      not been returned yet.  Bindings 3k are removed right after they
+      are returned, and bindings 3k + 2 once binding 3k + 1 is. */
+   uLength = BINDING_COUNT;
+   iPutCount = 0;
+   oIter = SymTable_iterBegin(oSymTable);
+   ASSURE(oIter != NULL);
+   while (SymTable_iterNext(oIter, &pcKey, &pvValue))
+   {
+      iIndex = (int)((int*)pvValue - piCounts);
+      ASSURE(iIndex >= 0 && iIndex < (1 + PUT_EVERY) * BINDING_COUNT);
+      piCounts[iIndex]++;
+      if (iIndex < BINDING_COUNT && iIndex % 3 == 0)
+      {
+         ASSURE(SymTable_remove(oSymTable, pcKey) == pvValue);
+         uLength--;
+      }
+      if (iIndex < BINDING_COUNT && iIndex % 3 == 1 &&
+         iIndex + 1 < BINDING_COUNT)
+      {
+         sprintf(acKey, "%d", iIndex + 1);
+         if (SymTable_remove(oSymTable, acKey) != NULL)
+            uLength--;
+      }
+      for (j = 0; j < PUT_EVERY && iPutCount < PUT_EVERY * BINDING_COUNT;
+         j++)
+      {
+         sprintf(acKey, "new%d", iPutCount);
+         iSuccessful = SymTable_put(oSymTable, acKey,
+            &piCounts[BINDING_COUNT + iPutCount]);
+         ASSURE(iSuccessful);
+         iPutCount++;
+         uLength++;
+      }
+   }
+   SymTable_iterEnd(oIter);
+   ASSURE(SymTable_getLength(oSymTable) == uLength);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      if (i % 3 == 2)
+         ASSURE(piCounts[i] <= 1);
+      else
+         ASSURE(piCounts[i] == 1);
+   }
+   for (i = BINDING_COUNT; i < (1 + PUT_EVERY) * BINDING_COUNT; i++)
+      ASSURE(piCounts[i] <= 1);
+
+   /* Whatever happened in between, a new iteration returns exactly
+      the bindings that are left. */
+   oIter = SymTable_iterBegin(oSymTable);
+   ASSURE(oIter != NULL);
+   while (SymTable_iterNext(oIter, &pcKey, &pvValue))
+   {
+      ASSURE(SymTable_get(oSymTable, pcKey) == pvValue);
+      uLength--;
+   }
+   SymTable_iterEnd(oIter);
+   ASSURE(uLength == 0);
+   SymTable_free(oSymTable);
+
+   /* An iteration of a table that is partway through migrating
+      returns each binding exactly once, and stops. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   (void)SymTable_setIncremental(oSymTable, 1);
+   for (i = 0; i < MIGRATING_COUNT; i++)
+   {
+      piCounts[i] = 0;
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &piCounts[i]);
+      ASSURE(iSuccessful);
+   }
+   oIter = SymTable_iterBegin(oSymTable);
+   ASSURE(oIter != NULL);
+   uLength = 0;
+   while (uLength <= MIGRATING_COUNT &&
+      SymTable_iterNext(oIter, &pcKey, &pvValue))
+   {
+      (*(int*)pvValue)++;
+      uLength++;
+   }
+   SymTable_iterEnd(oIter);
+   ASSURE(uLength == MIGRATING_COUNT);
+   for (i = 0; i < MIGRATING_COUNT; i++)
+      ASSURE(piCounts[i] == 1);
+
+   SymTable_free(oSymTable);
+   free(piCounts);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* RangeCheck is what checkRangeBinding() checks the keys it is given
+   against: pcLow <= key < pcHigh (either may be NULL), and that the
+   key starts with pcPrefix (if it is not NULL).  It counts the
+   bindings in uCount and the keys that fail in iFailures. */
+
+struct RangeCheck
+{
+   const char *pcLow;
+   const char *pcHigh;
+   const char *pcPrefix;
+   size_t uCount;
+   int iFailures;
+};
+
+/* Check the key pcKey against the RangeCheck that pvExtra points to,
+   and count it there. */
+
+static void checkRangeBinding(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   struct RangeCheck *psCheck = (struct RangeCheck*)pvExtra;
+
+   assert(pcKey != NULL);
+   assert(pvExtra != NULL);
+
+   (void)pvValue;
+   if (psCheck->pcLow != NULL && strcmp(pcKey, psCheck->pcLow) < 0)
+      psCheck->iFailures++;
+   if (psCheck->pcHigh != NULL && strcmp(pcKey, psCheck->pcHigh) >= 0)
+      psCheck->iFailures++;
+   if (psCheck->pcPrefix != NULL &&
+      strncmp(pcKey, psCheck->pcPrefix, strlen(psCheck->pcPrefix)) != 0)
+      psCheck->iFailures++;
+   psCheck->uCount++;
+}
+
+/* Return how many bindings of oSymTable SymTable_mapRange() maps for
+   pcLow and pcHigh, checking that each is in range. */
+
+static size_t countRange(SymTable_T oSymTable, const char *pcLow,
+   const char *pcHigh)
+{
+   struct RangeCheck sCheck;
+
+   sCheck.pcLow = pcLow;
+   sCheck.pcHigh = pcHigh;
+   sCheck.pcPrefix = NULL;
+   sCheck.uCount = 0;
+   sCheck.iFailures = 0;
+   SymTable_mapRange(oSymTable, pcLow, pcHigh, checkRangeBinding,
+      &sCheck);
+   ASSURE(sCheck.iFailures == 0);
+   return sCheck.uCount;
+}
+
+/* Return how many bindings of oSymTable SymTable_mapPrefix() maps for
+   pcPrefix, checking that each key starts with it. */
+
+static size_t countPrefix(SymTable_T oSymTable, const char *pcPrefix)
+{
+   struct RangeCheck sCheck;
+
+   sCheck.pcLow = NULL;
+   sCheck.pcHigh = NULL;
+   sCheck.pcPrefix = pcPrefix;
+   sCheck.uCount = 0;
+   sCheck.iFailures = 0;
+   SymTable_mapPrefix(oSymTable, pcPrefix, checkRangeBinding, &sCheck);
+   ASSURE(sCheck.iFailures == 0);
+   return sCheck.uCount;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTable_mapRange() and SymTable_mapPrefix() functions,
+   before and after most of the bindings in range are removed. */
+
+static void testMapRange(void)
+{
+   enum {BINDING_COUNT = 2000, MAX_KEY_LENGTH = 12, EXTRA_COUNT = 5};
+
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   char acShortstop[] = "Shortstop";
+   int i;
+   int iSuccessful;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_mapRange() and SymTable_mapPrefix()\n");
+   printf("functions.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   ASSURE(countRange(oSymTable, NULL, NULL) == 0);
+   ASSURE(countPrefix(oSymTable, "") == 0);
+
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "key%04d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, acShortstop);
+      ASSURE(iSuccessful);
+   }
+   /* Keys on either side of the "key" ones, and one whose '\0' makes
+      it come before "key0100" but still start with "key01". */
+   ASSURE(SymTable_put(oSymTable, "", acShortstop));
+   ASSURE(SymTable_put(oSymTable, "ke", acShortstop));
+   ASSURE(SymTable_put(oSymTable, "kez", acShortstop));
+   ASSURE(SymTable_put(oSymTable, "zebra", acShortstop));
+   ASSURE(SymTable_putN(oSymTable, "key01", 6, acShortstop));
+
+   ASSURE(countRange(oSymTable, "key0100", "key0200") == 100);
+   ASSURE(countRange(oSymTable, NULL, "key") == 2);
+   ASSURE(countRange(oSymTable, "key", NULL) == BINDING_COUNT + 3);
+   ASSURE(countRange(oSymTable, NULL, NULL) ==
+      BINDING_COUNT + EXTRA_COUNT);
+   ASSURE(countRange(oSymTable, "key0200", "key0100") == 0);
+   ASSURE(countRange(oSymTable, "key0150", "key0150") == 0);
+   ASSURE(countPrefix(oSymTable, "key01") == 101);
+   ASSURE(countPrefix(oSymTable, "") == BINDING_COUNT + EXTRA_COUNT);
+   ASSURE(countPrefix(oSymTable, "kez") == 1);
+   ASSURE(countPrefix(oSymTable, "kezz") == 0);
+
+   /* Leave only the keys with numbers divisible by 3. */
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      if (i % 3 != 0)
+      {
+         sprintf(acKey, "key%04d", i);
+         ASSURE(SymTable_remove(oSymTable, acKey) == acShortstop);
+      }
+   }
+   ASSURE(countRange(oSymTable, "key0100", "key0200") == 33);
+   ASSURE(countPrefix(oSymTable, "key01") == 34);
+   ASSURE(countRange(oSymTable, NULL, NULL) ==
+      SymTable_getLength(oSymTable));
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTable_newWithOptions() function with each hash. */
+
+static void testHashOptions(void)
+{
+   enum {BINDING_COUNT = 1000, MAX_KEY_LENGTH = 10, HASH_COUNT = 3};
+
+   static const enum SymTableHash aeHashes[HASH_COUNT] =
+      {SYMTABLE_HASH_DEFAULT, SYMTABLE_HASH_FAST, SYMTABLE_HASH_SIPHASH};
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   char acShortstop[] = "Shortstop";
+   const char *pcAtom;
+   char *pcValue;
+   size_t uCount;
+   int iSuccessful;
+   int i;
+   int j;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_newWithOptions() function.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_newWithOptions((enum SymTableHash)99);
+   ASSURE(oSymTable == NULL);
+
+   pcAtom = SymTable_intern("Jeter");
+   ASSURE(pcAtom != NULL);
+
+   for (j = 0; j < HASH_COUNT; j++)
+   {
+      oSymTable = SymTable_newWithOptions(aeHashes[j]);
+      ASSURE(oSymTable != NULL);
+
+      for (i = 0; i < BINDING_COUNT; i++)
+      {
+         sprintf(acKey, "%d", i);
+         iSuccessful = SymTable_put(oSymTable, acKey, acShortstop + i % 9);
+         ASSURE(iSuccessful);
+      }
+      pcValue = (char*)SymTable_get(oSymTable, "250");
+      ASSURE(pcValue == acShortstop + 250 % 9);
+      pcValue = (char*)SymTable_get(oSymTable, "469");
+      ASSURE(pcValue == acShortstop + 469 % 9);
+      ASSURE(SymTable_contains(oSymTable, "947"));
+      ASSURE(! SymTable_contains(oSymTable, "1000"));
+
+      /* Atoms and precomputed hashes carry the default hash, which
+         every kind of SymTable must still accept. */
+      iSuccessful = SymTable_putAtom(oSymTable, pcAtom, acShortstop);
+      ASSURE(iSuccessful);
+      pcValue = (char*)SymTable_get(oSymTable, "Jeter");
+      ASSURE(pcValue == acShortstop);
+      pcValue = (char*)SymTable_getHashed(oSymTable, "Jeter",
+         SymTable_hashKey("Jeter"));
+      ASSURE(pcValue == acShortstop);
+      iSuccessful = SymTable_putHashed(oSymTable, "Ruth",
+         SymTable_hashKey("Ruth"), acShortstop);
+      ASSURE(iSuccessful);
+      pcValue = (char*)SymTable_getAtom(oSymTable,
+         SymTable_intern("Ruth"));
+      ASSURE(pcValue == acShortstop);
+
+      pcValue = (char*)SymTable_remove(oSymTable, "250");
+      ASSURE(pcValue == acShortstop + 250 % 9);
+      ASSURE(! SymTable_contains(oSymTable, "250"));
+      ASSURE(SymTable_getLength(oSymTable) == BINDING_COUNT + 1);
+
+      uCount = 0;
+      SymTable_map(oSymTable, countBinding, &uCount);
+      ASSURE(uCount == BINDING_COUNT + 1);
+
+      SymTable_free(oSymTable);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Copy the snapshot pcPath to pcDamaged with lLength bytes from
+   lPos on (or every byte from lPos on, if lLength is negative) set
+   to 0xff, and open the copy.  If it opens, read every key and value
+   of it, so a damaged snapshot that is read outside its mapping is
+   caught by a memory checker.  Return 1 if the copy opened, 0 if
+   not. */
+
+static int openDamaged(const char *pcPath, const char *pcDamaged,
+   long lPos, long lLength)
+{
+   SymTable_T oMapped;
+   SymTableIter_T oIter;
+   FILE *psFile;
+   unsigned char *pucBytes;
+   const char *pcKey;
+   void *pvValue;
+   long lSize;
+   long l;
+   size_t uCount = 0;
+   int iSum = 0;
+
+   psFile = fopen(pcPath, "rb");
+   ASSURE(psFile != NULL);
+   if (psFile == NULL)
+      return 0;
+   fseek(psFile, 0L, SEEK_END);
+   lSize = ftell(psFile);
+   rewind(psFile);
+   pucBytes = (unsigned char*)malloc((size_t)lSize);
+   ASSURE(pucBytes != NULL);
+   if (pucBytes == NULL ||
+      fread(pucBytes, 1, (size_t)lSize, psFile) != (size_t)lSize)
+   {
+      fclose(psFile);
+      free(pucBytes);
+      return 0;
+   }
+   fclose(psFile);
+
+   for (l = lPos; l < lSize && (lLength < 0 || l < lPos + lLength); l++)
+      pucBytes[l] = 0xff;
+   psFile = fopen(pcDamaged, "wb");
+   ASSURE(psFile != NULL);
+   if (psFile != NULL)
+   {
+      ASSURE(fwrite(pucBytes, 1, (size_t)lSize, psFile) ==
+         (size_t)lSize);
+      fclose(psFile);
+   }
+   free(pucBytes);
+
+   oMapped = SymTable_openMapped(pcDamaged);
+   if (oMapped == NULL)
+      return 0;
+   oIter = SymTable_iterBegin(oMapped);
+   ASSURE(oIter != NULL);
+   while (oIter != NULL && SymTable_iterNext(oIter, &pcKey, &pvValue))
+   {
+      iSum += (int)strlen(pcKey);
+      if (pvValue != NULL)
+         iSum += *(int*)pvValue;
+      (void)SymTable_contains(oMapped, pcKey);
+      uCount++;
+   }
+   if (oIter != NULL)
+      SymTable_iterEnd(oIter);
+   ASSURE(uCount == SymTable_getLength(oMapped));
+   (void)iSum;
+   SymTable_free(oMapped);
+   return 1;
+}
+
+/* Test the SymTable_save() and SymTable_openMapped() functions: save
+   a SymTable object with ordinary, binary, empty and long keys and a
+   NULL value, then check that the mapped SymTable object has the same
+   bindings for every way of reading them, refuses every change, and
+   can be saved in turn.  Files that are not snapshots must not open. */
+
+static void testSnapshot(void)
+{
+   enum {BINDING_COUNT = 2000, MAX_KEY_LENGTH = 12,
+      LONG_KEY_LENGTH = 300, EXTRA_COUNT = 3, CORRUPT_COUNT = 64,
+      CORRUPT_STRIDE = 1000, HEADER_BYTES = 128};
+
+   static const char acPath[] = "testsymtable.snapshot";
+   static const char acPath2[] = "testsymtable2.snapshot";
+   SymTable_T oSymTable;
+   SymTable_T oMapped;
+   SymTableIter_T oIter;
+   FILE *psFile;
+   char acKey[MAX_KEY_LENGTH];
+   char acLongKey[LONG_KEY_LENGTH + 1];
+   char acPrevious[LONG_KEY_LENGTH + 1];
+   const char *pcKey;
+   void *pvValue;
+   int aiValues[BINDING_COUNT];
+   int i;
+   int iSuccessful;
+   size_t uCount;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_save() and SymTable_openMapped()\n");
+   printf("functions.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* An empty SymTable object makes an empty snapshot. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_save(oSymTable, acPath, sizeof(int)));
+   SymTable_free(oSymTable);
+   oMapped = SymTable_openMapped(acPath);
+   ASSURE(oMapped != NULL);
+   if (oMapped == NULL)
+      return;
+   ASSURE(SymTable_getLength(oMapped) == 0);
+   ASSURE(! SymTable_contains(oMapped, ""));
+   oIter = SymTable_iterBegin(oMapped);
+   ASSURE(oIter != NULL);
+   ASSURE(! SymTable_iterNext(oIter, &pcKey, &pvValue));
+   SymTable_iterEnd(oIter);
+   SymTable_free(oMapped);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      aiValues[i] = i;
+      sprintf(acKey, "key%04d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &aiValues[i]);
+      ASSURE(iSuccessful);
+   }
+   memset(acLongKey, 'x', LONG_KEY_LENGTH);
+   acLongKey[LONG_KEY_LENGTH] = '\0';
+   ASSURE(SymTable_putN(oSymTable, "a\0b", 3, &aiValues[1]));
+   ASSURE(SymTable_put(oSymTable, "", NULL));
+   ASSURE(SymTable_put(oSymTable, acLongKey, &aiValues[2]));
+   ASSURE(SymTable_save(oSymTable, acPath, sizeof(int)));
+
+   /* The values are copied, so changing them now does not change the
+      snapshot. */
+   for (i = 0; i < BINDING_COUNT; i++)
+      aiValues[i] = -1;
+   SymTable_free(oSymTable);
+
+   oMapped = SymTable_openMapped(acPath);
+   ASSURE(oMapped != NULL);
+   if (oMapped == NULL)
+      return;
+   ASSURE(SymTable_getLength(oMapped) == BINDING_COUNT + EXTRA_COUNT);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "key%04d", i);
+      pvValue = SymTable_get(oMapped, acKey);
+      ASSURE(pvValue != NULL && *(int*)pvValue == i);
+      ASSURE(SymTable_contains(oMapped, acKey));
+   }
+   pvValue = SymTable_getN(oMapped, "a\0b", 3);
+   ASSURE(pvValue != NULL && *(int*)pvValue == 1);
+   ASSURE(! SymTable_containsN(oMapped, "a\0", 2));
+   ASSURE(! SymTable_contains(oMapped, "a"));
+   ASSURE(SymTable_contains(oMapped, ""));
+   ASSURE(SymTable_get(oMapped, "") == NULL);
+   pvValue = SymTable_get(oMapped, acLongKey);
+   ASSURE(pvValue != NULL && *(int*)pvValue == 2);
+   ASSURE(SymTable_get(oMapped, "key0000x") == NULL);
+   ASSURE(! SymTable_contains(oMapped, "key"));
+
+   /* A mapped SymTable object is read-only. */
+   ASSURE(! SymTable_put(oMapped, "new", &aiValues[0]));
+   ASSURE(! SymTable_putN(oMapped, "newer", 5, &aiValues[0]));
+   ASSURE(SymTable_replace(oMapped, "key0001", &aiValues[0]) == NULL);
+   ASSURE(SymTable_remove(oMapped, "key0001") == NULL);
+   ASSURE(SymTable_getOrPut(oMapped, "key0001", NULL, NULL) == NULL);
+   ASSURE(! SymTable_upsert(oMapped, "key0001", NULL, NULL));
+   ASSURE(SymTable_getLength(oMapped) == BINDING_COUNT + EXTRA_COUNT);
+   pvValue = SymTable_get(oMapped, "key0001");
+   ASSURE(pvValue != NULL && *(int*)pvValue == 1);
+   ASSURE(! SymTable_contains(oMapped, "new"));
+
+   /* Every binding is mapped and iterated over once, in ascending
+      order of key. */
+   uCount = 0;
+   SymTable_map(oMapped, countBinding, &uCount);
+   ASSURE(uCount == BINDING_COUNT + EXTRA_COUNT);
+   uCount = 0;
+   acPrevious[0] = '\0';
+   oIter = SymTable_iterBegin(oMapped);
+   ASSURE(oIter != NULL);
+   while (SymTable_iterNext(oIter, &pcKey, &pvValue))
+   {
+      ASSURE(uCount == 0 || strcmp(acPrevious, pcKey) < 0);
+      strcpy(acPrevious, pcKey);
+      uCount++;
+   }
+   SymTable_iterEnd(oIter);
+   ASSURE(uCount == BINDING_COUNT + EXTRA_COUNT);
+   ASSURE(countRange(oMapped, "key0100", "key0200") == 100);
+   ASSURE(countRange(oMapped, NULL, "key") == 2);
+   ASSURE(countRange(oMapped, NULL, NULL) == BINDING_COUNT + EXTRA_COUNT);
+   ASSURE(countPrefix(oMapped, "key01") == 100);
+   ASSURE(countPrefix(oMapped, "x") == 1);
+
+   /* A mapped SymTable object can be saved, but only with values no
+      bigger than the ones in its snapshot. */
+   ASSURE(! SymTable_save(oMapped, acPath2, sizeof(int) + 1));
+   ASSURE(SymTable_save(oMapped, acPath2, sizeof(int)));
+   SymTable_free(oMapped);
+   oMapped = SymTable_openMapped(acPath2);
+   ASSURE(oMapped != NULL);
+   if (oMapped != NULL)
+   {
+      ASSURE(SymTable_getLength(oMapped) ==
+         BINDING_COUNT + EXTRA_COUNT);
+      pvValue = SymTable_get(oMapped, "key1999");
+      ASSURE(pvValue != NULL && *(int*)pvValue == 1999);
+      SymTable_free(oMapped);
+   }
+
+   /* A snapshot damaged anywhere past its header either does not
+      open or is read only inside itself, and one damaged all the way
+      through does not open. */
+   for (i = 0; i < CORRUPT_COUNT; i++)
+      (void)openDamaged(acPath2, acPath, (long)i * CORRUPT_STRIDE +
+         HEADER_BYTES, 8);
+   ASSURE(! openDamaged(acPath2, acPath, HEADER_BYTES, -1));
+
+   /* Files that are missing or are not snapshots do not open. */
+   psFile = fopen(acPath, "w");
+   ASSURE(psFile != NULL);
+   if (psFile != NULL)
+   {
+      fputs("This is not a snapshot of a SymTable object.\n", psFile);
+      fclose(psFile);
+      ASSURE(SymTable_openMapped(acPath) == NULL);
+   }
+   ASSURE(remove(acPath) == 0);
+   ASSURE(remove(acPath2) == 0);
+   ASSURE(SymTable_openMapped(acPath) == NULL);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTable_newWithCapacity() and SymTable_reserve()
+   functions: a SymTable object with room reserved for its bindings
+   rehashes none of them while they are put, and reserving room in a
+   SymTable object keeps the bindings it has. */
+
+static void testReserve(void)
+{
+   enum {BINDING_COUNT = 5000, MAX_KEY_LENGTH = 10};
+
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   char acShortstop[] = "Shortstop";
+   size_t uRehashes;
+   size_t uRehashes2;
+   size_t uCompares;
+   int i;
+   int iSuccessful;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_newWithCapacity() and\n");
+   printf("SymTable_reserve() functions.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_newWithCapacity(0);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+   ASSURE(SymTable_reserve(oSymTable, 0));
+   SymTable_free(oSymTable);
+
+   oSymTable = SymTable_newWithCapacity(BINDING_COUNT);
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, acShortstop);
+      ASSURE(iSuccessful);
+   }
+   SymTable_getCounts(oSymTable, &uRehashes, &uCompares);
+   ASSURE(uRehashes == 0);
+   /* Reserving less than the SymTable object holds changes
+      nothing. */
+   ASSURE(SymTable_reserve(oSymTable, BINDING_COUNT / 2));
+   SymTable_getCounts(oSymTable, &uRehashes, &uCompares);
+   ASSURE(uRehashes == 0);
+   SymTable_free(oSymTable);
+
+   /* Reserving room in a SymTable object that already has bindings
+      rehashes each of them at most once, and no more while it fills
+      up to the capacity reserved. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < BINDING_COUNT / 10; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, acShortstop);
+      ASSURE(iSuccessful);
+   }
+   SymTable_getCounts(oSymTable, &uRehashes, &uCompares);
+   ASSURE(SymTable_reserve(oSymTable, BINDING_COUNT));
+   SymTable_getCounts(oSymTable, &uRehashes2, &uCompares);
+   ASSURE(uRehashes2 - uRehashes <= (size_t)(BINDING_COUNT / 10));
+   for (i = 0; i < BINDING_COUNT / 10; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_get(oSymTable, acKey) == acShortstop);
+   }
+   for (i = BINDING_COUNT / 10; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, acShortstop);
+      ASSURE(iSuccessful);
+   }
+   SymTable_getCounts(oSymTable, &uRehashes, &uCompares);
+   ASSURE(uRehashes == uRehashes2);
+   ASSURE(SymTable_getLength(oSymTable) == BINDING_COUNT);
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTable_compact() function: after most of its bindings
+   are removed, compacting a SymTable object gives memory back and
+   keeps the rest of the bindings, and a key put and removed over and
+   over near the size it shrank to rehashes nothing. */
+
+static void testCompact(void)
+{
+   enum {BINDING_COUNT = 5000, KEEP_EVERY = 100, MAX_KEY_LENGTH = 40};
+
+   SymTable_T oSymTable;
+   SymTableIter_T oIter;
+   char acKey[MAX_KEY_LENGTH];
+   char acShortstop[] = "Shortstop";
+   size_t uPeakBytes;
+   size_t uBytes;
+   size_t uRehashes;
+   size_t uRehashes2;
+   size_t uCompares;
+   size_t uCount;
+   int i;
+   int iSuccessful;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_compact() function.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_compact(oSymTable));
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+
+   /* Every tenth key is too long to be held inline. */
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, i % 10 == 0 ? "a long key that is kept apart %d" :
+         "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, acShortstop);
+      ASSURE(iSuccessful);
+   }
+   uPeakBytes = SymTable_getBytes(oSymTable);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      if (i % KEEP_EVERY != 0)
+      {
+         sprintf(acKey, i % 10 == 0 ?
+            "a long key that is kept apart %d" : "%d", i);
+         ASSURE(SymTable_remove(oSymTable, acKey) == acShortstop);
+      }
+   }
+   ASSURE(SymTable_getLength(oSymTable) == BINDING_COUNT / KEEP_EVERY);
+
+   /* A key put and removed over and over does not make the SymTable
+      object shrink and expand back and forth. */
+   SymTable_getCounts(oSymTable, &uRehashes, &uCompares);
+   for (i = 0; i < 1000; i++)
+   {
+      iSuccessful = SymTable_put(oSymTable, "Ruth", acShortstop);
+      ASSURE(iSuccessful);
+      ASSURE(SymTable_remove(oSymTable, "Ruth") == acShortstop);
+   }
+   SymTable_getCounts(oSymTable, &uRehashes2, &uCompares);
+   ASSURE(uRehashes2 == uRehashes);
+
+   uBytes = SymTable_getBytes(oSymTable);
+   ASSURE(SymTable_compact(oSymTable));
+   ASSURE(SymTable_getBytes(oSymTable) <= uBytes);
+   ASSURE(SymTable_getBytes(oSymTable) < uPeakBytes);
+   ASSURE(SymTable_getLength(oSymTable) == BINDING_COUNT / KEEP_EVERY);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, i % 10 == 0 ? "a long key that is kept apart %d" :
+         "%d", i);
+      if (i % KEEP_EVERY == 0)
+         ASSURE(SymTable_get(oSymTable, acKey) == acShortstop);
+      else
+         ASSURE(! SymTable_contains(oSymTable, acKey));
+   }
+
+   /* A SymTable object compacted (or not) while an iterator is open
+      still iterates over every binding. */
+   oIter = SymTable_iterBegin(oSymTable);
+   ASSURE(oIter != NULL);
+   (void)SymTable_compact(oSymTable);
+   uCount = 0;
+   while (SymTable_iterNext(oIter, NULL, NULL))
+      uCount++;
+   SymTable_iterEnd(oIter);
+   ASSURE(uCount == BINDING_COUNT / KEEP_EVERY);
+
+   /* The compacted SymTable object fills up again as usual. */
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, i % 10 == 0 ? "a long key that is kept apart %d" :
+         "%d", i);
+      if (i % KEEP_EVERY != 0)
+      {
+         iSuccessful = SymTable_put(oSymTable, acKey, acShortstop);
+         ASSURE(iSuccessful);
+      }
+   }
+   ASSURE(SymTable_getLength(oSymTable) == BINDING_COUNT);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, i % 10 == 0 ? "a long key that is kept apart %d" :
+         "%d", i);
+      ASSURE(SymTable_get(oSymTable, acKey) == acShortstop);
+   }
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTable_newWithStats() and SymTable_getStats() functions:
+   a SymTable object made by SymTable_newWithStats() that counts its
+   lookups counts every one of them, the chain histogram agrees with
+   the bucket count and length, and a SymTable object made by
+   SymTable_new() counts nothing. */
+
+static void testStats(void)
+{
+   enum {BINDING_COUNT = 1000, MISS_COUNT = 500, MAX_KEY_LENGTH = 10};
+
+   SymTable_T oSymTable;
+   struct SymTableStats sStats;
+   char acKey[MAX_KEY_LENGTH];
+   char acShortstop[] = "Shortstop";
+   size_t uChains;
+   size_t uHits;
+   size_t uMisses;
+   size_t i;
+   int iCounts;
+   int iSuccessful;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_newWithStats() and\n");
+   printf("SymTable_getStats() functions.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_newWithStats(SYMTABLE_HASH_DEFAULT);
+   ASSURE(oSymTable != NULL);
+   iCounts = SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.hits == 0);
+   ASSURE(sStats.misses == 0);
+   ASSURE(sStats.maxChain == 0);
+
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%lu", (unsigned long)i);
+      iSuccessful = SymTable_put(oSymTable, acKey, acShortstop);
+      ASSURE(iSuccessful);
+   }
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%lu", (unsigned long)i);
+      ASSURE(SymTable_get(oSymTable, acKey) == acShortstop);
+   }
+   for (i = 0; i < MISS_COUNT; i++)
+   {
+      sprintf(acKey, "x%lu", (unsigned long)i);
+      ASSURE(SymTable_get(oSymTable, acKey) == NULL);
+   }
+
+   ASSURE(SymTable_getStats(oSymTable, &sStats) == iCounts);
+   ASSURE(sStats.allocCount == SymTable_getAllocCount(oSymTable));
+   ASSURE(sStats.bytes == SymTable_getBytes(oSymTable));
+   if (iCounts)
+   {
+      /* Each put looked its key up first and missed. */
+      ASSURE(sStats.hits == BINDING_COUNT);
+      ASSURE(sStats.misses == BINDING_COUNT + MISS_COUNT);
+      ASSURE(sStats.probesPerHit >= 1.0);
+      ASSURE(sStats.probesPerMiss >= 0.0);
+      ASSURE(sStats.expansions > 0);
+      ASSURE(sStats.expandSeconds >= 0.0);
+   }
+   else
+   {
+      ASSURE(sStats.hits == 0);
+      ASSURE(sStats.expansions == 0);
+   }
+   if (sStats.bucketCount != 0)
+   {
+      /* A histogram of chained buckets counts every bucket, and one
+         of open addressing slots counts every binding. */
+      uChains = 0;
+      for (i = 0; i < SYMTABLE_STATS_CHAINS; i++)
+         uChains += sStats.chainCounts[i];
+      ASSURE(uChains == sStats.bucketCount || uChains == BINDING_COUNT);
+      ASSURE(sStats.maxChain >= 1);
+      ASSURE(sStats.load > 0.0);
+      ASSURE(sStats.load * (double)sStats.bucketCount >
+         BINDING_COUNT - 0.5);
+      ASSURE(sStats.load * (double)sStats.bucketCount <
+         BINDING_COUNT + 0.5);
+   }
+
+   /* Removes are not counted, whether or not the key is there. */
+   uHits = sStats.hits;
+   uMisses = sStats.misses;
+   ASSURE(SymTable_remove(oSymTable, "0") == acShortstop);
+   ASSURE(SymTable_remove(oSymTable, "x0") == NULL);
+   ASSURE(SymTable_getStats(oSymTable, &sStats) == iCounts);
+   ASSURE(sStats.hits == uHits);
+   ASSURE(sStats.misses == uMisses);
+   SymTable_free(oSymTable);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   iSuccessful = SymTable_put(oSymTable, "Ruth", acShortstop);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_get(oSymTable, "Ruth") == acShortstop);
+   ASSURE(SymTable_getStats(oSymTable, &sStats) == 0);
+   ASSURE(sStats.hits == 0);
+   ASSURE(sStats.misses == 0);
+   ASSURE(sStats.expansions == 0);
+   SymTable_free(oSymTable);
+
+   ASSURE(SymTable_newWithStats((enum SymTableHash)99) == NULL);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write the rehash and compare counts of oSymTable to stdout,
+   labelled with pcPhase. */
+
+static void printCounts(SymTable_T oSymTable, const char *pcPhase)
+{
+   size_t uRehashes;
+   size_t uCompares;
+
+   assert(oSymTable != NULL);
+   assert(pcPhase != NULL);
+
+   SymTable_getCounts(oSymTable, &uRehashes, &uCompares);
+   printf("After %s:  %lu bindings rehashed, %lu key compares, "
+      "%lu allocations\n", pcPhase, (unsigned long)uRehashes,
+      (unsigned long)uCompares,
+      (unsigned long)SymTable_getAllocCount(oSymTable));
+   fflush(stdout);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put iBindingCount bindings into a new SymTable object and write
+   the number of allocations it made and the CPU time consumed by
+   SymTable_free() to stdout. */
+
+static void timeTeardown(int iBindingCount)
+{
+   enum {MAX_KEY_LENGTH = 11};
+
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   int i;
+   int iSuccessful;
+   size_t uAllocCount;
+   clock_t iInitialClock;
+   clock_t iFinalClock;
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, NULL);
+      ASSURE(iSuccessful);
+   }
+   uAllocCount = SymTable_getAllocCount(oSymTable);
+
+   iInitialClock = clock();
+   SymTable_free(oSymTable);
+   iFinalClock = clock();
+   printf("Teardown (%d bindings, %lu allocations):  %f seconds\n",
+      iBindingCount, (unsigned long)uAllocCount,
+      ((double)(iFinalClock - iInitialClock)) / CLOCKS_PER_SEC);
+   fflush(stdout);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the ability of a SymTable object to be large, that is, to
+   contain iBindingCount bindings. The SymTable object is made with
+   room for them all, so putting them must rehash nothing. Write the
+   time consumed to stdout. If iBenchmark is nonzero, also write the
+   operation counts of the large SymTable object after each phase, and
+   time the teardown of a full SymTable object. */
+
+static void testLargeTable(int iBindingCount, int iBenchmark)
+{
+   enum {MAX_KEY_LENGTH = 10};
+
+   SymTable_T oSymTable;
+   SymTable_T oSymTableSmall;
+   char acKey[MAX_KEY_LENGTH];
+   char *pcValue;
+   int i;
+   int iSmall;
+   int iLarge;
+   int iSuccessful;
+   clock_t iInitialClock;
+   clock_t iFinalClock;
+   size_t uLength = 0;
+   size_t uLength2;
+   size_t uRehashes;
+   size_t uCompares;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a potentially large SymTable object.\n");
+   printf("No output except CPU time consumed should appear here:\n");
+   fflush(stdout);
+
+   /* Note the current time. */
+   iInitialClock = clock();
+
+   /* Create oSymTableSmall, and put a couple of bindings into it. */
+   oSymTableSmall = SymTable_new();
+   ASSURE(oSymTableSmall != NULL);
+   iSuccessful = SymTable_put(oSymTableSmall, "xxx", "xxx");
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTableSmall, "yyy", "yyy");
+   ASSURE(iSuccessful);
+
+   /* Create oSymTable, the primary SymTable object, with room for
+      every binding. */
+   oSymTable = SymTable_newWithCapacity((size_t)iBindingCount);
+   ASSURE(oSymTable != NULL);
+
+   /* Put iBindingCount new bindings into oSymTable.  Each binding's
+      key and value contain the same characters. */
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      pcValue = (char*)malloc(sizeof(char) * (strlen(acKey) + 1));
+      ASSURE(pcValue != NULL);
+      strcpy(pcValue, acKey);
+      iSuccessful = SymTable_put(oSymTable, acKey, pcValue);
+      ASSURE(iSuccessful);
+      uLength = SymTable_getLength(oSymTable);
+      ASSURE(uLength == (size_t)(i+1));
+   }
+   SymTable_getCounts(oSymTable, &uRehashes, &uCompares);
+   ASSURE(uRehashes == 0);
+   if (iBenchmark)
+      printCounts(oSymTable, "put");
+
+   /* Get each binding's value, and make sure that it contains
+      the same characters as its key. */
+   iSmall = 0;
+   iLarge = iBindingCount - 1;
+   while (iSmall < iLarge)
+   {
+      /* Get the smallest of the remaining bindings. */
+      sprintf(acKey, "%d", iSmall);
+      pcValue = (char*)SymTable_get(oSymTable, acKey);
+      ASSURE(pcValue != NULL);
+      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
+      iSmall++;
+      /* Get the largest of the remaining bindings. */
+      sprintf(acKey, "%d", iLarge);
+      pcValue = (char*)SymTable_get(oSymTable, acKey);
+      ASSURE(pcValue != NULL);
+      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
+      iLarge--;
+   }
+   /* Get the middle binding -- if there is one. */
+   if (iSmall == iLarge)
+   {
+      sprintf(acKey, "%d", iSmall);
+      pcValue = (char*)SymTable_get(oSymTable, acKey);
+      ASSURE(pcValue != NULL);
+      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
+   }
+   if (iBenchmark)
+      printCounts(oSymTable, "get");
+
+   /* Remove each binding. Also free each binding's value. */
+   iSmall = 0;
+   iLarge = iBindingCount - 1;
+   while (iSmall < iLarge)
+   {
+      /* Remove the smallest of the remaining bindings. */
+      sprintf(acKey, "%d", iSmall);
+      pcValue = (char*)SymTable_remove(oSymTable, acKey);
+      ASSURE(pcValue != NULL);
+      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
+      free(pcValue);
+      uLength--;
+      uLength2 = SymTable_getLength(oSymTable);
+      ASSURE(uLength2 == uLength);
+      iSmall++;
+      /* Remove the largest of the remaining bindings. */
+      sprintf(acKey, "%d", iLarge);
+      pcValue = (char*)SymTable_remove(oSymTable, acKey);
+      ASSURE(pcValue != NULL);
+      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
+      free(pcValue);
+      uLength--;
+      uLength2 = SymTable_getLength(oSymTable);
+      ASSURE(uLength2 == uLength);
+      iLarge--;
+   }
+   /* Remove the middle binding -- if there is one. */
+   if (iSmall == iLarge)
+   {
+      sprintf(acKey, "%d", iSmall);
+      pcValue = (char*)SymTable_remove(oSymTable, acKey);
+      ASSURE(pcValue != NULL);
+      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
+      free(pcValue);
+      uLength--;
+      uLength2 = SymTable_getLength(oSymTable);
+      ASSURE(uLength2 == uLength);  
+   }
+   if (iBenchmark)
+      printCounts(oSymTable, "remove");
+
+   /* Make sure oSymTableSmall hasn't been corrupted by expansion
+      of oSymTable. */
+   pcValue = (char*)SymTable_get(oSymTableSmall, "xxx");
+   ASSURE((pcValue != NULL) && (strcmp(pcValue, "xxx") == 0));
+   pcValue = (char*)SymTable_get(oSymTableSmall, "yyy");
+   ASSURE((pcValue != NULL) && (strcmp(pcValue, "yyy") == 0));
+
+   /* Free both SymTable objects. */
+   SymTable_free(oSymTable);
+   SymTable_free(oSymTableSmall);
+
+   /* Note the current time, and print the time consumed to stdout. */
+   iFinalClock = clock();
+   printf("CPU time (%d bindings):  %f seconds\n", iBindingCount,
+      ((double)(iFinalClock - iInitialClock)) / CLOCKS_PER_SEC);
+   fflush(stdout);
+
+   if (iBenchmark)
+      timeTeardown(iBindingCount);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the current time of a monotonic clock in nanoseconds. */
+
+static double getNanoseconds(void)
+{
+   struct timespec sTime;
+   clock_gettime(CLOCK_MONOTONIC, &sTime);
+   return (double)sTime.tv_sec * 1e9 + (double)sTime.tv_nsec;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compare the doubles that pvFirst and pvSecond point to, for
+   qsort(). */
+
+static int compareDoubles(const void *pvFirst, const void *pvSecond)
+{
+   double dFirst = *(const double*)pvFirst;
+   double dSecond = *(const double*)pvSecond;
+
+   assert(pvFirst != NULL);
+   assert(pvSecond != NULL);
+
+   if (dFirst < dSecond)
+      return -1;
+   if (dFirst > dSecond)
+      return 1;
+   return 0;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put iBindingCount bindings into a new SymTable object, with
+   incremental expansion turned on if iIncremental is nonzero, timing
+   each SymTable_put() call.  Write the median, 99th percentile,
+   99.9th percentile and max latency to stdout. */
+
+static void measurePutLatency(int iBindingCount, int iIncremental)
+{
+   enum {MAX_KEY_LENGTH = 11};
+
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   double *pdLatencies;
+   double dStart;
+   int i;
+   int iSuccessful;
+
+   assert(iBindingCount > 0);
+
+   pdLatencies = (double*)malloc(sizeof(double) * (size_t)iBindingCount);
+   ASSURE(pdLatencies != NULL);
+   if (pdLatencies == NULL)
+      return;
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   if (! SymTable_setIncremental(oSymTable, iIncremental))
+   {
+      printf("put latency, incremental %d:  not supported\n",
+         iIncremental);
+      fflush(stdout);
+      SymTable_free(oSymTable);
+      free(pdLatencies);
+      return;
+   }
+
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      dStart = getNanoseconds();
+      iSuccessful = SymTable_put(oSymTable, acKey, NULL);
+      pdLatencies[i] = getNanoseconds() - dStart;
+      ASSURE(iSuccessful);
+   }
+   SymTable_free(oSymTable);
+
+   qsort(pdLatencies, (size_t)iBindingCount, sizeof(double),
+      compareDoubles);
+   printf("put latency, incremental %d:  p50 %.0f ns, p99 %.0f ns, "
+      "p999 %.0f ns, max %.0f ns\n", iIncremental,
+      pdLatencies[iBindingCount / 2],
+      pdLatencies[(int)((double)iBindingCount * 0.99)],
+      pdLatencies[(int)((double)iBindingCount * 0.999)],
+      pdLatencies[iBindingCount - 1]);
+   fflush(stdout);
+   free(pdLatencies);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Write the tail latency of SymTable_put() while putting
+   iBindingCount bindings into a SymTable object, with and without
+   incremental expansion, to stdout. */
+
+static void testPutLatency(int iBindingCount)
+{
+   printf("------------------------------------------------------\n");
+   printf("Timing SymTable_put() with and without incremental\n");
+   printf("expansion.\n");
+   fflush(stdout);
+
+   if (iBindingCount == 0)
+      return;
+   measurePutLatency(iBindingCount, 0);
+   measurePutLatency(iBindingCount, 1);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put iBindingCount bindings into a new SymTable object and look all
+   of them up in a scrambled order, once with a loop of SymTable_get()
+   calls and once with SymTable_getMany() in batches.  Write the time
+   each took to stdout. */
+
+static void timeGetMany(int iBindingCount)
+{
+   enum {MAX_KEY_LENGTH = 11, BATCH_SIZE = 256};
+
+   SymTable_T oSymTable;
+   char *pcKeys;
+   const char **ppcKeys;
+   void **ppvValues;
+   const char *pcSwap;
+   size_t uRandom = 1;
+   size_t uBatch;
+   double dStart;
+   double dGetTime;
+   double dGetManyTime;
+   int i;
+   int j;
+   int iSuccessful;
+
+   printf("------------------------------------------------------\n");
+   printf("Timing SymTable_get() against SymTable_getMany().\n");
+   fflush(stdout);
+
+   if (iBindingCount == 0)
+      return;
+
+   pcKeys = (char*)malloc((size_t)iBindingCount * MAX_KEY_LENGTH);
+   ppcKeys = (const char**)malloc((size_t)iBindingCount *
+      sizeof(const char*));
+   ppvValues = (void**)malloc((size_t)iBindingCount * sizeof(void*));
+   ASSURE(pcKeys != NULL && ppcKeys != NULL && ppvValues != NULL);
+   if (pcKeys == NULL || ppcKeys == NULL || ppvValues == NULL)
+   {
+      free(pcKeys);
+      free(ppcKeys);
+      free(ppvValues);
+      return;
+   }
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(pcKeys + (size_t)i * MAX_KEY_LENGTH, "%d", i);
+      ppcKeys[i] = pcKeys + (size_t)i * MAX_KEY_LENGTH;
+      iSuccessful = SymTable_put(oSymTable, ppcKeys[i], ppcKeys[i]);
+      ASSURE(iSuccessful);
+   }
+
+   /* Scramble the lookup order so consecutive keys are not in
+      neighbouring buckets. */
+   for (i = iBindingCount - 1; i > 0; i--)
+   {
+      uRandom = uRandom * 6364136223846793005UL + 1442695040888963407UL;
+      j = (int)((uRandom >> 33) % (size_t)(i + 1));
+      pcSwap = ppcKeys[i];
+      ppcKeys[i] = ppcKeys[j];
+      ppcKeys[j] = pcSwap;
+   }
+
+   dStart = getNanoseconds();
+   for (i = 0; i < iBindingCount; i++)
+      ppvValues[i] = SymTable_get(oSymTable, ppcKeys[i]);
+   dGetTime = getNanoseconds() - dStart;
+   for (i = 0; i < iBindingCount; i++)
+      ASSURE(ppvValues[i] == ppcKeys[i]);
+
+   dStart = getNanoseconds();
+   for (i = 0; i < iBindingCount; i += (int)uBatch)
+   {
+      uBatch = (size_t)(iBindingCount - i);
+      if (uBatch > BATCH_SIZE)
+         uBatch = BATCH_SIZE;
+      SymTable_getMany(oSymTable, ppcKeys + i, uBatch, ppvValues + i);
+   }
+   dGetManyTime = getNanoseconds() - dStart;
+   for (i = 0; i < iBindingCount; i++)
+      ASSURE(ppvValues[i] == ppcKeys[i]);
+
+   printf("SymTable_get loop (%d keys):  %f seconds\n", iBindingCount,
+      dGetTime / 1e9);
+   printf("SymTable_getMany (%d keys):  %f seconds\n", iBindingCount,
+      dGetManyTime / 1e9);
+   fflush(stdout);
+
+   SymTable_free(oSymTable);
+   free(pcKeys);
+   free(ppcKeys);
+   free(ppvValues);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* For each kind of hash, put iBindingCount bindings with short keys
+   into a new SymTable object and get all of them, then do the same
+   with long keys.  Write the throughput of each to stdout. */
+
+static void timeHashes(int iBindingCount)
+{
+   enum {SHORT_KEY_LENGTH = 11, LONG_KEY_LENGTH = 112, HASH_COUNT = 3};
+
+   static const enum SymTableHash aeHashes[HASH_COUNT] =
+      {SYMTABLE_HASH_DEFAULT, SYMTABLE_HASH_FAST, SYMTABLE_HASH_SIPHASH};
+   static const char *const apcNames[HASH_COUNT] =
+      {"default", "fast", "siphash"};
+   SymTable_T oSymTable;
+   char *pcKeys;
+   size_t uKeyLength;
+   double dStart;
+   double dPutTime;
+   double dGetTime;
+   int iLong;
+   int i;
+   int j;
+   int iSuccessful;
+
+   printf("------------------------------------------------------\n");
+   printf("Timing the hashes of SymTable_newWithOptions().\n");
+   fflush(stdout);
+
+   if (iBindingCount == 0)
+      return;
+
+   pcKeys = (char*)malloc((size_t)iBindingCount * LONG_KEY_LENGTH);
+   ASSURE(pcKeys != NULL);
+   if (pcKeys == NULL)
+      return;
+
+   for (iLong = 0; iLong < 2; iLong++)
+   {
+      /* A long key is a 100 character prefix shared by every key,
+         followed by the number. */
+      uKeyLength = iLong ? LONG_KEY_LENGTH : SHORT_KEY_LENGTH;
+      for (i = 0; i < iBindingCount; i++)
+      {
+         if (iLong)
+            sprintf(pcKeys + (size_t)i * uKeyLength, "%.100s%d",
+               "identifier_identifier_identifier_identifier_identifier_"
+               "identifier_identifier_identifier_identifier_identifier",
+               i);
+         else
+            sprintf(pcKeys + (size_t)i * uKeyLength, "%d", i);
+      }
+
+      for (j = 0; j < HASH_COUNT; j++)
+      {
+         oSymTable = SymTable_newWithOptions(aeHashes[j]);
+         ASSURE(oSymTable != NULL);
+
+         dStart = getNanoseconds();
+         for (i = 0; i < iBindingCount; i++)
+         {
+            iSuccessful = SymTable_put(oSymTable,
+               pcKeys + (size_t)i * uKeyLength, NULL);
+            ASSURE(iSuccessful);
+         }
+         dPutTime = getNanoseconds() - dStart;
+
+         dStart = getNanoseconds();
+         for (i = 0; i < iBindingCount; i++)
+            ASSURE(SymTable_contains(oSymTable,
+               pcKeys + (size_t)i * uKeyLength));
+         dGetTime = getNanoseconds() - dStart;
+
+         printf("%-7s %s keys:  put %.2f Mops/s  get %.2f Mops/s\n",
+            apcNames[j], iLong ? "long " : "short",
+            iBindingCount / dPutTime * 1e3,
+            iBindingCount / dGetTime * 1e3);
+         fflush(stdout);
+
+         SymTable_free(oSymTable);
+      }
+   }
+
+   free(pcKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put the 2 to the COLLIDING_BLOCKS keys of makeCollidingKey() into a
+   new SymTable object and get all of them, once with the hash function
+   from the assignment specification, under which they all collide,
+   and once with SipHash, under which they do not.  Write the time
+   each took to stdout. */
+
+static void timeCollisions(void)
+{
+   enum {KEY_COUNT = 1 << COLLIDING_BLOCKS,
+      KEY_LENGTH = COLLIDING_BLOCKS * BLOCK_LENGTH + 1, HASH_COUNT = 2,
+      ROUND_COUNT = 10};
+
+   static const enum SymTableHash aeHashes[HASH_COUNT] =
+      {SYMTABLE_HASH_DEFAULT, SYMTABLE_HASH_SIPHASH};
+   static const char *const apcNames[HASH_COUNT] =
+      {"colliding (default hash)", "spread out (siphash)"};
+   SymTable_T oSymTable;
+   char *pcKeys;
+   double dStart;
+   double dTime;
+   int iSuccessful;
+   int i;
+   int j;
+   int iRound;
+
+   printf("------------------------------------------------------\n");
+   printf("Timing keys that all collide.\n");
+   fflush(stdout);
+
+   pcKeys = (char*)malloc((size_t)KEY_COUNT * KEY_LENGTH);
+   ASSURE(pcKeys != NULL);
+   if (pcKeys == NULL)
+      return;
+   for (i = 0; i < KEY_COUNT; i++)
+      makeCollidingKey(pcKeys + i * KEY_LENGTH, i);
+
+   for (j = 0; j < HASH_COUNT; j++)
+   {
+      oSymTable = SymTable_newWithOptions(aeHashes[j]);
+      ASSURE(oSymTable != NULL);
+
+      dStart = getNanoseconds();
+      for (i = 0; i < KEY_COUNT; i++)
+      {
+         iSuccessful = SymTable_put(oSymTable, pcKeys + i * KEY_LENGTH,
+            NULL);
+         ASSURE(iSuccessful);
+      }
+      for (iRound = 0; iRound < ROUND_COUNT; iRound++)
+         for (i = 0; i < KEY_COUNT; i++)
+            ASSURE(SymTable_contains(oSymTable, pcKeys + i * KEY_LENGTH));
+      dTime = getNanoseconds() - dStart;
+
+      printf("%d puts, %d gets, %s:  %f seconds\n", KEY_COUNT,
+         KEY_COUNT * ROUND_COUNT, apcNames[j], dTime / 1e9);
+      fflush(stdout);
+
+      SymTable_free(oSymTable);
+   }
+
+   free(pcKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Store in the size_t that pvValue points to a hash of pcKey, which
+   stands in for per binding work that is worth spreading over several
+   threads.  pvExtra is unused. */
+
+static void hashBinding(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   enum {ROUND_COUNT = 16};
+
+   size_t uHash = 0;
+   const char *pc;
+   int i;
+
+   assert(pcKey != NULL);
+   assert(pvValue != NULL);
+
+   (void)pvExtra;
+   for (i = 0; i < ROUND_COUNT; i++)
+      for (pc = pcKey; *pc != '\0'; pc++)
+         uHash = uHash * 65599 + (size_t)*pc;
+   *(size_t*)pvValue = uHash;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Map a SymTable object of iBindingCount bindings with SymTable_map()
+   and with SymTable_mapParallel() on a growing number of threads.
+   Write the time each took to stdout. */
+
+static void timeMapParallel(int iBindingCount)
+{
+   enum {MAX_KEY_LENGTH = 11, MAX_THREADS = 8};
+
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   size_t *puHashes;
+   size_t uThreads;
+   double dStart;
+   int i;
+   int iSuccessful;
+
+   printf("------------------------------------------------------\n");
+   printf("Timing SymTable_map() against SymTable_mapParallel().\n");
+   fflush(stdout);
+
+   if (iBindingCount == 0)
+      return;
+
+   puHashes = (size_t*)malloc((size_t)iBindingCount * sizeof(size_t));
+   ASSURE(puHashes != NULL);
+   if (puHashes == NULL)
+      return;
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &puHashes[i]);
+      ASSURE(iSuccessful);
+   }
+
+   dStart = getNanoseconds();
+   SymTable_map(oSymTable, hashBinding, NULL);
+   printf("SymTable_map:  %f seconds\n",
+      (getNanoseconds() - dStart) / 1e9);
+   for (uThreads = 1; uThreads <= MAX_THREADS; uThreads *= 2)
+   {
+      dStart = getNanoseconds();
+      SymTable_mapParallel(oSymTable, hashBinding, NULL, uThreads);
+      printf("SymTable_mapParallel (%lu threads):  %f seconds\n",
+         (unsigned long)uThreads, (getNanoseconds() - dStart) / 1e9);
+   }
+   fflush(stdout);
+
+   SymTable_free(oSymTable);
+   free(puHashes);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put iBindingCount bindings into a SymTable object and remove all
+   but one in a hundred, leaving it sparse, then find the last binding
+   with SymTable_map() and with an iterator, and find any binding with
+   an iterator that stops at the first one.  Write the time each took
+   to stdout. */
+
+static void timeSparseIteration(int iBindingCount)
+{
+   enum {MAX_KEY_LENGTH = 11, KEEP_EVERY = 100};
+
+   SymTable_T oSymTable;
+   SymTableIter_T oIter;
+   char acKey[MAX_KEY_LENGTH];
+   size_t uCount;
+   double dStart;
+   int i;
+   int iSuccessful;
+
+   printf("------------------------------------------------------\n");
+   printf("Timing SymTable_map() against an iterator.\n");
+   fflush(stdout);
+
+   if (iBindingCount == 0)
+      return;
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, acKey);
+      ASSURE(iSuccessful);
+   }
+   for (i = 0; i < iBindingCount; i++)
+   {
+      if (i % KEEP_EVERY != 0)
+      {
+         sprintf(acKey, "%d", i);
+         (void)SymTable_remove(oSymTable, acKey);
+      }
+   }
+
+   uCount = 0;
+   dStart = getNanoseconds();
+   SymTable_map(oSymTable, countBinding, &uCount);
+   printf("SymTable_map over %lu bindings:  %f seconds\n",
+      (unsigned long)uCount, (getNanoseconds() - dStart) / 1e9);
+
+   uCount = 0;
+   dStart = getNanoseconds();
+   oIter = SymTable_iterBegin(oSymTable);
+   ASSURE(oIter != NULL);
+   while (SymTable_iterNext(oIter, NULL, NULL))
+      uCount++;
+   SymTable_iterEnd(oIter);
+   printf("Iterator over %lu bindings:  %f seconds\n",
+      (unsigned long)uCount, (getNanoseconds() - dStart) / 1e9);
+
+   dStart = getNanoseconds();
+   oIter = SymTable_iterBegin(oSymTable);
+   ASSURE(oIter != NULL);
+   ASSURE(SymTable_iterNext(oIter, NULL, NULL));
+   SymTable_iterEnd(oIter);
+   printf("Iterator stopping at the first binding:  %f seconds\n",
+      (getNanoseconds() - dStart) / 1e9);
+   fflush(stdout);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put iBindingCount bindings with zero padded numbers for keys into a
+   SymTable object, then map the hundred bindings under each of a few
+   prefixes with SymTable_mapPrefix() and the same bindings with
+   SymTable_mapRange().  Write the time each took to stdout. */
+
+static void timeRangeScans(int iBindingCount)
+{
+   enum {MAX_KEY_LENGTH = 12, SCAN_COUNT = 20, SCAN_WIDTH = 100};
+
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   char acLow[MAX_KEY_LENGTH];
+   char acHigh[MAX_KEY_LENGTH];
+   size_t uCount;
+   double dStart;
+   int i;
+   int iStart;
+   int iSuccessful;
+
+   printf("------------------------------------------------------\n");
+   printf("Timing SymTable_mapPrefix() and SymTable_mapRange().\n");
+   fflush(stdout);
+
+   if (iBindingCount < SCAN_WIDTH)
+      return;
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%09d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, acKey);
+      ASSURE(iSuccessful);
+   }
+
+   /* The prefixes are 7 digits, so each covers SCAN_WIDTH keys. */
+   uCount = 0;
+   dStart = getNanoseconds();
+   for (i = 0; i < SCAN_COUNT; i++)
+   {
+      iStart = (int)((long)i * (iBindingCount / SCAN_WIDTH) / SCAN_COUNT)
+         * SCAN_WIDTH;
+      sprintf(acKey, "%07d", iStart / SCAN_WIDTH);
+      SymTable_mapPrefix(oSymTable, acKey, countBinding, &uCount);
+   }
+   ASSURE(uCount == (size_t)SCAN_COUNT * SCAN_WIDTH);
+   printf("%d prefix scans of %d bindings each:  %f seconds\n",
+      SCAN_COUNT, SCAN_WIDTH, (getNanoseconds() - dStart) / 1e9);
+
+   uCount = 0;
+   dStart = getNanoseconds();
+   for (i = 0; i < SCAN_COUNT; i++)
+   {
+      iStart = (int)((long)i * (iBindingCount / SCAN_WIDTH) / SCAN_COUNT)
+         * SCAN_WIDTH;
+      sprintf(acLow, "%09d", iStart);
+      sprintf(acHigh, "%09d", iStart + SCAN_WIDTH);
+      SymTable_mapRange(oSymTable, acLow, acHigh, countBinding, &uCount);
+   }
+   ASSURE(uCount == (size_t)SCAN_COUNT * SCAN_WIDTH);
+   printf("%d range scans of %d bindings each:  %f seconds\n",
+      SCAN_COUNT, SCAN_WIDTH, (getNanoseconds() - dStart) / 1e9);
+
+   uCount = 0;
+   dStart = getNanoseconds();
+   SymTable_map(oSymTable, countBinding, &uCount);
+   printf("SymTable_map over %lu bindings:  %f seconds\n",
+      (unsigned long)uCount, (getNanoseconds() - dStart) / 1e9);
+   fflush(stdout);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put iBindingCount bindings with namespaced keys of the form
+   "app.moduleM.subS.nameN" into a SymTable object, so that most keys
+   share a long prefix with many others, then get every key and as
+   many absent ones.  Write the memory the SymTable object holds per
+   binding and the time each operation took to stdout. */
+
+static void timePrefixedKeys(int iBindingCount)
+{
+   enum {MAX_KEY_LENGTH = 48, MODULE_COUNT = 100, SUB_COUNT = 10};
+
+   SymTable_T oSymTable;
+   char *pcKeys;
+   char acMissing[MAX_KEY_LENGTH + 1];
+   size_t uBytes;
+   size_t uKeyBytes = 0;
+   double dStart;
+   int i;
+   int iSuccessful;
+
+   printf("------------------------------------------------------\n");
+   printf("Timing a SymTable object with prefixed keys.\n");
+   fflush(stdout);
+
+   if (iBindingCount == 0)
+      return;
+
+   /* The keys are made before the timing starts, so only the
+      SymTable is timed. */
+   pcKeys = malloc((size_t)iBindingCount * MAX_KEY_LENGTH);
+   ASSURE(pcKeys != NULL);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(pcKeys + (size_t)i * MAX_KEY_LENGTH,
+         "app.module%d.sub%d.name%d", i % MODULE_COUNT,
+         i / MODULE_COUNT % SUB_COUNT, i);
+      uKeyBytes += strlen(pcKeys + (size_t)i * MAX_KEY_LENGTH) + 1;
+   }
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   dStart = getNanoseconds();
+   for (i = 0; i < iBindingCount; i++)
+   {
+      iSuccessful = SymTable_put(oSymTable,
+         pcKeys + (size_t)i * MAX_KEY_LENGTH, pcKeys);
+      ASSURE(iSuccessful);
+   }
+   printf("Put:  %.1f ns per binding\n",
+      (getNanoseconds() - dStart) / iBindingCount);
+
+   uBytes = SymTable_getBytes(oSymTable);
+   ASSURE(uBytes > uKeyBytes);
+   printf("Memory:  %lu bytes, %.1f per binding (keys are %.1f)\n",
+      (unsigned long)uBytes, (double)uBytes / iBindingCount,
+      (double)uKeyBytes / iBindingCount);
+
+   dStart = getNanoseconds();
+   for (i = 0; i < iBindingCount; i++)
+      ASSURE(SymTable_get(oSymTable, pcKeys + (size_t)i * MAX_KEY_LENGTH)
+         == pcKeys);
+   printf("Get (present):  %.1f ns per lookup\n",
+      (getNanoseconds() - dStart) / iBindingCount);
+
+   /* An absent key shares all but its last byte with a present one. */
+   dStart = getNanoseconds();
+   for (i = 0; i < iBindingCount; i++)
+   {
+      strcpy(acMissing, pcKeys + (size_t)i * MAX_KEY_LENGTH);
+      strcat(acMissing, "x");
+      ASSURE(SymTable_get(oSymTable, acMissing) == NULL);
+   }
+   printf("Get (absent):  %.1f ns per lookup\n",
+      (getNanoseconds() - dStart) / iBindingCount);
+   fflush(stdout);
+
+   SymTable_free(oSymTable);
+   free(pcKeys);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Compare two ways of starting up with iBindingCount bindings: putting
+   them all into a new SymTable object, and mapping a snapshot of them
+   saved with SymTable_save().  Then get every key from each.  Write
+   the time each took to stdout. */
+
+static void timeSnapshot(int iBindingCount)
+{
+   enum {MAX_KEY_LENGTH = 24};
+
+   static const char acPath[] = "testsymtable.snapshot";
+   SymTable_T oSymTable;
+   SymTable_T oMapped;
+   char *pcKeys;
+   int *piValues;
+   void *pvValue;
+   double dStart;
+   int i;
+   int iSuccessful;
+
+   printf("------------------------------------------------------\n");
+   printf("Timing SymTable_save() and SymTable_openMapped().\n");
+   fflush(stdout);
+
+   if (iBindingCount == 0)
+      return;
+
+   pcKeys = malloc((size_t)iBindingCount * MAX_KEY_LENGTH);
+   piValues = malloc((size_t)iBindingCount * sizeof(int));
+   ASSURE(pcKeys != NULL && piValues != NULL);
+   if (pcKeys == NULL || piValues == NULL)
+   {
+      free(pcKeys);
+      free(piValues);
+      return;
+   }
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(pcKeys + (size_t)i * MAX_KEY_LENGTH, "symbol%d", i);
+      piValues[i] = i;
+   }
+
+   dStart = getNanoseconds();
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      iSuccessful = SymTable_put(oSymTable,
+         pcKeys + (size_t)i * MAX_KEY_LENGTH, &piValues[i]);
+      ASSURE(iSuccessful);
+   }
+   printf("Start up by putting %d bindings:  %f seconds\n",
+      iBindingCount, (getNanoseconds() - dStart) / 1e9);
+
+   dStart = getNanoseconds();
+   iSuccessful = SymTable_save(oSymTable, acPath, sizeof(int));
+   ASSURE(iSuccessful);
+   printf("SymTable_save:  %f seconds\n",
+      (getNanoseconds() - dStart) / 1e9);
+
+   dStart = getNanoseconds();
+   oMapped = SymTable_openMapped(acPath);
+   ASSURE(oMapped != NULL);
+   printf("Start up by SymTable_openMapped:  %f seconds\n",
+      (getNanoseconds() - dStart) / 1e9);
+   if (oMapped == NULL)
+   {
+      SymTable_free(oSymTable);
+      free(pcKeys);
+      free(piValues);
+      return;
+   }
+
+   dStart = getNanoseconds();
+   for (i = 0; i < iBindingCount; i++)
+      ASSURE(SymTable_get(oSymTable, pcKeys + (size_t)i * MAX_KEY_LENGTH)
+         == &piValues[i]);
+   printf("Get (built):  %.1f ns per lookup\n",
+      (getNanoseconds() - dStart) / iBindingCount);
+
+   /* The first lookups also fault the pages of the snapshot in. */
+   dStart = getNanoseconds();
+   for (i = 0; i < iBindingCount; i++)
+   {
+      pvValue = SymTable_get(oMapped, pcKeys + (size_t)i * MAX_KEY_LENGTH);
+      ASSURE(pvValue != NULL && *(int*)pvValue == i);
+   }
+   printf("Get (mapped):  %.1f ns per lookup\n",
+      (getNanoseconds() - dStart) / iBindingCount);
+   fflush(stdout);
+
+   SymTable_free(oMapped);
+   SymTable_free(oSymTable);
+   ASSURE(remove(acPath) == 0);
+   free(pcKeys);
+   free(piValues);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put iBindingCount bindings into iCapacity == 0 ? a SymTable object
+   from SymTable_new() : one from SymTable_newWithCapacity(iCapacity),
+   and return the number of puts that expanded it, which are the ones
+   after which the rehash count went up.  Store the time the puts took
+   in seconds in *pdSeconds. */
+
+static size_t countExpansions(int iBindingCount, int iCapacity,
+   double *pdSeconds)
+{
+   enum {MAX_KEY_LENGTH = 11};
+
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   size_t uRehashes;
+   size_t uLastRehashes = 0;
+   size_t uCompares;
+   size_t uExpansions = 0;
+   double dStart;
+   int i;
+   int iSuccessful;
+
+   dStart = getNanoseconds();
+   if (iCapacity == 0)
+      oSymTable = SymTable_new();
+   else
+      oSymTable = SymTable_newWithCapacity((size_t)iCapacity);
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, NULL);
+      ASSURE(iSuccessful);
+      SymTable_getCounts(oSymTable, &uRehashes, &uCompares);
+      if (uRehashes != uLastRehashes)
+      {
+         uExpansions++;
+         uLastRehashes = uRehashes;
+      }
+   }
+   *pdSeconds = (getNanoseconds() - dStart) / 1e9;
+   SymTable_free(oSymTable);
+   return uExpansions;
+}
+
+/* Put iBindingCount bindings into a SymTable object from
+   SymTable_new() and into one from SymTable_newWithCapacity(), and
+   write the time each took and how many expansions the capacity hint
+   avoided to stdout. */
+
+static void timeCapacity(int iBindingCount)
+{
+   size_t uExpansions;
+   size_t uExpansionsHinted;
+   double dSeconds;
+   double dSecondsHinted;
+
+   printf("------------------------------------------------------\n");
+   printf("Timing SymTable_newWithCapacity().\n");
+   fflush(stdout);
+
+   if (iBindingCount == 0)
+      return;
+
+   uExpansions = countExpansions(iBindingCount, 0, &dSeconds);
+   uExpansionsHinted = countExpansions(iBindingCount, iBindingCount,
+      &dSecondsHinted);
+   ASSURE(uExpansionsHinted == 0);
+   printf("SymTable_new:  %d puts in %f seconds, %lu expansions\n",
+      iBindingCount, dSeconds, (unsigned long)uExpansions);
+   printf("SymTable_newWithCapacity:  %d puts in %f seconds, "
+      "%lu expansions\n", iBindingCount, dSecondsHinted,
+      (unsigned long)uExpansionsHinted);
+   printf("Expansions avoided:  %lu\n",
+      (unsigned long)(uExpansions - uExpansionsHinted));
+   fflush(stdout);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put iBindingCount bindings into a SymTable object, remove all but
+   one in a hundred, and write its size in bytes and the time a
+   SymTable_map() over it takes before and after SymTable_compact() to
+   stdout, along with the time SymTable_compact() takes. */
+
+static void timeCompact(int iBindingCount)
+{
+   enum {MAX_KEY_LENGTH = 11, KEEP_EVERY = 100};
+
+   SymTable_T oSymTable;
+   char acKey[MAX_KEY_LENGTH];
+   size_t uCount;
+   double dStart;
+   int i;
+   int iSuccessful;
+
+   printf("------------------------------------------------------\n");
+   printf("Timing SymTable_compact().\n");
+   fflush(stdout);
+
+   if (iBindingCount == 0)
+      return;
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, acKey);
+      ASSURE(iSuccessful);
+   }
+   printf("Bytes with %d bindings:  %lu\n", iBindingCount,
+      (unsigned long)SymTable_getBytes(oSymTable));
+   for (i = 0; i < iBindingCount; i++)
+   {
+      if (i % KEEP_EVERY != 0)
+      {
+         sprintf(acKey, "%d", i);
+         (void)SymTable_remove(oSymTable, acKey);
+      }
+   }
+
+   uCount = 0;
+   dStart = getNanoseconds();
+   SymTable_map(oSymTable, countBinding, &uCount);
+   printf("After removals:  %lu bytes, SymTable_map over %lu bindings "
+      "in %f seconds\n", (unsigned long)SymTable_getBytes(oSymTable),
+      (unsigned long)uCount, (getNanoseconds() - dStart) / 1e9);
+
+   dStart = getNanoseconds();
+   iSuccessful = SymTable_compact(oSymTable);
+   ASSURE(iSuccessful);
+   printf("SymTable_compact:  %f seconds\n",
+      (getNanoseconds() - dStart) / 1e9);
+
+   uCount = 0;
+   dStart = getNanoseconds();
+   SymTable_map(oSymTable, countBinding, &uCount);
+   printf("After compacting:  %lu bytes, SymTable_map over %lu bindings "
+      "in %f seconds\n", (unsigned long)SymTable_getBytes(oSymTable),
+      (unsigned long)uCount, (getNanoseconds() - dStart) / 1e9);
+   fflush(stdout);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Put iBindingCount bindings into a SymTable object and get each of
+   them back, in a SymTable_new() and in a SymTable_newWithStats(),
+   and write the time each took to stdout, followed by what
+   SymTable_getStats() reports for the second. */
+
+static void timeStats(int iBindingCount)
+{
+   enum {MAX_KEY_LENGTH = 11};
+
+   SymTable_T oSymTable;
+   struct SymTableStats sStats;
+   char acKey[MAX_KEY_LENGTH];
+   double dStart;
+   double dSeconds;
+   int iStats;
+   int i;
+   int iSuccessful;
+
+   printf("------------------------------------------------------\n");
+   printf("Timing SymTable_newWithStats().\n");
+   fflush(stdout);
+
+   if (iBindingCount == 0)
+      return;
+
+   for (iStats = 0; iStats <= 1; iStats++)
+   {
+      oSymTable = iStats ? SymTable_newWithStats(SYMTABLE_HASH_DEFAULT) :
+         SymTable_new();
+      ASSURE(oSymTable != NULL);
+      dStart = getNanoseconds();
+      for (i = 0; i < iBindingCount; i++)
+      {
+         sprintf(acKey, "%d", i);
+         iSuccessful = SymTable_put(oSymTable, acKey, acKey);
+         ASSURE(iSuccessful);
+      }
+      for (i = 0; i < iBindingCount; i++)
+      {
+         sprintf(acKey, "%d", i);
+         ASSURE(SymTable_contains(oSymTable, acKey));
+      }
+      dSeconds = (getNanoseconds() - dStart) / 1e9;
+      printf("%s:  %d puts and gets in %f seconds\n",
+         iStats ? "SymTable_newWithStats" : "SymTable_new",
+         iBindingCount, dSeconds);
+      if (iStats)
+      {
+         (void)SymTable_getStats(oSymTable, &sStats);
+         printf("Buckets:  %lu, load %f, longest chain %lu\n",
+            (unsigned long)sStats.bucketCount, sStats.load,
+            (unsigned long)sStats.maxChain);
+         printf("Probes per hit:  %f, per miss:  %f\n",
+            sStats.probesPerHit, sStats.probesPerMiss);
+         printf("Expansions:  %lu in %f seconds\n",
+            (unsigned long)sStats.expansions, sStats.expandSeconds);
+      }
+      fflush(stdout);
+      SymTable_free(oSymTable);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTable ADT.  Write the output of the tests to stdout.
+   As always, argc is the command-line argument count, argv contains
+   the command-line arguments, and argv[0] is the name of the
+   executable binary file. argv[1] is the number of bindings to put
+   into a potentially large SymTable object.  argv[2], if present,
+   must be "bench" and turns on benchmark output.  Exit with
+   EXIT_FAILURE if argv[1] is missing or not numeric, or argv[2] is
+   not "bench".  Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount;
+   int iBenchmark = 0;
+
+   if ((argc != 2) && (argc != 3))
+   {
+      fprintf(stderr, "Usage: %s bindingcount [bench]\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   if (argc == 3)
+   {
+      if (strcmp(argv[2], "bench") != 0)
+      {
+         fprintf(stderr, "Usage: %s bindingcount [bench]\n", argv[0]);
+         exit(EXIT_FAILURE);
+      }
+      iBenchmark = 1;
+   }
+
+   if (sscanf(argv[1], "%d", &iBindingCount) != 1)
+   {
+      fprintf(stderr, "bindingcount must be numeric\n");
+      exit(EXIT_FAILURE);
+   }
+   if (iBindingCount < 0)
+   {
+      fprintf(stderr, "bindingcount cannot be negative\n");
+      exit(EXIT_FAILURE);
+   }
+   
+#ifndef S_SPLINT_S
+   setCpuTimeLimit();
+#endif
 
    testBasics();
    testKeyComparison();
@@ -960,7 +3652,38 @@ int main(int argc, char *argv[])
    testLongKey();
    testTableOfTables();
    testCollisions();
-   testLargeTable(iBindingCount);
+   testMaxLoad();
+   testIncremental();
+   testAtoms();
+   testBorrowedKeys();
+   testGetOrPut();
+   testBinaryKeys();
+   testHashedKeys();
+   testGetMany();
+   testHashOptions();
+   testMapParallel();
+   testIterator();
+   testMapRange();
+   testSnapshot();
+   testReserve();
+   testCompact();
+   testStats();
+   testLargeTable(iBindingCount, iBenchmark);
+   if (iBenchmark)
+   {
+      testPutLatency(iBindingCount);
+      timeGetMany(iBindingCount);
+      timeHashes(iBindingCount);
+      timeCollisions();
+      timeMapParallel(iBindingCount);
+      timeSparseIteration(iBindingCount);
+      timeRangeScans(iBindingCount);
+      timePrefixedKeys(iBindingCount);
+      timeSnapshot(iBindingCount);
+      timeCapacity(iBindingCount);
+      timeCompact(iBindingCount);
+      timeStats(iBindingCount);
+   }
 
    printf("------------------------------------------------------\n");
    printf("End of %s.\n", argv[0]);